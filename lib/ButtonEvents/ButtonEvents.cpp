@@ -0,0 +1,32 @@
+#include "ButtonEvents.h"
+
+void ButtonEvents::apply(const ButtonEvent& event) {
+  if (event.button >= BUTTON_COUNT) {
+    return;
+  }
+  const uint8_t bit = 1 << event.button;
+  if (event.pressed) {
+    if (heldMask == 0) {
+      pressStart = event.time;
+    }
+    heldMask |= bit;
+    pressedEdges |= bit;
+  } else if (heldMask & bit) {
+    heldMask &= ~bit;
+    releasedEdges |= bit;
+    if (heldMask == 0) {
+      pressEnd = event.time;
+    }
+  }
+}
+
+void ButtonEvents::resync(const uint8_t sample, const uint32_t time) {
+  diff(heldMask, sample, time, [this](const ButtonEvent& event) { apply(event); });
+}
+
+uint32_t ButtonEvents::getHeldTime(const uint32_t now) const {
+  if (heldMask != 0) {
+    return now - pressStart;
+  }
+  return pressEnd - pressStart;
+}
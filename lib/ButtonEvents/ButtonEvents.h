@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+struct ButtonEvent {
+  uint8_t button;
+  bool pressed;   // false for a release
+  uint32_t time;  // ms
+};
+
+/**
+ * Button state as the main loop sees it, built from press and release events instead of sampling the buttons itself.
+ *
+ * The input task compares each sample of the buttons with the previous one and queues an event per change (diff()).
+ * Every iteration, the main loop starts a frame and applies the events queued since the last one; activities then
+ * read the same things they always have: what is held now, what was pressed or released during this iteration, and
+ * how long the current (or just released) press lasted. Between events the main loop can block on the queue.
+ */
+class ButtonEvents {
+ public:
+  static constexpr uint8_t BUTTON_COUNT = 8;
+  // Queued to end a wait early without a button change; ignored by apply()
+  static constexpr uint8_t NO_BUTTON = 0xFF;
+
+  // Calls emit(event) for every button whose bit differs between two samples (bit n set = button n held)
+  template <typename Emit>
+  static void diff(const uint8_t previous, const uint8_t current, const uint32_t time, Emit&& emit) {
+    const uint8_t changed = previous ^ current;
+    for (uint8_t button = 0; button < BUTTON_COUNT; button++) {
+      if (changed & (1 << button)) {
+        emit(ButtonEvent{button, (current & (1 << button)) != 0, time});
+      }
+    }
+  }
+
+  // Clears the edges of the previous iteration
+  void beginFrame() {
+    pressedEdges = 0;
+    releasedEdges = 0;
+  }
+  void apply(const ButtonEvent& event);
+  // Adopts a sample as the held state, for when events were lost; edges of the difference are reported
+  void resync(uint8_t sample, uint32_t time);
+
+  bool isPressed(const uint8_t button) const { return button < BUTTON_COUNT && (heldMask & (1 << button)); }
+  bool isAnyPressed() const { return heldMask != 0; }
+  bool wasPressed(const uint8_t button) const { return button < BUTTON_COUNT && (pressedEdges & (1 << button)); }
+  bool wasAnyPressed() const { return pressedEdges != 0; }
+  bool wasReleased(const uint8_t button) const { return button < BUTTON_COUNT && (releasedEdges & (1 << button)); }
+  bool wasAnyReleased() const { return releasedEdges != 0; }
+  // Time since the first button of the current press went down; after all are released, how long the press lasted
+  uint32_t getHeldTime(uint32_t now) const;
+
+ private:
+  uint8_t heldMask = 0;
+  uint8_t pressedEdges = 0;
+  uint8_t releasedEdges = 0;
+  uint32_t pressStart = 0;
+  uint32_t pressEnd = 0;
+};
@@ -0,0 +1,112 @@
+#include "DirectoryListing.h"
+
+#include <cstring>
+
+namespace DirectoryListing {
+
+namespace {
+constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+}  // namespace
+
+void ChunkedWriter::write(const char* data, size_t dataLen) {
+  while (dataLen > 0) {
+    if (len == BUFFER_SIZE) flush();
+    const size_t n = dataLen < BUFFER_SIZE - len ? dataLen : BUFFER_SIZE - len;
+    memcpy(buffer + len, data, n);
+    len += n;
+    data += n;
+    dataLen -= n;
+  }
+}
+
+void ChunkedWriter::write(const char* str) { write(str, strlen(str)); }
+
+void ChunkedWriter::writeUnsigned(uint64_t value) {
+  char digits[20];
+  size_t n = 0;
+  do {
+    digits[n++] = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value > 0);
+  while (n > 0) {
+    write(digits[--n]);
+  }
+}
+
+void ChunkedWriter::writeJsonEscaped(const char* str) {
+  for (const char* p = str; *p; p++) {
+    const auto c = static_cast<uint8_t>(*p);
+    if (c == '"' || c == '\\') {
+      write('\\');
+      write(static_cast<char>(c));
+    } else if (c < 0x20) {
+      write("\\u00", 4);
+      write(HEX_DIGITS[c >> 4]);
+      write(HEX_DIGITS[c & 0x0F]);
+    } else {
+      write(static_cast<char>(c));
+    }
+  }
+}
+
+void ChunkedWriter::writeUrlEncodedPath(const char* path) {
+  for (const char* p = path; *p; p++) {
+    const auto c = static_cast<uint8_t>(*p);
+    if (c == ' ' || c == '%' || c == '#' || c == '?' || c == '&' || c > 127) {
+      write('%');
+      write(HEX_DIGITS[c >> 4]);
+      write(HEX_DIGITS[c & 0x0F]);
+    } else {
+      write(static_cast<char>(c));
+    }
+  }
+}
+
+void ChunkedWriter::flush() {
+  if (len == 0) return;
+  sink(buffer, len);
+  total += len;
+  len = 0;
+}
+
+void writeFileJson(ChunkedWriter& out, const char* name, const uint64_t size, const bool isDirectory,
+                   const bool isEpub) {
+  out.write("{\"name\":\"");
+  out.writeJsonEscaped(name);
+  out.write("\",\"size\":");
+  out.writeUnsigned(size);
+  out.write(isDirectory ? ",\"isDirectory\":true" : ",\"isDirectory\":false");
+  out.write(isEpub ? ",\"isEpub\":true}" : ",\"isEpub\":false}");
+}
+
+void writePropResponse(ChunkedWriter& out, const char* dirPath, const char* name, const bool isDirectory,
+                       const uint64_t size, const char* mimeType, const char* lastModified) {
+  out.write("<D:response><D:href>");
+  out.writeUrlEncodedPath(dirPath);
+  const size_t dirLen = strlen(dirPath);
+  char last = dirLen > 0 ? dirPath[dirLen - 1] : '\0';
+  if (name && *name) {
+    if (last != '/') out.write('/');
+    out.writeUrlEncodedPath(name);
+    last = name[strlen(name) - 1];
+  }
+  // Collection hrefs end with a slash
+  if (isDirectory && last != '/') out.write('/');
+  out.write("</D:href><D:propstat><D:prop>");
+
+  if (isDirectory) {
+    out.write("<D:resourcetype><D:collection/></D:resourcetype>");
+  } else {
+    out.write("<D:resourcetype/><D:getcontentlength>");
+    out.writeUnsigned(size);
+    out.write("</D:getcontentlength><D:getcontenttype>");
+    out.write(mimeType);
+    out.write("</D:getcontenttype>");
+  }
+
+  out.write("<D:getlastmodified>");
+  out.write(lastModified);
+  out.write("</D:getlastmodified></D:prop><D:status>HTTP/1.1 200 OK</D:status></D:propstat></D:response>\n");
+}
+
+}  // namespace DirectoryListing
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace DirectoryListing {
+
+/**
+ * Fixed-size output buffer for chunked HTTP responses.
+ *
+ * Directory listings are formatted straight into the buffer and handed to the sink (WebServer::sendContent) one full
+ * buffer at a time, so a response costs the same memory for five files as for five thousand, and the client receives
+ * a few large chunks instead of one per entry.
+ */
+class ChunkedWriter {
+ public:
+  // One TCP segment at lwIP's default MSS
+  static constexpr size_t BUFFER_SIZE = 1436;
+
+  using Sink = std::function<void(const char* data, size_t len)>;
+
+  explicit ChunkedWriter(Sink sink) : sink(std::move(sink)) {}
+  ~ChunkedWriter() { flush(); }
+
+  ChunkedWriter(const ChunkedWriter&) = delete;
+  ChunkedWriter& operator=(const ChunkedWriter&) = delete;
+
+  void write(char c) {
+    if (len == BUFFER_SIZE) flush();
+    buffer[len++] = c;
+  }
+  void write(const char* data, size_t dataLen);
+  void write(const char* str);
+  void writeUnsigned(uint64_t value);
+  // Contents of a JSON string literal, without the quotes
+  void writeJsonEscaped(const char* str);
+  // Path for a WebDAV href: '/' is kept, reserved and non-ASCII bytes are percent-encoded
+  void writeUrlEncodedPath(const char* path);
+
+  // Passes buffered output to the sink
+  void flush();
+  size_t getBytesWritten() const { return total + len; }
+
+ private:
+  Sink sink;
+  char buffer[BUFFER_SIZE];
+  size_t len = 0;
+  size_t total = 0;
+};
+
+// {"name":...,"size":...,"isDirectory":...,"isEpub":...} for /api/files
+void writeFileJson(ChunkedWriter& out, const char* name, uint64_t size, bool isDirectory, bool isEpub);
+
+// One <D:response> of a PROPFIND multistatus for dirPath/name (name may be null for dirPath itself).
+// mimeType is ignored for directories.
+void writePropResponse(ChunkedWriter& out, const char* dirPath, const char* name, bool isDirectory, uint64_t size,
+                       const char* mimeType, const char* lastModified);
+
+}  // namespace DirectoryListing
@@ -1,6 +1,8 @@
 #include "FontDecompressor.h"
 
+#include <HeapTrace.h>
 #include <Logging.h>
+#include <PerfTrace.h>
 
 #include <cstdlib>
 
@@ -12,7 +14,7 @@ bool FontDecompressor::init() {
 void FontDecompressor::freeAllEntries() {
   for (auto& entry : cache) {
     if (entry.data) {
-      free(entry.data);
+      HEAP_FREE(entry.data);
       entry.data = nullptr;
     }
     entry.valid = false;
@@ -63,17 +65,18 @@ FontDecompressor::CacheEntry* FontDecompressor::findEvictionCandidate() {
 }
 
 bool FontDecompressor::decompressGroup(const EpdFontData* fontData, uint16_t groupIndex, CacheEntry* entry) {
+  PERF_SCOPE(FONT_INFLATE);
   const EpdFontGroup& group = fontData->groups[groupIndex];
 
   // Free old buffer if reusing a slot
   if (entry->data) {
-    free(entry->data);
+    HEAP_FREE(entry->data);
     entry->data = nullptr;
   }
   entry->valid = false;
 
   // Allocate output buffer
-  auto* outBuf = static_cast<uint8_t*>(malloc(group.uncompressedSize));
+  auto* outBuf = static_cast<uint8_t*>(HEAP_MALLOC(FONT_CACHE, group.uncompressedSize));
   if (!outBuf) {
     LOG_ERR("FDC", "Failed to allocate %u bytes for group %u", group.uncompressedSize, groupIndex);
     return false;
@@ -83,7 +86,7 @@ bool FontDecompressor::decompressGroup(const EpdFontData* fontData, uint16_t gro
   inflateReader.setSource(&fontData->bitmap[group.compressedOffset], group.compressedSize);
   if (!inflateReader.read(outBuf, group.uncompressedSize)) {
     LOG_ERR("FDC", "Decompression failed for group %u", groupIndex);
-    free(outBuf);
+    HEAP_FREE(outBuf);
     return false;
   }
 
@@ -5,13 +5,22 @@
 #include <JpegToBmpConverter.h>
 #include <Logging.h>
 #include <PngToBmpConverter.h>
+#include <ScaledBmpWriter.h>
 #include <ZipFile.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include "Epub/parsers/ContainerParser.h"
 #include "Epub/parsers/ContentOpfParser.h"
 #include "Epub/parsers/TocNavParser.h"
 #include "Epub/parsers/TocNcxParser.h"
 
+namespace {
+// Section layouts kept per book: enough to flip orientation or font size and back without a re-index
+constexpr size_t MAX_SECTION_LAYOUTS = 3;
+}  // namespace
+
 bool Epub::findContentOpfFile(std::string* contentOpfFile) const {
   const auto containerPath = "META-INF/container.xml";
   size_t containerSize;
@@ -353,7 +362,7 @@ bool Epub::load(const bool buildIfMissing, const bool skipLoadingCss) {
         }
         parseCssFiles();
         // Invalidate section caches so they are rebuilt with the new CSS
-        Storage.removeDir((cachePath + "/sections").c_str());
+        clearSectionCaches();
       }
     }
     LOG_DBG("EBP", "Loaded ePub: %s", filepath.c_str());
@@ -455,13 +464,111 @@ bool Epub::load(const bool buildIfMissing, const bool skipLoadingCss) {
   if (!skipLoadingCss) {
     // Parse CSS files after cache reload
     parseCssFiles();
-    Storage.removeDir((cachePath + "/sections").c_str());
+    clearSectionCaches();
   }
 
   LOG_DBG("EBP", "Loaded ePub: %s", filepath.c_str());
   return true;
 }
 
+void Epub::clearSectionCaches() const {
+  Storage.removeDir((cachePath + "/sections").c_str());
+  removePackedSections("section/");
+  removeSectionImages("");
+}
+
+void Epub::removeSectionImages(const std::string& layoutName) const {
+  // Named img_<spine>_<layout>_<n>
+  const std::string infix = "_" + layoutName + "_";
+  FsFile dir = Storage.open(cachePath.c_str());
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    return;
+  }
+  char name[64];
+  std::vector<std::string> doomed;
+  for (auto file = dir.openNextFile(); file; file = dir.openNextFile()) {
+    file.getName(name, sizeof(name));
+    file.close();
+    if (strncmp(name, "img_", 4) == 0 && (layoutName.empty() || strstr(name + 4, infix.c_str()))) {
+      doomed.emplace_back(name);
+    }
+  }
+  dir.close();
+  for (const auto& file : doomed) {
+    Storage.remove((cachePath + "/" + file).c_str());
+  }
+}
+
+void Epub::removePackedSections(const std::string& prefix) const {
+  // The pack may hold sections from when packing was enabled
+  if (pack) {
+    pack->removePrefix(prefix);
+  } else if (Storage.exists(getPackPath().c_str())) {
+    PackFile(getPackPath()).removePrefix(prefix);
+  }
+}
+
+std::string Epub::getSectionLayoutName(const uint32_t layout) {
+  char name[9];
+  snprintf(name, sizeof(name), "%08lx", static_cast<unsigned long>(layout));
+  return name;
+}
+
+std::vector<uint32_t> Epub::readSectionLayouts(const std::string& cachePath) {
+  std::vector<uint32_t> layouts;
+  FsFile f;
+  const std::string listPath = cachePath + "/sections/layouts.bin";
+  if (!Storage.exists(listPath.c_str()) || !Storage.openFileForRead("EBP", listPath, f)) {
+    return layouts;
+  }
+  uint32_t layout;
+  while (layouts.size() < MAX_SECTION_LAYOUTS && f.read(&layout, sizeof(layout)) == sizeof(layout)) {
+    layouts.push_back(layout);
+  }
+  f.close();
+  return layouts;
+}
+
+void Epub::useSectionLayout(const uint32_t layout) const {
+  auto layouts = readSectionLayouts(cachePath);
+  if (!layouts.empty() && layouts.front() == layout) {
+    return;
+  }
+  if (layouts.empty()) {
+    // Sections cached before they were kept per layout cannot be told apart
+    clearSectionCaches();
+  }
+
+  const std::string sectionsDir = cachePath + "/sections";
+  layouts.erase(std::remove(layouts.begin(), layouts.end(), layout), layouts.end());
+  layouts.insert(layouts.begin(), layout);
+  while (layouts.size() > MAX_SECTION_LAYOUTS) {
+    const std::string name = getSectionLayoutName(layouts.back());
+    LOG_DBG("EBP", "Dropping sections of layout %s", name.c_str());
+    Storage.removeDir((sectionsDir + "/" + name).c_str());
+    removePackedSections("section/" + name + "/");
+    removeSectionImages(name);
+    layouts.pop_back();
+  }
+
+  Storage.mkdir(sectionsDir.c_str());
+  FsFile f;
+  if (!Storage.openFileForWrite("EBP", sectionsDir + "/layouts.bin", f)) {
+    return;
+  }
+  f.write(reinterpret_cast<const uint8_t*>(layouts.data()), layouts.size() * sizeof(uint32_t));
+  f.close();
+}
+
+void Epub::setPackCaches(const bool enabled) {
+  if (!enabled) {
+    pack.reset();
+  } else if (!pack) {
+    pack.reset(new PackFile(getPackPath()));
+  }
+}
+
 bool Epub::clearCache() const {
   if (!Storage.exists(cachePath.c_str())) {
     LOG_DBG("EPB", "Cache does not exist, no action needed");
@@ -522,188 +629,124 @@ std::string Epub::getCoverBmpPath(bool cropped) const {
 }
 
 bool Epub::generateCoverBmp(bool cropped) const {
+  return generateCoverImages(!cropped, cropped, std::vector<int>());
+}
+
+std::string Epub::getThumbBmpPath() const { return cachePath + "/thumb_[HEIGHT].bmp"; }
+std::string Epub::getThumbBmpPath(int height) const { return cachePath + "/thumb_" + std::to_string(height) + ".bmp"; }
+
+bool Epub::generateThumbBmp(int height) const { return generateCoverImages(false, false, std::vector<int>{height}); }
+
+bool Epub::generateCoverImages(const bool cover, const bool croppedCover, const std::vector<int>& thumbHeights,
+                               const std::function<bool()>& progressFn) const {
+  struct Target {
+    std::string path;
+    BmpOutputSpec spec;
+    bool isThumb;
+  };
+
+  // Collect the files that are still missing
+  std::vector<Target> targets;
+  if (cover && !Storage.exists(getCoverBmpPath(false).c_str())) {
+    targets.push_back(
+        {getCoverBmpPath(false), {nullptr, COVER_BMP_MAX_WIDTH, COVER_BMP_MAX_HEIGHT, false, false}, false});
+  }
+  if (croppedCover && !Storage.exists(getCoverBmpPath(true).c_str())) {
+    targets.push_back(
+        {getCoverBmpPath(true), {nullptr, COVER_BMP_MAX_WIDTH, COVER_BMP_MAX_HEIGHT, false, true}, false});
+  }
+  for (const int height : thumbHeights) {
+    if (!Storage.exists(getThumbBmpPath(height).c_str())) {
+      // Generate 1-bit BMP thumbnails for fast home screen rendering (no gray passes needed)
+      targets.push_back({getThumbBmpPath(height), {nullptr, static_cast<int>(height * 0.6), height, true, true}, true});
+    }
+  }
+
   // Already generated, return true
-  if (Storage.exists(getCoverBmpPath(cropped).c_str())) {
+  if (targets.empty()) {
     return true;
   }
 
   if (!bookMetadataCache || !bookMetadataCache->isLoaded()) {
-    LOG_ERR("EBP", "Cannot generate cover BMP, cache not loaded");
+    LOG_ERR("EBP", "Cannot generate cover images, cache not loaded");
     return false;
   }
 
   const auto coverImageHref = bookMetadataCache->coreMetadata.coverItemHref;
-  if (coverImageHref.empty()) {
-    LOG_ERR("EBP", "No known cover image");
-    return false;
-  }
-
-  if (FsHelpers::hasJpgExtension(coverImageHref)) {
-    LOG_DBG("EBP", "Generating BMP from JPG cover image (%s mode)", cropped ? "cropped" : "fit");
-    const auto coverJpgTempPath = getCachePath() + "/.cover.jpg";
-
-    FsFile coverJpg;
-    if (!Storage.openFileForWrite("EBP", coverJpgTempPath, coverJpg)) {
-      return false;
-    }
-    readItemContentsToStream(coverImageHref, coverJpg, 1024);
-    coverJpg.close();
-
-    if (!Storage.openFileForRead("EBP", coverJpgTempPath, coverJpg)) {
-      return false;
+  const bool isJpg = FsHelpers::hasJpgExtension(coverImageHref);
+  const bool isPng = FsHelpers::hasPngExtension(coverImageHref);
+  if (!isJpg && !isPng) {
+    if (coverImageHref.empty()) {
+      LOG_ERR("EBP", "No known cover image");
+    } else {
+      LOG_ERR("EBP", "Cover image is not a supported format, skipping");
     }
-
-    FsFile coverBmp;
-    if (!Storage.openFileForWrite("EBP", getCoverBmpPath(cropped), coverBmp)) {
-      coverJpg.close();
-      return false;
-    }
-    const bool success = JpegToBmpConverter::jpegFileToBmpStream(coverJpg, coverBmp, cropped);
-    coverJpg.close();
-    coverBmp.close();
-    Storage.remove(coverJpgTempPath.c_str());
-
-    if (!success) {
-      LOG_ERR("EBP", "Failed to generate BMP from cover image");
-      Storage.remove(getCoverBmpPath(cropped).c_str());
-    }
-    LOG_DBG("EBP", "Generated BMP from JPG cover image, success: %s", success ? "yes" : "no");
-    return success;
-  }
-
-  if (FsHelpers::hasPngExtension(coverImageHref)) {
-    LOG_DBG("EBP", "Generating BMP from PNG cover image (%s mode)", cropped ? "cropped" : "fit");
-    const auto coverPngTempPath = getCachePath() + "/.cover.png";
-
-    FsFile coverPng;
-    if (!Storage.openFileForWrite("EBP", coverPngTempPath, coverPng)) {
-      return false;
-    }
-    readItemContentsToStream(coverImageHref, coverPng, 1024);
-    coverPng.close();
-
-    if (!Storage.openFileForRead("EBP", coverPngTempPath, coverPng)) {
-      return false;
-    }
-
-    FsFile coverBmp;
-    if (!Storage.openFileForWrite("EBP", getCoverBmpPath(cropped), coverBmp)) {
-      coverPng.close();
-      return false;
-    }
-    const bool success = PngToBmpConverter::pngFileToBmpStream(coverPng, coverBmp, cropped);
-    coverPng.close();
-    coverBmp.close();
-    Storage.remove(coverPngTempPath.c_str());
-
-    if (!success) {
-      LOG_ERR("EBP", "Failed to generate BMP from PNG cover image");
-      Storage.remove(getCoverBmpPath(cropped).c_str());
+    // Write empty thumbnail files to avoid generation attempts in the future
+    for (const auto& target : targets) {
+      if (target.isThumb) {
+        FsFile thumbBmp;
+        Storage.openFileForWrite("EBP", target.path, thumbBmp);
+        thumbBmp.close();
+      }
     }
-    LOG_DBG("EBP", "Generated BMP from PNG cover image, success: %s", success ? "yes" : "no");
-    return success;
+    return false;
   }
 
-  LOG_ERR("EBP", "Cover image is not a supported format, skipping");
-  return false;
-}
-
-std::string Epub::getThumbBmpPath() const { return cachePath + "/thumb_[HEIGHT].bmp"; }
-std::string Epub::getThumbBmpPath(int height) const { return cachePath + "/thumb_" + std::to_string(height) + ".bmp"; }
+  LOG_DBG("EBP", "Generating %d cover image(s) from %s cover", static_cast<int>(targets.size()), isJpg ? "JPG" : "PNG");
+  const auto start = millis();
+  const auto coverTempPath = getCachePath() + (isJpg ? "/.cover.jpg" : "/.cover.png");
 
-bool Epub::generateThumbBmp(int height) const {
-  // Already generated, return true
-  if (Storage.exists(getThumbBmpPath(height).c_str())) {
-    return true;
+  // Extract the cover once; every output is produced from a single decode of it
+  FsFile coverImage;
+  if (!Storage.openFileForWrite("EBP", coverTempPath, coverImage)) {
+    return false;
   }
+  readItemContentsToStream(coverImageHref, coverImage, 1024);
+  coverImage.close();
 
-  if (!bookMetadataCache || !bookMetadataCache->isLoaded()) {
-    LOG_ERR("EBP", "Cannot generate thumb BMP, cache not loaded");
+  if (!Storage.openFileForRead("EBP", coverTempPath, coverImage)) {
     return false;
   }
 
-  const auto coverImageHref = bookMetadataCache->coreMetadata.coverItemHref;
-  if (coverImageHref.empty()) {
-    LOG_DBG("EBP", "No known cover image for thumbnail");
-  } else if (FsHelpers::hasJpgExtension(coverImageHref)) {
-    LOG_DBG("EBP", "Generating thumb BMP from JPG cover image");
-    const auto coverJpgTempPath = getCachePath() + "/.cover.jpg";
-
-    FsFile coverJpg;
-    if (!Storage.openFileForWrite("EBP", coverJpgTempPath, coverJpg)) {
-      return false;
-    }
-    readItemContentsToStream(coverImageHref, coverJpg, 1024);
-    coverJpg.close();
-
-    if (!Storage.openFileForRead("EBP", coverJpgTempPath, coverJpg)) {
-      return false;
-    }
-
-    FsFile thumbBmp;
-    if (!Storage.openFileForWrite("EBP", getThumbBmpPath(height), thumbBmp)) {
-      coverJpg.close();
-      return false;
-    }
-    // Use smaller target size for Continue Reading card (half of screen: 240x400)
-    // Generate 1-bit BMP for fast home screen rendering (no gray passes needed)
-    int THUMB_TARGET_WIDTH = height * 0.6;
-    int THUMB_TARGET_HEIGHT = height;
-    const bool success = JpegToBmpConverter::jpegFileTo1BitBmpStreamWithSize(coverJpg, thumbBmp, THUMB_TARGET_WIDTH,
-                                                                             THUMB_TARGET_HEIGHT);
-    coverJpg.close();
-    thumbBmp.close();
-    Storage.remove(coverJpgTempPath.c_str());
-
-    if (!success) {
-      LOG_ERR("EBP", "Failed to generate thumb BMP from JPG cover image");
-      Storage.remove(getThumbBmpPath(height).c_str());
-    }
-    LOG_DBG("EBP", "Generated thumb BMP from JPG cover image, success: %s", success ? "yes" : "no");
-    return success;
-  } else if (FsHelpers::hasPngExtension(coverImageHref)) {
-    LOG_DBG("EBP", "Generating thumb BMP from PNG cover image");
-    const auto coverPngTempPath = getCachePath() + "/.cover.png";
-
-    FsFile coverPng;
-    if (!Storage.openFileForWrite("EBP", coverPngTempPath, coverPng)) {
-      return false;
+  std::vector<FsFile> outFiles(targets.size());
+  std::vector<BmpOutputSpec> specs;
+  specs.reserve(targets.size());
+  bool success = true;
+  // Outputs are written under a temporary name so the home screen never draws a half-written thumbnail
+  for (size_t i = 0; i < targets.size(); i++) {
+    if (!Storage.openFileForWrite("EBP", targets[i].path + ".tmp", outFiles[i])) {
+      success = false;
+      break;
     }
-    readItemContentsToStream(coverImageHref, coverPng, 1024);
-    coverPng.close();
+    specs.push_back(targets[i].spec);
+    specs.back().out = &outFiles[i];
+  }
 
-    if (!Storage.openFileForRead("EBP", coverPngTempPath, coverPng)) {
-      return false;
+  if (success) {
+    success = isJpg ? JpegToBmpConverter::jpegFileToBmpStreams(coverImage, specs.data(), specs.size(), progressFn)
+                    : PngToBmpConverter::pngFileToBmpStreams(coverImage, specs.data(), specs.size(), progressFn);
+  }
+  coverImage.close();
+  for (auto& outFile : outFiles) {
+    if (outFile) {
+      outFile.close();
     }
+  }
+  Storage.remove(coverTempPath.c_str());
 
-    FsFile thumbBmp;
-    if (!Storage.openFileForWrite("EBP", getThumbBmpPath(height), thumbBmp)) {
-      coverPng.close();
-      return false;
+  for (const auto& target : targets) {
+    const std::string tmpPath = target.path + ".tmp";
+    if (!success || !Storage.rename(tmpPath.c_str(), target.path.c_str())) {
+      Storage.remove(tmpPath.c_str());
+      success = false;
     }
-    int THUMB_TARGET_WIDTH = height * 0.6;
-    int THUMB_TARGET_HEIGHT = height;
-    const bool success =
-        PngToBmpConverter::pngFileTo1BitBmpStreamWithSize(coverPng, thumbBmp, THUMB_TARGET_WIDTH, THUMB_TARGET_HEIGHT);
-    coverPng.close();
-    thumbBmp.close();
-    Storage.remove(coverPngTempPath.c_str());
-
-    if (!success) {
-      LOG_ERR("EBP", "Failed to generate thumb BMP from PNG cover image");
-      Storage.remove(getThumbBmpPath(height).c_str());
-    }
-    LOG_DBG("EBP", "Generated thumb BMP from PNG cover image, success: %s", success ? "yes" : "no");
-    return success;
-  } else {
-    LOG_ERR("EBP", "Cover image is not a supported format, skipping thumbnail");
   }
-
-  // Write an empty bmp file to avoid generation attempts in the future
-  FsFile thumbBmp;
-  Storage.openFileForWrite("EBP", getThumbBmpPath(height), thumbBmp);
-  thumbBmp.close();
-  return false;
+  if (!success) {
+    LOG_ERR("EBP", "Failed to generate cover images");
+  }
+  LOG_DBG("EBP", "Generated %d cover image(s) in %lums, success: %s", static_cast<int>(targets.size()),
+          millis() - start, success ? "yes" : "no");
+  return success;
 }
 
 uint8_t* Epub::readItemContentsToBytes(const std::string& itemHref, size_t* size, const bool trailingNullByte) const {
@@ -775,6 +818,16 @@ BookMetadataCache::TocEntry Epub::getTocItem(const int tocIndex) const {
   return bookMetadataCache->getTocEntry(tocIndex);
 }
 
+bool Epub::getTocItems(const int firstTocIndex, const int count,
+                       std::vector<BookMetadataCache::TocEntry>& out) const {
+  if (!bookMetadataCache || !bookMetadataCache->isLoaded()) {
+    LOG_DBG("EBP", "getTocItems called but cache not loaded");
+    return false;
+  }
+
+  return bookMetadataCache->getTocEntries(firstTocIndex, count, out);
+}
+
 int Epub::getTocItemsCount() const {
   if (!bookMetadataCache || !bookMetadataCache->isLoaded()) {
     return 0;
@@ -1,7 +1,9 @@
 #pragma once
 
+#include <PackFile.h>
 #include <Print.h>
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -29,12 +31,18 @@ class Epub {
   std::unique_ptr<CssParser> cssParser;
   // CSS files
   std::vector<std::string> cssFiles;
+  // Single-file store for section caches, when enabled
+  std::unique_ptr<PackFile> pack;
 
   bool findContentOpfFile(std::string* contentOpfFile) const;
   bool parseContentOpf(BookMetadataCache::BookMetadata& bookMetadata);
   bool parseTocNcxFile() const;
   bool parseTocNavFile() const;
   void parseCssFiles() const;
+  void clearSectionCaches() const;
+  void removePackedSections(const std::string& prefix) const;
+  // Inline image caches of one layout, or of every layout when layoutName is empty
+  void removeSectionImages(const std::string& layoutName) const;
 
  public:
   explicit Epub(std::string filepath, const std::string& cacheDir) : filepath(std::move(filepath)) {
@@ -47,6 +55,17 @@ class Epub {
   bool clearCache() const;
   void setupCacheDir() const;
   const std::string& getCachePath() const;
+  // Keep section caches in one pack file instead of one file per chapter
+  void setPackCaches(bool enabled);
+  PackFile* getPack() const { return pack.get(); }
+  std::string getPackPath() const { return cachePath + "/pack.bin"; }
+  // Sections are cached per layout (font, spacing, viewport, ...) so that switching back to a recent layout reuses
+  // its chapters, together with their inline images at that layout's size. Records layout as the most recently used
+  // one and drops the sections and images of layouts that fall out.
+  void useSectionLayout(uint32_t layout) const;
+  // Layouts with cached sections, most recently used first
+  static std::vector<uint32_t> readSectionLayouts(const std::string& cachePath);
+  static std::string getSectionLayoutName(uint32_t layout);
   const std::string& getPath() const;
   const std::string& getTitle() const;
   const std::string& getAuthor() const;
@@ -56,12 +75,18 @@ class Epub {
   std::string getThumbBmpPath() const;
   std::string getThumbBmpPath(int height) const;
   bool generateThumbBmp(int height) const;
+  // Extracts and decodes the cover once to write every missing variant: the fit and/or cropped sleep cover and a
+  // 1-bit thumbnail per height. Returns true if all requested files exist afterwards. progressFn is polled during
+  // the decode; returning false stops it and leaves the missing files missing.
+  bool generateCoverImages(bool cover, bool croppedCover, const std::vector<int>& thumbHeights,
+                           const std::function<bool()>& progressFn = nullptr) const;
   uint8_t* readItemContentsToBytes(const std::string& itemHref, size_t* size = nullptr,
                                    bool trailingNullByte = false) const;
   bool readItemContentsToStream(const std::string& itemHref, Print& out, size_t chunkSize) const;
   bool getItemSize(const std::string& itemHref, size_t* size) const;
   BookMetadataCache::SpineEntry getSpineItem(int spineIndex) const;
   BookMetadataCache::TocEntry getTocItem(int tocIndex) const;
+  bool getTocItems(int firstTocIndex, int count, std::vector<BookMetadataCache::TocEntry>& out) const;
   int getSpineItemsCount() const;
   int getTocItemsCount() const;
   int getSpineIndexForTocIndex(int tocIndex) const;
@@ -29,12 +29,21 @@ bool BookMetadataCache::beginContentOpfPass() {
   LOG_DBG("BMC", "Beginning content opf pass");
 
   // Open spine file for writing
-  return Storage.openFileForWrite("BMC", cachePath + tmpSpineBinFile, spineFile);
+  if (!Storage.openFileForWrite("BMC", cachePath + tmpSpineBinFile, spineFile)) {
+    return false;
+  }
+  spineWriter.reset(new serialization::BufferedWriter(spineFile));
+  return true;
 }
 
 bool BookMetadataCache::endContentOpfPass() {
+  bool ok = true;
+  if (spineWriter) {
+    ok = spineWriter->flush();
+    spineWriter.reset();
+  }
   spineFile.close();
-  return true;
+  return ok;
 }
 
 bool BookMetadataCache::beginTocPass() {
@@ -47,13 +56,15 @@ bool BookMetadataCache::beginTocPass() {
     spineFile.close();
     return false;
   }
+  spineReader.reset(new serialization::BufferedReader(spineFile));
+  tocWriter.reset(new serialization::BufferedWriter(tocFile));
 
   if (spineCount >= LARGE_SPINE_THRESHOLD) {
     spineHrefIndex.clear();
     spineHrefIndex.reserve(spineCount);
-    spineFile.seek(0);
+    spineReader->seek(0);
     for (int i = 0; i < spineCount; i++) {
-      auto entry = readSpineEntry(spineFile);
+      auto entry = readSpineEntry(*spineReader);
       SpineHrefIndexEntry idx;
       idx.hrefHash = fnvHash64(entry.href);
       idx.hrefLen = static_cast<uint16_t>(entry.href.size());
@@ -64,7 +75,7 @@ bool BookMetadataCache::beginTocPass() {
               [](const SpineHrefIndexEntry& a, const SpineHrefIndexEntry& b) {
                 return a.hrefHash < b.hrefHash || (a.hrefHash == b.hrefHash && a.hrefLen < b.hrefLen);
               });
-    spineFile.seek(0);
+    spineReader->seek(0);
     useSpineHrefIndex = true;
     LOG_DBG("BMC", "Using fast index for %d spine items", spineCount);
   } else {
@@ -75,6 +86,12 @@ bool BookMetadataCache::beginTocPass() {
 }
 
 bool BookMetadataCache::endTocPass() {
+  bool ok = true;
+  if (tocWriter) {
+    ok = tocWriter->flush();
+    tocWriter.reset();
+  }
+  spineReader.reset();
   tocFile.close();
   spineFile.close();
 
@@ -82,7 +99,7 @@ bool BookMetadataCache::endTocPass() {
   spineHrefIndex.shrink_to_fit();
   useSpineHrefIndex = false;
 
-  return true;
+  return ok;
 }
 
 bool BookMetadataCache::endWrite() {
@@ -121,32 +138,36 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
   const uint32_t lutSize = sizeof(uint32_t) * spineCount + sizeof(uint32_t) * tocCount;
   const uint32_t lutOffset = headerASize + metadataSize;
 
+  serialization::BufferedWriter bookWriter(bookFile);
+  serialization::BufferedReader spineIn(spineFile);
+  serialization::BufferedReader tocIn(tocFile);
+
   // Header A
-  serialization::writePod(bookFile, BOOK_CACHE_VERSION);
-  serialization::writePod(bookFile, lutOffset);
-  serialization::writePod(bookFile, spineCount);
-  serialization::writePod(bookFile, tocCount);
+  serialization::writePod(bookWriter, BOOK_CACHE_VERSION);
+  serialization::writePod(bookWriter, lutOffset);
+  serialization::writePod(bookWriter, spineCount);
+  serialization::writePod(bookWriter, tocCount);
   // Metadata
-  serialization::writeString(bookFile, metadata.title);
-  serialization::writeString(bookFile, metadata.author);
-  serialization::writeString(bookFile, metadata.language);
-  serialization::writeString(bookFile, metadata.coverItemHref);
-  serialization::writeString(bookFile, metadata.textReferenceHref);
+  serialization::writeString(bookWriter, metadata.title);
+  serialization::writeString(bookWriter, metadata.author);
+  serialization::writeString(bookWriter, metadata.language);
+  serialization::writeString(bookWriter, metadata.coverItemHref);
+  serialization::writeString(bookWriter, metadata.textReferenceHref);
 
   // Loop through spine entries, writing LUT positions
-  spineFile.seek(0);
+  spineIn.seek(0);
   for (int i = 0; i < spineCount; i++) {
-    uint32_t pos = spineFile.position();
-    auto spineEntry = readSpineEntry(spineFile);
-    serialization::writePod(bookFile, pos + lutOffset + lutSize);
+    uint32_t pos = spineIn.position();
+    auto spineEntry = readSpineEntry(spineIn);
+    serialization::writePod(bookWriter, pos + lutOffset + lutSize);
   }
 
   // Loop through toc entries, writing LUT positions
-  tocFile.seek(0);
+  tocIn.seek(0);
   for (int i = 0; i < tocCount; i++) {
-    uint32_t pos = tocFile.position();
-    auto tocEntry = readTocEntry(tocFile);
-    serialization::writePod(bookFile, pos + lutOffset + lutSize + static_cast<uint32_t>(spineFile.position()));
+    uint32_t pos = tocIn.position();
+    auto tocEntry = readTocEntry(tocIn);
+    serialization::writePod(bookWriter, pos + lutOffset + lutSize + spineIn.position());
   }
 
   // LUTs complete
@@ -154,9 +175,9 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
 
   // Build spineIndex->tocIndex mapping in one pass (O(n) instead of O(n*m))
   std::vector<int16_t> spineToTocIndex(spineCount, -1);
-  tocFile.seek(0);
+  tocIn.seek(0);
   for (int j = 0; j < tocCount; j++) {
-    auto tocEntry = readTocEntry(tocFile);
+    auto tocEntry = readTocEntry(tocIn);
     if (tocEntry.spineIndex >= 0 && tocEntry.spineIndex < spineCount) {
       if (spineToTocIndex[tocEntry.spineIndex] == -1) {
         spineToTocIndex[tocEntry.spineIndex] = static_cast<int16_t>(j);
@@ -168,6 +189,7 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
   // Pre-open zip file to speed up size calculations
   if (!zip.open()) {
     LOG_ERR("BMC", "Could not open EPUB zip for size calculations");
+    bookWriter.discard();
     bookFile.close();
     spineFile.close();
     tocFile.close();
@@ -190,9 +212,9 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
     std::vector<ZipFile::SizeTarget> targets;
     targets.reserve(spineCount);
 
-    spineFile.seek(0);
+    spineIn.seek(0);
     for (int i = 0; i < spineCount; i++) {
-      auto entry = readSpineEntry(spineFile);
+      auto entry = readSpineEntry(spineIn);
       std::string path = FsHelpers::normalisePath(entry.href);
 
       ZipFile::SizeTarget t;
@@ -217,10 +239,10 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
   }
 
   uint32_t cumSize = 0;
-  spineFile.seek(0);
+  spineIn.seek(0);
   int lastSpineTocIndex = -1;
   for (int i = 0; i < spineCount; i++) {
-    auto spineEntry = readSpineEntry(spineFile);
+    auto spineEntry = readSpineEntry(spineIn);
 
     spineEntry.tocIndex = spineToTocIndex[i];
 
@@ -253,23 +275,29 @@ bool BookMetadataCache::buildBookBin(const std::string& epubPath, const BookMeta
     spineEntry.cumulativeSize = cumSize;
 
     // Write out spine data to book.bin
-    writeSpineEntry(bookFile, spineEntry);
+    writeSpineEntry(bookWriter, spineEntry);
   }
   // Close opened zip file
   zip.close();
 
   // Loop through toc entries from toc file writing to book.bin
-  tocFile.seek(0);
+  tocIn.seek(0);
   for (int i = 0; i < tocCount; i++) {
-    auto tocEntry = readTocEntry(tocFile);
-    writeTocEntry(bookFile, tocEntry);
+    auto tocEntry = readTocEntry(tocIn);
+    writeTocEntry(bookWriter, tocEntry);
   }
 
+  const bool writeOk = bookWriter.flush();
   bookFile.close();
   spineFile.close();
   tocFile.close();
 
-  LOG_DBG("BMC", "Successfully built book.bin");
+  if (!writeOk || !spineIn.ok() || !tocIn.ok()) {
+    LOG_ERR("BMC", "Failed to build book.bin");
+    return false;
+  }
+
+  LOG_DBG("BMC", "Successfully built book.bin (%lu SD writes)", bookWriter.getWriteCalls());
   return true;
 }
 
@@ -285,40 +313,40 @@ bool BookMetadataCache::cleanupTmpFiles() const {
   return true;
 }
 
-uint32_t BookMetadataCache::writeSpineEntry(FsFile& file, const SpineEntry& entry) const {
-  const uint32_t pos = file.position();
-  serialization::writeString(file, entry.href);
-  serialization::writePod(file, entry.cumulativeSize);
-  serialization::writePod(file, entry.tocIndex);
+uint32_t BookMetadataCache::writeSpineEntry(serialization::BufferedWriter& writer, const SpineEntry& entry) const {
+  const uint32_t pos = writer.position();
+  serialization::writeString(writer, entry.href);
+  serialization::writePod(writer, entry.cumulativeSize);
+  serialization::writePod(writer, entry.tocIndex);
   return pos;
 }
 
-uint32_t BookMetadataCache::writeTocEntry(FsFile& file, const TocEntry& entry) const {
-  const uint32_t pos = file.position();
-  serialization::writeString(file, entry.title);
-  serialization::writeString(file, entry.href);
-  serialization::writeString(file, entry.anchor);
-  serialization::writePod(file, entry.level);
-  serialization::writePod(file, entry.spineIndex);
+uint32_t BookMetadataCache::writeTocEntry(serialization::BufferedWriter& writer, const TocEntry& entry) const {
+  const uint32_t pos = writer.position();
+  serialization::writeString(writer, entry.title);
+  serialization::writeString(writer, entry.href);
+  serialization::writeString(writer, entry.anchor);
+  serialization::writePod(writer, entry.level);
+  serialization::writePod(writer, entry.spineIndex);
   return pos;
 }
 
 // Note: for the LUT to be accurate, this **MUST** be called for all spine items before `addTocEntry` is ever called
 // this is because in this function we're marking positions of the items
 void BookMetadataCache::createSpineEntry(const std::string& href) {
-  if (!buildMode || !spineFile) {
+  if (!buildMode || !spineWriter) {
     LOG_DBG("BMC", "createSpineEntry called but not in build mode");
     return;
   }
 
   const SpineEntry entry(href, 0, -1);
-  writeSpineEntry(spineFile, entry);
+  writeSpineEntry(*spineWriter, entry);
   spineCount++;
 }
 
 void BookMetadataCache::createTocEntry(const std::string& title, const std::string& href, const std::string& anchor,
                                        const uint8_t level) {
-  if (!buildMode || !tocFile || !spineFile) {
+  if (!buildMode || !tocWriter || !spineReader) {
     LOG_DBG("BMC", "createTocEntry called but not in build mode");
     return;
   }
@@ -344,9 +372,9 @@ void BookMetadataCache::createTocEntry(const std::string& title, const std::stri
       LOG_DBG("BMC", "createTocEntry: Could not find spine item for TOC href %s", href.c_str());
     }
   } else {
-    spineFile.seek(0);
+    spineReader->seek(0);
     for (int i = 0; i < spineCount; i++) {
-      auto spineEntry = readSpineEntry(spineFile);
+      auto spineEntry = readSpineEntry(*spineReader);
       if (spineEntry.href == href) {
         spineIndex = static_cast<int16_t>(i);
         break;
@@ -358,7 +386,7 @@ void BookMetadataCache::createTocEntry(const std::string& title, const std::stri
   }
 
   const TocEntry entry(title, href, anchor, level, spineIndex);
-  writeTocEntry(tocFile, entry);
+  writeTocEntry(*tocWriter, entry);
   tocCount++;
 }
 
@@ -368,24 +396,33 @@ bool BookMetadataCache::load() {
   if (!Storage.openFileForRead("BMC", cachePath + bookBinFile, bookFile)) {
     return false;
   }
+  bookReader.reset(new serialization::BufferedReader(bookFile));
 
   uint8_t version;
-  serialization::readPod(bookFile, version);
+  serialization::readPod(*bookReader, version);
   if (version != BOOK_CACHE_VERSION) {
     LOG_DBG("BMC", "Cache version mismatch: expected %d, got %d", BOOK_CACHE_VERSION, version);
+    bookReader.reset();
     bookFile.close();
     return false;
   }
 
-  serialization::readPod(bookFile, lutOffset);
-  serialization::readPod(bookFile, spineCount);
-  serialization::readPod(bookFile, tocCount);
+  serialization::readPod(*bookReader, lutOffset);
+  serialization::readPod(*bookReader, spineCount);
+  serialization::readPod(*bookReader, tocCount);
 
-  serialization::readString(bookFile, coreMetadata.title);
-  serialization::readString(bookFile, coreMetadata.author);
-  serialization::readString(bookFile, coreMetadata.language);
-  serialization::readString(bookFile, coreMetadata.coverItemHref);
-  serialization::readString(bookFile, coreMetadata.textReferenceHref);
+  serialization::readString(*bookReader, coreMetadata.title);
+  serialization::readString(*bookReader, coreMetadata.author);
+  serialization::readString(*bookReader, coreMetadata.language);
+  serialization::readString(*bookReader, coreMetadata.coverItemHref);
+  serialization::readString(*bookReader, coreMetadata.textReferenceHref);
+
+  if (!bookReader->ok()) {
+    LOG_ERR("BMC", "Cache file truncated");
+    bookReader.reset();
+    bookFile.close();
+    return false;
+  }
 
   loaded = true;
   LOG_DBG("BMC", "Loaded cache data: %d spine, %d TOC entries", spineCount, tocCount);
@@ -404,11 +441,17 @@ BookMetadataCache::SpineEntry BookMetadataCache::getSpineEntry(const int index)
   }
 
   // Seek to spine LUT item, read from LUT and get out data
-  bookFile.seek(lutOffset + sizeof(uint32_t) * index);
+  bookReader->seek(lutOffset + sizeof(uint32_t) * index);
   uint32_t spineEntryPos;
-  serialization::readPod(bookFile, spineEntryPos);
-  bookFile.seek(spineEntryPos);
-  return readSpineEntry(bookFile);
+  serialization::readPod(*bookReader, spineEntryPos);
+  bookReader->seek(spineEntryPos);
+  auto entry = readSpineEntry(*bookReader);
+  if (!bookReader->ok()) {
+    LOG_ERR("BMC", "Failed to read spine entry %d", index);
+    bookReader.reset(new serialization::BufferedReader(bookFile));  // clear error state for later lookups
+    return {};
+  }
+  return entry;
 }
 
 BookMetadataCache::TocEntry BookMetadataCache::getTocEntry(const int index) {
@@ -423,27 +466,60 @@ BookMetadataCache::TocEntry BookMetadataCache::getTocEntry(const int index) {
   }
 
   // Seek to TOC LUT item, read from LUT and get out data
-  bookFile.seek(lutOffset + sizeof(uint32_t) * spineCount + sizeof(uint32_t) * index);
+  bookReader->seek(lutOffset + sizeof(uint32_t) * spineCount + sizeof(uint32_t) * index);
   uint32_t tocEntryPos;
-  serialization::readPod(bookFile, tocEntryPos);
-  bookFile.seek(tocEntryPos);
-  return readTocEntry(bookFile);
+  serialization::readPod(*bookReader, tocEntryPos);
+  bookReader->seek(tocEntryPos);
+  auto entry = readTocEntry(*bookReader);
+  if (!bookReader->ok()) {
+    LOG_ERR("BMC", "Failed to read TOC entry %d", index);
+    bookReader.reset(new serialization::BufferedReader(bookFile));  // clear error state for later lookups
+    return {};
+  }
+  return entry;
+}
+
+bool BookMetadataCache::getTocEntries(const int first, const int count, std::vector<TocEntry>& out) {
+  if (!loaded) {
+    LOG_ERR("BMC", "getTocEntries called but cache not loaded");
+    return false;
+  }
+
+  if (first < 0 || count < 0 || first + count > static_cast<int>(tocCount)) {
+    LOG_ERR("BMC", "getTocEntries range %d+%d out of range", first, count);
+    return false;
+  }
+
+  std::vector<uint32_t> positions(count);
+  bookReader->seek(lutOffset + sizeof(uint32_t) * spineCount + sizeof(uint32_t) * first);
+  bookReader->read(positions.data(), count * sizeof(uint32_t));
+  out.reserve(out.size() + count);
+  for (const uint32_t position : positions) {
+    bookReader->seek(position);
+    out.push_back(readTocEntry(*bookReader));
+  }
+  if (!bookReader->ok()) {
+    LOG_ERR("BMC", "Failed to read TOC entries %d+%d", first, count);
+    bookReader.reset(new serialization::BufferedReader(bookFile));  // clear error state for later lookups
+    return false;
+  }
+  return true;
 }
 
-BookMetadataCache::SpineEntry BookMetadataCache::readSpineEntry(FsFile& file) const {
+BookMetadataCache::SpineEntry BookMetadataCache::readSpineEntry(serialization::BufferedReader& reader) const {
   SpineEntry entry;
-  serialization::readString(file, entry.href);
-  serialization::readPod(file, entry.cumulativeSize);
-  serialization::readPod(file, entry.tocIndex);
+  serialization::readString(reader, entry.href);
+  serialization::readPod(reader, entry.cumulativeSize);
+  serialization::readPod(reader, entry.tocIndex);
   return entry;
 }
 
-BookMetadataCache::TocEntry BookMetadataCache::readTocEntry(FsFile& file) const {
+BookMetadataCache::TocEntry BookMetadataCache::readTocEntry(serialization::BufferedReader& reader) const {
   TocEntry entry;
-  serialization::readString(file, entry.title);
-  serialization::readString(file, entry.href);
-  serialization::readString(file, entry.anchor);
-  serialization::readPod(file, entry.level);
-  serialization::readPod(file, entry.spineIndex);
+  serialization::readString(reader, entry.title);
+  serialization::readString(reader, entry.href);
+  serialization::readString(reader, entry.anchor);
+  serialization::readPod(reader, entry.level);
+  serialization::readPod(reader, entry.spineIndex);
   return entry;
 }
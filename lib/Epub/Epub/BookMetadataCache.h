@@ -1,8 +1,10 @@
 #pragma once
 
+#include <BufferedIO.h>
 #include <HalStorage.h>
 
 #include <algorithm>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -54,6 +56,11 @@ class BookMetadataCache {
   // Temp file handles during build
   FsFile spineFile;
   FsFile tocFile;
+  // Buffered views over the files above; entries are small and written/read field by field
+  std::unique_ptr<serialization::BufferedWriter> spineWriter;
+  std::unique_ptr<serialization::BufferedWriter> tocWriter;
+  std::unique_ptr<serialization::BufferedReader> spineReader;
+  std::unique_ptr<serialization::BufferedReader> bookReader;
 
   // Index for fast href→spineIndex lookup (used only for large EPUBs)
   struct SpineHrefIndexEntry {
@@ -76,10 +83,10 @@ class BookMetadataCache {
     return hash;
   }
 
-  uint32_t writeSpineEntry(FsFile& file, const SpineEntry& entry) const;
-  uint32_t writeTocEntry(FsFile& file, const TocEntry& entry) const;
-  SpineEntry readSpineEntry(FsFile& file) const;
-  TocEntry readTocEntry(FsFile& file) const;
+  uint32_t writeSpineEntry(serialization::BufferedWriter& writer, const SpineEntry& entry) const;
+  uint32_t writeTocEntry(serialization::BufferedWriter& writer, const TocEntry& entry) const;
+  SpineEntry readSpineEntry(serialization::BufferedReader& reader) const;
+  TocEntry readTocEntry(serialization::BufferedReader& reader) const;
 
  public:
   BookMetadata coreMetadata;
@@ -106,6 +113,8 @@ class BookMetadataCache {
   bool load();
   SpineEntry getSpineEntry(int index);
   TocEntry getTocEntry(int index);
+  // Appends entries [first, first + count): one read of their LUT slots, then the entries in order
+  bool getTocEntries(int first, int count, std::vector<TocEntry>& out);
   int getSpineCount() const { return spineCount; }
   int getTocCount() const { return tocCount; }
   bool isLoaded() const { return loaded; }
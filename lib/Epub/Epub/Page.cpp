@@ -1,27 +1,31 @@
 #include "Page.h"
 
 #include <Logging.h>
+#include <PerfTrace.h>
 #include <Serialization.h>
 
 void PageLine::render(GfxRenderer& renderer, const int fontId, const int xOffset, const int yOffset) {
   block->render(renderer, fontId, xPos + xOffset, yPos + yOffset);
 }
 
-bool PageLine::serialize(FsFile& file) {
-  serialization::writePod(file, xPos);
-  serialization::writePod(file, yPos);
+bool PageLine::serialize(serialization::BufferedWriter& writer) {
+  serialization::writePod(writer, xPos);
+  serialization::writePod(writer, yPos);
 
   // serialize TextBlock pointed to by PageLine
-  return block->serialize(file);
+  return block->serialize(writer);
 }
 
-std::unique_ptr<PageLine> PageLine::deserialize(FsFile& file) {
+std::unique_ptr<PageLine> PageLine::deserialize(serialization::BufferedReader& reader) {
   int16_t xPos;
   int16_t yPos;
-  serialization::readPod(file, xPos);
-  serialization::readPod(file, yPos);
+  serialization::readPod(reader, xPos);
+  serialization::readPod(reader, yPos);
 
-  auto tb = TextBlock::deserialize(file);
+  auto tb = TextBlock::deserialize(reader);
+  if (!tb) {
+    return nullptr;
+  }
   return std::unique_ptr<PageLine>(new PageLine(std::move(tb), xPos, yPos));
 }
 
@@ -30,73 +34,85 @@ void PageImage::render(GfxRenderer& renderer, const int fontId, const int xOffse
   imageBlock->render(renderer, xPos + xOffset, yPos + yOffset);
 }
 
-bool PageImage::serialize(FsFile& file) {
-  serialization::writePod(file, xPos);
-  serialization::writePod(file, yPos);
+bool PageImage::serialize(serialization::BufferedWriter& writer) {
+  serialization::writePod(writer, xPos);
+  serialization::writePod(writer, yPos);
 
   // serialize ImageBlock
-  return imageBlock->serialize(file);
+  return imageBlock->serialize(writer);
 }
 
-std::unique_ptr<PageImage> PageImage::deserialize(FsFile& file) {
+std::unique_ptr<PageImage> PageImage::deserialize(serialization::BufferedReader& reader) {
   int16_t xPos;
   int16_t yPos;
-  serialization::readPod(file, xPos);
-  serialization::readPod(file, yPos);
+  serialization::readPod(reader, xPos);
+  serialization::readPod(reader, yPos);
 
-  auto ib = ImageBlock::deserialize(file);
+  auto ib = ImageBlock::deserialize(reader);
+  if (!ib) {
+    return nullptr;
+  }
   return std::unique_ptr<PageImage>(new PageImage(std::move(ib), xPos, yPos));
 }
 
 void Page::render(GfxRenderer& renderer, const int fontId, const int xOffset, const int yOffset) const {
+  PERF_SCOPE(RENDER_PASS);
   for (auto& element : elements) {
     element->render(renderer, fontId, xOffset, yOffset);
   }
 }
 
-bool Page::serialize(FsFile& file) const {
+bool Page::serialize(serialization::BufferedWriter& writer) const {
   const uint16_t count = elements.size();
-  serialization::writePod(file, count);
+  serialization::writePod(writer, count);
 
   for (const auto& el : elements) {
     // Use getTag() method to determine type
-    serialization::writePod(file, static_cast<uint8_t>(el->getTag()));
+    serialization::writePod(writer, static_cast<uint8_t>(el->getTag()));
 
-    if (!el->serialize(file)) {
+    if (!el->serialize(writer)) {
       return false;
     }
   }
 
   // Serialize footnotes (clamp to MAX_FOOTNOTES_PER_PAGE to match addFootnote/deserialize limits)
   const uint16_t fnCount = std::min<uint16_t>(footnotes.size(), MAX_FOOTNOTES_PER_PAGE);
-  serialization::writePod(file, fnCount);
+  serialization::writePod(writer, fnCount);
   for (uint16_t i = 0; i < fnCount; i++) {
     const auto& fn = footnotes[i];
-    if (file.write(fn.number, sizeof(fn.number)) != sizeof(fn.number) ||
-        file.write(fn.href, sizeof(fn.href)) != sizeof(fn.href)) {
+    if (!writer.write(fn.number, sizeof(fn.number)) || !writer.write(fn.href, sizeof(fn.href))) {
       LOG_ERR("PGE", "Failed to write footnote");
       return false;
     }
   }
 
-  return true;
+  return !writer.hasError();
 }
 
-std::unique_ptr<Page> Page::deserialize(FsFile& file) {
+std::unique_ptr<Page> Page::deserialize(serialization::BufferedReader& reader) {
   auto page = std::unique_ptr<Page>(new Page());
 
   uint16_t count;
-  serialization::readPod(file, count);
+  if (!serialization::readPod(reader, count)) {
+    LOG_ERR("PGE", "Deserialization failed: truncated page");
+    return nullptr;
+  }
 
   for (uint16_t i = 0; i < count; i++) {
     uint8_t tag;
-    serialization::readPod(file, tag);
+    serialization::readPod(reader, tag);
 
     if (tag == TAG_PageLine) {
-      auto pl = PageLine::deserialize(file);
+      auto pl = PageLine::deserialize(reader);
+      if (!pl) {
+        return nullptr;
+      }
       page->elements.push_back(std::move(pl));
     } else if (tag == TAG_PageImage) {
-      auto pi = PageImage::deserialize(file);
+      auto pi = PageImage::deserialize(reader);
+      if (!pi) {
+        return nullptr;
+      }
       page->elements.push_back(std::move(pi));
     } else {
       LOG_ERR("PGE", "Deserialization failed: Unknown tag %u", tag);
@@ -106,7 +122,7 @@ std::unique_ptr<Page> Page::deserialize(FsFile& file) {
 
   // Deserialize footnotes
   uint16_t fnCount;
-  serialization::readPod(file, fnCount);
+  serialization::readPod(reader, fnCount);
   if (fnCount > MAX_FOOTNOTES_PER_PAGE) {
     LOG_ERR("PGE", "Invalid footnote count %u", fnCount);
     return nullptr;
@@ -114,8 +130,7 @@ std::unique_ptr<Page> Page::deserialize(FsFile& file) {
   page->footnotes.resize(fnCount);
   for (uint16_t i = 0; i < fnCount; i++) {
     auto& entry = page->footnotes[i];
-    if (file.read(entry.number, sizeof(entry.number)) != sizeof(entry.number) ||
-        file.read(entry.href, sizeof(entry.href)) != sizeof(entry.href)) {
+    if (!reader.read(entry.number, sizeof(entry.number)) || !reader.read(entry.href, sizeof(entry.href))) {
       LOG_ERR("PGE", "Failed to read footnote %u", i);
       return nullptr;
     }
@@ -123,5 +138,10 @@ std::unique_ptr<Page> Page::deserialize(FsFile& file) {
     entry.href[sizeof(entry.href) - 1] = '\0';
   }
 
+  if (!reader.ok()) {
+    LOG_ERR("PGE", "Deserialization failed: read past end of section file");
+    return nullptr;
+  }
+
   return page;
 }
@@ -1,4 +1,5 @@
 #pragma once
+#include <BufferedIO.h>
 #include <HalStorage.h>
 
 #include <algorithm>
@@ -22,7 +23,7 @@ class PageElement {
   explicit PageElement(const int16_t xPos, const int16_t yPos) : xPos(xPos), yPos(yPos) {}
   virtual ~PageElement() = default;
   virtual void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) = 0;
-  virtual bool serialize(FsFile& file) = 0;
+  virtual bool serialize(serialization::BufferedWriter& writer) = 0;
   virtual PageElementTag getTag() const = 0;  // Add type identification
 };
 
@@ -35,9 +36,9 @@ class PageLine final : public PageElement {
       : PageElement(xPos, yPos), block(std::move(block)) {}
   const std::shared_ptr<TextBlock>& getBlock() const { return block; }
   void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) override;
-  bool serialize(FsFile& file) override;
+  bool serialize(serialization::BufferedWriter& writer) override;
   PageElementTag getTag() const override { return TAG_PageLine; }
-  static std::unique_ptr<PageLine> deserialize(FsFile& file);
+  static std::unique_ptr<PageLine> deserialize(serialization::BufferedReader& reader);
 };
 
 // New PageImage class
@@ -48,9 +49,9 @@ class PageImage final : public PageElement {
   PageImage(std::shared_ptr<ImageBlock> block, const int16_t xPos, const int16_t yPos)
       : PageElement(xPos, yPos), imageBlock(std::move(block)) {}
   void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) override;
-  bool serialize(FsFile& file) override;
+  bool serialize(serialization::BufferedWriter& writer) override;
   PageElementTag getTag() const override { return TAG_PageImage; }
-  static std::unique_ptr<PageImage> deserialize(FsFile& file);
+  static std::unique_ptr<PageImage> deserialize(serialization::BufferedReader& reader);
   const ImageBlock& getImageBlock() const { return *imageBlock; }
 };
 
@@ -72,8 +73,8 @@ class Page {
   }
 
   void render(GfxRenderer& renderer, int fontId, int xOffset, int yOffset) const;
-  bool serialize(FsFile& file) const;
-  static std::unique_ptr<Page> deserialize(FsFile& file);
+  bool serialize(serialization::BufferedWriter& writer) const;
+  static std::unique_ptr<Page> deserialize(serialization::BufferedReader& reader);
 
   // Check if page contains any images (used to force full refresh)
   bool hasImages() const {
@@ -0,0 +1,116 @@
+#include "PageIndex.h"
+
+#include <HalStorage.h>
+#include <Logging.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "Epub.h"
+
+namespace {
+std::string layoutDir(const std::string& cachePath, const uint32_t layout) {
+  return cachePath + "/sections/" + Epub::getSectionLayoutName(layout);
+}
+}  // namespace
+
+void PageIndex::record(const std::string& cachePath, const uint32_t layout, const int spineCount,
+                       const int spineIndex, const uint16_t pageCount) {
+  if (spineIndex < 0 || spineIndex >= spineCount) {
+    return;
+  }
+  const std::string dir = layoutDir(cachePath, layout);
+  const std::string path = dir + "/pages.bin";
+  FsFile f = Storage.open(path.c_str(), O_RDWR | O_CREAT);
+  if (!f) {
+    // Packed sections leave no directory for the layout
+    Storage.mkdir(dir.c_str());
+    f = Storage.open(path.c_str(), O_RDWR | O_CREAT);
+    if (!f) {
+      LOG_ERR("PGI", "Failed to open %s", path.c_str());
+      return;
+    }
+  }
+
+  const uint32_t tableSize = spineCount * sizeof(uint16_t);
+  uint16_t stored = UNKNOWN;
+  if (f.size() != tableSize) {
+    // New table, or one left from before the spine changed
+    uint8_t fill[64];
+    memset(fill, 0xFF, sizeof(fill));
+    f.truncate(0);
+    for (uint32_t written = 0; written < tableSize;) {
+      const uint32_t len = std::min<uint32_t>(sizeof(fill), tableSize - written);
+      if (f.write(fill, len) != len) {
+        break;
+      }
+      written += len;
+    }
+  } else if (f.seek(spineIndex * sizeof(uint16_t))) {
+    f.read(&stored, sizeof(stored));
+  }
+
+  if (stored != pageCount && f.seek(spineIndex * sizeof(uint16_t))) {
+    f.write(reinterpret_cast<const uint8_t*>(&pageCount), sizeof(pageCount));
+  }
+  f.close();
+}
+
+void PageIndex::clear() {
+  firstPages.clear();
+  firstMissing = 0;
+}
+
+bool PageIndex::load(const std::string& cachePath, const uint32_t layout, const int spineCount) {
+  clear();
+  const std::string path = layoutDir(cachePath, layout) + "/pages.bin";
+  FsFile f;
+  if (spineCount <= 0 || !Storage.exists(path.c_str()) || !Storage.openFileForRead("PGI", path, f)) {
+    return false;
+  }
+  std::vector<uint16_t> pages(spineCount);
+  const int tableSize = spineCount * sizeof(uint16_t);
+  const bool ok = f.size() == static_cast<size_t>(tableSize) &&
+                  f.read(reinterpret_cast<uint8_t*>(pages.data()), tableSize) == tableSize;
+  f.close();
+  if (!ok) {
+    return false;
+  }
+
+  firstMissing = -1;
+  firstPages.resize(spineCount + 1, 0);
+  for (int i = 0; i < spineCount; i++) {
+    if (pages[i] == UNKNOWN && firstMissing < 0) {
+      firstMissing = i;
+    }
+    firstPages[i + 1] = firstPages[i] + (pages[i] == UNKNOWN ? 0 : pages[i]);
+  }
+  return true;
+}
+
+int PageIndex::getFirstPage(const int spineIndex) const {
+  if (spineIndex < 0 || spineIndex + 1 >= static_cast<int>(firstPages.size())) {
+    return 0;
+  }
+  return static_cast<int>(firstPages[spineIndex]);
+}
+
+int PageIndex::getPageCount(const int spineIndex) const {
+  if (spineIndex < 0 || spineIndex + 1 >= static_cast<int>(firstPages.size())) {
+    return 0;
+  }
+  return static_cast<int>(firstPages[spineIndex + 1] - firstPages[spineIndex]);
+}
+
+void PageIndex::locate(const int globalPage, int& spineIndex, int& page) const {
+  spineIndex = 0;
+  page = 0;
+  if (firstPages.size() < 2 || firstPages.back() == 0) {
+    return;
+  }
+  const uint32_t target = std::min<uint32_t>(std::max(0, globalPage), firstPages.back() - 1);
+  // Last spine item starting at or before target; items without pages share their start with the next one
+  const auto it = std::upper_bound(firstPages.begin(), firstPages.end() - 1, target);
+  spineIndex = static_cast<int>(it - firstPages.begin()) - 1;
+  page = static_cast<int>(target - firstPages[spineIndex]);
+}
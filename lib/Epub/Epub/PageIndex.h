@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Page count of every spine item for one section layout, stored next to that layout's sections as pages.bin (one u16
+ * per spine item, UNKNOWN until the item has been laid out). A section records its count whenever it is built or
+ * loaded; once every item has one, page numbers and percentages are exact across the whole book.
+ */
+class PageIndex {
+  std::vector<uint32_t> firstPages;  // global index of each spine item's first page, plus the total at the end
+  int firstMissing = 0;              // first spine item without a count; -1 once complete
+
+ public:
+  static constexpr uint16_t UNKNOWN = UINT16_MAX;
+
+  // Store the page count of one spine item; spineCount sizes a new table
+  static void record(const std::string& cachePath, uint32_t layout, int spineCount, int spineIndex,
+                     uint16_t pageCount);
+
+  // Read the table of layout; false if there is none for a book of spineCount items
+  bool load(const std::string& cachePath, uint32_t layout, int spineCount);
+  void clear();
+
+  bool isComplete() const { return firstMissing < 0; }
+  int getFirstMissing() const { return firstMissing; }
+
+  // Only meaningful once complete
+  int getTotalPages() const { return firstPages.empty() ? 0 : static_cast<int>(firstPages.back()); }
+  int getFirstPage(int spineIndex) const;
+  int getPageCount(int spineIndex) const;
+  // Spine item and page within it holding the book page globalPage
+  void locate(int globalPage, int& spineIndex, int& page) const;
+};
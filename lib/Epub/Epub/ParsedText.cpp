@@ -1,6 +1,7 @@
 #include "ParsedText.h"
 
 #include <GfxRenderer.h>
+#include <PerfTrace.h>
 #include <Utf8.h>
 
 #include <algorithm>
@@ -93,6 +94,7 @@ void ParsedText::addWord(std::string word, const EpdFontFamily::Style fontStyle,
 void ParsedText::layoutAndExtractLines(const GfxRenderer& renderer, const int fontId, const uint16_t viewportWidth,
                                        const std::function<void(std::shared_ptr<TextBlock>)>& processLine,
                                        const bool includeLastLine) {
+  PERF_SCOPE(LAYOUT);
   if (words.empty()) {
     return;
   }
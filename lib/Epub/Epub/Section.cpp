@@ -1,29 +1,75 @@
 #include "Section.h"
 
 #include <HalStorage.h>
+#include <HeapTrace.h>
 #include <Logging.h>
+#include <PerfTrace.h>
 #include <Serialization.h>
 
 #include "Epub/css/CssParser.h"
 #include "Page.h"
+#include "PageIndex.h"
 #include "hyphenation/Hyphenator.h"
 #include "parsers/ChapterHtmlSlimParser.h"
 
 namespace {
-constexpr uint8_t SECTION_FILE_VERSION = 18;
+constexpr uint8_t SECTION_FILE_VERSION = 20;
 constexpr uint32_t HEADER_SIZE = sizeof(uint8_t) + sizeof(int) + sizeof(float) + sizeof(bool) + sizeof(uint8_t) +
                                  sizeof(uint16_t) + sizeof(uint16_t) + sizeof(uint16_t) + sizeof(bool) + sizeof(bool) +
                                  sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint32_t);
+
+// FNV-1a
+void hashBytes(uint32_t& hash, const void* data, const size_t size) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+}
 }  // namespace
 
-uint32_t Section::onPageComplete(std::unique_ptr<Page> page) {
+void Section::selectLayout(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
+                           const uint8_t paragraphAlignment, const uint16_t viewportWidth,
+                           const uint16_t viewportHeight, const bool hyphenationEnabled, const bool embeddedStyle,
+                           const uint8_t imageRendering) {
+  // Everything the header is checked against, so each layout gets its own files
+  layout = 2166136261u;
+  hashBytes(layout, &SECTION_FILE_VERSION, sizeof(SECTION_FILE_VERSION));
+  hashBytes(layout, &fontId, sizeof(fontId));
+  hashBytes(layout, &lineCompression, sizeof(lineCompression));
+  hashBytes(layout, &extraParagraphSpacing, sizeof(extraParagraphSpacing));
+  hashBytes(layout, &paragraphAlignment, sizeof(paragraphAlignment));
+  hashBytes(layout, &viewportWidth, sizeof(viewportWidth));
+  hashBytes(layout, &viewportHeight, sizeof(viewportHeight));
+  hashBytes(layout, &hyphenationEnabled, sizeof(hyphenationEnabled));
+  hashBytes(layout, &embeddedStyle, sizeof(embeddedStyle));
+  hashBytes(layout, &imageRendering, sizeof(imageRendering));
+
+  const std::string name = Epub::getSectionLayoutName(layout) + "/" + std::to_string(spineIndex);
+  filePath = epub->getCachePath() + "/sections/" + name + ".bin";
+  packEntry = "section/" + name;
+}
+
+bool Section::openForRead(FsFile& f, uint32_t& base, uint32_t& size) const {
+  if (PackFile* pack = epub->getPack()) {
+    return pack->openEntry(packEntry, f, base, size);
+  }
+  if (!Storage.openFileForRead("SCT", filePath, f)) {
+    return false;
+  }
+  base = 0;
+  size = f.size();
+  return true;
+}
+
+uint32_t Section::onPageComplete(serialization::BufferedWriter& writer, std::unique_ptr<Page> page) {
+  PERF_SCOPE(SERIALIZE);
   if (!file) {
     LOG_ERR("SCT", "File not open for writing page %d", pageCount);
     return 0;
   }
 
-  const uint32_t position = file.position();
-  if (!page->serialize(file)) {
+  const uint32_t position = writer.position();
+  if (!page->serialize(writer)) {
     LOG_ERR("SCT", "Failed to serialize page %d", pageCount);
     return 0;
   }
@@ -33,7 +79,8 @@ uint32_t Section::onPageComplete(std::unique_ptr<Page> page) {
   return position;
 }
 
-void Section::writeSectionFileHeader(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
+void Section::writeSectionFileHeader(serialization::BufferedWriter& writer, const int fontId,
+                                     const float lineCompression, const bool extraParagraphSpacing,
                                      const uint8_t paragraphAlignment, const uint16_t viewportWidth,
                                      const uint16_t viewportHeight, const bool hyphenationEnabled,
                                      const bool embeddedStyle, const uint8_t imageRendering) {
@@ -46,33 +93,37 @@ void Section::writeSectionFileHeader(const int fontId, const float lineCompressi
                                    sizeof(viewportHeight) + sizeof(pageCount) + sizeof(hyphenationEnabled) +
                                    sizeof(embeddedStyle) + sizeof(imageRendering) + sizeof(uint32_t) + sizeof(uint32_t),
                 "Header size mismatch");
-  serialization::writePod(file, SECTION_FILE_VERSION);
-  serialization::writePod(file, fontId);
-  serialization::writePod(file, lineCompression);
-  serialization::writePod(file, extraParagraphSpacing);
-  serialization::writePod(file, paragraphAlignment);
-  serialization::writePod(file, viewportWidth);
-  serialization::writePod(file, viewportHeight);
-  serialization::writePod(file, hyphenationEnabled);
-  serialization::writePod(file, embeddedStyle);
-  serialization::writePod(file, imageRendering);
-  serialization::writePod(file, pageCount);  // Placeholder for page count (will be initially 0, patched later)
-  serialization::writePod(file, static_cast<uint32_t>(0));  // Placeholder for LUT offset (patched later)
-  serialization::writePod(file, static_cast<uint32_t>(0));  // Placeholder for anchor map offset (patched later)
+  serialization::writePod(writer, SECTION_FILE_VERSION);
+  serialization::writePod(writer, fontId);
+  serialization::writePod(writer, lineCompression);
+  serialization::writePod(writer, extraParagraphSpacing);
+  serialization::writePod(writer, paragraphAlignment);
+  serialization::writePod(writer, viewportWidth);
+  serialization::writePod(writer, viewportHeight);
+  serialization::writePod(writer, hyphenationEnabled);
+  serialization::writePod(writer, embeddedStyle);
+  serialization::writePod(writer, imageRendering);
+  serialization::writePod(writer, pageCount);  // Placeholder for page count (will be initially 0, patched later)
+  serialization::writePod(writer, static_cast<uint32_t>(0));  // Placeholder for LUT offset (patched later)
+  serialization::writePod(writer, static_cast<uint32_t>(0));  // Placeholder for anchor map offset (patched later)
 }
 
 bool Section::loadSectionFile(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
                               const uint8_t paragraphAlignment, const uint16_t viewportWidth,
                               const uint16_t viewportHeight, const bool hyphenationEnabled, const bool embeddedStyle,
                               const uint8_t imageRendering) {
-  if (!Storage.openFileForRead("SCT", filePath, file)) {
+  selectLayout(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth, viewportHeight,
+               hyphenationEnabled, embeddedStyle, imageRendering);
+  uint32_t base, size;
+  if (!openForRead(file, base, size)) {
     return false;
   }
 
   // Match parameters
+  serialization::BufferedReader reader(file, base, size);
   {
     uint8_t version;
-    serialization::readPod(file, version);
+    serialization::readPod(reader, version);
     if (version != SECTION_FILE_VERSION) {
       file.close();
       LOG_ERR("SCT", "Deserialization failed: Unknown version %u", version);
@@ -88,15 +139,21 @@ bool Section::loadSectionFile(const int fontId, const float lineCompression, con
     bool fileHyphenationEnabled;
     bool fileEmbeddedStyle;
     uint8_t fileImageRendering;
-    serialization::readPod(file, fileFontId);
-    serialization::readPod(file, fileLineCompression);
-    serialization::readPod(file, fileExtraParagraphSpacing);
-    serialization::readPod(file, fileParagraphAlignment);
-    serialization::readPod(file, fileViewportWidth);
-    serialization::readPod(file, fileViewportHeight);
-    serialization::readPod(file, fileHyphenationEnabled);
-    serialization::readPod(file, fileEmbeddedStyle);
-    serialization::readPod(file, fileImageRendering);
+    serialization::readPod(reader, fileFontId);
+    serialization::readPod(reader, fileLineCompression);
+    serialization::readPod(reader, fileExtraParagraphSpacing);
+    serialization::readPod(reader, fileParagraphAlignment);
+    serialization::readPod(reader, fileViewportWidth);
+    serialization::readPod(reader, fileViewportHeight);
+    serialization::readPod(reader, fileHyphenationEnabled);
+    serialization::readPod(reader, fileEmbeddedStyle);
+    serialization::readPod(reader, fileImageRendering);
+    if (!reader.ok()) {
+      file.close();
+      LOG_ERR("SCT", "Deserialization failed: Truncated header");
+      clearCache();
+      return false;
+    }
 
     if (fontId != fileFontId || lineCompression != fileLineCompression ||
         extraParagraphSpacing != fileExtraParagraphSpacing || paragraphAlignment != fileParagraphAlignment ||
@@ -110,14 +167,22 @@ bool Section::loadSectionFile(const int fontId, const float lineCompression, con
     }
   }
 
-  serialization::readPod(file, pageCount);
+  serialization::readPod(reader, pageCount);
   file.close();
+  epub->useSectionLayout(layout);
+  PageIndex::record(epub->getCachePath(), layout, epub->getSpineItemsCount(), spineIndex, pageCount);
   LOG_DBG("SCT", "Deserialization succeeded: %d pages", pageCount);
   return true;
 }
 
 // Your updated class method (assuming you are using the 'SD' object, which is a wrapper for a specific filesystem)
 bool Section::clearCache() const {
+  if (PackFile* pack = epub->getPack()) {
+    // The dead record is reclaimed when the pack is compacted
+    pack->remove(packEntry);
+    return true;
+  }
+
   if (!Storage.exists(filePath.c_str())) {
     LOG_DBG("SCT", "Cache does not exist, no action needed");
     return true;
@@ -135,14 +200,21 @@ bool Section::clearCache() const {
 bool Section::createSectionFile(const int fontId, const float lineCompression, const bool extraParagraphSpacing,
                                 const uint8_t paragraphAlignment, const uint16_t viewportWidth,
                                 const uint16_t viewportHeight, const bool hyphenationEnabled, const bool embeddedStyle,
-                                const uint8_t imageRendering, const std::function<void()>& popupFn) {
+                                const uint8_t imageRendering, const std::function<void()>& popupFn,
+                                const std::function<bool()>& progressFn) {
+  HEAP_SCOPE(LAYOUT);
   const auto localPath = epub->getSpineItem(spineIndex).href;
   const auto tmpHtmlPath = epub->getCachePath() + "/.tmp_" + std::to_string(spineIndex) + ".html";
+  PackFile* pack = epub->getPack();
+  selectLayout(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth, viewportHeight,
+               hyphenationEnabled, embeddedStyle, imageRendering);
+  // Before the section is written: a layout new to the book may push out the oldest one
+  epub->useSectionLayout(layout);
 
   // Create cache directory if it doesn't exist
-  {
-    const auto sectionsDir = epub->getCachePath() + "/sections";
-    Storage.mkdir(sectionsDir.c_str());
+  if (!pack) {
+    const auto layoutDir = epub->getCachePath() + "/sections/" + Epub::getSectionLayoutName(layout);
+    Storage.mkdir(layoutDir.c_str());
   }
 
   // Retry logic for SD card timing issues
@@ -181,17 +253,31 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
 
   LOG_DBG("SCT", "Streamed temp HTML to %s (%d bytes)", tmpHtmlPath.c_str(), fileSize);
 
-  if (!Storage.openFileForWrite("SCT", filePath, file)) {
+  uint32_t base = 0;
+  if (pack ? !pack->beginEntry(packEntry, file, base) : !Storage.openFileForWrite("SCT", filePath, file)) {
     return false;
   }
-  writeSectionFileHeader(fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
+  // Drops the partly written section; closes file
+  const auto discardSection = [this, pack, base] {
+    if (pack) {
+      pack->abortEntry(packEntry, file, base);
+    } else {
+      file.close();
+      Storage.remove(filePath.c_str());
+    }
+  };
+  const auto buildStart = millis();
+  serialization::BufferedWriter writer(file, base);
+  writeSectionFileHeader(writer, fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
                          viewportHeight, hyphenationEnabled, embeddedStyle, imageRendering);
   std::vector<uint32_t> lut = {};
 
   // Derive the content base directory and image cache path prefix for the parser
   size_t lastSlash = localPath.find_last_of('/');
   std::string contentBase = (lastSlash != std::string::npos) ? localPath.substr(0, lastSlash + 1) : "";
-  std::string imageBasePath = epub->getCachePath() + "/img_" + std::to_string(spineIndex) + "_";
+  // Per layout: another viewport decodes the same image at another size
+  std::string imageBasePath =
+      epub->getCachePath() + "/img_" + std::to_string(spineIndex) + "_" + Epub::getSectionLayoutName(layout) + "_";
 
   CssParser* cssParser = nullptr;
   if (embeddedStyle) {
@@ -206,23 +292,29 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
   ChapterHtmlSlimParser visitor(
       epub, tmpHtmlPath, renderer, fontId, lineCompression, extraParagraphSpacing, paragraphAlignment, viewportWidth,
       viewportHeight, hyphenationEnabled,
-      [this, &lut](std::unique_ptr<Page> page) { lut.emplace_back(this->onPageComplete(std::move(page))); },
-      embeddedStyle, contentBase, imageBasePath, imageRendering, popupFn, cssParser);
+      [this, &lut, &writer](std::unique_ptr<Page> page) {
+        lut.emplace_back(this->onPageComplete(writer, std::move(page)));
+      },
+      embeddedStyle, contentBase, imageBasePath, imageRendering, popupFn, cssParser, progressFn);
   Hyphenator::setPreferredLanguage(epub->getLanguage());
   success = visitor.parseAndBuildPages();
 
   Storage.remove(tmpHtmlPath.c_str());
   if (!success) {
-    LOG_ERR("SCT", "Failed to parse XML and build pages");
-    file.close();
-    Storage.remove(filePath.c_str());
+    if (visitor.wasStopped()) {
+      LOG_DBG("SCT", "Layout stopped, discarding the partial section");
+    } else {
+      LOG_ERR("SCT", "Failed to parse XML and build pages");
+    }
+    writer.discard();
+    discardSection();
     if (cssParser) {
       cssParser->clear();
     }
     return false;
   }
 
-  const uint32_t lutOffset = file.position();
+  const uint32_t lutOffset = writer.position();
   bool hasFailedLutRecords = false;
   // Write LUT
   for (const uint32_t& pos : lut) {
@@ -230,79 +322,111 @@ bool Section::createSectionFile(const int fontId, const float lineCompression, c
       hasFailedLutRecords = true;
       break;
     }
-    serialization::writePod(file, pos);
+    serialization::writePod(writer, pos);
   }
 
   if (hasFailedLutRecords) {
     LOG_ERR("SCT", "Failed to write LUT due to invalid page positions");
-    file.close();
-    Storage.remove(filePath.c_str());
+    writer.discard();
+    discardSection();
     return false;
   }
 
   // Write anchor-to-page map for fragment navigation (e.g. footnote targets)
-  const uint32_t anchorMapOffset = file.position();
+  const uint32_t anchorMapOffset = writer.position();
   const auto& anchors = visitor.getAnchors();
-  serialization::writePod(file, static_cast<uint16_t>(anchors.size()));
+  serialization::writePod(writer, static_cast<uint16_t>(anchors.size()));
   for (const auto& [anchor, page] : anchors) {
-    serialization::writeString(file, anchor);
-    serialization::writePod(file, page);
+    serialization::writeString(writer, anchor);
+    serialization::writePod(writer, page);
   }
 
   // Patch header with final pageCount, lutOffset, and anchorMapOffset
-  file.seek(HEADER_SIZE - sizeof(uint32_t) * 2 - sizeof(pageCount));
-  serialization::writePod(file, pageCount);
-  serialization::writePod(file, lutOffset);
-  serialization::writePod(file, anchorMapOffset);
-  file.close();
+  writer.seek(HEADER_SIZE - sizeof(uint32_t) * 2 - sizeof(pageCount));
+  serialization::writePod(writer, pageCount);
+  serialization::writePod(writer, lutOffset);
+  serialization::writePod(writer, anchorMapOffset);
+  bool writeOk = writer.flush();
+  if (!writeOk) {
+    discardSection();
+  } else if (pack) {
+    writeOk = pack->commitEntry(packEntry, file, base);
+  } else {
+    file.close();
+  }
+  if (!writeOk) {
+    LOG_ERR("SCT", "Failed to write section file");
+    if (cssParser) {
+      cssParser->clear();
+    }
+    return false;
+  }
+  LOG_DBG("SCT", "Built section in %lums (%d pages, %lu SD writes)", millis() - buildStart, pageCount,
+          writer.getWriteCalls());
+  PageIndex::record(epub->getCachePath(), layout, epub->getSpineItemsCount(), spineIndex, pageCount);
   if (cssParser) {
     cssParser->clear();
   }
   return true;
 }
 
-std::unique_ptr<Page> Section::loadPageFromSectionFile() {
-  if (!Storage.openFileForRead("SCT", filePath, file)) {
+std::unique_ptr<Page> Section::loadPageFromSectionFile() { return loadPage(currentPage); }
+
+std::unique_ptr<Page> Section::loadPage(const int pageNumber) const {
+  PERF_SCOPE(PAGE_LOAD);
+  HEAP_SCOPE(PAGE_CACHE);
+  FsFile f;
+  uint32_t base, size;
+  if (!openForRead(f, base, size)) {
     return nullptr;
   }
 
-  file.seek(HEADER_SIZE - sizeof(uint32_t) * 2);
+  const auto start = millis();
+  serialization::BufferedReader reader(f, base, size);
+  reader.seek(HEADER_SIZE - sizeof(uint32_t) * 2);
   uint32_t lutOffset;
-  serialization::readPod(file, lutOffset);
-  file.seek(lutOffset + sizeof(uint32_t) * currentPage);
+  serialization::readPod(reader, lutOffset);
+  reader.seek(lutOffset + sizeof(uint32_t) * pageNumber);
   uint32_t pagePos;
-  serialization::readPod(file, pagePos);
-  file.seek(pagePos);
+  serialization::readPod(reader, pagePos);
+  reader.seek(pagePos);
+  if (!reader.ok()) {
+    LOG_ERR("SCT", "Invalid page offset for page %d", pageNumber);
+    f.close();
+    return nullptr;
+  }
 
-  auto page = Page::deserialize(file);
-  file.close();
+  auto page = Page::deserialize(reader);
+  f.close();
+  LOG_DBG("SCT", "Loaded page %d in %lums (%lu SD reads)", pageNumber, millis() - start, reader.getReadCalls());
   return page;
 }
 
 std::optional<uint16_t> Section::getPageForAnchor(const std::string& anchor) const {
   FsFile f;
-  if (!Storage.openFileForRead("SCT", filePath, f)) {
+  uint32_t base, size;
+  if (!openForRead(f, base, size)) {
     return std::nullopt;
   }
 
-  const uint32_t fileSize = f.size();
-  f.seek(HEADER_SIZE - sizeof(uint32_t));
+  serialization::BufferedReader reader(f, base, size);
+  reader.seek(HEADER_SIZE - sizeof(uint32_t));
   uint32_t anchorMapOffset;
-  serialization::readPod(f, anchorMapOffset);
-  if (anchorMapOffset == 0 || anchorMapOffset >= fileSize) {
+  serialization::readPod(reader, anchorMapOffset);
+  if (anchorMapOffset == 0 || anchorMapOffset >= reader.size()) {
     f.close();
     return std::nullopt;
   }
 
-  f.seek(anchorMapOffset);
+  reader.seek(anchorMapOffset);
   uint16_t count;
-  serialization::readPod(f, count);
-  for (uint16_t i = 0; i < count; i++) {
+  serialization::readPod(reader, count);
+  for (uint16_t i = 0; i < count && reader.ok(); i++) {
     std::string key;
     uint16_t page;
-    serialization::readString(f, key);
-    serialization::readPod(f, page);
-    if (key == anchor) {
+    serialization::readString(reader, key);
+    serialization::readPod(reader, page);
+    if (reader.ok() && key == anchor) {
       f.close();
       return page;
     }
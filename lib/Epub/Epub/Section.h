@@ -1,4 +1,6 @@
 #pragma once
+#include <BufferedIO.h>
+
 #include <functional>
 #include <memory>
 #include <optional>
@@ -13,32 +15,44 @@ class Section {
   std::shared_ptr<Epub> epub;
   const int spineIndex;
   GfxRenderer& renderer;
+  // Both depend on the layout and are set by loadSectionFile() and createSectionFile()
   std::string filePath;
+  std::string packEntry;  // name in the book's pack, when the book uses one
+  uint32_t layout = 0;
   FsFile file;
 
-  void writeSectionFileHeader(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
-                              uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled,
-                              bool embeddedStyle, uint8_t imageRendering);
-  uint32_t onPageComplete(std::unique_ptr<Page> page);
+  void selectLayout(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
+                    uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle,
+                    uint8_t imageRendering);
+
+  void writeSectionFileHeader(serialization::BufferedWriter& writer, int fontId, float lineCompression,
+                              bool extraParagraphSpacing, uint8_t paragraphAlignment, uint16_t viewportWidth,
+                              uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle,
+                              uint8_t imageRendering);
+  uint32_t onPageComplete(serialization::BufferedWriter& writer, std::unique_ptr<Page> page);
+  // Opens the section's own file, or its entry in the pack; base and size locate the section within f
+  bool openForRead(FsFile& f, uint32_t& base, uint32_t& size) const;
 
  public:
   uint16_t pageCount = 0;
   int currentPage = 0;
 
   explicit Section(const std::shared_ptr<Epub>& epub, const int spineIndex, GfxRenderer& renderer)
-      : epub(epub),
-        spineIndex(spineIndex),
-        renderer(renderer),
-        filePath(epub->getCachePath() + "/sections/" + std::to_string(spineIndex) + ".bin") {}
+      : epub(epub), spineIndex(spineIndex), renderer(renderer) {}
   ~Section() = default;
+  // Fingerprint of the layout parameters, known once the section was loaded or created
+  uint32_t getLayout() const { return layout; }
   bool loadSectionFile(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                        uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle,
                        uint8_t imageRendering);
   bool clearCache() const;
   bool createSectionFile(int fontId, float lineCompression, bool extraParagraphSpacing, uint8_t paragraphAlignment,
                          uint16_t viewportWidth, uint16_t viewportHeight, bool hyphenationEnabled, bool embeddedStyle,
-                         uint8_t imageRendering, const std::function<void()>& popupFn = nullptr);
+                         uint8_t imageRendering, const std::function<void()>& popupFn = nullptr,
+                         const std::function<bool()>& progressFn = nullptr);
   std::unique_ptr<Page> loadPageFromSectionFile();
+  // Any page of the section; uses its own file handle, so it can run while the render task waits for the panel
+  std::unique_ptr<Page> loadPage(int pageNumber) const;
 
   // Look up the page number for an anchor id from the section cache file.
   std::optional<uint16_t> getPageForAnchor(const std::string& anchor) const;
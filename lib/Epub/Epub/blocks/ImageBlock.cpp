@@ -1,25 +1,23 @@
 #include "ImageBlock.h"
 
 #include <GfxRenderer.h>
+#include <HeapTrace.h>
 #include <Logging.h>
 #include <Serialization.h>
 
-#include "../converters/DitherUtils.h"
+#include <algorithm>
+
 #include "../converters/ImageDecoderFactory.h"
+#include "../converters/PixelCache.h"
 
-// Cache file format:
-// - uint16_t width
-// - uint16_t height
-// - uint8_t pixels[...] - 2 bits per pixel, packed (4 pixels per byte), row-major order
+// Cache file format: see PixelCacheHeader in PixelCache.h
 
 ImageBlock::ImageBlock(const std::string& imagePath, int16_t width, int16_t height)
     : imagePath(imagePath), width(width), height(height) {}
 
 bool ImageBlock::imageExists() const { return Storage.exists(imagePath.c_str()); }
 
-namespace {
-
-std::string getCachePath(const std::string& imagePath) {
+std::string ImageBlock::getCachePath(const std::string& imagePath) {
   // Replace extension with .pxc (pixel cache)
   size_t dotPos = imagePath.rfind('.');
   if (dotPos != std::string::npos) {
@@ -28,6 +26,10 @@ std::string getCachePath(const std::string& imagePath) {
   return imagePath + ".pxc";
 }
 
+namespace {
+
+constexpr size_t CACHE_CHUNK_SIZE = 4096;
+
 bool renderFromCache(GfxRenderer& renderer, const std::string& cachePath, int x, int y, int expectedWidth,
                      int expectedHeight) {
   FsFile cacheFile;
@@ -35,64 +37,91 @@ bool renderFromCache(GfxRenderer& renderer, const std::string& cachePath, int x,
     return false;
   }
 
-  uint16_t cachedWidth, cachedHeight;
-  if (cacheFile.read(&cachedWidth, 2) != 2 || cacheFile.read(&cachedHeight, 2) != 2) {
+  PixelCacheHeader header;
+  if (cacheFile.read(&header, sizeof(header)) != sizeof(header) || header.magic != PIXEL_CACHE_MAGIC ||
+      header.version != PIXEL_CACHE_VERSION || header.planeRowBytes == 0) {
+    LOG_DBG("IMG", "Old or invalid cache format, decoding again: %s", cachePath.c_str());
     cacheFile.close();
     return false;
   }
 
   // Verify dimensions are close (allow 1 pixel tolerance for rounding differences)
-  int widthDiff = abs(cachedWidth - expectedWidth);
-  int heightDiff = abs(cachedHeight - expectedHeight);
+  int widthDiff = abs(header.width - expectedWidth);
+  int heightDiff = abs(header.height - expectedHeight);
   if (widthDiff > 1 || heightDiff > 1) {
-    LOG_ERR("IMG", "Cache dimension mismatch: %dx%d vs %dx%d", cachedWidth, cachedHeight, expectedWidth,
+    LOG_ERR("IMG", "Cache dimension mismatch: %dx%d vs %dx%d", header.width, header.height, expectedWidth,
             expectedHeight);
     cacheFile.close();
     return false;
   }
 
   // Use cached dimensions for rendering (they're the actual decoded size)
-  expectedWidth = cachedWidth;
-  expectedHeight = cachedHeight;
+  const int width = header.width;
+  const int height = header.height;
+  const int rowBytes = header.planeRowBytes;
+
+  // Each render pass draws one plane: BW clears black pixels, the grayscale passes set theirs
+  const GfxRenderer::RenderMode mode = renderer.getRenderMode();
+  const int plane = mode == GfxRenderer::BW ? 0 : mode == GfxRenderer::GRAYSCALE_LSB ? 1 : 2;
+  const bool black = mode == GfxRenderer::BW;
+  const uint32_t planeOffset = sizeof(header) + static_cast<uint32_t>(plane) * rowBytes * header.planeHeight;
+  if (!cacheFile.seek(planeOffset)) {
+    cacheFile.close();
+    return false;
+  }
 
-  LOG_DBG("IMG", "Loading from cache: %s (%dx%d)", cachePath.c_str(), cachedWidth, cachedHeight);
+  // Planes laid out for another orientation (e.g. portrait cache shown inverted) still render, pixel by pixel
+  const auto cacheOrientation = static_cast<GfxRenderer::Orientation>(header.orientation);
+  const bool native = cacheOrientation == renderer.getOrientation();
 
-  // Read and render row by row to minimize memory usage
-  const int bytesPerRow = (cachedWidth + 3) / 4;  // 2 bits per pixel, 4 pixels per byte
-  uint8_t* rowBuffer = (uint8_t*)malloc(bytesPerRow);
-  if (!rowBuffer) {
-    LOG_ERR("IMG", "Failed to allocate row buffer");
+  LOG_DBG("IMG", "Loading from cache: %s (%dx%d, plane %d%s)", cachePath.c_str(), width, height, plane,
+          native ? "" : ", rotating");
+
+  const int rowsPerChunk = std::max<int>(1, CACHE_CHUNK_SIZE / rowBytes);
+  uint8_t* chunk = static_cast<uint8_t*>(HEAP_MALLOC(IMAGE, static_cast<size_t>(rowsPerChunk) * rowBytes));
+  if (!chunk) {
+    LOG_ERR("IMG", "Failed to allocate cache chunk");
     cacheFile.close();
     return false;
   }
 
-  for (int row = 0; row < cachedHeight; row++) {
-    if (cacheFile.read(rowBuffer, bytesPerRow) != bytesPerRow) {
+  const unsigned long start = millis();
+  for (int row = 0; row < header.planeHeight; row += rowsPerChunk) {
+    const int rows = std::min(rowsPerChunk, header.planeHeight - row);
+    const int len = rows * rowBytes;
+    if (cacheFile.read(chunk, len) != len) {
       LOG_ERR("IMG", "Cache read error at row %d", row);
-      free(rowBuffer);
+      HEAP_FREE(chunk);
       cacheFile.close();
       return false;
     }
 
-    int destY = y + row;
-    for (int col = 0; col < cachedWidth; col++) {
-      int byteIdx = col / 4;
-      int bitShift = 6 - (col % 4) * 2;  // MSB first within byte
-      uint8_t pixelValue = (rowBuffer[byteIdx] >> bitShift) & 0x03;
-
-      drawPixelWithRenderMode(renderer, x + col, destY, pixelValue);
+    if (native) {
+      renderer.drawPlaneRows(x, y, width, height, chunk, rowBytes, row, rows, black);
+      continue;
+    }
+    for (int i = 0; i < rows; i++) {
+      const uint8_t* src = chunk + i * rowBytes;
+      for (int px = 0; px < header.planeWidth; px++) {
+        const bool bit = (src[px / 8] >> (7 - px % 8)) & 1;
+        if (bit == black) continue;
+        int imageX, imageY;
+        planeToImageCoordinates(cacheOrientation, width, height, px, row + i, &imageX, &imageY);
+        renderer.drawPixel(x + imageX, y + imageY, black);
+      }
     }
   }
 
-  free(rowBuffer);
+  HEAP_FREE(chunk);
   cacheFile.close();
-  LOG_DBG("IMG", "Cache render complete");
+  LOG_DBG("IMG", "Cache render complete in %lums", millis() - start);
   return true;
 }
 
 }  // namespace
 
 void ImageBlock::render(GfxRenderer& renderer, const int x, const int y) {
+  HEAP_SCOPE(IMAGE);
   LOG_DBG("IMG", "Rendering image at %d,%d: %s (%dx%d)", x, y, imagePath.c_str(), width, height);
 
   const int screenWidth = renderer.getScreenWidth();
@@ -156,18 +185,22 @@ void ImageBlock::render(GfxRenderer& renderer, const int x, const int y) {
   LOG_DBG("IMG", "Decode successful");
 }
 
-bool ImageBlock::serialize(FsFile& file) {
-  serialization::writeString(file, imagePath);
-  serialization::writePod(file, width);
-  serialization::writePod(file, height);
-  return true;
+bool ImageBlock::serialize(serialization::BufferedWriter& writer) {
+  serialization::writeVarString(writer, imagePath);
+  serialization::writePod(writer, width);
+  serialization::writePod(writer, height);
+  return !writer.hasError();
 }
 
-std::unique_ptr<ImageBlock> ImageBlock::deserialize(FsFile& file) {
+std::unique_ptr<ImageBlock> ImageBlock::deserialize(serialization::BufferedReader& reader) {
   std::string path;
-  serialization::readString(file, path);
+  serialization::readVarString(reader, path);
   int16_t w, h;
-  serialization::readPod(file, w);
-  serialization::readPod(file, h);
+  serialization::readPod(reader, w);
+  serialization::readPod(reader, h);
+  if (!reader.ok()) {
+    LOG_ERR("IMG", "Deserialization failed: truncated image block");
+    return nullptr;
+  }
   return std::unique_ptr<ImageBlock>(new ImageBlock(path, w, h));
 }
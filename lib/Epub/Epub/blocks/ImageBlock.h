@@ -1,4 +1,5 @@
 #pragma once
+#include <BufferedIO.h>
 #include <HalStorage.h>
 
 #include <memory>
@@ -16,13 +17,15 @@ class ImageBlock final : public Block {
   int16_t getHeight() const { return height; }
 
   bool imageExists() const;
+  // Pixel cache (.pxc) written next to the image the first time it is decoded at its display size
+  static std::string getCachePath(const std::string& imagePath);
 
   BlockType getType() override { return IMAGE_BLOCK; }
   bool isEmpty() override { return false; }
 
   void render(GfxRenderer& renderer, const int x, const int y);
-  bool serialize(FsFile& file);
-  static std::unique_ptr<ImageBlock> deserialize(FsFile& file);
+  bool serialize(serialization::BufferedWriter& writer);
+  static std::unique_ptr<ImageBlock> deserialize(serialization::BufferedReader& reader);
 
  private:
   std::string imagePath;
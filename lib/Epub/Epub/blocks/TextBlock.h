@@ -1,5 +1,6 @@
 #pragma once
 #include <EpdFontFamily.h>
+#include <BufferedIO.h>
 #include <HalStorage.h>
 
 #include <memory>
@@ -33,6 +34,6 @@ class TextBlock final : public Block {
   // given a renderer works out where to break the words into lines
   void render(const GfxRenderer& renderer, int fontId, int x, int y) const;
   BlockType getType() override { return TEXT_BLOCK; }
-  bool serialize(FsFile& file) const;
-  static std::unique_ptr<TextBlock> deserialize(FsFile& file);
+  bool serialize(serialization::BufferedWriter& writer) const;
+  static std::unique_ptr<TextBlock> deserialize(serialization::BufferedReader& reader);
 };
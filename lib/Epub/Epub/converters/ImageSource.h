@@ -0,0 +1,70 @@
+#pragma once
+
+#include <HalStorage.h>
+#include <ZipFile.h>
+#include <stdint.h>
+
+#include <string>
+
+/**
+ * Byte stream an image decoder reads from.
+ *
+ * Images are decoded either from a file on SD or, while a chapter is being indexed, directly from their entry in the
+ * EPUB. JPEGDEC and PNGdec pass the name given to open() through to the open callback untouched, so the converters
+ * hand them the source itself in that argument (see asOpenArg) and the callbacks only ever talk to an ImageSource.
+ */
+class ImageSource {
+ public:
+  virtual ~ImageSource() = default;
+
+  // Returns the number of bytes read, 0 at the end of the image
+  virtual int32_t read(uint8_t* buf, int32_t len) = 0;
+  virtual bool seek(uint32_t pos) = 0;
+  virtual uint32_t size() = 0;
+  // Path of the image, for log messages
+  virtual const std::string& getPath() const = 0;
+
+  const char* asOpenArg() { return reinterpret_cast<const char*>(this); }
+  static ImageSource* fromOpenArg(const char* arg) { return reinterpret_cast<ImageSource*>(const_cast<char*>(arg)); }
+};
+
+class FileImageSource final : public ImageSource {
+ public:
+  explicit FileImageSource(const std::string& path) : path(path) {}
+
+  bool open() { return Storage.openFileForRead("IMG", path, file); }
+
+  int32_t read(uint8_t* buf, const int32_t len) override {
+    const int bytesRead = file.read(buf, len);
+    return bytesRead < 0 ? 0 : bytesRead;
+  }
+  bool seek(const uint32_t pos) override { return file.seek(pos); }
+  uint32_t size() override { return file.size(); }
+  const std::string& getPath() const override { return path; }
+
+ private:
+  std::string path;
+  FsFile file;
+};
+
+// Streams an image out of the book's ZIP without extracting it (see ZipEntryReader for the seek cost)
+class ZipImageSource final : public ImageSource {
+ public:
+  ZipImageSource(const std::string& zipPath, const std::string& itemPath) : path(itemPath), reader(zipPath) {}
+
+  bool open() { return reader.open(path.c_str()); }
+  // Releases the archive and the inflate window
+  void close() { reader.close(); }
+
+  int32_t read(uint8_t* buf, const int32_t len) override {
+    const int bytesRead = reader.read(buf, len);
+    return bytesRead < 0 ? 0 : bytesRead;
+  }
+  bool seek(const uint32_t pos) override { return reader.seek(pos); }
+  uint32_t size() override { return reader.size(); }
+  const std::string& getPath() const override { return path; }
+
+ private:
+  std::string path;
+  ZipEntryReader reader;
+};
@@ -1,10 +1,11 @@
 #pragma once
+#include <GfxRenderer.h>
 #include <HalStorage.h>
 
 #include <memory>
 #include <string>
 
-class GfxRenderer;
+class ImageSource;
 
 struct ImageDimensions {
   int16_t width;
@@ -19,6 +20,8 @@ struct RenderConfig {
   bool performanceMode = false;
   bool useExactDimensions = false;  // If true, use maxWidth/maxHeight as exact output size (no recalculation)
   std::string cachePath;            // If non-empty, decoder will write pixel cache to this path
+  // Panel layout of the cache planes when there is no renderer to take it from (decodeToCache)
+  GfxRenderer::Orientation cacheOrientation = GfxRenderer::Portrait;
 };
 
 class ImageToFramebufferDecoder {
@@ -27,7 +30,12 @@ class ImageToFramebufferDecoder {
 
   virtual bool decodeToFramebuffer(const std::string& imagePath, GfxRenderer& renderer, const RenderConfig& config) = 0;
 
+  // Decodes into the pixel cache at config.cachePath without drawing. Cache coordinates start at config.x/config.y.
+  virtual bool decodeToCache(ImageSource& source, const RenderConfig& config) = 0;
+
   virtual bool getDimensions(const std::string& imagePath, ImageDimensions& dims) const = 0;
+  // Reads the header from the current position; the caller rewinds the source before decoding
+  virtual bool getDimensions(ImageSource& source, ImageDimensions& dims) const = 0;
 
   virtual const char* getFormatName() const = 0;
 
@@ -10,13 +10,14 @@
 #include <new>
 
 #include "DitherUtils.h"
+#include "ImageSource.h"
 #include "PixelCache.h"
 
 namespace {
 
 // Context struct passed through JPEGDEC callbacks to avoid global mutable state.
 // The draw callback receives this via pDraw->pUser (set by setUserPointer()).
-// The file I/O callbacks receive the FsFile* via pFile->fHandle (set by jpegOpen()).
+// The file I/O callbacks receive the ImageSource* via pFile->fHandle (set by jpegOpen()).
 struct JpegContext {
   GfxRenderer* renderer;
   const RenderConfig* config;
@@ -52,43 +53,32 @@ struct JpegContext {
         caching(false) {}
 };
 
-// File I/O callbacks use pFile->fHandle to access the FsFile*,
-// avoiding the need for global file state.
+// File I/O callbacks use pFile->fHandle to access the ImageSource*, which is passed to
+// jpeg->open() in place of a file name. The caller owns the source, so close does nothing.
 void* jpegOpen(const char* filename, int32_t* size) {
-  FsFile* f = new FsFile();
-  if (!Storage.openFileForRead("JPG", std::string(filename), *f)) {
-    delete f;
-    return nullptr;
-  }
-  *size = f->size();
-  return f;
+  ImageSource* source = ImageSource::fromOpenArg(filename);
+  *size = source->size();
+  return source;
 }
 
-void jpegClose(void* handle) {
-  FsFile* f = reinterpret_cast<FsFile*>(handle);
-  if (f) {
-    f->close();
-    delete f;
-  }
-}
+void jpegClose(void* handle) {}
 
 // JPEGDEC tracks file position via pFile->iPos internally (e.g. JPEGGetMoreData
 // checks iPos < iSize to decide whether more data is available). The callbacks
 // MUST maintain iPos to match the actual file position, otherwise progressive
 // JPEGs with large headers fail during parsing.
 int32_t jpegRead(JPEGFILE* pFile, uint8_t* pBuf, int32_t len) {
-  FsFile* f = reinterpret_cast<FsFile*>(pFile->fHandle);
-  if (!f) return 0;
-  int32_t bytesRead = f->read(pBuf, len);
-  if (bytesRead < 0) return 0;
+  ImageSource* source = reinterpret_cast<ImageSource*>(pFile->fHandle);
+  if (!source) return 0;
+  int32_t bytesRead = source->read(pBuf, len);
   pFile->iPos += bytesRead;
   return bytesRead;
 }
 
 int32_t jpegSeek(JPEGFILE* pFile, int32_t pos) {
-  FsFile* f = reinterpret_cast<FsFile*>(pFile->fHandle);
-  if (!f) return -1;
-  if (!f->seek(pos)) return -1;
+  ImageSource* source = reinterpret_cast<ImageSource*>(pFile->fHandle);
+  if (!source) return -1;
+  if (!source->seek(pos)) return -1;
   pFile->iPos = pos;
   return pos;
 }
@@ -124,7 +114,7 @@ constexpr int32_t FP_MASK = FP_ONE - 1;
 
 int jpegDrawCallback(JPEGDRAW* pDraw) {
   JpegContext* ctx = reinterpret_cast<JpegContext*>(pDraw->pUser);
-  if (!ctx || !ctx->config || !ctx->renderer) return 0;
+  if (!ctx || !ctx->config) return 0;
 
   // In EIGHT_BIT_GRAYSCALE mode, pPixels contains 8-bit grayscale values
   // Buffer is densely packed: stride = pDraw->iWidth, valid columns = pDraw->iWidthUsed
@@ -139,7 +129,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
   const bool caching = ctx->caching;
   const int32_t fineScaleFP = ctx->fineScaleFP;
   const int32_t invScaleFP = ctx->invScaleFP;
-  GfxRenderer& renderer = *ctx->renderer;
+  GfxRenderer* renderer = ctx->renderer;  // null when only filling the cache
   const int cfgX = ctx->config->x;
   const int cfgY = ctx->config->y;
   const int blockX = pDraw->x;
@@ -182,7 +172,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
           dithered = gray / 85;
           if (dithered > 3) dithered = 3;
         }
-        drawPixelWithRenderMode(renderer, outX, outY, dithered);
+        if (renderer) drawPixelWithRenderMode(*renderer, outX, outY, dithered);
         if (caching) ctx->cache.setPixel(outX, outY, dithered);
       }
     }
@@ -239,7 +229,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
           dithered = gray / 85;
           if (dithered > 3) dithered = 3;
         }
-        drawPixelWithRenderMode(renderer, outX, outY, dithered);
+        if (renderer) drawPixelWithRenderMode(*renderer, outX, outY, dithered);
         if (caching) ctx->cache.setPixel(outX, outY, dithered);
       }
 
@@ -262,7 +252,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
           dithered = gray / 85;
           if (dithered > 3) dithered = 3;
         }
-        drawPixelWithRenderMode(renderer, outX, outY, dithered);
+        if (renderer) drawPixelWithRenderMode(*renderer, outX, outY, dithered);
         if (caching) ctx->cache.setPixel(outX, outY, dithered);
       }
 
@@ -288,7 +278,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
           dithered = gray / 85;
           if (dithered > 3) dithered = 3;
         }
-        drawPixelWithRenderMode(renderer, outX, outY, dithered);
+        if (renderer) drawPixelWithRenderMode(*renderer, outX, outY, dithered);
         if (caching) ctx->cache.setPixel(outX, outY, dithered);
       }
     }
@@ -319,7 +309,7 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
         dithered = gray / 85;
         if (dithered > 3) dithered = 3;
       }
-      drawPixelWithRenderMode(renderer, outX, outY, dithered);
+      if (renderer) drawPixelWithRenderMode(*renderer, outX, outY, dithered);
       if (caching) ctx->cache.setPixel(outX, outY, dithered);
     }
   }
@@ -330,6 +320,15 @@ int jpegDrawCallback(JPEGDRAW* pDraw) {
 }  // namespace
 
 bool JpegToFramebufferConverter::getDimensionsStatic(const std::string& imagePath, ImageDimensions& out) {
+  FileImageSource source(imagePath);
+  if (!source.open()) {
+    LOG_ERR("JPG", "Failed to open JPEG for dimensions: %s", imagePath.c_str());
+    return false;
+  }
+  return getDimensionsStatic(source, out);
+}
+
+bool JpegToFramebufferConverter::getDimensionsStatic(ImageSource& source, ImageDimensions& out) {
   size_t freeHeap = ESP.getFreeHeap();
   if (freeHeap < MIN_FREE_HEAP_FOR_JPEG) {
     LOG_ERR("JPG", "Not enough heap for JPEG decoder (%u free, need %u)", freeHeap, MIN_FREE_HEAP_FOR_JPEG);
@@ -342,9 +341,9 @@ bool JpegToFramebufferConverter::getDimensionsStatic(const std::string& imagePat
     return false;
   }
 
-  int rc = jpeg->open(imagePath.c_str(), jpegOpen, jpegClose, jpegRead, jpegSeek, nullptr);
+  int rc = jpeg->open(source.asOpenArg(), jpegOpen, jpegClose, jpegRead, jpegSeek, nullptr);
   if (rc != 1) {
-    LOG_ERR("JPG", "Failed to open JPEG for dimensions (err=%d): %s", jpeg->getLastError(), imagePath.c_str());
+    LOG_ERR("JPG", "Failed to open JPEG for dimensions (err=%d): %s", jpeg->getLastError(), source.getPath().c_str());
     delete jpeg;
     return false;
   }
@@ -360,7 +359,24 @@ bool JpegToFramebufferConverter::getDimensionsStatic(const std::string& imagePat
 
 bool JpegToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath, GfxRenderer& renderer,
                                                      const RenderConfig& config) {
-  LOG_DBG("JPG", "Decoding JPEG: %s", imagePath.c_str());
+  FileImageSource source(imagePath);
+  if (!source.open()) {
+    LOG_ERR("JPG", "Failed to open JPEG: %s", imagePath.c_str());
+    return false;
+  }
+  return decode(source, &renderer, config);
+}
+
+bool JpegToFramebufferConverter::decodeToCache(ImageSource& source, const RenderConfig& config) {
+  if (config.cachePath.empty() || !config.useExactDimensions) {
+    LOG_ERR("JPG", "Cache-only decode needs a cache path and exact dimensions");
+    return false;
+  }
+  return decode(source, nullptr, config);
+}
+
+bool JpegToFramebufferConverter::decode(ImageSource& source, GfxRenderer* renderer, const RenderConfig& config) {
+  LOG_DBG("JPG", "Decoding JPEG: %s", source.getPath().c_str());
 
   size_t freeHeap = ESP.getFreeHeap();
   if (freeHeap < MIN_FREE_HEAP_FOR_JPEG) {
@@ -375,14 +391,15 @@ bool JpegToFramebufferConverter::decodeToFramebuffer(const std::string& imagePat
   }
 
   JpegContext ctx;
-  ctx.renderer = &renderer;
+  ctx.renderer = renderer;
   ctx.config = &config;
-  ctx.screenWidth = renderer.getScreenWidth();
-  ctx.screenHeight = renderer.getScreenHeight();
+  // Without a renderer the only output is the cache, which the exact dimensions bound
+  ctx.screenWidth = renderer ? renderer->getScreenWidth() : config.x + config.maxWidth;
+  ctx.screenHeight = renderer ? renderer->getScreenHeight() : config.y + config.maxHeight;
 
-  int rc = jpeg->open(imagePath.c_str(), jpegOpen, jpegClose, jpegRead, jpegSeek, jpegDrawCallback);
+  int rc = jpeg->open(source.asOpenArg(), jpegOpen, jpegClose, jpegRead, jpegSeek, jpegDrawCallback);
   if (rc != 1) {
-    LOG_ERR("JPG", "Failed to open JPEG (err=%d): %s", jpeg->getLastError(), imagePath.c_str());
+    LOG_ERR("JPG", "Failed to open JPEG (err=%d): %s", jpeg->getLastError(), source.getPath().c_str());
     delete jpeg;
     return false;
   }
@@ -397,12 +414,6 @@ bool JpegToFramebufferConverter::decodeToFramebuffer(const std::string& imagePat
     return false;
   }
 
-  if (!validateImageDimensions(srcWidth, srcHeight, "JPEG")) {
-    jpeg->close();
-    delete jpeg;
-    return false;
-  }
-
   bool isProgressive = jpeg->getJPEGType() == JPEG_MODE_PROGRESSIVE;
   if (isProgressive) {
     LOG_INF("JPG", "Progressive JPEG detected - decoding DC coefficients only (lower quality)");
@@ -441,6 +452,13 @@ bool JpegToFramebufferConverter::decodeToFramebuffer(const std::string& imagePat
 
   ctx.scaledSrcWidth = (srcWidth + jpegScaleDenom - 1) / jpegScaleDenom;
   ctx.scaledSrcHeight = (srcHeight + jpegScaleDenom - 1) / jpegScaleDenom;
+
+  // The size limit applies to what is actually decoded: a large photo shown small is reduced in the DCT domain
+  if (!validateImageDimensions(ctx.scaledSrcWidth, ctx.scaledSrcHeight, "JPEG")) {
+    jpeg->close();
+    delete jpeg;
+    return false;
+  }
   ctx.dstWidth = destWidth;
   ctx.dstHeight = destHeight;
   ctx.fineScaleFP = (int32_t)((int64_t)destWidth * FP_ONE / ctx.scaledSrcWidth);
@@ -458,6 +476,12 @@ bool JpegToFramebufferConverter::decodeToFramebuffer(const std::string& imagePat
   ctx.caching = !config.cachePath.empty();
   if (ctx.caching) {
     if (!ctx.cache.allocate(destWidth, destHeight, config.x, config.y)) {
+      if (!renderer) {
+        LOG_ERR("JPG", "Failed to allocate cache buffer");
+        jpeg->close();
+        delete jpeg;
+        return false;
+      }
       LOG_ERR("JPG", "Failed to allocate cache buffer, continuing without caching");
       ctx.caching = false;
     }
@@ -478,9 +502,12 @@ bool JpegToFramebufferConverter::decodeToFramebuffer(const std::string& imagePat
   delete jpeg;
   LOG_DBG("JPG", "JPEG decoding complete - render time: %lu ms", decodeTime);
 
-  // Write cache file if caching was enabled
+  // Write cache file if caching was enabled; a cache-only decode has failed without it
   if (ctx.caching) {
-    ctx.cache.writeToFile(config.cachePath);
+    const auto orientation = renderer ? renderer->getOrientation() : config.cacheOrientation;
+    if (!ctx.cache.writeToFile(config.cachePath, orientation) && !renderer) {
+      return false;
+    }
   }
 
   return true;
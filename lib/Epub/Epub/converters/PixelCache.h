@@ -1,12 +1,69 @@
 #pragma once
 
+#include <BufferedIO.h>
+#include <GfxRenderer.h>
 #include <HalStorage.h>
+#include <HeapTrace.h>
 #include <Logging.h>
 #include <stdint.h>
 
 #include <cstring>
 #include <string>
 
+// Pixel cache file (.pxc), version 2. The decoded image is stored as the three 1-bit planes the render passes draw
+// (BW, grayscale LSB, grayscale MSB), already rotated to the panel layout for `orientation` so that each pass is a run
+// of row merges into the framebuffer (GfxRenderer::drawPlaneRows). Plane rows run along physical X, MSB first.
+// Version 1 files (a bare uint16 width/height followed by 2-bit rows) fail the magic check and are rebuilt.
+#pragma pack(push, 1)
+struct PixelCacheHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t orientation;  // GfxRenderer::Orientation the planes are laid out for
+  uint16_t width;       // logical image size
+  uint16_t height;
+  uint16_t planeWidth;  // physical extent of the rotated image
+  uint16_t planeHeight;
+  uint16_t planeRowBytes;
+};
+#pragma pack(pop)
+
+constexpr uint32_t PIXEL_CACHE_MAGIC = 0x32435850;  // "PXC2"
+constexpr uint8_t PIXEL_CACHE_VERSION = 2;
+constexpr int PIXEL_CACHE_PLANES = 3;
+
+// Physical extent of a width x height logical image under `orientation`
+inline void getPixelCachePlaneSize(const GfxRenderer::Orientation orientation, const int width, const int height,
+                                   int* planeWidth, int* planeHeight) {
+  const bool portrait = orientation == GfxRenderer::Portrait || orientation == GfxRenderer::PortraitInverted;
+  *planeWidth = portrait ? height : width;
+  *planeHeight = portrait ? width : height;
+}
+
+// Logical image pixel shown at plane position (px, py); the inverse of GfxRenderer's rotation relative to the
+// image's physical top-left corner
+inline void planeToImageCoordinates(const GfxRenderer::Orientation orientation, const int width, const int height,
+                                    const int px, const int py, int* x, int* y) {
+  switch (orientation) {
+    case GfxRenderer::Portrait:
+      *x = width - 1 - py;
+      *y = px;
+      break;
+    case GfxRenderer::LandscapeClockwise:
+      *x = width - 1 - px;
+      *y = height - 1 - py;
+      break;
+    case GfxRenderer::PortraitInverted:
+      *x = py;
+      *y = height - 1 - px;
+      break;
+    case GfxRenderer::LandscapeCounterClockwise:
+    default:
+      *x = px;
+      *y = py;
+      break;
+  }
+}
+
 // Cache buffer for storing 2-bit pixels (4 levels) during decode.
 // Packs 4 pixels per byte, MSB first.
 struct PixelCache {
@@ -34,7 +91,7 @@ struct PixelCache {
       LOG_ERR("IMG", "Cache buffer too large: %d bytes for %dx%d (limit %d)", bufferSize, w, h, MAX_CACHE_BYTES);
       return false;
     }
-    buffer = (uint8_t*)malloc(bufferSize);
+    buffer = static_cast<uint8_t*>(HEAP_MALLOC(IMAGE, bufferSize));
     if (buffer) {
       memset(buffer, 0, bufferSize);
       LOG_DBG("IMG", "Allocated cache buffer: %d bytes for %dx%d", bufferSize, w, h);
@@ -53,29 +110,74 @@ struct PixelCache {
     buffer[byteIdx] = (buffer[byteIdx] & ~(0x03 << bitShift)) | ((value & 0x03) << bitShift);
   }
 
-  bool writeToFile(const std::string& cachePath) {
+  uint8_t getPixel(int x, int y) const { return (buffer[y * bytesPerRow + x / 4] >> (6 - (x % 4) * 2)) & 0x03; }
+
+  // Writes the version 2 plane file for `orientation`
+  bool writeToFile(const std::string& cachePath, const GfxRenderer::Orientation orientation) {
     if (!buffer) return false;
 
+    int planeWidth, planeHeight;
+    getPixelCachePlaneSize(orientation, width, height, &planeWidth, &planeHeight);
+    const int planeRowBytes = (planeWidth + 7) / 8;
+    uint8_t* row = static_cast<uint8_t*>(HEAP_MALLOC(IMAGE, planeRowBytes));
+    if (!row) {
+      LOG_ERR("IMG", "Failed to allocate plane row");
+      return false;
+    }
+
     FsFile cacheFile;
     if (!Storage.openFileForWrite("IMG", cachePath, cacheFile)) {
       LOG_ERR("IMG", "Failed to open cache file for writing: %s", cachePath.c_str());
+      HEAP_FREE(row);
       return false;
     }
 
-    uint16_t w = width;
-    uint16_t h = height;
-    cacheFile.write(&w, 2);
-    cacheFile.write(&h, 2);
-    cacheFile.write(buffer, bytesPerRow * height);
+    PixelCacheHeader header = {};
+    header.magic = PIXEL_CACHE_MAGIC;
+    header.version = PIXEL_CACHE_VERSION;
+    header.orientation = static_cast<uint8_t>(orientation);
+    header.width = width;
+    header.height = height;
+    header.planeWidth = planeWidth;
+    header.planeHeight = planeHeight;
+    header.planeRowBytes = planeRowBytes;
+
+    bool ok;
+    {
+      serialization::BufferedWriter writer(cacheFile);
+      writer.write(&header, sizeof(header));
+      // Plane bits match the framebuffer after the pass: BW 0 = black, LSB/MSB 1 = drawn white by drawPixel
+      for (int plane = 0; plane < PIXEL_CACHE_PLANES; plane++) {
+        for (int py = 0; py < planeHeight; py++) {
+          memset(row, 0, planeRowBytes);
+          for (int px = 0; px < planeWidth; px++) {
+            int x, y;
+            planeToImageCoordinates(orientation, width, height, px, py, &x, &y);
+            const uint8_t value = getPixel(x, y);
+            const bool bit = plane == 0 ? value == 3 : plane == 1 ? value == 1 : (value == 1 || value == 2);
+            if (bit) row[px / 8] |= 0x80 >> (px % 8);
+          }
+          writer.write(row, planeRowBytes);
+        }
+      }
+      ok = writer.flush();
+    }
     cacheFile.close();
+    HEAP_FREE(row);
 
-    LOG_DBG("IMG", "Cache written: %s (%dx%d, %d bytes)", cachePath.c_str(), width, height, 4 + bytesPerRow * height);
+    if (!ok) {
+      LOG_ERR("IMG", "Failed to write cache file: %s", cachePath.c_str());
+      Storage.remove(cachePath.c_str());
+      return false;
+    }
+    LOG_DBG("IMG", "Cache written: %s (%dx%d, %d bytes)", cachePath.c_str(), width, height,
+            static_cast<int>(sizeof(header)) + PIXEL_CACHE_PLANES * planeRowBytes * planeHeight);
     return true;
   }
 
   ~PixelCache() {
     if (buffer) {
-      free(buffer);
+      HEAP_FREE(buffer);
       buffer = nullptr;
     }
   }
@@ -10,13 +10,14 @@
 #include <new>
 
 #include "DitherUtils.h"
+#include "ImageSource.h"
 #include "PixelCache.h"
 
 namespace {
 
 // Context struct passed through PNGdec callbacks to avoid global mutable state.
 // The draw callback receives this via pDraw->pUser (set by png.decode()).
-// The file I/O callbacks receive the FsFile* via pFile->fHandle (set by pngOpen()).
+// The file I/O callbacks receive the ImageSource* via pFile->fHandle (set by pngOpenWithHandle()).
 struct PngContext {
   GfxRenderer* renderer;
   const RenderConfig* config;
@@ -51,36 +52,26 @@ struct PngContext {
         grayLineBuffer(nullptr) {}
 };
 
-// File I/O callbacks use pFile->fHandle to access the FsFile*,
-// avoiding the need for global file state.
+// File I/O callbacks use pFile->fHandle to access the ImageSource*, which is passed to
+// png->open() in place of a file name. The caller owns the source, so close does nothing.
 void* pngOpenWithHandle(const char* filename, int32_t* size) {
-  FsFile* f = new FsFile();
-  if (!Storage.openFileForRead("PNG", std::string(filename), *f)) {
-    delete f;
-    return nullptr;
-  }
-  *size = f->size();
-  return f;
+  ImageSource* source = ImageSource::fromOpenArg(filename);
+  *size = source->size();
+  return source;
 }
 
-void pngCloseWithHandle(void* handle) {
-  FsFile* f = reinterpret_cast<FsFile*>(handle);
-  if (f) {
-    f->close();
-    delete f;
-  }
-}
+void pngCloseWithHandle(void* handle) {}
 
 int32_t pngReadWithHandle(PNGFILE* pFile, uint8_t* pBuf, int32_t len) {
-  FsFile* f = reinterpret_cast<FsFile*>(pFile->fHandle);
-  if (!f) return 0;
-  return f->read(pBuf, len);
+  ImageSource* source = reinterpret_cast<ImageSource*>(pFile->fHandle);
+  if (!source) return 0;
+  return source->read(pBuf, len);
 }
 
 int32_t pngSeekWithHandle(PNGFILE* pFile, int32_t pos) {
-  FsFile* f = reinterpret_cast<FsFile*>(pFile->fHandle);
-  if (!f) return -1;
-  return f->seek(pos);
+  ImageSource* source = reinterpret_cast<ImageSource*>(pFile->fHandle);
+  if (!source) return -1;
+  return source->seek(pos);
 }
 
 // The PNG decoder (PNGdec) is ~42 KB due to internal zlib decompression buffers.
@@ -178,7 +169,7 @@ void convertLineToGray(uint8_t* pPixels, uint8_t* grayLine, int width, int pixel
 
 int pngDrawCallback(PNGDRAW* pDraw) {
   PngContext* ctx = reinterpret_cast<PngContext*>(pDraw->pUser);
-  if (!ctx || !ctx->config || !ctx->renderer || !ctx->grayLineBuffer) return 0;
+  if (!ctx || !ctx->config || !ctx->grayLineBuffer) return 0;
 
   int srcY = pDraw->y;
   int srcWidth = ctx->srcWidth;
@@ -206,6 +197,7 @@ int pngDrawCallback(PNGDRAW* pDraw) {
   int screenWidth = ctx->screenWidth;
   bool useDithering = ctx->config->useDithering;
   bool caching = ctx->caching;
+  GfxRenderer* renderer = ctx->renderer;  // null when only filling the cache
 
   int srcX = 0;
   int error = 0;
@@ -222,7 +214,7 @@ int pngDrawCallback(PNGDRAW* pDraw) {
         ditheredGray = gray / 85;
         if (ditheredGray > 3) ditheredGray = 3;
       }
-      drawPixelWithRenderMode(*ctx->renderer, outX, outY, ditheredGray);
+      if (renderer) drawPixelWithRenderMode(*renderer, outX, outY, ditheredGray);
       if (caching) ctx->cache.setPixel(outX, outY, ditheredGray);
     }
 
@@ -240,6 +232,15 @@ int pngDrawCallback(PNGDRAW* pDraw) {
 }  // namespace
 
 bool PngToFramebufferConverter::getDimensionsStatic(const std::string& imagePath, ImageDimensions& out) {
+  FileImageSource source(imagePath);
+  if (!source.open()) {
+    LOG_ERR("PNG", "Failed to open PNG for dimensions: %s", imagePath.c_str());
+    return false;
+  }
+  return getDimensionsStatic(source, out);
+}
+
+bool PngToFramebufferConverter::getDimensionsStatic(ImageSource& source, ImageDimensions& out) {
   size_t freeHeap = ESP.getFreeHeap();
   if (freeHeap < MIN_FREE_HEAP_FOR_PNG) {
     LOG_ERR("PNG", "Not enough heap for PNG decoder (%u free, need %u)", freeHeap, MIN_FREE_HEAP_FOR_PNG);
@@ -252,7 +253,7 @@ bool PngToFramebufferConverter::getDimensionsStatic(const std::string& imagePath
     return false;
   }
 
-  int rc = png->open(imagePath.c_str(), pngOpenWithHandle, pngCloseWithHandle, pngReadWithHandle, pngSeekWithHandle,
+  int rc = png->open(source.asOpenArg(), pngOpenWithHandle, pngCloseWithHandle, pngReadWithHandle, pngSeekWithHandle,
                      nullptr);
 
   if (rc != 0) {
@@ -271,7 +272,24 @@ bool PngToFramebufferConverter::getDimensionsStatic(const std::string& imagePath
 
 bool PngToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath, GfxRenderer& renderer,
                                                     const RenderConfig& config) {
-  LOG_DBG("PNG", "Decoding PNG: %s", imagePath.c_str());
+  FileImageSource source(imagePath);
+  if (!source.open()) {
+    LOG_ERR("PNG", "Failed to open PNG: %s", imagePath.c_str());
+    return false;
+  }
+  return decode(source, &renderer, config);
+}
+
+bool PngToFramebufferConverter::decodeToCache(ImageSource& source, const RenderConfig& config) {
+  if (config.cachePath.empty() || !config.useExactDimensions) {
+    LOG_ERR("PNG", "Cache-only decode needs a cache path and exact dimensions");
+    return false;
+  }
+  return decode(source, nullptr, config);
+}
+
+bool PngToFramebufferConverter::decode(ImageSource& source, GfxRenderer* renderer, const RenderConfig& config) {
+  LOG_DBG("PNG", "Decoding PNG: %s", source.getPath().c_str());
 
   size_t freeHeap = ESP.getFreeHeap();
   if (freeHeap < MIN_FREE_HEAP_FOR_PNG) {
@@ -287,12 +305,13 @@ bool PngToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath
   }
 
   PngContext ctx;
-  ctx.renderer = &renderer;
+  ctx.renderer = renderer;
   ctx.config = &config;
-  ctx.screenWidth = renderer.getScreenWidth();
-  ctx.screenHeight = renderer.getScreenHeight();
+  // Without a renderer the only output is the cache, which the exact dimensions bound
+  ctx.screenWidth = renderer ? renderer->getScreenWidth() : config.x + config.maxWidth;
+  ctx.screenHeight = renderer ? renderer->getScreenHeight() : config.y + config.maxHeight;
 
-  int rc = png->open(imagePath.c_str(), pngOpenWithHandle, pngCloseWithHandle, pngReadWithHandle, pngSeekWithHandle,
+  int rc = png->open(source.asOpenArg(), pngOpenWithHandle, pngCloseWithHandle, pngReadWithHandle, pngSeekWithHandle,
                      pngDrawCallback);
   if (rc != PNG_SUCCESS) {
     LOG_ERR("PNG", "Failed to open PNG: %d", rc);
@@ -343,7 +362,7 @@ bool PngToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath
   }
 
   if (png->getBpp() != 8) {
-    warnUnsupportedFeature("bit depth (" + std::to_string(png->getBpp()) + "bpp)", imagePath);
+    warnUnsupportedFeature("bit depth (" + std::to_string(png->getBpp()) + "bpp)", source.getPath());
   }
 
   // Allocate grayscale line buffer on demand (~3.2 KB) - freed after decode
@@ -360,6 +379,13 @@ bool PngToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath
   ctx.caching = !config.cachePath.empty();
   if (ctx.caching) {
     if (!ctx.cache.allocate(ctx.dstWidth, ctx.dstHeight, config.x, config.y)) {
+      if (!renderer) {
+        LOG_ERR("PNG", "Failed to allocate cache buffer");
+        free(ctx.grayLineBuffer);
+        png->close();
+        delete png;
+        return false;
+      }
       LOG_ERR("PNG", "Failed to allocate cache buffer, continuing without caching");
       ctx.caching = false;
     }
@@ -383,9 +409,12 @@ bool PngToFramebufferConverter::decodeToFramebuffer(const std::string& imagePath
   delete png;
   LOG_DBG("PNG", "PNG decoding complete - render time: %lu ms", decodeTime);
 
-  // Write cache file if caching was enabled and buffer was allocated
+  // Write cache file if caching was enabled and buffer was allocated; a cache-only decode has failed without it
   if (ctx.caching) {
-    ctx.cache.writeToFile(config.cachePath);
+    const auto orientation = renderer ? renderer->getOrientation() : config.cacheOrientation;
+    if (!ctx.cache.writeToFile(config.cachePath, orientation) && !renderer) {
+      return false;
+    }
   }
 
   return true;
@@ -5,13 +5,22 @@
 class PngToFramebufferConverter final : public ImageToFramebufferDecoder {
  public:
   static bool getDimensionsStatic(const std::string& imagePath, ImageDimensions& out);
+  static bool getDimensionsStatic(ImageSource& source, ImageDimensions& out);
 
   bool decodeToFramebuffer(const std::string& imagePath, GfxRenderer& renderer, const RenderConfig& config) override;
+  bool decodeToCache(ImageSource& source, const RenderConfig& config) override;
 
   bool getDimensions(const std::string& imagePath, ImageDimensions& dims) const override {
     return getDimensionsStatic(imagePath, dims);
   }
+  bool getDimensions(ImageSource& source, ImageDimensions& dims) const override {
+    return getDimensionsStatic(source, dims);
+  }
 
   static bool supportsFormat(const std::string& extension);
   const char* getFormatName() const override { return "PNG"; }
+
+ private:
+  // Shared by both entry points; renderer is null when only the cache is written
+  bool decode(ImageSource& source, GfxRenderer* renderer, const RenderConfig& config);
 };
\ No newline at end of file
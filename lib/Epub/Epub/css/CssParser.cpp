@@ -1,7 +1,9 @@
 #include "CssParser.h"
 
 #include <Arduino.h>
+#include <HeapTrace.h>
 #include <Logging.h>
+#include <Serialization.h>
 
 #include <algorithm>
 #include <array>
@@ -434,6 +436,7 @@ void CssParser::processRuleBlockWithStyle(const std::string& selectorGroup, cons
 // Main parsing entry point
 
 bool CssParser::loadFromStream(FsFile& source) {
+  HEAP_SCOPE(CSS);
   if (!source) {
     LOG_ERR("CSS", "Cannot read from invalid file");
     return false;
@@ -654,31 +657,33 @@ bool CssParser::saveToCache() const {
     return false;
   }
 
+  serialization::BufferedWriter writer(file);
+
   // Write version
-  file.write(CssParser::CSS_CACHE_VERSION);
+  writer.write(CssParser::CSS_CACHE_VERSION);
 
   // Write rule count
   const auto ruleCount = static_cast<uint16_t>(rulesBySelector_.size());
-  file.write(reinterpret_cast<const uint8_t*>(&ruleCount), sizeof(ruleCount));
+  serialization::writePod(writer, ruleCount);
 
   // Write each rule: selector string + CssStyle fields
   for (const auto& pair : rulesBySelector_) {
     // Write selector string (length-prefixed)
     const auto selectorLen = static_cast<uint16_t>(pair.first.size());
-    file.write(reinterpret_cast<const uint8_t*>(&selectorLen), sizeof(selectorLen));
-    file.write(reinterpret_cast<const uint8_t*>(pair.first.data()), selectorLen);
+    serialization::writePod(writer, selectorLen);
+    writer.write(pair.first.data(), selectorLen);
 
     // Write CssStyle fields (all are POD types)
     const CssStyle& style = pair.second;
-    file.write(static_cast<uint8_t>(style.textAlign));
-    file.write(static_cast<uint8_t>(style.fontStyle));
-    file.write(static_cast<uint8_t>(style.fontWeight));
-    file.write(static_cast<uint8_t>(style.textDecoration));
+    writer.write(static_cast<uint8_t>(style.textAlign));
+    writer.write(static_cast<uint8_t>(style.fontStyle));
+    writer.write(static_cast<uint8_t>(style.fontWeight));
+    writer.write(static_cast<uint8_t>(style.textDecoration));
 
     // Write CssLength fields (value + unit)
-    auto writeLength = [&file](const CssLength& len) {
-      file.write(reinterpret_cast<const uint8_t*>(&len.value), sizeof(len.value));
-      file.write(static_cast<uint8_t>(len.unit));
+    auto writeLength = [&writer](const CssLength& len) {
+      serialization::writePod(writer, len.value);
+      writer.write(static_cast<uint8_t>(len.unit));
     };
 
     writeLength(style.textIndent);
@@ -710,15 +715,22 @@ bool CssParser::saveToCache() const {
     if (style.defined.paddingRight) definedBits |= 1 << 12;
     if (style.defined.imageHeight) definedBits |= 1 << 13;
     if (style.defined.imageWidth) definedBits |= 1 << 14;
-    file.write(reinterpret_cast<const uint8_t*>(&definedBits), sizeof(definedBits));
+    serialization::writePod(writer, definedBits);
   }
 
-  LOG_DBG("CSS", "Saved %u rules to cache", ruleCount);
+  const bool writeOk = writer.flush();
   file.close();
+  if (!writeOk) {
+    LOG_ERR("CSS", "Failed to write rules cache");
+    Storage.remove((cachePath + rulesCache).c_str());
+    return false;
+  }
+  LOG_DBG("CSS", "Saved %u rules to cache", ruleCount);
   return true;
 }
 
 bool CssParser::loadFromCache() {
+  HEAP_SCOPE(CSS);
   if (cachePath.empty()) {
     return false;
   }
@@ -731,9 +743,11 @@ bool CssParser::loadFromCache() {
   // Clear existing rules
   clear();
 
+  serialization::BufferedReader reader(file);
+
   // Read and verify version
   uint8_t version = 0;
-  if (file.read(&version, 1) != 1 || version != CssParser::CSS_CACHE_VERSION) {
+  if (!serialization::readPod(reader, version) || version != CssParser::CSS_CACHE_VERSION) {
     LOG_DBG("CSS", "Cache version mismatch (got %u, expected %u), removing stale cache for rebuild", version,
             CssParser::CSS_CACHE_VERSION);
     file.close();
@@ -743,7 +757,7 @@ bool CssParser::loadFromCache() {
 
   // Read rule count
   uint16_t ruleCount = 0;
-  if (file.read(&ruleCount, sizeof(ruleCount)) != sizeof(ruleCount)) {
+  if (!serialization::readPod(reader, ruleCount)) {
     file.close();
     return false;
   }
@@ -752,15 +766,21 @@ bool CssParser::loadFromCache() {
   for (uint16_t i = 0; i < ruleCount; ++i) {
     // Read selector string
     uint16_t selectorLen = 0;
-    if (file.read(&selectorLen, sizeof(selectorLen)) != sizeof(selectorLen)) {
+    if (!serialization::readPod(reader, selectorLen)) {
       rulesBySelector_.clear();
       file.close();
       return false;
     }
 
+    if (selectorLen > reader.remaining()) {
+      LOG_ERR("CSS", "Cache corrupt: selector length %u exceeds file", selectorLen);
+      rulesBySelector_.clear();
+      file.close();
+      return false;
+    }
     std::string selector;
     selector.resize(selectorLen);
-    if (file.read(&selector[0], selectorLen) != selectorLen) {
+    if (!reader.read(&selector[0], selectorLen)) {
       rulesBySelector_.clear();
       file.close();
       return false;
@@ -770,28 +790,28 @@ bool CssParser::loadFromCache() {
     CssStyle style;
     uint8_t enumVal;
 
-    if (file.read(&enumVal, 1) != 1) {
+    if (!serialization::readPod(reader, enumVal)) {
       rulesBySelector_.clear();
       file.close();
       return false;
     }
     style.textAlign = static_cast<CssTextAlign>(enumVal);
 
-    if (file.read(&enumVal, 1) != 1) {
+    if (!serialization::readPod(reader, enumVal)) {
       rulesBySelector_.clear();
       file.close();
       return false;
     }
     style.fontStyle = static_cast<CssFontStyle>(enumVal);
 
-    if (file.read(&enumVal, 1) != 1) {
+    if (!serialization::readPod(reader, enumVal)) {
       rulesBySelector_.clear();
       file.close();
       return false;
     }
     style.fontWeight = static_cast<CssFontWeight>(enumVal);
 
-    if (file.read(&enumVal, 1) != 1) {
+    if (!serialization::readPod(reader, enumVal)) {
       rulesBySelector_.clear();
       file.close();
       return false;
@@ -799,12 +819,12 @@ bool CssParser::loadFromCache() {
     style.textDecoration = static_cast<CssTextDecoration>(enumVal);
 
     // Read CssLength fields
-    auto readLength = [&file](CssLength& len) -> bool {
-      if (file.read(&len.value, sizeof(len.value)) != sizeof(len.value)) {
+    auto readLength = [&reader](CssLength& len) -> bool {
+      if (!serialization::readPod(reader, len.value)) {
         return false;
       }
       uint8_t unitVal;
-      if (file.read(&unitVal, 1) != 1) {
+      if (!serialization::readPod(reader, unitVal)) {
         return false;
       }
       len.unit = static_cast<CssUnit>(unitVal);
@@ -822,7 +842,7 @@ bool CssParser::loadFromCache() {
 
     // Read defined flags
     uint16_t definedBits = 0;
-    if (file.read(&definedBits, sizeof(definedBits)) != sizeof(definedBits)) {
+    if (!serialization::readPod(reader, definedBits)) {
       rulesBySelector_.clear();
       file.close();
       return false;
@@ -4,11 +4,13 @@
 #include <GfxRenderer.h>
 #include <HalStorage.h>
 #include <Logging.h>
+#include <PerfTrace.h>
 #include <expat.h>
 
 #include "../../Epub.h"
 #include "../Page.h"
 #include "../converters/ImageDecoderFactory.h"
+#include "../converters/ImageSource.h"
 #include "../converters/ImageToFramebufferDecoder.h"
 #include "../htmlEntities.h"
 
@@ -37,6 +39,43 @@ constexpr int NUM_IMAGE_TAGS = sizeof(IMAGE_TAGS) / sizeof(IMAGE_TAGS[0]);
 const char* SKIP_TAGS[] = {"head"};
 constexpr int NUM_SKIP_TAGS = sizeof(SKIP_TAGS) / sizeof(SKIP_TAGS[0]);
 
+// Decodes an inline image from the EPUB straight into its pixel cache at display size, so the page is drawn from the
+// cache on its first visit. If that fails (usually too little heap left mid-chapter) the image is extracted instead and
+// ImageBlock decodes it the first time the page is shown.
+bool cacheInlineImage(const Epub& epub, ZipImageSource& source, ImageToFramebufferDecoder& decoder,
+                      const GfxRenderer::Orientation orientation, const std::string& imagePath, const int width,
+                      const int height) {
+  RenderConfig config;
+  config.x = 0;
+  config.y = 0;
+  config.maxWidth = width;
+  config.maxHeight = height;
+  config.useExactDimensions = true;
+  config.cachePath = ImageBlock::getCachePath(imagePath);
+  config.cacheOrientation = orientation;
+
+  const auto start = millis();
+  const bool cached = source.seek(0) && decoder.decodeToCache(source, config);
+  source.close();
+  if (cached) {
+    LOG_DBG("EHP", "Cached image %s in %lums", config.cachePath.c_str(), millis() - start);
+    return true;
+  }
+  Storage.remove(config.cachePath.c_str());
+
+  LOG_DBG("EHP", "Direct decode failed, extracting %s for decode on display", source.getPath().c_str());
+  FsFile imageFile;
+  if (!Storage.openFileForWrite("EHP", imagePath, imageFile)) {
+    return false;
+  }
+  const bool extracted = epub.readItemContentsToStream(source.getPath(), imageFile, 4096);
+  imageFile.close();
+  if (!extracted) {
+    Storage.remove(imagePath.c_str());
+  }
+  return extracted;
+}
+
 bool isWhitespace(const char c) { return c == ' ' || c == '\r' || c == '\n' || c == '\t'; }
 
 // given the start and end of a tag, check to see if it matches a known tag
@@ -279,21 +318,13 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
             }
             std::string cachedImagePath = self->imageBasePath + std::to_string(self->imageCounter++) + ext;
 
-            // Extract image to cache file
-            FsFile cachedImageFile;
-            bool extractSuccess = false;
-            if (Storage.openFileForWrite("EHP", cachedImagePath, cachedImageFile)) {
-              extractSuccess = self->epub->readItemContentsToStream(resolvedPath, cachedImageFile, 4096);
-              cachedImageFile.flush();
-              cachedImageFile.close();
-              delay(50);  // Give SD card time to sync
-            }
-
-            if (extractSuccess) {
+            // Read the image straight from the EPUB; normally only its pixel cache is written to SD
+            ZipImageSource imageSource(self->epub->getPath(), resolvedPath);
+            if (imageSource.open()) {
               // Get image dimensions
               ImageDimensions dims = {0, 0};
-              ImageToFramebufferDecoder* decoder = ImageDecoderFactory::getDecoder(cachedImagePath);
-              if (decoder && decoder->getDimensions(cachedImagePath, dims)) {
+              ImageToFramebufferDecoder* decoder = ImageDecoderFactory::getDecoder(resolvedPath);
+              if (decoder && decoder->getDimensions(imageSource, dims)) {
                 LOG_DBG("EHP", "Image dimensions: %dx%d", dims.width, dims.height);
 
                 int displayWidth = 0;
@@ -383,49 +414,53 @@ void XMLCALL ChapterHtmlSlimParser::startElement(void* userData, const XML_Char*
                   LOG_DBG("EHP", "Display size: %dx%d (scale %.2f)", displayWidth, displayHeight, scale);
                 }
 
-                // Create page for image - only break if image won't fit remaining space
-                if (self->currentPage && !self->currentPage->elements.empty() &&
-                    (self->currentPageNextY + displayHeight > self->viewportHeight)) {
-                  self->completePageFn(std::move(self->currentPage));
-                  self->completedPageCount++;
-                  self->currentPage.reset(new Page());
-                  if (!self->currentPage) {
-                    LOG_ERR("EHP", "Failed to create new page");
+                if (displayWidth > 0 && displayHeight > 0 &&
+                    cacheInlineImage(*self->epub, imageSource, *decoder, self->renderer.getOrientation(),
+                                     cachedImagePath, displayWidth, displayHeight)) {
+                  // Create page for image - only break if image won't fit remaining space
+                  if (self->currentPage && !self->currentPage->elements.empty() &&
+                      (self->currentPageNextY + displayHeight > self->viewportHeight)) {
+                    self->completePageFn(std::move(self->currentPage));
+                    self->completedPageCount++;
+                    self->currentPage.reset(new Page());
+                    if (!self->currentPage) {
+                      LOG_ERR("EHP", "Failed to create new page");
+                      return;
+                    }
+                    self->currentPageNextY = 0;
+                  } else if (!self->currentPage) {
+                    self->currentPage.reset(new Page());
+                    if (!self->currentPage) {
+                      LOG_ERR("EHP", "Failed to create initial page");
+                      return;
+                    }
+                    self->currentPageNextY = 0;
+                  }
+
+                  // Create ImageBlock and add to page
+                  auto imageBlock = std::make_shared<ImageBlock>(cachedImagePath, displayWidth, displayHeight);
+                  if (!imageBlock) {
+                    LOG_ERR("EHP", "Failed to create ImageBlock");
                     return;
                   }
-                  self->currentPageNextY = 0;
-                } else if (!self->currentPage) {
-                  self->currentPage.reset(new Page());
-                  if (!self->currentPage) {
-                    LOG_ERR("EHP", "Failed to create initial page");
+                  int xPos = (self->viewportWidth - displayWidth) / 2;
+                  auto pageImage = std::make_shared<PageImage>(imageBlock, xPos, self->currentPageNextY);
+                  if (!pageImage) {
+                    LOG_ERR("EHP", "Failed to create PageImage");
                     return;
                   }
-                  self->currentPageNextY = 0;
-                }
+                  self->currentPage->elements.push_back(pageImage);
+                  self->currentPageNextY += displayHeight;
 
-                // Create ImageBlock and add to page
-                auto imageBlock = std::make_shared<ImageBlock>(cachedImagePath, displayWidth, displayHeight);
-                if (!imageBlock) {
-                  LOG_ERR("EHP", "Failed to create ImageBlock");
+                  self->depth += 1;
                   return;
                 }
-                int xPos = (self->viewportWidth - displayWidth) / 2;
-                auto pageImage = std::make_shared<PageImage>(imageBlock, xPos, self->currentPageNextY);
-                if (!pageImage) {
-                  LOG_ERR("EHP", "Failed to create PageImage");
-                  return;
-                }
-                self->currentPage->elements.push_back(pageImage);
-                self->currentPageNextY += displayHeight;
-
-                self->depth += 1;
-                return;
+                LOG_ERR("EHP", "Failed to cache image");
               } else {
                 LOG_ERR("EHP", "Failed to get image dimensions");
-                Storage.remove(cachedImagePath.c_str());
               }
             } else {
-              LOG_ERR("EHP", "Failed to extract image");
+              LOG_ERR("EHP", "Failed to open image in EPUB");
             }
           }  // isFormatSupported
         }
@@ -961,6 +996,17 @@ bool ChapterHtmlSlimParser::parseAndBuildPages() {
   // Compute the time taken to parse and build pages
   const uint32_t chapterStartTime = millis();
   do {
+    if (progressFn && !progressFn()) {
+      LOG_DBG("EHP", "Stopped after %lu ms", millis() - chapterStartTime);
+      stopped = true;
+      XML_StopParser(parser, XML_FALSE);                // Stop any pending processing
+      XML_SetElementHandler(parser, nullptr, nullptr);  // Clear callbacks
+      XML_SetCharacterDataHandler(parser, nullptr);
+      XML_ParserFree(parser);
+      file.close();
+      return false;
+    }
+
     void* const buf = XML_GetBuffer(parser, PARSE_BUFFER_SIZE);
     if (!buf) {
       LOG_ERR("EHP", "Couldn't allocate memory for buffer");
@@ -986,7 +1032,12 @@ bool ChapterHtmlSlimParser::parseAndBuildPages() {
 
     done = file.available() == 0;
 
-    if (XML_ParseBuffer(parser, static_cast<int>(len), done) == XML_STATUS_ERROR) {
+    XML_Status status;
+    {
+      PERF_SCOPE(XML_PARSE);
+      status = XML_ParseBuffer(parser, static_cast<int>(len), done);
+    }
+    if (status == XML_STATUS_ERROR) {
       LOG_ERR("EHP", "Parse error at line %lu:\n%s", XML_GetCurrentLineNumber(parser),
               XML_ErrorString(XML_GetErrorCode(parser)));
       XML_StopParser(parser, XML_FALSE);                // Stop any pending processing
@@ -1,5 +1,6 @@
 #include "Bitmap.h"
 
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
@@ -19,6 +20,8 @@ Bitmap::~Bitmap() {
 
   delete atkinsonDitherer;
   delete fsDitherer;
+
+  free(bandBuffer);
 }
 
 uint16_t Bitmap::readLE16(FsFile& f) {
@@ -174,16 +177,92 @@ BmpReaderError Bitmap::parseHeaders() {
     }
   }
 
+  // 1-bit and 2-bit images already carry one of the panel's gray levels per pixel, so the whole palette/luminance
+  // path collapses to a per-byte table lookup.
+  usePackedLut = bpp <= 2;
+  if (usePackedLut) {
+    uint8_t level[4] = {};
+    for (uint32_t i = 0; i < 4; i++) {
+      level[i] = static_cast<uint8_t>(adjustPixel(paletteLum[i]) >> 6);
+    }
+    if (bpp == 2) {
+      for (int b = 0; b < 256; b++) {
+        packedLut[b] = (level[(b >> 6) & 3] << 6) | (level[(b >> 4) & 3] << 4) | (level[(b >> 2) & 3] << 2) |
+                       level[b & 3];
+      }
+    } else {
+      for (int n = 0; n < 16; n++) {
+        packedLut[n] = (level[(n >> 3) & 1] << 6) | (level[(n >> 2) & 1] << 4) | (level[(n >> 1) & 1] << 2) |
+                       level[n & 1];
+      }
+    }
+  }
+
+  bandFilledRows = 0;
+  bandNextRow = 0;
+  rowsConsumed = 0;
+
   return BmpReaderError::Ok;
 }
 
+// Returns a pointer to the next raw BMP row, either inside the band buffer or read directly into rowBuffer
+const uint8_t* Bitmap::nextRawRow(uint8_t* rowBuffer) const {
+  if (bandNextRow < bandFilledRows) {
+    rowsConsumed++;
+    return bandBuffer + static_cast<size_t>(bandNextRow++) * rowBytes;
+  }
+
+  if (!bandBuffer && rowBytes * 2 <= BAND_BUFFER_SIZE && height > 1) {
+    bandCapacityRows = BAND_BUFFER_SIZE / rowBytes;
+    bandBuffer = static_cast<uint8_t*>(malloc(static_cast<size_t>(bandCapacityRows) * rowBytes));
+    // Allocation failure just means falling back to per-row reads
+  }
+
+  if (bandBuffer) {
+    const int rowsToRead = std::min(bandCapacityRows, height - rowsConsumed);
+    if (rowsToRead > 0) {
+      const int bytes = rowsToRead * rowBytes;
+      const int got = file.read(bandBuffer, bytes);
+      bandFilledRows = got > 0 ? got / rowBytes : 0;
+      bandNextRow = 0;
+      if (bandFilledRows > 0) {
+        rowsConsumed++;
+        bandNextRow = 1;
+        return bandBuffer;
+      }
+    }
+    return nullptr;
+  }
+
+  // Note: rowBuffer should be pre-allocated by the caller to size 'rowBytes'
+  if (file.read(rowBuffer, rowBytes) != rowBytes) return nullptr;
+  rowsConsumed++;
+  return rowBuffer;
+}
+
 // packed 2bpp output, 0 = black, 1 = dark gray, 2 = light gray, 3 = white
 BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
-  // Note: rowBuffer should be pre-allocated by the caller to size 'rowBytes'
-  if (file.read(rowBuffer, rowBytes) != rowBytes) return BmpReaderError::ShortReadRow;
+  const uint8_t* row = nextRawRow(rowBuffer);
+  if (!row) return BmpReaderError::ShortReadRow;
 
   prevRowY += 1;
 
+  if (usePackedLut) {
+    const int outBytes = (width + 3) / 4;
+    if (bpp == 2) {
+      for (int i = 0; i < outBytes; i++) data[i] = packedLut[row[i]];
+    } else {
+      for (int i = 0; i < outBytes; i++) {
+        const uint8_t src = row[i >> 1];
+        data[i] = packedLut[(i & 1) ? (src & 0x0F) : (src >> 4)];
+      }
+    }
+    // Keep padding pixels zeroed like the per-pixel path does
+    const int tailPixels = width & 3;
+    if (tailPixels) data[outBytes - 1] &= static_cast<uint8_t>(0xFF << (8 - tailPixels * 2));
+    return BmpReaderError::Ok;
+  }
+
   uint8_t* outPtr = data;
   uint8_t currentOutByte = 0;
   int bitShift = 6;
@@ -220,7 +299,7 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
 
   switch (bpp) {
     case 32: {
-      const uint8_t* p = rowBuffer;
+      const uint8_t* p = row;
       for (int x = 0; x < width; x++) {
         lum = (77u * p[2] + 150u * p[1] + 29u * p[0]) >> 8;
         packPixel(lum);
@@ -229,7 +308,7 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
       break;
     }
     case 24: {
-      const uint8_t* p = rowBuffer;
+      const uint8_t* p = row;
       for (int x = 0; x < width; x++) {
         lum = (77u * p[2] + 150u * p[1] + 29u * p[0]) >> 8;
         packPixel(lum);
@@ -239,20 +318,20 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
     }
     case 8: {
       for (int x = 0; x < width; x++) {
-        packPixel(paletteLum[rowBuffer[x]]);
+        packPixel(paletteLum[row[x]]);
       }
       break;
     }
     case 4: {
       for (int x = 0; x < width; x++) {
-        const uint8_t nibble = (x & 1) ? (rowBuffer[x >> 1] & 0x0F) : (rowBuffer[x >> 1] >> 4);
+        const uint8_t nibble = (x & 1) ? (row[x >> 1] & 0x0F) : (row[x >> 1] >> 4);
         packPixel(paletteLum[nibble]);
       }
       break;
     }
     case 2: {
       for (int x = 0; x < width; x++) {
-        lum = paletteLum[(rowBuffer[x >> 2] >> (6 - ((x & 3) * 2))) & 0x03];
+        lum = paletteLum[(row[x >> 2] >> (6 - ((x & 3) * 2))) & 0x03];
         packPixel(lum);
       }
       break;
@@ -260,7 +339,7 @@ BmpReaderError Bitmap::readNextRow(uint8_t* data, uint8_t* rowBuffer) const {
     case 1: {
       for (int x = 0; x < width; x++) {
         // Get palette index (0 or 1) from bit at position x
-        const uint8_t palIndex = (rowBuffer[x >> 3] & (0x80 >> (x & 7))) ? 1 : 0;
+        const uint8_t palIndex = (row[x >> 3] & (0x80 >> (x & 7))) ? 1 : 0;
         // Use palette lookup for proper black/white mapping
         lum = paletteLum[palIndex];
         packPixel(lum);
@@ -287,6 +366,11 @@ BmpReaderError Bitmap::rewindToData() const {
     return BmpReaderError::SeekPixelDataFailed;
   }
 
+  // Band contents are stale after a seek; keep the allocation for the next pass
+  bandFilledRows = 0;
+  bandNextRow = 0;
+  rowsConsumed = 0;
+
   // Reset dithering when rewinding
   if (fsDitherer) fsDitherer->reset();
   if (atkinsonDitherer) atkinsonDitherer->reset();
@@ -78,8 +78,13 @@ class Bitmap {
   uint16_t getBpp() const { return bpp; }
 
  private:
+  // Rows are pulled from SD in bands of up to this many bytes (a multiple of the 512-byte sector size) instead of
+  // one read per row. Images whose rows don't fit twice into a band are read row by row.
+  static constexpr int BAND_BUFFER_SIZE = 4096;
+
   static uint16_t readLE16(FsFile& f);
   static uint32_t readLE32(FsFile& f);
+  const uint8_t* nextRawRow(uint8_t* rowBuffer) const;
 
   FsFile& file;
   bool dithering = false;
@@ -92,6 +97,17 @@ class Bitmap {
   bool nativePalette = false;  // true if all palette entries map to native gray levels
   int rowBytes = 0;
   uint8_t paletteLum[256] = {};
+  // 1bpp/2bpp fast path: packed source bits -> packed 2bpp output without per-pixel work.
+  // For 2bpp, indexed by a whole source byte (4 pixels); for 1bpp, by a source nibble (4 pixels).
+  bool usePackedLut = false;
+  uint8_t packedLut[256] = {};
+
+  // Band read state (mutable for const methods)
+  mutable uint8_t* bandBuffer = nullptr;
+  mutable int bandCapacityRows = 0;
+  mutable int bandFilledRows = 0;
+  mutable int bandNextRow = 0;
+  mutable int rowsConsumed = 0;
 
   // Dithering state (mutable for const methods)
   mutable int16_t* errorCurRow = nullptr;
@@ -1,8 +1,13 @@
 #include "GfxRenderer.h"
 
 #include <Logging.h>
+#include <HeapTrace.h>
+#include <PerfTrace.h>
 #include <Utf8.h>
 
+#include <algorithm>
+#include <cstring>
+
 const uint8_t* GfxRenderer::getGlyphBitmap(const EpdFontData* fontData, const EpdGlyph* glyph) const {
   if (fontData->groups != nullptr) {
     if (!fontDecompressor) {
@@ -634,6 +639,11 @@ void GfxRenderer::drawBitmap(const Bitmap& bitmap, const int x, const int y, con
     }
 
     for (int bmpX = cropPixX; bmpX < bitmap.getWidth() - cropPixX; bmpX++) {
+      // Four white pixels in one byte: nothing to draw in any render mode
+      if ((bmpX & 3) == 0 && outputRow[bmpX / 4] == 0xFF) {
+        bmpX += 3;
+        continue;
+      }
       int screenX = bmpX - cropPixX;
       if (isScaled) {
         screenX = std::floor(screenX * scale);
@@ -707,6 +717,11 @@ void GfxRenderer::drawBitmap1Bit(const Bitmap& bitmap, const int x, const int y,
     }
 
     for (int bmpX = 0; bmpX < bitmap.getWidth(); bmpX++) {
+      // Four white pixels in one byte: leave background
+      if ((bmpX & 3) == 0 && outputRow[bmpX / 4] == 0xFF) {
+        bmpX += 3;
+        continue;
+      }
       int screenX = x + (isScaled ? static_cast<int>(std::floor(bmpX * scale)) : bmpX);
       if (screenX >= getScreenWidth()) {
         break;
@@ -816,6 +831,7 @@ void GfxRenderer::invertScreen() const {
 void GfxRenderer::displayBuffer(const HalDisplay::RefreshMode refreshMode) const {
   auto elapsed = millis() - start_ms;
   LOG_DBG("GFX", "Time = %lu ms from clearScreen to displayBuffer", elapsed);
+  PERF_SCOPE(DISPLAY_REFRESH);
   display.displayBuffer(refreshMode, fadingFix);
 }
 
@@ -1078,6 +1094,177 @@ uint8_t* GfxRenderer::getFrameBuffer() const { return frameBuffer; }
 
 size_t GfxRenderer::getBufferSize() { return HalDisplay::BUFFER_SIZE; }
 
+namespace {
+// Byte-aligned physical bounds of a logical rectangle
+struct PhysicalRegion {
+  int firstByte;
+  int byteCount;
+  int firstRow;
+  int rowCount;
+  int shift;          // bit offset of the rectangle's left edge within the first byte
+  uint8_t leftMask;   // bits of the first byte inside the rectangle
+  uint8_t rightMask;  // bits of the last byte inside the rectangle
+};
+
+constexpr size_t REGION_CHUNK_SIZE = 4096;
+}  // namespace
+
+static bool getPhysicalRegion(const GfxRenderer::Orientation orientation, const int x, const int y, const int width,
+                              const int height, PhysicalRegion* out) {
+  if (width <= 0 || height <= 0) {
+    return false;
+  }
+
+  int x0, y0, x1, y1;
+  rotateCoordinates(orientation, x, y, &x0, &y0);
+  rotateCoordinates(orientation, x + width - 1, y + height - 1, &x1, &y1);
+
+  const int minX = std::max(0, std::min(x0, x1));
+  const int maxX = std::min(HalDisplay::DISPLAY_WIDTH - 1, std::max(x0, x1));
+  const int minY = std::max(0, std::min(y0, y1));
+  const int maxY = std::min(HalDisplay::DISPLAY_HEIGHT - 1, std::max(y0, y1));
+  if (minX > maxX || minY > maxY) {
+    return false;
+  }
+
+  out->firstByte = minX / 8;
+  out->byteCount = maxX / 8 - minX / 8 + 1;
+  out->firstRow = minY;
+  out->rowCount = maxY - minY + 1;
+  out->shift = minX % 8;
+  out->leftMask = 0xFF >> (minX % 8);
+  out->rightMask = static_cast<uint8_t>(0xFF << (7 - maxX % 8));
+  if (out->byteCount == 1) {
+    out->leftMask &= out->rightMask;
+    out->rightMask = out->leftMask;
+  }
+  return true;
+}
+
+size_t GfxRenderer::getRegionSize(const int x, const int y, const int width, const int height) const {
+  PhysicalRegion region;
+  if (!getPhysicalRegion(orientation, x, y, width, height, &region)) {
+    return 0;
+  }
+  return static_cast<size_t>(region.byteCount) * region.rowCount;
+}
+
+bool GfxRenderer::writeRegion(FsFile& file, const int x, const int y, const int width, const int height) const {
+  PhysicalRegion region;
+  if (!getPhysicalRegion(orientation, x, y, width, height, &region)) {
+    return false;
+  }
+
+  // Full-width regions are contiguous in the framebuffer
+  if (region.byteCount == HalDisplay::DISPLAY_WIDTH_BYTES) {
+    const size_t len = static_cast<size_t>(region.byteCount) * region.rowCount;
+    return file.write(frameBuffer + region.firstRow * HalDisplay::DISPLAY_WIDTH_BYTES, len) == len;
+  }
+
+  // Otherwise gather rows into chunks so the SD card sees a few large writes
+  const int rowsPerChunk = std::max<int>(1, REGION_CHUNK_SIZE / region.byteCount);
+  auto* chunk = static_cast<uint8_t*>(malloc(static_cast<size_t>(rowsPerChunk) * region.byteCount));
+  if (!chunk) {
+    LOG_ERR("GFX", "!! Failed to allocate region chunk");
+    return false;
+  }
+
+  bool ok = true;
+  for (int row = 0; row < region.rowCount && ok; row += rowsPerChunk) {
+    const int rows = std::min(rowsPerChunk, region.rowCount - row);
+    for (int i = 0; i < rows; i++) {
+      memcpy(chunk + i * region.byteCount,
+             frameBuffer + (region.firstRow + row + i) * HalDisplay::DISPLAY_WIDTH_BYTES + region.firstByte,
+             region.byteCount);
+    }
+    const size_t len = static_cast<size_t>(rows) * region.byteCount;
+    ok = file.write(chunk, len) == len;
+  }
+
+  free(chunk);
+  return ok;
+}
+
+bool GfxRenderer::readRegion(FsFile& file, const int x, const int y, const int width, const int height) const {
+  PhysicalRegion region;
+  if (!getPhysicalRegion(orientation, x, y, width, height, &region)) {
+    return false;
+  }
+
+  if (region.byteCount == HalDisplay::DISPLAY_WIDTH_BYTES) {
+    const int len = region.byteCount * region.rowCount;
+    return file.read(frameBuffer + region.firstRow * HalDisplay::DISPLAY_WIDTH_BYTES, len) == len;
+  }
+
+  const int rowsPerChunk = std::max<int>(1, REGION_CHUNK_SIZE / region.byteCount);
+  auto* chunk = static_cast<uint8_t*>(malloc(static_cast<size_t>(rowsPerChunk) * region.byteCount));
+  if (!chunk) {
+    LOG_ERR("GFX", "!! Failed to allocate region chunk");
+    return false;
+  }
+
+  const int lastByte = region.byteCount - 1;
+  bool ok = true;
+  for (int row = 0; row < region.rowCount && ok; row += rowsPerChunk) {
+    const int rows = std::min(rowsPerChunk, region.rowCount - row);
+    const int len = rows * region.byteCount;
+    if (file.read(chunk, len) != len) {
+      ok = false;
+      break;
+    }
+    for (int i = 0; i < rows; i++) {
+      const uint8_t* src = chunk + i * region.byteCount;
+      uint8_t* dst = frameBuffer + (region.firstRow + row + i) * HalDisplay::DISPLAY_WIDTH_BYTES + region.firstByte;
+      dst[0] = (dst[0] & ~region.leftMask) | (src[0] & region.leftMask);
+      if (lastByte > 0) {
+        if (lastByte > 1) {
+          memcpy(dst + 1, src + 1, lastByte - 1);
+        }
+        dst[lastByte] = (dst[lastByte] & ~region.rightMask) | (src[lastByte] & region.rightMask);
+      }
+    }
+  }
+
+  free(chunk);
+  return ok;
+}
+
+void GfxRenderer::drawPlaneRows(const int x, const int y, const int width, const int height, const uint8_t* rows,
+                                const int rowBytes, const int firstRow, const int rowCount, const bool black) const {
+  PhysicalRegion region;
+  if (!getPhysicalRegion(orientation, x, y, width, height, &region) || firstRow < 0 ||
+      firstRow + rowCount > region.rowCount) {
+    return;
+  }
+
+  const int lastByte = region.byteCount - 1;
+  const int shift = region.shift;
+  for (int i = 0; i < rowCount; i++) {
+    const uint8_t* src = rows + i * rowBytes;
+    uint8_t* dst = frameBuffer + (region.firstRow + firstRow + i) * HalDisplay::DISPLAY_WIDTH_BYTES + region.firstByte;
+    for (int k = 0; k <= lastByte; k++) {
+      // Source byte realigned to the framebuffer's byte grid
+      uint8_t bits;
+      if (shift == 0) {
+        bits = src[k];
+      } else {
+        const uint8_t prev = k > 0 ? src[k - 1] : 0;
+        const uint8_t cur = k < rowBytes ? src[k] : 0;
+        bits = static_cast<uint8_t>(prev << (8 - shift)) | static_cast<uint8_t>(cur >> shift);
+      }
+      uint8_t mask = 0xFF;
+      if (k == 0) mask &= region.leftMask;
+      if (k == lastByte) mask &= region.rightMask;
+
+      if (black) {
+        dst[k] &= bits | static_cast<uint8_t>(~mask);
+      } else {
+        dst[k] |= bits & mask;
+      }
+    }
+  }
+}
+
 // unused
 // void GfxRenderer::grayscaleRevert() const { display.grayscaleRevert(); }
 
@@ -1085,12 +1272,15 @@ void GfxRenderer::copyGrayscaleLsbBuffers() const { display.copyGrayscaleLsbBuff
 
 void GfxRenderer::copyGrayscaleMsbBuffers() const { display.copyGrayscaleMsbBuffers(frameBuffer); }
 
-void GfxRenderer::displayGrayBuffer() const { display.displayGrayBuffer(fadingFix); }
+void GfxRenderer::displayGrayBuffer() const {
+  PERF_SCOPE(DISPLAY_REFRESH);
+  display.displayGrayBuffer(fadingFix);
+}
 
 void GfxRenderer::freeBwBufferChunks() {
   for (auto& bwBufferChunk : bwBufferChunks) {
     if (bwBufferChunk) {
-      free(bwBufferChunk);
+      HEAP_FREE(bwBufferChunk);
       bwBufferChunk = nullptr;
     }
   }
@@ -1108,12 +1298,12 @@ bool GfxRenderer::storeBwBuffer() {
     // Check if any chunks are already allocated
     if (bwBufferChunks[i]) {
       LOG_ERR("GFX", "!! BW buffer chunk %zu already stored - this is likely a bug, freeing chunk", i);
-      free(bwBufferChunks[i]);
+      HEAP_FREE(bwBufferChunks[i]);
       bwBufferChunks[i] = nullptr;
     }
 
     const size_t offset = i * BW_BUFFER_CHUNK_SIZE;
-    bwBufferChunks[i] = static_cast<uint8_t*>(malloc(BW_BUFFER_CHUNK_SIZE));
+    bwBufferChunks[i] = static_cast<uint8_t*>(HEAP_MALLOC(DISPLAY, BW_BUFFER_CHUNK_SIZE));
 
     if (!bwBufferChunks[i]) {
       LOG_ERR("GFX", "!! Failed to allocate BW buffer chunk %zu (%zu bytes)", i, BW_BUFFER_CHUNK_SIZE);
@@ -147,4 +147,17 @@ class GfxRenderer {
   // Low level functions
   uint8_t* getFrameBuffer() const;
   static size_t getBufferSize();
+
+  // Raw framebuffer copies of a logical rectangle, stored as the physical rows it covers (see PlaneCache).
+  // Edge bytes shared with neighbouring pixels are masked on read so only the rectangle is overwritten.
+  size_t getRegionSize(int x, int y, int width, int height) const;
+  bool writeRegion(FsFile& file, int x, int y, int width, int height) const;
+  bool readRegion(FsFile& file, int x, int y, int width, int height) const;
+
+  // Merges 1-bit rows that are already rotated to the panel layout into the logical rectangle x,y,width,height.
+  // `rows` holds `rowCount` rows of `rowBytes` bytes, starting at row `firstRow` of the rectangle's physical extent,
+  // each packed MSB first from its physical left edge. Like drawPixel, black rows clear the framebuffer bits whose
+  // source bit is 0 and white rows set the bits whose source bit is 1; everything else is left alone.
+  void drawPlaneRows(int x, int y, int width, int height, const uint8_t* rows, int rowBytes, int firstRow,
+                     int rowCount, bool black) const;
 };
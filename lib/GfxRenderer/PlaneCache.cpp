@@ -0,0 +1,103 @@
+#include "PlaneCache.h"
+
+#include <Logging.h>
+
+#include <cstring>
+
+#include "GfxRenderer.h"
+
+namespace {
+constexpr uint32_t PLANE_CACHE_MAGIC = 0x4E4C5043;  // "CPLN"
+constexpr uint8_t PLANE_CACHE_VERSION = 1;
+
+#pragma pack(push, 1)
+struct PlaneCacheHeader {
+  uint32_t magic;
+  uint8_t version;
+  uint8_t orientation;
+  uint8_t planes;
+  uint8_t reserved;
+  int16_t x;
+  int16_t y;
+  int16_t width;
+  int16_t height;
+  uint32_t sourceTag;
+  uint32_t planeSize;
+};
+#pragma pack(pop)
+
+PlaneCacheHeader makeHeader(const GfxRenderer& renderer, const PlaneCache::Key& key) {
+  PlaneCacheHeader header = {};
+  header.magic = PLANE_CACHE_MAGIC;
+  header.version = PLANE_CACHE_VERSION;
+  header.orientation = static_cast<uint8_t>(renderer.getOrientation());
+  header.planes = key.planes;
+  header.x = static_cast<int16_t>(key.x);
+  header.y = static_cast<int16_t>(key.y);
+  header.width = static_cast<int16_t>(key.width);
+  header.height = static_cast<int16_t>(key.height);
+  header.sourceTag = key.sourceTag;
+  header.planeSize = renderer.getRegionSize(key.x, key.y, key.width, key.height);
+  return header;
+}
+}  // namespace
+
+std::string PlaneCache::getPathFor(const std::string& bmpPath) {
+  const size_t dot = bmpPath.rfind('.');
+  const size_t slash = bmpPath.rfind('/');
+  if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) {
+    return bmpPath + ".pln";
+  }
+  return bmpPath.substr(0, dot) + ".pln";
+}
+
+uint32_t PlaneCache::makeSourceTag(FsFile& bmpFile, const uint8_t variant) {
+  return (static_cast<uint32_t>(bmpFile.size()) & 0x00FFFFFF) | (static_cast<uint32_t>(variant) << 24);
+}
+
+bool PlaneCache::openForRead(const std::string& path, const GfxRenderer& renderer, const Key& key, FsFile& file) {
+  if (key.planes == 0 || key.planes > MAX_PLANES || !Storage.exists(path.c_str())) {
+    return false;
+  }
+  if (!Storage.openFileForRead("PLN", path, file)) {
+    return false;
+  }
+
+  const PlaneCacheHeader expected = makeHeader(renderer, key);
+  PlaneCacheHeader header;
+  if (file.read(&header, sizeof(header)) != sizeof(header) || memcmp(&header, &expected, sizeof(header)) != 0 ||
+      file.size() != sizeof(header) + static_cast<size_t>(header.planeSize) * header.planes) {
+    LOG_DBG("PLN", "Stale plane cache: %s", path.c_str());
+    file.close();
+    return false;
+  }
+  return true;
+}
+
+bool PlaneCache::openForWrite(const std::string& path, const GfxRenderer& renderer, const Key& key, FsFile& file) {
+  if (key.planes == 0 || key.planes > MAX_PLANES) {
+    return false;
+  }
+  const PlaneCacheHeader header = makeHeader(renderer, key);
+  if (header.planeSize == 0) {
+    return false;
+  }
+  if (!Storage.openFileForWrite("PLN", path, file)) {
+    return false;
+  }
+  if (file.write(reinterpret_cast<const uint8_t*>(&header), sizeof(header)) != sizeof(header)) {
+    finish(path, file, false);
+    return false;
+  }
+  return true;
+}
+
+void PlaneCache::finish(const std::string& path, FsFile& file, const bool ok) {
+  file.close();
+  if (!ok) {
+    LOG_ERR("PLN", "Failed to write plane cache: %s", path.c_str());
+    Storage.remove(path.c_str());
+  } else {
+    LOG_DBG("PLN", "Wrote plane cache: %s", path.c_str());
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <HalStorage.h>
+
+#include <cstdint>
+#include <string>
+
+class GfxRenderer;
+
+/**
+ * Panel-native snapshot of a drawn cover or thumbnail.
+ *
+ * Drawing a BMP means scaling, converting and dithering every pixel, once per render pass. A plane cache file holds
+ * the result of those passes as raw physical framebuffer rows for a logical rectangle: one plane for BW-only images,
+ * or BW, LSB and MSB planes for grayscale ones. Restoring it is a handful of SD reads and row copies.
+ *
+ * The header records the orientation, rectangle, plane count and a caller-chosen source tag. A snapshot is only used
+ * if all of them match; otherwise the caller draws the BMP as before and rewrites the file.
+ */
+class PlaneCache {
+ public:
+  static constexpr uint8_t MAX_PLANES = 3;
+
+  struct Key {
+    int x;
+    int y;
+    int width;
+    int height;
+    uint8_t planes;      // 1 = BW only, 3 = BW + grayscale LSB + MSB
+    uint32_t sourceTag;  // identifies the source image and any settings baked into the planes
+  };
+
+  // "cover.bmp" -> "cover.pln"
+  static std::string getPathFor(const std::string& bmpPath);
+  // Source tag from the BMP file size plus a small variant (e.g. a filter setting)
+  static uint32_t makeSourceTag(FsFile& bmpFile, uint8_t variant = 0);
+
+  // On success `file` is positioned at the first plane
+  static bool openForRead(const std::string& path, const GfxRenderer& renderer, const Key& key, FsFile& file);
+  // Writes the header; the caller follows with one GfxRenderer::writeRegion per plane, then finish()
+  static bool openForWrite(const std::string& path, const GfxRenderer& renderer, const Key& key, FsFile& file);
+  // Closes the file, removing it if any plane failed to write
+  static void finish(const std::string& path, FsFile& file, bool ok);
+};
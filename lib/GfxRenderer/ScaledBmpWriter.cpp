@@ -0,0 +1,239 @@
+#include "ScaledBmpWriter.h"
+
+#include <Logging.h>
+#include <Print.h>
+
+#include <cstdlib>
+#include <cstring>
+
+// ============================================================================
+// IMAGE PROCESSING OPTIONS - shared by the JPEG and PNG converters
+// ============================================================================
+constexpr bool USE_8BIT_OUTPUT = false;  // true: 8-bit grayscale (no quantization), false: 2-bit (4 levels)
+// Dithering method selection (only one should be true, or all false for simple quantization):
+constexpr bool USE_ATKINSON = true;          // Atkinson dithering (cleaner than F-S, less error diffusion)
+constexpr bool USE_FLOYD_STEINBERG = false;  // Floyd-Steinberg error diffusion (can cause "worm" artifacts)
+// ============================================================================
+
+static inline void write16(Print& out, const uint16_t value) {
+  out.write(value & 0xFF);
+  out.write((value >> 8) & 0xFF);
+}
+
+static inline void write32(Print& out, const uint32_t value) {
+  out.write(value & 0xFF);
+  out.write((value >> 8) & 0xFF);
+  out.write((value >> 16) & 0xFF);
+  out.write((value >> 24) & 0xFF);
+}
+
+// BMP file + BITMAPINFOHEADER for a top-down image with a gray palette of `colors` entries
+static void writeBmpHeader(Print& bmpOut, const int width, const int height, const uint16_t bpp,
+                           const int bytesPerRow) {
+  const uint32_t colors = 1u << bpp;
+  const uint32_t paletteSize = colors * 4;
+  const uint32_t imageSize = bytesPerRow * height;
+  const uint32_t dataOffset = 14 + 40 + paletteSize;
+
+  // BMP File Header (14 bytes)
+  bmpOut.write('B');
+  bmpOut.write('M');
+  write32(bmpOut, dataOffset + imageSize);  // File size
+  write32(bmpOut, 0);                       // Reserved
+  write32(bmpOut, dataOffset);              // Offset to pixel data
+
+  // DIB Header (BITMAPINFOHEADER - 40 bytes)
+  write32(bmpOut, 40);
+  write32(bmpOut, static_cast<uint32_t>(width));
+  write32(bmpOut, static_cast<uint32_t>(-height));  // Negative height = top-down bitmap
+  write16(bmpOut, 1);                               // Color planes
+  write16(bmpOut, bpp);                             // Bits per pixel
+  write32(bmpOut, 0);                               // BI_RGB (no compression)
+  write32(bmpOut, imageSize);
+  write32(bmpOut, 2835);  // xPixelsPerMeter (72 DPI)
+  write32(bmpOut, 2835);  // yPixelsPerMeter (72 DPI)
+  write32(bmpOut, colors);
+  write32(bmpOut, colors);
+
+  // Evenly spaced gray palette (BGRA): 1-bit = black/white, 2-bit = 0/85/170/255
+  for (uint32_t i = 0; i < colors; i++) {
+    const uint8_t level = static_cast<uint8_t>(i * 255 / (colors - 1));
+    bmpOut.write(level);
+    bmpOut.write(level);
+    bmpOut.write(level);
+    bmpOut.write(static_cast<uint8_t>(0));
+  }
+}
+
+ScaledBmpWriter::ScaledBmpWriter(Print& out, const int srcWidth, const int srcHeight, const int targetWidth,
+                                 const int targetHeight, const bool oneBit, const bool crop)
+    : out(out), srcWidth(srcWidth), outWidth(srcWidth), outHeight(srcHeight), oneBit(oneBit) {
+  if (targetWidth > 0 && targetHeight > 0 && (srcWidth != targetWidth || srcHeight != targetHeight)) {
+    // Scale to fit/fill target dimensions while maintaining aspect ratio
+    const float scaleToFitWidth = static_cast<float>(targetWidth) / srcWidth;
+    const float scaleToFitHeight = static_cast<float>(targetHeight) / srcHeight;
+    // When cropping, scale to the larger factor so the image fills the target; otherwise fit inside it
+    float scale;
+    if (crop) {
+      scale = (scaleToFitWidth > scaleToFitHeight) ? scaleToFitWidth : scaleToFitHeight;
+    } else {
+      scale = (scaleToFitWidth < scaleToFitHeight) ? scaleToFitWidth : scaleToFitHeight;
+    }
+
+    outWidth = static_cast<int>(srcWidth * scale);
+    outHeight = static_cast<int>(srcHeight * scale);
+    if (outWidth < 1) outWidth = 1;
+    if (outHeight < 1) outHeight = 1;
+
+    scaleX_fp = (static_cast<uint32_t>(srcWidth) << 16) / outWidth;
+    scaleY_fp = (static_cast<uint32_t>(srcHeight) << 16) / outHeight;
+    needsScaling = true;
+
+    LOG_DBG("BMW", "Scaling %dx%d -> %dx%d (target %dx%d)", srcWidth, srcHeight, outWidth, outHeight, targetWidth,
+            targetHeight);
+  }
+}
+
+ScaledBmpWriter::~ScaledBmpWriter() {
+  delete[] rowAccum;
+  delete[] rowCount;
+  delete atkinsonDitherer;
+  delete fsDitherer;
+  delete atkinson1BitDitherer;
+  free(grayOut);
+  free(rowBuffer);
+}
+
+bool ScaledBmpWriter::begin() {
+  uint16_t bpp;
+  if (USE_8BIT_OUTPUT && !oneBit) {
+    bpp = 8;
+    bytesPerRow = (outWidth + 3) / 4 * 4;
+  } else if (oneBit) {
+    bpp = 1;
+    bytesPerRow = (outWidth + 31) / 32 * 4;
+  } else {
+    bpp = 2;
+    bytesPerRow = (outWidth * 2 + 31) / 32 * 4;
+  }
+
+  rowBuffer = static_cast<uint8_t*>(malloc(bytesPerRow));
+  if (!rowBuffer) {
+    LOG_ERR("BMW", "Failed to allocate row buffer");
+    return false;
+  }
+
+  if (needsScaling) {
+    grayOut = static_cast<uint8_t*>(malloc(outWidth));
+    rowAccum = new uint32_t[outWidth]();
+    rowCount = new uint16_t[outWidth]();
+    nextOutY_srcStart = scaleY_fp;  // First boundary is at scaleY_fp (source Y for outY=1)
+    if (!grayOut) {
+      LOG_ERR("BMW", "Failed to allocate scaled row buffer");
+      return false;
+    }
+  }
+
+  // Dither at output resolution (after prescaling)
+  if (oneBit) {
+    atkinson1BitDitherer = new Atkinson1BitDitherer(outWidth);
+  } else if (!USE_8BIT_OUTPUT) {
+    if (USE_ATKINSON) {
+      atkinsonDitherer = new AtkinsonDitherer(outWidth);
+    } else if (USE_FLOYD_STEINBERG) {
+      fsDitherer = new FloydSteinbergDitherer(outWidth);
+    }
+  }
+
+  writeBmpHeader(out, outWidth, outHeight, bpp, bytesPerRow);
+  return true;
+}
+
+void ScaledBmpWriter::emitRow(const int outY, const uint8_t* grayRow) {
+  memset(rowBuffer, 0, bytesPerRow);
+
+  if (USE_8BIT_OUTPUT && !oneBit) {
+    for (int x = 0; x < outWidth; x++) {
+      rowBuffer[x] = adjustPixel(grayRow[x]);
+    }
+  } else if (oneBit) {
+    // 1-bit output with Atkinson dithering for better quality
+    for (int x = 0; x < outWidth; x++) {
+      const uint8_t bit =
+          atkinson1BitDitherer ? atkinson1BitDitherer->processPixel(grayRow[x], x) : quantize1bit(grayRow[x], x, outY);
+      // Pack 1-bit value: MSB first, 8 pixels per byte
+      rowBuffer[x / 8] |= (bit << (7 - (x % 8)));
+    }
+    if (atkinson1BitDitherer) atkinson1BitDitherer->nextRow();
+  } else {
+    // 2-bit output
+    for (int x = 0; x < outWidth; x++) {
+      const uint8_t gray = adjustPixel(grayRow[x]);
+      uint8_t twoBit;
+      if (atkinsonDitherer) {
+        twoBit = atkinsonDitherer->processPixel(gray, x);
+      } else if (fsDitherer) {
+        twoBit = fsDitherer->processPixel(gray, x);
+      } else {
+        twoBit = quantize(gray, x, outY);
+      }
+      rowBuffer[(x * 2) / 8] |= (twoBit << (6 - ((x * 2) % 8)));
+    }
+    if (atkinsonDitherer)
+      atkinsonDitherer->nextRow();
+    else if (fsDitherer)
+      fsDitherer->nextRow();
+  }
+
+  out.write(rowBuffer, bytesPerRow);
+}
+
+void ScaledBmpWriter::addRow(const uint8_t* grayRow, const int y) {
+  if (!needsScaling) {
+    // No scaling - direct output (1:1 mapping)
+    emitRow(y, grayRow);
+    return;
+  }
+
+  // Fixed-point area averaging: accumulate the source pixels [outX * scaleX, (outX+1) * scaleX) of this row
+  for (int outX = 0; outX < outWidth; outX++) {
+    const int srcXStart = (static_cast<uint32_t>(outX) * scaleX_fp) >> 16;
+    const int srcXEnd = (static_cast<uint32_t>(outX + 1) * scaleX_fp) >> 16;
+
+    int sum = 0;
+    int count = 0;
+    for (int srcX = srcXStart; srcX < srcXEnd && srcX < srcWidth; srcX++) {
+      sum += grayRow[srcX];
+      count++;
+    }
+
+    // Handle edge case: if no pixels in range, use nearest
+    if (count == 0 && srcXStart < srcWidth) {
+      sum = grayRow[srcXStart];
+      count = 1;
+    }
+
+    rowAccum[outX] += sum;
+    rowCount[outX] += count;
+  }
+
+  // Output all rows whose boundaries we've crossed (handles both up and downscaling)
+  // For upscaling, one source row may produce multiple output rows
+  const uint32_t srcY_fp = static_cast<uint32_t>(y + 1) << 16;
+  while (srcY_fp >= nextOutY_srcStart && currentOutY < outHeight) {
+    for (int x = 0; x < outWidth; x++) {
+      grayOut[x] = (rowCount[x] > 0) ? (rowAccum[x] / rowCount[x]) : 0;
+    }
+    emitRow(currentOutY, grayOut);
+    currentOutY++;
+
+    nextOutY_srcStart = static_cast<uint32_t>(currentOutY + 1) * scaleY_fp;
+
+    // For upscaling: keep the accumulators while the next output row still maps to this source row
+    if (srcY_fp >= nextOutY_srcStart) {
+      continue;
+    }
+    memset(rowAccum, 0, outWidth * sizeof(uint32_t));
+    memset(rowCount, 0, outWidth * sizeof(uint16_t));
+  }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+
+#include "BitmapHelpers.h"
+
+class Print;
+
+// Size full-screen covers are converted to (portrait display)
+constexpr int COVER_BMP_MAX_WIDTH = 480;
+constexpr int COVER_BMP_MAX_HEIGHT = 800;
+
+// One requested output when a decoder writes several BMPs from a single decode
+struct BmpOutputSpec {
+  Print* out;
+  int targetWidth;
+  int targetHeight;
+  bool oneBit;
+  bool crop;
+};
+
+/**
+ * Output stage shared by the JPEG and PNG to BMP converters.
+ *
+ * The decoder pushes 8-bit gray source rows top to bottom; the writer area-averages them to the output size, dithers
+ * to 1 or 2 bits and writes finished BMP rows to its stream. A decoder can drive several writers at once, which lets a
+ * cover be decoded a single time for the sleep cover, the cropped cover and every thumbnail height.
+ */
+class ScaledBmpWriter {
+ public:
+  // crop: scale to fill the target (the BMP is cropped when drawn) instead of fitting inside it
+  ScaledBmpWriter(Print& out, int srcWidth, int srcHeight, int targetWidth, int targetHeight, bool oneBit, bool crop);
+  ~ScaledBmpWriter();
+
+  ScaledBmpWriter(const ScaledBmpWriter&) = delete;
+  ScaledBmpWriter& operator=(const ScaledBmpWriter&) = delete;
+
+  // Writes the BMP header and allocates row state. Returns false if allocation fails.
+  bool begin();
+  // Feed source row `y` (srcWidth gray pixels); emits zero or more BMP rows
+  void addRow(const uint8_t* grayRow, int y);
+
+  int getOutWidth() const { return outWidth; }
+  int getOutHeight() const { return outHeight; }
+
+ private:
+  void emitRow(int outY, const uint8_t* grayRow);
+
+  Print& out;
+  int srcWidth;
+  int outWidth;
+  int outHeight;
+  bool oneBit;
+  bool needsScaling = false;
+  uint32_t scaleX_fp = 65536;  // source pixels per output pixel (16.16)
+  uint32_t scaleY_fp = 65536;
+  int bytesPerRow = 0;
+
+  uint8_t* rowBuffer = nullptr;
+  uint8_t* grayOut = nullptr;     // averaged gray for one output row
+  uint32_t* rowAccum = nullptr;   // per output X sum of source pixels
+  uint16_t* rowCount = nullptr;   // per output X count of source pixels
+  int currentOutY = 0;
+  uint32_t nextOutY_srcStart = 0;  // source Y (16.16) where the next output row starts
+
+  AtkinsonDitherer* atkinsonDitherer = nullptr;
+  FloydSteinbergDitherer* fsDitherer = nullptr;
+  Atkinson1BitDitherer* atkinson1BitDitherer = nullptr;
+};
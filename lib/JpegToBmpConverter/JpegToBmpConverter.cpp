@@ -6,8 +6,10 @@
 
 #include <cstdio>
 #include <cstring>
+#include <memory>
+#include <vector>
 
-#include "BitmapHelpers.h"
+#include "ScaledBmpWriter.h"
 
 // Context structure for picojpeg callback
 struct JpegReadContext {
@@ -17,155 +19,6 @@ struct JpegReadContext {
   size_t bufferFilled;
 };
 
-// ============================================================================
-// IMAGE PROCESSING OPTIONS - Toggle these to test different configurations
-// ============================================================================
-constexpr bool USE_8BIT_OUTPUT = false;  // true: 8-bit grayscale (no quantization), false: 2-bit (4 levels)
-// Dithering method selection (only one should be true, or all false for simple quantization):
-constexpr bool USE_ATKINSON = true;          // Atkinson dithering (cleaner than F-S, less error diffusion)
-constexpr bool USE_FLOYD_STEINBERG = false;  // Floyd-Steinberg error diffusion (can cause "worm" artifacts)
-constexpr bool USE_NOISE_DITHERING = false;  // Hash-based noise dithering (good for downsampling)
-// Pre-resize to target display size (CRITICAL: avoids dithering artifacts from post-downsampling)
-constexpr bool USE_PRESCALE = true;     // true: scale image to target size before dithering
-constexpr int TARGET_MAX_WIDTH = 480;   // Max width for cover images (portrait display width)
-constexpr int TARGET_MAX_HEIGHT = 800;  // Max height for cover images (portrait display height)
-// ============================================================================
-
-inline void write16(Print& out, const uint16_t value) {
-  out.write(value & 0xFF);
-  out.write((value >> 8) & 0xFF);
-}
-
-inline void write32(Print& out, const uint32_t value) {
-  out.write(value & 0xFF);
-  out.write((value >> 8) & 0xFF);
-  out.write((value >> 16) & 0xFF);
-  out.write((value >> 24) & 0xFF);
-}
-
-inline void write32Signed(Print& out, const int32_t value) {
-  out.write(value & 0xFF);
-  out.write((value >> 8) & 0xFF);
-  out.write((value >> 16) & 0xFF);
-  out.write((value >> 24) & 0xFF);
-}
-
-// Helper function: Write BMP header with 8-bit grayscale (256 levels)
-void writeBmpHeader8bit(Print& bmpOut, const int width, const int height) {
-  // Calculate row padding (each row must be multiple of 4 bytes)
-  const int bytesPerRow = (width + 3) / 4 * 4;  // 8 bits per pixel, padded
-  const int imageSize = bytesPerRow * height;
-  const uint32_t paletteSize = 256 * 4;  // 256 colors * 4 bytes (BGRA)
-  const uint32_t fileSize = 14 + 40 + paletteSize + imageSize;
-
-  // BMP File Header (14 bytes)
-  bmpOut.write('B');
-  bmpOut.write('M');
-  write32(bmpOut, fileSize);
-  write32(bmpOut, 0);                      // Reserved
-  write32(bmpOut, 14 + 40 + paletteSize);  // Offset to pixel data
-
-  // DIB Header (BITMAPINFOHEADER - 40 bytes)
-  write32(bmpOut, 40);
-  write32Signed(bmpOut, width);
-  write32Signed(bmpOut, -height);  // Negative height = top-down bitmap
-  write16(bmpOut, 1);              // Color planes
-  write16(bmpOut, 8);              // Bits per pixel (8 bits)
-  write32(bmpOut, 0);              // BI_RGB (no compression)
-  write32(bmpOut, imageSize);
-  write32(bmpOut, 2835);  // xPixelsPerMeter (72 DPI)
-  write32(bmpOut, 2835);  // yPixelsPerMeter (72 DPI)
-  write32(bmpOut, 256);   // colorsUsed
-  write32(bmpOut, 256);   // colorsImportant
-
-  // Color Palette (256 grayscale entries x 4 bytes = 1024 bytes)
-  for (int i = 0; i < 256; i++) {
-    bmpOut.write(static_cast<uint8_t>(i));  // Blue
-    bmpOut.write(static_cast<uint8_t>(i));  // Green
-    bmpOut.write(static_cast<uint8_t>(i));  // Red
-    bmpOut.write(static_cast<uint8_t>(0));  // Reserved
-  }
-}
-
-// Helper function: Write BMP header with 1-bit color depth (black and white)
-static void writeBmpHeader1bit(Print& bmpOut, const int width, const int height) {
-  // Calculate row padding (each row must be multiple of 4 bytes)
-  const int bytesPerRow = (width + 31) / 32 * 4;  // 1 bit per pixel, round up to 4-byte boundary
-  const int imageSize = bytesPerRow * height;
-  const uint32_t fileSize = 62 + imageSize;  // 14 (file header) + 40 (DIB header) + 8 (palette) + image
-
-  // BMP File Header (14 bytes)
-  bmpOut.write('B');
-  bmpOut.write('M');
-  write32(bmpOut, fileSize);  // File size
-  write32(bmpOut, 0);         // Reserved
-  write32(bmpOut, 62);        // Offset to pixel data (14 + 40 + 8)
-
-  // DIB Header (BITMAPINFOHEADER - 40 bytes)
-  write32(bmpOut, 40);
-  write32Signed(bmpOut, width);
-  write32Signed(bmpOut, -height);  // Negative height = top-down bitmap
-  write16(bmpOut, 1);              // Color planes
-  write16(bmpOut, 1);              // Bits per pixel (1 bit)
-  write32(bmpOut, 0);              // BI_RGB (no compression)
-  write32(bmpOut, imageSize);
-  write32(bmpOut, 2835);  // xPixelsPerMeter (72 DPI)
-  write32(bmpOut, 2835);  // yPixelsPerMeter (72 DPI)
-  write32(bmpOut, 2);     // colorsUsed
-  write32(bmpOut, 2);     // colorsImportant
-
-  // Color Palette (2 colors x 4 bytes = 8 bytes)
-  // Format: Blue, Green, Red, Reserved (BGRA)
-  // Note: In 1-bit BMP, palette index 0 = black, 1 = white
-  uint8_t palette[8] = {
-      0x00, 0x00, 0x00, 0x00,  // Color 0: Black
-      0xFF, 0xFF, 0xFF, 0x00   // Color 1: White
-  };
-  for (const uint8_t i : palette) {
-    bmpOut.write(i);
-  }
-}
-
-// Helper function: Write BMP header with 2-bit color depth
-static void writeBmpHeader2bit(Print& bmpOut, const int width, const int height) {
-  // Calculate row padding (each row must be multiple of 4 bytes)
-  const int bytesPerRow = (width * 2 + 31) / 32 * 4;  // 2 bits per pixel, round up
-  const int imageSize = bytesPerRow * height;
-  const uint32_t fileSize = 70 + imageSize;  // 14 (file header) + 40 (DIB header) + 16 (palette) + image
-
-  // BMP File Header (14 bytes)
-  bmpOut.write('B');
-  bmpOut.write('M');
-  write32(bmpOut, fileSize);  // File size
-  write32(bmpOut, 0);         // Reserved
-  write32(bmpOut, 70);        // Offset to pixel data
-
-  // DIB Header (BITMAPINFOHEADER - 40 bytes)
-  write32(bmpOut, 40);
-  write32Signed(bmpOut, width);
-  write32Signed(bmpOut, -height);  // Negative height = top-down bitmap
-  write16(bmpOut, 1);              // Color planes
-  write16(bmpOut, 2);              // Bits per pixel (2 bits)
-  write32(bmpOut, 0);              // BI_RGB (no compression)
-  write32(bmpOut, imageSize);
-  write32(bmpOut, 2835);  // xPixelsPerMeter (72 DPI)
-  write32(bmpOut, 2835);  // yPixelsPerMeter (72 DPI)
-  write32(bmpOut, 4);     // colorsUsed
-  write32(bmpOut, 4);     // colorsImportant
-
-  // Color Palette (4 colors x 4 bytes = 16 bytes)
-  // Format: Blue, Green, Red, Reserved (BGRA)
-  uint8_t palette[16] = {
-      0x00, 0x00, 0x00, 0x00,  // Color 0: Black
-      0x55, 0x55, 0x55, 0x00,  // Color 1: Dark gray (85)
-      0xAA, 0xAA, 0xAA, 0x00,  // Color 2: Light gray (170)
-      0xFF, 0xFF, 0xFF, 0x00   // Color 3: White
-  };
-  for (const uint8_t i : palette) {
-    bmpOut.write(i);
-  }
-}
-
 // Callback function for picojpeg to read JPEG data
 unsigned char JpegToBmpConverter::jpegReadCallback(unsigned char* pBuf, const unsigned char buf_size,
                                                    unsigned char* pBytes_actually_read, void* pCallback_data) {
@@ -198,147 +51,117 @@ unsigned char JpegToBmpConverter::jpegReadCallback(unsigned char* pBuf, const un
   return 0;  // Success
 }
 
-// Internal implementation with configurable target size and bit depth
-bool JpegToBmpConverter::jpegFileToBmpStreamInternal(FsFile& jpegFile, Print& bmpOut, int targetWidth, int targetHeight,
-                                                     bool oneBit, bool crop) {
-  LOG_DBG("JPG", "Converting JPEG to %s BMP (target: %dx%d)", oneBit ? "1-bit" : "2-bit", targetWidth, targetHeight);
+// Largest DCT-domain reduction (as a shift: 1/1 .. 1/8) that still leaves every output at least its own resolution,
+// so the writers only ever downscale. Outputs without a target size keep the full resolution.
+static int chooseScaleShift(const int srcWidth, const int srcHeight, const BmpOutputSpec* outputs,
+                            const int outputCount) {
+  int shift = 3;
+  for (int i = 0; i < outputCount && shift > 0; i++) {
+    const BmpOutputSpec& spec = outputs[i];
+    if (spec.targetWidth <= 0 || spec.targetHeight <= 0) {
+      return 0;
+    }
+    const float scaleX = static_cast<float>(spec.targetWidth) / srcWidth;
+    const float scaleY = static_cast<float>(spec.targetHeight) / srcHeight;
+    const float scale = spec.crop ? (scaleX > scaleY ? scaleX : scaleY) : (scaleX < scaleY ? scaleX : scaleY);
+    const int outWidth = static_cast<int>(srcWidth * scale);
+    const int outHeight = static_cast<int>(srcHeight * scale);
+    while (shift > 0 && ((srcWidth >> shift) < outWidth || (srcHeight >> shift) < outHeight)) {
+      shift--;
+    }
+  }
+  return shift;
+}
 
-  // Setup context for picojpeg callback
-  JpegReadContext context = {.file = jpegFile, .bufferPos = 0, .bufferFilled = 0};
+// Decode the JPEG once and feed every gray row to one ScaledBmpWriter per requested output
+bool JpegToBmpConverter::jpegFileToBmpStreams(FsFile& jpegFile, const BmpOutputSpec* outputs, const int outputCount,
+                                              const std::function<bool()>& progressFn) {
+  if (outputCount <= 0) {
+    return false;
+  }
+  LOG_DBG("JPG", "Converting JPEG to %d BMP output(s)", outputCount);
+  const auto start = millis();
 
-  // Initialize picojpeg decoder
+  // Read just the header first to pick the reduction, then restart the decoder with it
+  JpegReadContext context = {.file = jpegFile, .bufferPos = 0, .bufferFilled = 0};
+  const uint32_t jpegStart = jpegFile.position();
   pjpeg_image_info_t imageInfo;
-  const unsigned char status = pjpeg_decode_init(&imageInfo, jpegReadCallback, &context, 0);
+  unsigned char status = pjpeg_decode_init_gray(&imageInfo, jpegReadCallback, &context, 0);
   if (status != 0) {
     LOG_ERR("JPG", "JPEG decode init failed with error code: %d", status);
     return false;
   }
 
-  LOG_DBG("JPG", "JPEG dimensions: %dx%d, components: %d, MCUs: %dx%d", imageInfo.m_width, imageInfo.m_height,
-          imageInfo.m_comps, imageInfo.m_MCUSPerRow, imageInfo.m_MCUSPerCol);
+  const int scaleShift = chooseScaleShift(imageInfo.m_width, imageInfo.m_height, outputs, outputCount);
+  if (scaleShift > 0) {
+    jpegFile.seek(jpegStart);
+    context.bufferPos = 0;
+    context.bufferFilled = 0;
+    status = pjpeg_decode_init_gray(&imageInfo, jpegReadCallback, &context, scaleShift);
+    if (status != 0) {
+      LOG_ERR("JPG", "JPEG decode init failed with error code: %d", status);
+      return false;
+    }
+  }
+
+  // Decoded size: every 8x8 block shrinks to blockSize x blockSize pixels in the DCT domain
+  const int blockSize = 8 >> scaleShift;
+  const int decodedWidth = (imageInfo.m_width + (1 << scaleShift) - 1) >> scaleShift;
+  const int decodedHeight = (imageInfo.m_height + (1 << scaleShift) - 1) >> scaleShift;
+
+  LOG_DBG("JPG", "JPEG dimensions: %dx%d, components: %d, MCUs: %dx%d, decoding at 1/%d (%dx%d)", imageInfo.m_width,
+          imageInfo.m_height, imageInfo.m_comps, imageInfo.m_MCUSPerRow, imageInfo.m_MCUSPerCol, 1 << scaleShift,
+          decodedWidth, decodedHeight);
 
-  // Safety limits to prevent memory issues on ESP32
+  // Safety limits to prevent memory issues on ESP32. Memory follows the decoded size, so large photos are fine as
+  // long as the outputs let them be reduced.
   constexpr int MAX_IMAGE_WIDTH = 2048;
   constexpr int MAX_IMAGE_HEIGHT = 3072;
   constexpr int MAX_MCU_ROW_BYTES = 65536;
 
-  if (imageInfo.m_width > MAX_IMAGE_WIDTH || imageInfo.m_height > MAX_IMAGE_HEIGHT) {
-    LOG_DBG("JPG", "Image too large (%dx%d), max supported: %dx%d", imageInfo.m_width, imageInfo.m_height,
+  if (decodedWidth > MAX_IMAGE_WIDTH || decodedHeight > MAX_IMAGE_HEIGHT) {
+    LOG_DBG("JPG", "Image too large (%dx%d decoded), max supported: %dx%d", decodedWidth, decodedHeight,
             MAX_IMAGE_WIDTH, MAX_IMAGE_HEIGHT);
     return false;
   }
 
-  // Calculate output dimensions (pre-scale to fit display exactly)
-  int outWidth = imageInfo.m_width;
-  int outHeight = imageInfo.m_height;
-  // Use fixed-point scaling (16.16) for sub-pixel accuracy
-  uint32_t scaleX_fp = 65536;  // 1.0 in 16.16 fixed point
-  uint32_t scaleY_fp = 65536;
-  bool needsScaling = false;
-
-  if (targetWidth > 0 && targetHeight > 0 && (imageInfo.m_width != targetWidth || imageInfo.m_height != targetHeight)) {
-    // Calculate scale to fit/fill target dimensions while maintaining aspect ratio
-    const float scaleToFitWidth = static_cast<float>(targetWidth) / imageInfo.m_width;
-    const float scaleToFitHeight = static_cast<float>(targetHeight) / imageInfo.m_height;
-    // We scale to the smaller dimension, so we can potentially crop later.
-    float scale = 1.0;
-    if (crop) {  // if we will crop, scale to the smaller dimension
-      scale = (scaleToFitWidth > scaleToFitHeight) ? scaleToFitWidth : scaleToFitHeight;
-    } else {  // else, scale to the larger dimension to fit
-      scale = (scaleToFitWidth < scaleToFitHeight) ? scaleToFitWidth : scaleToFitHeight;
-    }
-
-    outWidth = static_cast<int>(imageInfo.m_width * scale);
-    outHeight = static_cast<int>(imageInfo.m_height * scale);
-
-    // Ensure at least 1 pixel
-    if (outWidth < 1) outWidth = 1;
-    if (outHeight < 1) outHeight = 1;
-
-    // Calculate fixed-point scale factors (source pixels per output pixel)
-    // scaleX_fp = (srcWidth << 16) / outWidth
-    scaleX_fp = (static_cast<uint32_t>(imageInfo.m_width) << 16) / outWidth;
-    scaleY_fp = (static_cast<uint32_t>(imageInfo.m_height) << 16) / outHeight;
-    needsScaling = true;
-
-    LOG_DBG("JPG", "Scaling %dx%d -> %dx%d (target %dx%d)", imageInfo.m_width, imageInfo.m_height, outWidth, outHeight,
-            targetWidth, targetHeight);
-  }
-
-  // Write BMP header with output dimensions
-  int bytesPerRow;
-  if (USE_8BIT_OUTPUT && !oneBit) {
-    writeBmpHeader8bit(bmpOut, outWidth, outHeight);
-    bytesPerRow = (outWidth + 3) / 4 * 4;
-  } else if (oneBit) {
-    writeBmpHeader1bit(bmpOut, outWidth, outHeight);
-    bytesPerRow = (outWidth + 31) / 32 * 4;  // 1 bit per pixel
-  } else {
-    writeBmpHeader2bit(bmpOut, outWidth, outHeight);
-    bytesPerRow = (outWidth * 2 + 31) / 32 * 4;
-  }
-
-  // Allocate row buffer
-  auto* rowBuffer = static_cast<uint8_t*>(malloc(bytesPerRow));
-  if (!rowBuffer) {
-    LOG_ERR("JPG", "Failed to allocate row buffer");
-    return false;
-  }
-
   // Allocate a buffer for one MCU row worth of grayscale pixels
   // This is the minimal memory needed for streaming conversion
-  const int mcuPixelHeight = imageInfo.m_MCUHeight;
-  const int mcuRowPixels = imageInfo.m_width * mcuPixelHeight;
+  const int mcuPixelWidth = imageInfo.m_MCUWidth >> scaleShift;
+  const int mcuPixelHeight = imageInfo.m_MCUHeight >> scaleShift;
+  const int mcuRowPixels = decodedWidth * mcuPixelHeight;
 
   // Validate MCU row buffer size before allocation
   if (mcuRowPixels > MAX_MCU_ROW_BYTES) {
     LOG_DBG("JPG", "MCU row buffer too large (%d bytes), max: %d", mcuRowPixels, MAX_MCU_ROW_BYTES);
-    free(rowBuffer);
     return false;
   }
 
+  std::vector<std::unique_ptr<ScaledBmpWriter>> writers;
+  writers.reserve(outputCount);
+  for (int i = 0; i < outputCount; i++) {
+    const BmpOutputSpec& spec = outputs[i];
+    writers.emplace_back(new ScaledBmpWriter(*spec.out, decodedWidth, decodedHeight, spec.targetWidth,
+                                             spec.targetHeight, spec.oneBit, spec.crop));
+    if (!writers.back()->begin()) {
+      return false;
+    }
+  }
+
   auto* mcuRowBuffer = static_cast<uint8_t*>(malloc(mcuRowPixels));
   if (!mcuRowBuffer) {
     LOG_ERR("JPG", "Failed to allocate MCU row buffer (%d bytes)", mcuRowPixels);
-    free(rowBuffer);
     return false;
   }
 
-  // Create ditherer if enabled
-  // Use OUTPUT dimensions for dithering (after prescaling)
-  AtkinsonDitherer* atkinsonDitherer = nullptr;
-  FloydSteinbergDitherer* fsDitherer = nullptr;
-  Atkinson1BitDitherer* atkinson1BitDitherer = nullptr;
-
-  if (oneBit) {
-    // For 1-bit output, use Atkinson dithering for better quality
-    atkinson1BitDitherer = new Atkinson1BitDitherer(outWidth);
-  } else if (!USE_8BIT_OUTPUT) {
-    if (USE_ATKINSON) {
-      atkinsonDitherer = new AtkinsonDitherer(outWidth);
-    } else if (USE_FLOYD_STEINBERG) {
-      fsDitherer = new FloydSteinbergDitherer(outWidth);
-    }
-  }
-
-  // For scaling: accumulate source rows into scaled output rows
-  // We need to track which source Y maps to which output Y
-  // Using fixed-point: srcY_fp = outY * scaleY_fp (gives source Y in 16.16 format)
-  uint32_t* rowAccum = nullptr;    // Accumulator for each output X (32-bit for larger sums)
-  uint16_t* rowCount = nullptr;    // Count of source pixels accumulated per output X
-  int currentOutY = 0;             // Current output row being accumulated
-  uint32_t nextOutY_srcStart = 0;  // Source Y where next output row starts (16.16 fixed point)
-
-  if (needsScaling) {
-    rowAccum = new uint32_t[outWidth]();
-    rowCount = new uint16_t[outWidth]();
-    nextOutY_srcStart = scaleY_fp;  // First boundary is at scaleY_fp (source Y for outY=1)
-  }
-
   // Process MCUs row-by-row and write to BMP as we go (top-down)
-  const int mcuPixelWidth = imageInfo.m_MCUWidth;
-
   for (int mcuY = 0; mcuY < imageInfo.m_MCUSPerCol; mcuY++) {
+    if (progressFn && !progressFn()) {
+      LOG_DBG("JPG", "Conversion stopped at MCU row %d", mcuY);
+      free(mcuRowBuffer);
+      return false;
+    }
+
     // Clear the MCU row buffer
     memset(mcuRowBuffer, 0, mcuRowPixels);
 
@@ -352,214 +175,51 @@ bool JpegToBmpConverter::jpegFileToBmpStreamInternal(FsFile& jpegFile, Print& bm
           LOG_ERR("JPG", "JPEG decode MCU failed at (%d, %d) with error code: %d", mcuX, mcuY, mcuStatus);
         }
         free(mcuRowBuffer);
-        free(rowBuffer);
         return false;
       }
 
-      // picojpeg stores MCU data in 8x8 blocks
-      // Block layout: H2V2(16x16)=0,64,128,192 H2V1(16x8)=0,64 H1V2(8x16)=0,128
-      for (int blockY = 0; blockY < mcuPixelHeight; blockY++) {
-        for (int blockX = 0; blockX < mcuPixelWidth; blockX++) {
-          const int pixelX = mcuX * mcuPixelWidth + blockX;
-          if (pixelX >= imageInfo.m_width) continue;
-
-          // Calculate proper block offset for picojpeg buffer
-          const int blockCol = blockX / 8;
-          const int blockRow = blockY / 8;
-          const int localX = blockX % 8;
-          const int localY = blockY % 8;
-          const int blocksPerRow = mcuPixelWidth / 8;
-          const int blockIndex = blockRow * blocksPerRow + blockCol;
-          const int pixelOffset = blockIndex * 64 + localY * 8 + localX;
-
-          uint8_t gray;
-          if (imageInfo.m_comps == 1) {
-            gray = imageInfo.m_pMCUBufR[pixelOffset];
-          } else {
-            const uint8_t r = imageInfo.m_pMCUBufR[pixelOffset];
-            const uint8_t g = imageInfo.m_pMCUBufG[pixelOffset];
-            const uint8_t b = imageInfo.m_pMCUBufB[pixelOffset];
-            gray = (r * 25 + g * 50 + b * 25) / 100;
-          }
-
-          mcuRowBuffer[blockY * imageInfo.m_width + pixelX] = gray;
+      // picojpeg keeps each 8x8 block in a 64 byte slot (row stride 8), reduced blocks in the slot's top-left corner
+      // Block slots: H2V2(16x16)=0,64,128,192 H2V1(16x8)=0,64 H1V2(8x16)=0,128
+      for (int mcuPixelY = 0; mcuPixelY < mcuPixelHeight; mcuPixelY++) {
+        const uint8_t* blockRow = imageInfo.m_pMCUBufR + (mcuPixelY / blockSize) * 128 + (mcuPixelY % blockSize) * 8;
+        uint8_t* dst = mcuRowBuffer + mcuPixelY * decodedWidth;
+        for (int mcuPixelX = 0; mcuPixelX < mcuPixelWidth; mcuPixelX++) {
+          const int pixelX = mcuX * mcuPixelWidth + mcuPixelX;
+          if (pixelX >= decodedWidth) break;
+          dst[pixelX] = blockRow[(mcuPixelX / blockSize) * 64 + mcuPixelX % blockSize];
         }
       }
     }
 
-    // Process source rows from this MCU row
+    // Hand the source rows of this MCU row to every output
     const int startRow = mcuY * mcuPixelHeight;
     const int endRow = (mcuY + 1) * mcuPixelHeight;
 
-    for (int y = startRow; y < endRow && y < imageInfo.m_height; y++) {
-      const int bufferY = y - startRow;
-
-      if (!needsScaling) {
-        // No scaling - direct output (1:1 mapping)
-        memset(rowBuffer, 0, bytesPerRow);
-
-        if (USE_8BIT_OUTPUT && !oneBit) {
-          for (int x = 0; x < outWidth; x++) {
-            const uint8_t gray = mcuRowBuffer[bufferY * imageInfo.m_width + x];
-            rowBuffer[x] = adjustPixel(gray);
-          }
-        } else if (oneBit) {
-          // 1-bit output with Atkinson dithering for better quality
-          for (int x = 0; x < outWidth; x++) {
-            const uint8_t gray = mcuRowBuffer[bufferY * imageInfo.m_width + x];
-            const uint8_t bit =
-                atkinson1BitDitherer ? atkinson1BitDitherer->processPixel(gray, x) : quantize1bit(gray, x, y);
-            // Pack 1-bit value: MSB first, 8 pixels per byte
-            const int byteIndex = x / 8;
-            const int bitOffset = 7 - (x % 8);
-            rowBuffer[byteIndex] |= (bit << bitOffset);
-          }
-          if (atkinson1BitDitherer) atkinson1BitDitherer->nextRow();
-        } else {
-          // 2-bit output
-          for (int x = 0; x < outWidth; x++) {
-            const uint8_t gray = adjustPixel(mcuRowBuffer[bufferY * imageInfo.m_width + x]);
-            uint8_t twoBit;
-            if (atkinsonDitherer) {
-              twoBit = atkinsonDitherer->processPixel(gray, x);
-            } else if (fsDitherer) {
-              twoBit = fsDitherer->processPixel(gray, x);
-            } else {
-              twoBit = quantize(gray, x, y);
-            }
-            const int byteIndex = (x * 2) / 8;
-            const int bitOffset = 6 - ((x * 2) % 8);
-            rowBuffer[byteIndex] |= (twoBit << bitOffset);
-          }
-          if (atkinsonDitherer)
-            atkinsonDitherer->nextRow();
-          else if (fsDitherer)
-            fsDitherer->nextRow();
-        }
-        bmpOut.write(rowBuffer, bytesPerRow);
-      } else {
-        // Fixed-point area averaging for exact fit scaling
-        // For each output pixel X, accumulate source pixels that map to it
-        // srcX range for outX: [outX * scaleX_fp >> 16, (outX+1) * scaleX_fp >> 16)
-        const uint8_t* srcRow = mcuRowBuffer + bufferY * imageInfo.m_width;
-
-        for (int outX = 0; outX < outWidth; outX++) {
-          // Calculate source X range for this output pixel
-          const int srcXStart = (static_cast<uint32_t>(outX) * scaleX_fp) >> 16;
-          const int srcXEnd = (static_cast<uint32_t>(outX + 1) * scaleX_fp) >> 16;
-
-          // Accumulate all source pixels in this range
-          int sum = 0;
-          int count = 0;
-          for (int srcX = srcXStart; srcX < srcXEnd && srcX < imageInfo.m_width; srcX++) {
-            sum += srcRow[srcX];
-            count++;
-          }
-
-          // Handle edge case: if no pixels in range, use nearest
-          if (count == 0 && srcXStart < imageInfo.m_width) {
-            sum = srcRow[srcXStart];
-            count = 1;
-          }
-
-          rowAccum[outX] += sum;
-          rowCount[outX] += count;
-        }
-
-        // Check if we've crossed into the next output row(s)
-        // Current source Y in fixed point: y << 16
-        const uint32_t srcY_fp = static_cast<uint32_t>(y + 1) << 16;
-
-        // Output all rows whose boundaries we've crossed (handles both up and downscaling)
-        // For upscaling, one source row may produce multiple output rows
-        while (srcY_fp >= nextOutY_srcStart && currentOutY < outHeight) {
-          memset(rowBuffer, 0, bytesPerRow);
-
-          if (USE_8BIT_OUTPUT && !oneBit) {
-            for (int x = 0; x < outWidth; x++) {
-              const uint8_t gray = (rowCount[x] > 0) ? (rowAccum[x] / rowCount[x]) : 0;
-              rowBuffer[x] = adjustPixel(gray);
-            }
-          } else if (oneBit) {
-            // 1-bit output with Atkinson dithering for better quality
-            for (int x = 0; x < outWidth; x++) {
-              const uint8_t gray = (rowCount[x] > 0) ? (rowAccum[x] / rowCount[x]) : 0;
-              const uint8_t bit = atkinson1BitDitherer ? atkinson1BitDitherer->processPixel(gray, x)
-                                                       : quantize1bit(gray, x, currentOutY);
-              // Pack 1-bit value: MSB first, 8 pixels per byte
-              const int byteIndex = x / 8;
-              const int bitOffset = 7 - (x % 8);
-              rowBuffer[byteIndex] |= (bit << bitOffset);
-            }
-            if (atkinson1BitDitherer) atkinson1BitDitherer->nextRow();
-          } else {
-            // 2-bit output
-            for (int x = 0; x < outWidth; x++) {
-              const uint8_t gray = adjustPixel((rowCount[x] > 0) ? (rowAccum[x] / rowCount[x]) : 0);
-              uint8_t twoBit;
-              if (atkinsonDitherer) {
-                twoBit = atkinsonDitherer->processPixel(gray, x);
-              } else if (fsDitherer) {
-                twoBit = fsDitherer->processPixel(gray, x);
-              } else {
-                twoBit = quantize(gray, x, currentOutY);
-              }
-              const int byteIndex = (x * 2) / 8;
-              const int bitOffset = 6 - ((x * 2) % 8);
-              rowBuffer[byteIndex] |= (twoBit << bitOffset);
-            }
-            if (atkinsonDitherer)
-              atkinsonDitherer->nextRow();
-            else if (fsDitherer)
-              fsDitherer->nextRow();
-          }
-
-          bmpOut.write(rowBuffer, bytesPerRow);
-          currentOutY++;
-
-          // Update boundary for next output row
-          nextOutY_srcStart = static_cast<uint32_t>(currentOutY + 1) * scaleY_fp;
-
-          // For upscaling: don't reset accumulators if next output row uses same source data
-          // Only reset when we'll move to a new source row
-          if (srcY_fp >= nextOutY_srcStart) {
-            // More output rows to emit from same source - keep accumulator data
-            continue;
-          }
-          // Moving to next source row - reset accumulators
-          memset(rowAccum, 0, outWidth * sizeof(uint32_t));
-          memset(rowCount, 0, outWidth * sizeof(uint16_t));
-        }
+    for (int y = startRow; y < endRow && y < decodedHeight; y++) {
+      const uint8_t* srcRow = mcuRowBuffer + (y - startRow) * decodedWidth;
+      for (const auto& writer : writers) {
+        writer->addRow(srcRow, y);
       }
     }
   }
 
-  // Clean up
-  if (rowAccum) {
-    delete[] rowAccum;
-  }
-  if (rowCount) {
-    delete[] rowCount;
-  }
-  if (atkinsonDitherer) {
-    delete atkinsonDitherer;
-  }
-  if (fsDitherer) {
-    delete fsDitherer;
-  }
-  if (atkinson1BitDitherer) {
-    delete atkinson1BitDitherer;
-  }
   free(mcuRowBuffer);
-  free(rowBuffer);
 
-  LOG_DBG("JPG", "Successfully converted JPEG to BMP");
+  LOG_DBG("JPG", "Converted JPEG to BMP in %lums (1/%d decode)", millis() - start, 1 << scaleShift);
   return true;
 }
 
+// Internal implementation with configurable target size and bit depth
+bool JpegToBmpConverter::jpegFileToBmpStreamInternal(FsFile& jpegFile, Print& bmpOut, int targetWidth, int targetHeight,
+                                                     bool oneBit, bool crop) {
+  LOG_DBG("JPG", "Converting JPEG to %s BMP (target: %dx%d)", oneBit ? "1-bit" : "2-bit", targetWidth, targetHeight);
+  const BmpOutputSpec output{&bmpOut, targetWidth, targetHeight, oneBit, crop};
+  return jpegFileToBmpStreams(jpegFile, &output, 1);
+}
+
 // Core function: Convert JPEG file to 2-bit BMP (uses default target size)
 bool JpegToBmpConverter::jpegFileToBmpStream(FsFile& jpegFile, Print& bmpOut, bool crop) {
-  return jpegFileToBmpStreamInternal(jpegFile, bmpOut, TARGET_MAX_WIDTH, TARGET_MAX_HEIGHT, false, crop);
+  return jpegFileToBmpStreamInternal(jpegFile, bmpOut, COVER_BMP_MAX_WIDTH, COVER_BMP_MAX_HEIGHT, false, crop);
 }
 
 // Convert with custom target size (for thumbnails, 2-bit)
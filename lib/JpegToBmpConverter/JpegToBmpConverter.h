@@ -2,8 +2,11 @@
 
 #include <HalStorage.h>
 
+#include <functional>
+
 class Print;
 class ZipFile;
+struct BmpOutputSpec;
 
 class JpegToBmpConverter {
   static unsigned char jpegReadCallback(unsigned char* pBuf, unsigned char buf_size,
@@ -17,4 +20,8 @@ class JpegToBmpConverter {
   static bool jpegFileToBmpStreamWithSize(FsFile& jpegFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
   // Convert to 1-bit BMP (black and white only, no grays) for fast home screen rendering
   static bool jpegFileTo1BitBmpStreamWithSize(FsFile& jpegFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
+  // Decode once and write one BMP per output spec (e.g. cover plus every thumbnail size). progressFn runs before
+  // every MCU row; returning false stops the decode and fails it.
+  static bool jpegFileToBmpStreams(FsFile& jpegFile, const BmpOutputSpec* outputs, int outputCount,
+                                   const std::function<bool()>& progressFn = nullptr);
 };
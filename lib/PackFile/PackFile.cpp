@@ -0,0 +1,311 @@
+#include "PackFile.h"
+
+#include <BufferedIO.h>
+#include <Logging.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+constexpr uint32_t PACK_MAGIC = 0x4B435043;  // "CPCK"
+constexpr uint8_t PACK_VERSION = 1;
+constexpr uint32_t HEADER_SIZE = sizeof(uint32_t) + sizeof(uint8_t) + sizeof(uint32_t);
+
+/*
+ * Pack layout:
+ *   u32 magic, u8 version, u32 generation
+ *   records: u8 state, u32 size, u16 nameLength, name, size bytes of data
+ * A record is written PENDING and turned LIVE once its data is complete, so a pack cut short by a reset ends at the
+ * last complete record.
+ */
+constexpr uint8_t STATE_PENDING = 0;
+constexpr uint8_t STATE_LIVE = 1;
+constexpr uint8_t STATE_DEAD = 2;
+constexpr uint32_t RECORD_HEADER_SIZE = sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint16_t);
+
+// Below this, dead records cost less than the rewrite
+constexpr uint32_t COMPACT_MIN_DEAD_BYTES = 64 * 1024;
+}  // namespace
+
+bool PackFile::writeHeader(FsFile& file, const uint32_t newGeneration) {
+  uint8_t header[HEADER_SIZE];
+  memcpy(header, &PACK_MAGIC, sizeof(PACK_MAGIC));
+  header[sizeof(PACK_MAGIC)] = PACK_VERSION;
+  memcpy(header + sizeof(PACK_MAGIC) + 1, &newGeneration, sizeof(newGeneration));
+  return file.seek(0) && file.write(header, HEADER_SIZE) == HEADER_SIZE;
+}
+
+bool PackFile::sync(FsFile& file) {
+  serialization::BufferedReader reader(file, 0, file.size());
+  uint32_t magic = 0;
+  uint8_t version = 0;
+  uint32_t fileGeneration = 0;
+  serialization::readPod(reader, magic);
+  serialization::readPod(reader, version);
+  serialization::readPod(reader, fileGeneration);
+  if (!reader.ok() || magic != PACK_MAGIC || version != PACK_VERSION) {
+    records.clear();
+    scannedEnd = 0;
+    return false;
+  }
+
+  if (scannedEnd == 0 || fileGeneration != generation) {
+    records.clear();
+    generation = fileGeneration;
+    scannedEnd = HEADER_SIZE;
+    liveBytes = 0;
+    deadBytes = 0;
+  }
+
+  // Only records appended since the last look need reading; each costs one seek past its data
+  reader.seek(scannedEnd);
+  std::string name;
+  while (reader.remaining() >= RECORD_HEADER_SIZE) {
+    Record record;
+    uint8_t state = STATE_PENDING;
+    uint16_t nameLength = 0;
+    record.header = reader.position();
+    serialization::readPod(reader, state);
+    serialization::readPod(reader, record.size);
+    serialization::readPod(reader, nameLength);
+    name.resize(nameLength);
+    if (nameLength > 0) reader.read(&name[0], nameLength);
+    record.data = reader.position();
+    if (!reader.ok() || state == STATE_PENDING || record.size > reader.remaining()) {
+      break;
+    }
+
+    if (state == STATE_LIVE) {
+      // A reset between committing a replacement and retiring the old record leaves both live; the later one wins
+      auto it = records.find(name);
+      if (it != records.end()) {
+        liveBytes -= it->second.total();
+        deadBytes += it->second.total();
+        it->second = record;
+      } else {
+        records.emplace(name, record);
+      }
+      liveBytes += record.total();
+    } else {
+      deadBytes += record.total();
+    }
+    reader.seek(record.data + record.size);
+    scannedEnd = record.data + record.size;
+  }
+  return true;
+}
+
+bool PackFile::markDead(FsFile& file, const Record& record) {
+  return file.seek(record.header) && file.write(STATE_DEAD) == 1;
+}
+
+bool PackFile::openEntry(const std::string& name, FsFile& file, uint32_t& offset, uint32_t& size) {
+  // A book that was never packed has no pack; not worth a log line
+  file = Storage.open(path.c_str());
+  if (!file) {
+    return false;
+  }
+  const auto it = sync(file) ? records.find(name) : records.end();
+  if (it == records.end()) {
+    file.close();
+    return false;
+  }
+  offset = it->second.data;
+  size = it->second.size;
+  return true;
+}
+
+bool PackFile::contains(const std::string& name) {
+  FsFile file;
+  uint32_t offset, size;
+  if (!openEntry(name, file, offset, size)) {
+    return false;
+  }
+  file.close();
+  return true;
+}
+
+bool PackFile::beginEntry(const std::string& name, FsFile& file, uint32_t& offset) {
+  if (name.size() > UINT16_MAX) {
+    return false;
+  }
+  file = Storage.open(path.c_str(), O_RDWR | O_CREAT);
+  if (!file) {
+    LOG_ERR("PCK", "Failed to open %s", path.c_str());
+    return false;
+  }
+
+  if (!sync(file)) {
+    // New (or unreadable) pack
+    records.clear();
+    liveBytes = 0;
+    deadBytes = 0;
+    if (!file.truncate(0) || !writeHeader(file, generation + 1)) {
+      LOG_ERR("PCK", "Failed to create %s", path.c_str());
+      file.close();
+      return false;
+    }
+    generation++;
+    scannedEnd = HEADER_SIZE;
+  }
+
+  // Whatever follows the last complete record is an entry that was never committed
+  if (file.size() > scannedEnd && !file.truncate(scannedEnd)) {
+    file.close();
+    return false;
+  }
+
+  const uint16_t nameLength = name.size();
+  uint8_t header[RECORD_HEADER_SIZE] = {STATE_PENDING};
+  memcpy(header + sizeof(uint8_t) + sizeof(uint32_t), &nameLength, sizeof(nameLength));
+  if (!file.seek(scannedEnd) || file.write(header, RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE ||
+      file.write(name.data(), nameLength) != nameLength) {
+    LOG_ERR("PCK", "Failed to begin entry %s", name.c_str());
+    file.truncate(scannedEnd);
+    file.close();
+    return false;
+  }
+  offset = scannedEnd + RECORD_HEADER_SIZE + nameLength;
+  return true;
+}
+
+bool PackFile::commitEntry(const std::string& name, FsFile& file, const uint32_t offset) {
+  Record record;
+  record.header = offset - RECORD_HEADER_SIZE - name.size();
+  record.data = offset;
+  record.size = file.size() - offset;
+
+  uint8_t header[sizeof(uint8_t) + sizeof(uint32_t)] = {STATE_LIVE};
+  memcpy(header + 1, &record.size, sizeof(record.size));
+  if (!file.seek(record.header) || file.write(header, sizeof(header)) != sizeof(header)) {
+    LOG_ERR("PCK", "Failed to commit entry %s", name.c_str());
+    file.truncate(record.header);
+    file.close();
+    return false;
+  }
+
+  auto it = records.find(name);
+  if (it != records.end()) {
+    markDead(file, it->second);
+    liveBytes -= it->second.total();
+    deadBytes += it->second.total();
+    it->second = record;
+  } else {
+    records.emplace(name, record);
+  }
+  liveBytes += record.total();
+  scannedEnd = record.data + record.size;
+  file.close();
+  return true;
+}
+
+void PackFile::abortEntry(const std::string& name, FsFile& file, const uint32_t offset) {
+  file.truncate(offset - RECORD_HEADER_SIZE - name.size());
+  file.close();
+}
+
+bool PackFile::remove(const std::string& name) {
+  FsFile file = Storage.open(path.c_str(), O_RDWR);
+  if (!file) {
+    return false;
+  }
+  bool removed = false;
+  if (sync(file)) {
+    const auto it = records.find(name);
+    if (it != records.end()) {
+      removed = markDead(file, it->second);
+      liveBytes -= it->second.total();
+      deadBytes += it->second.total();
+      records.erase(it);
+    }
+  }
+  file.close();
+  return removed;
+}
+
+void PackFile::removePrefix(const std::string& prefix, const std::string& keep) {
+  FsFile file = Storage.open(path.c_str(), O_RDWR);
+  if (!file) {
+    return;
+  }
+  if (sync(file)) {
+    for (auto it = records.begin(); it != records.end();) {
+      if (it->first.compare(0, prefix.size(), prefix) == 0 && it->first != keep) {
+        markDead(file, it->second);
+        liveBytes -= it->second.total();
+        deadBytes += it->second.total();
+        it = records.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  file.close();
+}
+
+bool PackFile::compact() {
+  FsFile source = Storage.open(path.c_str());
+  if (!source) {
+    return false;
+  }
+  if (!sync(source)) {
+    source.close();
+    return false;
+  }
+
+  const std::string tempPath = path + ".tmp";
+  FsFile target;
+  if (!Storage.openFileForWrite("PCK", tempPath, target)) {
+    source.close();
+    return false;
+  }
+
+  const uint32_t deadBefore = deadBytes;
+  bool ok = writeHeader(target, generation + 1);
+  {
+    serialization::BufferedWriter writer(target, HEADER_SIZE);
+    std::vector<uint8_t> chunk(serialization::BufferedWriter::BUFFER_SIZE);
+    for (const auto& [name, record] : records) {
+      const uint16_t nameLength = name.size();
+      serialization::writePod(writer, STATE_LIVE);
+      serialization::writePod(writer, record.size);
+      serialization::writePod(writer, nameLength);
+      writer.write(name.data(), nameLength);
+      ok = ok && source.seek(record.data);
+      for (uint32_t copied = 0; ok && copied < record.size;) {
+        const uint32_t len = std::min<uint32_t>(chunk.size(), record.size - copied);
+        ok = source.read(chunk.data(), len) == static_cast<int>(len) && writer.write(chunk.data(), len);
+        copied += len;
+      }
+    }
+    ok = writer.flush() && ok;
+  }
+  target.close();
+  source.close();
+
+  if (!ok) {
+    LOG_ERR("PCK", "Failed to compact %s", path.c_str());
+    Storage.remove(tempPath.c_str());
+    return false;
+  }
+  Storage.remove(path.c_str());
+  Storage.rename(tempPath.c_str(), path.c_str());
+  // Offsets moved; the next use rescans
+  scannedEnd = 0;
+  LOG_DBG("PCK", "Compacted %s: %lu bytes reclaimed", path.c_str(), static_cast<unsigned long>(deadBefore));
+  return true;
+}
+
+bool PackFile::compactIfWorthwhile() {
+  FsFile file = Storage.open(path.c_str());
+  if (!file) {
+    return false;
+  }
+  const bool valid = sync(file);
+  file.close();
+  if (!valid || deadBytes < COMPACT_MIN_DEAD_BYTES || deadBytes <= liveBytes) {
+    return false;
+  }
+  return compact();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <HalStorage.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * One file holding many small cache artifacts of a book.
+ *
+ * Entries are appended to the end of the pack behind a record header (state, size, name). The index of live entries
+ * is rebuilt from those headers the first time the pack is used and extended when it has grown since. Replacing or
+ * removing an entry only flips the state byte of its old record, so nothing is ever rewritten in place; compact()
+ * copies the live entries into a fresh file once dead records take up more room than the live ones.
+ *
+ * An entry is read and written through a window of the pack file: BufferedReader and BufferedWriter take the entry's
+ * offset as their base, so a format that records offsets into itself (a section's page table) works unchanged.
+ */
+class PackFile {
+ public:
+  explicit PackFile(std::string path) : path(std::move(path)) {}
+
+  const std::string& getPath() const { return path; }
+
+  // Opens file for reading the entry called name; offset and size locate its bytes within the file
+  bool openEntry(const std::string& name, FsFile& file, uint32_t& offset, uint32_t& size);
+  bool contains(const std::string& name);
+
+  // Opens file at the data offset of a new entry. Everything written after offset belongs to the entry, which
+  // replaces any older entry of that name once commitEntry() succeeds. abortEntry() drops it instead. Both close file.
+  bool beginEntry(const std::string& name, FsFile& file, uint32_t& offset);
+  bool commitEntry(const std::string& name, FsFile& file, uint32_t offset);
+  void abortEntry(const std::string& name, FsFile& file, uint32_t offset);
+
+  bool remove(const std::string& name);
+  // Remove every entry whose name starts with prefix, except keep
+  void removePrefix(const std::string& prefix, const std::string& keep = "");
+
+  // Rewrite the pack without its dead records
+  bool compact();
+  // compact() when the dead records are large and outweigh the live ones
+  bool compactIfWorthwhile();
+
+ private:
+  struct Record {
+    uint32_t header = 0;  // offset of the record header
+    uint32_t data = 0;    // offset of the entry's bytes
+    uint32_t size = 0;
+    uint32_t total() const { return data - header + size; }
+  };
+
+  std::string path;
+  std::unordered_map<std::string, Record> records;
+  uint32_t generation = 0;  // bumped by every compaction so other PackFile objects rescan
+  uint32_t scannedEnd = 0;  // end of the last complete record seen; 0 before the first scan
+  uint32_t liveBytes = 0;
+  uint32_t deadBytes = 0;
+
+  // Bring the index up to date with the open pack; false if file is not a pack
+  bool sync(FsFile& file);
+  bool writeHeader(FsFile& file, uint32_t newGeneration);
+  bool markDead(FsFile& file, const Record& record);
+};
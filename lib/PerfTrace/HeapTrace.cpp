@@ -0,0 +1,283 @@
+#include "HeapTrace.h"
+
+#ifdef ENABLE_PERF_TRACE
+
+#include <cstdio>
+#include <new>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#else
+#include <mutex>
+#endif
+
+namespace {
+#ifdef ARDUINO
+// Counters only; the allocator itself is always called outside the critical section
+portMUX_TYPE heapLock = portMUX_INITIALIZER_UNLOCKED;
+
+struct HeapGuard {
+  HeapGuard() { portENTER_CRITICAL(&heapLock); }
+  ~HeapGuard() { portEXIT_CRITICAL(&heapLock); }
+};
+
+HeapTrace::HeapInfo platformHeapInfo() {
+  HeapTrace::HeapInfo info;
+  info.freeBytes = ESP.getFreeHeap();
+  info.largestFreeBlock = ESP.getMaxAllocHeap();
+  info.minFreeBytes = ESP.getMinFreeHeap();
+  return info;
+}
+#else
+std::mutex heapMutex;
+
+struct HeapGuard {
+  std::lock_guard<std::mutex> lock{heapMutex};
+};
+
+HeapTrace::HeapInfo platformHeapInfo() { return {}; }
+#endif
+
+HeapTrace::HeapInfo (*heapProbe)() = platformHeapInfo;
+
+thread_local HeapTrace::Tag currentTag = HeapTrace::OTHER;
+
+// Placed in front of every tracked block; the alignment keeps the block itself aligned like malloc's result
+struct alignas(std::max_align_t) BlockHeader {
+  uint32_t size;
+  uint8_t tag;
+};
+
+constexpr const char* TAG_NAMES[HeapTrace::TAG_COUNT] = {
+    "other", "layout", "page_cache", "font_cache", "image", "network", "css", "display",
+};
+
+uint32_t nowMs() { return PerfTrace::now() / 1000; }
+}  // namespace
+
+HeapTrace HeapTrace::instance;
+
+const char* HeapTrace::getTagName(const Tag tag) { return tag < TAG_COUNT ? TAG_NAMES[tag] : "unknown"; }
+
+HeapTrace::Tag HeapTrace::getCurrentTag() { return currentTag; }
+
+void HeapTrace::setCurrentTag(const Tag tag) { currentTag = tag < TAG_COUNT ? tag : OTHER; }
+
+HeapTrace::HeapInfo HeapTrace::getHeapInfo() { return heapProbe(); }
+
+void HeapTrace::setHeapProbe(HeapInfo (*probe)()) { heapProbe = probe ? probe : platformHeapInfo; }
+
+void* HeapTrace::allocate(const size_t size, const Tag tag) {
+  const Tag safeTag = tag < TAG_COUNT ? tag : OTHER;
+  void* raw = size <= UINT32_MAX - sizeof(BlockHeader) ? malloc(sizeof(BlockHeader) + size) : nullptr;
+  if (!raw) {
+    // What the request met; read before taking the lock since the allocator locks too
+    const HeapInfo heap = getHeapInfo();
+    HeapGuard guard;
+    stats[safeTag].failures++;
+    lastFailure.timeMs = nowMs();
+    lastFailure.size = static_cast<uint32_t>(size);
+    lastFailure.tag = safeTag;
+    lastFailure.heap = heap;
+    hasFailure = true;
+    recordSample(heap);
+    return nullptr;
+  }
+
+  auto* header = static_cast<BlockHeader*>(raw);
+  header->size = static_cast<uint32_t>(size);
+  header->tag = safeTag;
+  {
+    HeapGuard guard;
+    Stats& s = stats[safeTag];
+    s.liveBytes += header->size;
+    s.liveBlocks++;
+    s.allocations++;
+    if (s.liveBytes > s.peakBytes) {
+      s.peakBytes = s.liveBytes;
+    }
+    if (header->size > s.largestBlock) {
+      s.largestBlock = header->size;
+    }
+    trackedBytes += header->size;
+    if (trackedBytes > trackedPeak) {
+      trackedPeak = trackedBytes;
+    }
+  }
+  return header + 1;
+}
+
+void HeapTrace::release(void* ptr) {
+  if (!ptr) {
+    return;
+  }
+  auto* header = static_cast<BlockHeader*>(ptr) - 1;
+  {
+    HeapGuard guard;
+    Stats& s = stats[header->tag];
+    s.liveBytes -= header->size;
+    s.liveBlocks--;
+    trackedBytes -= header->size;
+  }
+  free(header);
+}
+
+HeapTrace::Stats HeapTrace::getStats(const Tag tag) const {
+  HeapGuard guard;
+  return tag < TAG_COUNT ? stats[tag] : Stats{};
+}
+
+uint32_t HeapTrace::getTrackedBytes() const {
+  HeapGuard guard;
+  return trackedBytes;
+}
+
+uint32_t HeapTrace::getTrackedPeak() const {
+  HeapGuard guard;
+  return trackedPeak;
+}
+
+uint32_t HeapTrace::getLowestLargestFreeBlock() const {
+  HeapGuard guard;
+  return lowestLargestFreeBlock == UINT32_MAX ? 0 : lowestLargestFreeBlock;
+}
+
+bool HeapTrace::getLastFailure(Failure& out) const {
+  HeapGuard guard;
+  out = lastFailure;
+  return hasFailure;
+}
+
+void HeapTrace::sample() {
+  const HeapInfo heap = getHeapInfo();
+  HeapGuard guard;
+  recordSample(heap);
+}
+
+void HeapTrace::recordSample(const HeapInfo& heap) {
+  Sample& s = samples[sampleCount % SAMPLE_COUNT];
+  s.timeMs = nowMs();
+  s.freeBytes = heap.freeBytes;
+  s.largestFreeBlock = heap.largestFreeBlock;
+  s.trackedBytes = trackedBytes;
+  sampleCount++;
+  if (heap.largestFreeBlock < lowestLargestFreeBlock) {
+    lowestLargestFreeBlock = heap.largestFreeBlock;
+  }
+}
+
+size_t HeapTrace::copySamples(Sample* out, const size_t maxSamples) const {
+  HeapGuard guard;
+  const size_t available = sampleCount < SAMPLE_COUNT ? sampleCount : SAMPLE_COUNT;
+  const size_t count = maxSamples < available ? maxSamples : available;
+  const uint32_t first = sampleCount - count;
+  for (size_t i = 0; i < count; i++) {
+    out[i] = samples[(first + i) % SAMPLE_COUNT];
+  }
+  return count;
+}
+
+void HeapTrace::reset() {
+  HeapGuard guard;
+  for (auto& s : stats) {
+    s.peakBytes = s.liveBytes;
+    s.allocations = 0;
+    s.failures = 0;
+    s.largestBlock = 0;
+  }
+  trackedPeak = trackedBytes;
+  lowestLargestFreeBlock = UINT32_MAX;
+  sampleCount = 0;
+  hasFailure = false;
+}
+
+HeapTrace::Snapshot HeapTrace::getSnapshot() const {
+  Snapshot snapshot;
+  HeapGuard guard;
+  for (uint8_t tag = 0; tag < TAG_COUNT; tag++) {
+    snapshot.stats[tag] = stats[tag];
+  }
+  snapshot.trackedBytes = trackedBytes;
+  snapshot.trackedPeak = trackedPeak;
+  snapshot.lowestLargestFreeBlock = lowestLargestFreeBlock == UINT32_MAX ? 0 : lowestLargestFreeBlock;
+  snapshot.hasFailure = hasFailure;
+  snapshot.lastFailure = lastFailure;
+  return snapshot;
+}
+
+std::string HeapTrace::formatReport() const {
+  // Both taken before the report allocates anything
+  const HeapInfo heap = getHeapInfo();
+  const Snapshot snapshot = getSnapshot();
+
+  char line[160];
+  std::string report;
+  // No allocator figures on the host without a probe
+  if (heap.freeBytes > 0) {
+    snprintf(line, sizeof(line), "heap: free %lu, largest block %lu (lowest sampled %lu), min free %lu\n",
+             static_cast<unsigned long>(heap.freeBytes), static_cast<unsigned long>(heap.largestFreeBlock),
+             static_cast<unsigned long>(snapshot.lowestLargestFreeBlock),
+             static_cast<unsigned long>(heap.minFreeBytes));
+    report += line;
+  }
+  snprintf(line, sizeof(line), "tracked: live %lu, peak %lu\n", static_cast<unsigned long>(snapshot.trackedBytes),
+           static_cast<unsigned long>(snapshot.trackedPeak));
+  report += line;
+
+  report += "tag            live_b    peak_b   blocks   allocs  largest_b  failed\n";
+  for (uint8_t tag = 0; tag < TAG_COUNT; tag++) {
+    const Stats& s = snapshot.stats[tag];
+    if (s.allocations == 0 && s.liveBlocks == 0 && s.failures == 0) {
+      continue;
+    }
+    snprintf(line, sizeof(line), "%-12s %9lu %9lu %8lu %8lu %10lu %7lu\n", getTagName(static_cast<Tag>(tag)),
+             static_cast<unsigned long>(s.liveBytes), static_cast<unsigned long>(s.peakBytes),
+             static_cast<unsigned long>(s.liveBlocks), static_cast<unsigned long>(s.allocations),
+             static_cast<unsigned long>(s.largestBlock), static_cast<unsigned long>(s.failures));
+    report += line;
+  }
+
+  if (snapshot.hasFailure) {
+    const Failure& failure = snapshot.lastFailure;
+    snprintf(line, sizeof(line), "last failure: %s %lu bytes at %lu ms, free %lu, largest block %lu\n",
+             getTagName(static_cast<Tag>(failure.tag)), static_cast<unsigned long>(failure.size),
+             static_cast<unsigned long>(failure.timeMs), static_cast<unsigned long>(failure.heap.freeBytes),
+             static_cast<unsigned long>(failure.heap.largestFreeBlock));
+    report += line;
+  }
+  return report;
+}
+
+// operator new feeds the tracker with the tag of the current scope. The aligned forms are left to the runtime; they
+// are paired with their own deletes and never see a tracking header.
+namespace {
+void* trackedNew(const std::size_t size) {
+  void* ptr = HEAP_TRACE.allocate(size, currentTag);
+  if (!ptr) {
+#if defined(__cpp_exceptions)
+    throw std::bad_alloc();
+#else
+    abort();
+#endif
+  }
+  return ptr;
+}
+}  // namespace
+
+void* operator new(const std::size_t size) { return trackedNew(size); }
+void* operator new[](const std::size_t size) { return trackedNew(size); }
+void* operator new(const std::size_t size, const std::nothrow_t&) noexcept {
+  return HEAP_TRACE.allocate(size, currentTag);
+}
+void* operator new[](const std::size_t size, const std::nothrow_t&) noexcept {
+  return HEAP_TRACE.allocate(size, currentTag);
+}
+void operator delete(void* ptr) noexcept { HEAP_TRACE.release(ptr); }
+void operator delete[](void* ptr) noexcept { HEAP_TRACE.release(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { HEAP_TRACE.release(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { HEAP_TRACE.release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { HEAP_TRACE.release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { HEAP_TRACE.release(ptr); }
+
+#endif
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "PerfTrace.h"
+
+/**
+ * Heap usage by subsystem, compiled in with -DENABLE_PERF_TRACE alongside PerfTrace.
+ *
+ * Every tracked block carries a small header with its size and tag, so live bytes, peak and block counts are exact per
+ * subsystem. Buffers the firmware mallocs directly go through HEAP_MALLOC(TAG, size) / HEAP_FREE(ptr), which must be
+ * paired. Everything allocated with operator new is tracked too, tagged with the innermost HEAP_SCOPE(TAG) active on
+ * the allocating task (OTHER outside any scope); the block keeps its tag wherever it is freed.
+ *
+ * Fragmentation shows in samples of the free heap next to its largest free block, taken periodically by the main loop
+ * and on every failed allocation. Allocation failures on the device are usually a large request meeting a fragmented
+ * heap, so the last failure is kept with the heap state it met.
+ *
+ * Without the flag the macros fall back to plain malloc/free and this class is not compiled.
+ */
+class HeapTrace {
+ public:
+  enum Tag : uint8_t {
+    OTHER,       // untagged allocations
+    LAYOUT,      // chapter parsing, words and lines while building sections or TXT pages
+    PAGE_CACHE,  // pages loaded for display or prepared ahead, XTC page buffers
+    FONT_CACHE,  // decompressed glyph groups
+    IMAGE,       // image decoding and pixel caches
+    NETWORK,     // web server and its handlers
+    CSS,         // stylesheet parsing and rules
+    DISPLAY,     // BW framebuffer copies kept across grayscale passes
+    TAG_COUNT
+  };
+
+  static constexpr size_t SAMPLE_COUNT = 120;
+
+  struct Stats {
+    uint32_t liveBytes = 0;
+    uint32_t peakBytes = 0;
+    uint32_t liveBlocks = 0;
+    uint32_t allocations = 0;
+    uint32_t failures = 0;
+    uint32_t largestBlock = 0;
+  };
+
+  // Heap state as the allocator reports it; all zero on the host unless a bench installs a probe
+  struct HeapInfo {
+    uint32_t freeBytes = 0;
+    uint32_t largestFreeBlock = 0;
+    uint32_t minFreeBytes = 0;
+  };
+
+  struct Sample {
+    uint32_t timeMs;
+    uint32_t freeBytes;
+    uint32_t largestFreeBlock;
+    uint32_t trackedBytes;
+  };
+
+  struct Failure {
+    uint32_t timeMs = 0;
+    uint32_t size = 0;
+    uint8_t tag = OTHER;
+    HeapInfo heap;
+  };
+
+  // Every counter at one instant, so the tracked total matches the sum of the tags' live bytes
+  struct Snapshot {
+    Stats stats[TAG_COUNT];
+    uint32_t trackedBytes = 0;
+    uint32_t trackedPeak = 0;
+    uint32_t lowestLargestFreeBlock = 0;
+    bool hasFailure = false;
+    Failure lastFailure;
+  };
+
+  // Tags operator new allocations of this task until destroyed; scopes nest
+  class Scope {
+    Tag previous;
+
+   public:
+    explicit Scope(const Tag tag) : previous(getCurrentTag()) { setCurrentTag(tag); }
+    ~Scope() { setCurrentTag(previous); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  static HeapTrace& getInstance() { return instance; }
+  static const char* getTagName(Tag tag);
+  static Tag getCurrentTag();
+  static void setCurrentTag(Tag tag);
+
+  static HeapInfo getHeapInfo();
+  static void setHeapProbe(HeapInfo (*probe)());
+
+  // malloc with a tracking header; nullptr on failure. Only release() may free the result.
+  void* allocate(size_t size, Tag tag);
+  void release(void* ptr);
+
+  Stats getStats(Tag tag) const;
+  uint32_t getTrackedBytes() const;
+  uint32_t getTrackedPeak() const;
+  // Lowest largest-free-block seen by any sample since the last reset
+  uint32_t getLowestLargestFreeBlock() const;
+  bool getLastFailure(Failure& out) const;
+  Snapshot getSnapshot() const;
+
+  void sample();
+  // Copies up to maxSamples of the most recent samples into out, oldest first; returns how many were copied
+  size_t copySamples(Sample* out, size_t maxSamples) const;
+  // Peaks, counters, failures and samples start over; live bytes stay, they are still allocated
+  void reset();
+
+  // Plain-text table of the tags that allocated, with the heap state, for the serial console and host benches. Built
+  // from one snapshot, so the report's own allocations do not show in it.
+  std::string formatReport() const;
+
+ private:
+  static HeapTrace instance;
+
+  Stats stats[TAG_COUNT];
+  uint32_t trackedBytes = 0;
+  uint32_t trackedPeak = 0;
+  uint32_t lowestLargestFreeBlock = UINT32_MAX;
+  Sample samples[SAMPLE_COUNT] = {};
+  uint32_t sampleCount = 0;
+  Failure lastFailure;
+  bool hasFailure = false;
+
+  void recordSample(const HeapInfo& heap);
+};
+
+#define HEAP_TRACE HeapTrace::getInstance()
+
+#ifdef ENABLE_PERF_TRACE
+#define HEAP_SCOPE(tag) const HeapTrace::Scope PERF_CONCAT(heapScope, __LINE__)(HeapTrace::tag)
+#define HEAP_MALLOC(tag, size) HEAP_TRACE.allocate(size, HeapTrace::tag)
+#define HEAP_FREE(ptr) HEAP_TRACE.release(ptr)
+#else
+#define HEAP_SCOPE(tag)
+#define HEAP_MALLOC(tag, size) malloc(size)
+#define HEAP_FREE(ptr) free(ptr)
+#endif
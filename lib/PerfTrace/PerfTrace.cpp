@@ -0,0 +1,160 @@
+#include "PerfTrace.h"
+
+#ifdef ENABLE_PERF_TRACE
+
+#include <cstdio>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#else
+#include <chrono>
+#include <mutex>
+#endif
+
+namespace {
+#ifdef ARDUINO
+// Scopes end on several tasks; the critical section is a handful of stores
+portMUX_TYPE traceLock = portMUX_INITIALIZER_UNLOCKED;
+
+struct TraceGuard {
+  TraceGuard() { portENTER_CRITICAL(&traceLock); }
+  ~TraceGuard() { portEXIT_CRITICAL(&traceLock); }
+};
+
+uint32_t platformClock() { return micros(); }
+#else
+std::mutex traceMutex;
+
+struct TraceGuard {
+  std::lock_guard<std::mutex> lock{traceMutex};
+};
+
+uint32_t platformClock() {
+  static const auto start = std::chrono::steady_clock::now();
+  return static_cast<uint32_t>(
+      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+}
+#endif
+
+uint32_t (*clockSource)() = platformClock;
+
+constexpr const char* STAGE_NAMES[PerfTrace::STAGE_COUNT] = {
+    "zip_lookup", "inflate", "xml_parse", "layout",  "serialize",   "page_load",
+    "render",     "display", "sd_read",   "sd_write", "font_inflate",
+};
+
+size_t bucketFor(const uint32_t durationUs) {
+  size_t bucket = 0;
+  for (uint32_t v = durationUs; v > 1 && bucket < PerfTrace::BUCKET_COUNT - 1; v >>= 1) {
+    bucket++;
+  }
+  return bucket;
+}
+}  // namespace
+
+PerfTrace PerfTrace::instance;
+
+const char* PerfTrace::getStageName(const Stage stage) {
+  return stage < STAGE_COUNT ? STAGE_NAMES[stage] : "unknown";
+}
+
+uint32_t PerfTrace::now() { return clockSource(); }
+
+void PerfTrace::setClock(uint32_t (*clock)()) { clockSource = clock ? clock : platformClock; }
+
+uint32_t PerfTrace::Stats::getPercentileUs(const uint8_t percentile) const {
+  if (count == 0) {
+    return 0;
+  }
+  // Rank of the sample, rounded up so p100 is the last one
+  const uint64_t rank = (static_cast<uint64_t>(count) * percentile + 99) / 100;
+  uint64_t seen = 0;
+  for (size_t b = 0; b < BUCKET_COUNT; b++) {
+    seen += buckets[b];
+    if (seen >= rank && seen > 0) {
+      const uint32_t upper = b == BUCKET_COUNT - 1 ? maxUs : (2u << b) - 1;
+      return upper < maxUs ? upper : maxUs;
+    }
+  }
+  return maxUs;
+}
+
+void PerfTrace::record(const Stage stage, const uint32_t timeUs, const bool end) {
+  Event& event = ring[eventCount % RING_SIZE];
+  event.timeUs = timeUs;
+  event.stage = stage;
+  event.end = end;
+  eventCount++;
+}
+
+uint32_t PerfTrace::begin(const Stage stage) {
+  const uint32_t startUs = now();
+  TraceGuard guard;
+  record(stage, startUs, false);
+  return startUs;
+}
+
+void PerfTrace::end(const Stage stage, const uint32_t startUs) {
+  const uint32_t endUs = now();
+  const uint32_t durationUs = endUs - startUs;
+  TraceGuard guard;
+  record(stage, endUs, true);
+  Stats& s = stats[stage];
+  s.count++;
+  s.totalUs += durationUs;
+  if (durationUs > s.maxUs) {
+    s.maxUs = durationUs;
+  }
+  s.buckets[bucketFor(durationUs)]++;
+}
+
+PerfTrace::Stats PerfTrace::getStats(const Stage stage) const {
+  TraceGuard guard;
+  return stage < STAGE_COUNT ? stats[stage] : Stats{};
+}
+
+size_t PerfTrace::copyEvents(Event* out, const size_t maxEvents) const {
+  TraceGuard guard;
+  const size_t available = eventCount < RING_SIZE ? eventCount : RING_SIZE;
+  const size_t count = maxEvents < available ? maxEvents : available;
+  // The newest `count` events, oldest first
+  const uint32_t first = eventCount - count;
+  for (size_t i = 0; i < count; i++) {
+    out[i] = ring[(first + i) % RING_SIZE];
+  }
+  return count;
+}
+
+uint32_t PerfTrace::getEventCount() const {
+  TraceGuard guard;
+  return eventCount;
+}
+
+void PerfTrace::reset() {
+  TraceGuard guard;
+  eventCount = 0;
+  for (auto& s : stats) {
+    s = Stats{};
+  }
+}
+
+std::string PerfTrace::formatReport() const {
+  std::string report = "stage           count    total_ms    avg_us    p50_us    p90_us    p99_us    max_us\n";
+  char line[128];
+  for (uint8_t stage = 0; stage < STAGE_COUNT; stage++) {
+    const Stats s = getStats(static_cast<Stage>(stage));
+    if (s.count == 0) {
+      continue;
+    }
+    snprintf(line, sizeof(line), "%-12s %8lu %11.1f %9lu %9lu %9lu %9lu %9lu\n",
+             getStageName(static_cast<Stage>(stage)), static_cast<unsigned long>(s.count), s.totalUs / 1000.0,
+             static_cast<unsigned long>(s.totalUs / s.count), static_cast<unsigned long>(s.getPercentileUs(50)),
+             static_cast<unsigned long>(s.getPercentileUs(90)), static_cast<unsigned long>(s.getPercentileUs(99)),
+             static_cast<unsigned long>(s.maxUs));
+    report += line;
+  }
+  return report;
+}
+
+#endif
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * Timing of the hot paths, compiled in with -DENABLE_PERF_TRACE (see the perf environment in platformio.ini).
+ *
+ * Code marks a stage with PERF_SCOPE(STAGE). Entering and leaving it appends a begin and an end event to a fixed ring
+ * of the most recent events, and the duration goes into a per-stage histogram with power-of-two buckets in
+ * microseconds. Stages nest and are timed inclusively: XML_PARSE also covers the layout and serialization its
+ * callbacks trigger, PAGE_LOAD the SD reads it makes. Scopes may run on any task.
+ *
+ * Without the flag PERF_SCOPE expands to nothing and this class is not compiled, so release builds pay nothing. The
+ * report is served at /api/perf, printed by the CMD:PERF serial command, and available to host benches that build
+ * the library with the flag set.
+ */
+class PerfTrace {
+ public:
+  enum Stage : uint8_t {
+    ZIP_LOOKUP,       // finding an entry in the EPUB's central directory
+    INFLATE,          // decompressing EPUB entries
+    XML_PARSE,        // expat over a chapter or package document
+    LAYOUT,           // breaking paragraphs or plain text into lines
+    SERIALIZE,        // writing a finished page to the section cache
+    PAGE_LOAD,        // reading a page back from a cache or book file
+    RENDER_PASS,      // drawing a page into the framebuffer (each BW or grayscale pass)
+    DISPLAY_REFRESH,  // sending the framebuffer and waiting for the panel
+    SD_READ,          // buffered cache reads
+    SD_WRITE,         // buffered cache writes
+    FONT_INFLATE,     // decompressing a glyph group
+    STAGE_COUNT
+  };
+
+  static constexpr size_t RING_SIZE = 512;
+  // Bucket b counts durations in [2^b, 2^(b+1)) us; the first one also holds 0 and the last everything longer
+  static constexpr size_t BUCKET_COUNT = 24;
+
+  struct Event {
+    uint32_t timeUs;
+    uint8_t stage;
+    bool end;
+  };
+
+  struct Stats {
+    uint32_t count = 0;
+    uint64_t totalUs = 0;
+    uint32_t maxUs = 0;
+    uint32_t buckets[BUCKET_COUNT] = {};
+
+    // Upper bound of the bucket holding the given percentile (0-100), capped at maxUs
+    uint32_t getPercentileUs(uint8_t percentile) const;
+  };
+
+  // Times one stage from construction to destruction
+  class Scope {
+    Stage stage;
+    uint32_t startUs;
+
+   public:
+    explicit Scope(const Stage stage) : stage(stage), startUs(getInstance().begin(stage)) {}
+    ~Scope() { getInstance().end(stage, startUs); }
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+  };
+
+  static PerfTrace& getInstance() { return instance; }
+  static const char* getStageName(Stage stage);
+
+  // Microsecond clock used for all events; host benches may install their own to get deterministic timings
+  static uint32_t now();
+  static void setClock(uint32_t (*clock)());
+
+  uint32_t begin(Stage stage);
+  void end(Stage stage, uint32_t startUs);
+
+  Stats getStats(Stage stage) const;
+  // Copies up to maxEvents of the most recent events into out, oldest first; returns how many were copied
+  size_t copyEvents(Event* out, size_t maxEvents) const;
+  // Events written since the last reset; anything beyond RING_SIZE has been overwritten
+  uint32_t getEventCount() const;
+  void reset();
+
+  // Plain-text table of all stages that ran, one line each, for the serial console and host benches
+  std::string formatReport() const;
+
+ private:
+  static PerfTrace instance;
+
+  Event ring[RING_SIZE] = {};
+  uint32_t eventCount = 0;
+  Stats stats[STAGE_COUNT];
+
+  void record(Stage stage, uint32_t timeUs, bool end);
+};
+
+#define PERF_TRACE PerfTrace::getInstance()
+
+#define PERF_CONCAT_INNER(a, b) a##b
+#define PERF_CONCAT(a, b) PERF_CONCAT_INNER(a, b)
+#ifdef ENABLE_PERF_TRACE
+#define PERF_SCOPE(stage) const PerfTrace::Scope PERF_CONCAT(perfScope, __LINE__)(PerfTrace::stage)
+#else
+#define PERF_SCOPE(stage)
+#endif
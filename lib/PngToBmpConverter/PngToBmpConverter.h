@@ -2,7 +2,10 @@
 
 #include <HalStorage.h>
 
+#include <functional>
+
 class Print;
+struct BmpOutputSpec;
 
 class PngToBmpConverter {
   static bool pngFileToBmpStreamInternal(FsFile& pngFile, Print& bmpOut, int targetWidth, int targetHeight, bool oneBit,
@@ -12,4 +15,8 @@ class PngToBmpConverter {
   static bool pngFileToBmpStream(FsFile& pngFile, Print& bmpOut, bool crop = true);
   static bool pngFileToBmpStreamWithSize(FsFile& pngFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
   static bool pngFileTo1BitBmpStreamWithSize(FsFile& pngFile, Print& bmpOut, int targetMaxWidth, int targetMaxHeight);
+  // Decode once and write one BMP per output spec (e.g. cover plus every thumbnail size). progressFn runs every
+  // few scanlines; returning false stops the decode and fails it.
+  static bool pngFileToBmpStreams(FsFile& pngFile, const BmpOutputSpec* outputs, int outputCount,
+                                  const std::function<bool()>& progressFn = nullptr);
 };
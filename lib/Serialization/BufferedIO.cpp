@@ -0,0 +1,180 @@
+#include "BufferedIO.h"
+
+#include <PerfTrace.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace serialization {
+
+/* ============= BufferedWriter ================ */
+
+BufferedWriter::BufferedWriter(FsFile& file) : file(file), filePos(file ? file.position() : 0) {}
+
+BufferedWriter::BufferedWriter(FsFile& file, const uint32_t base) : file(file), base(base) {
+  if (!file || !file.seek(base)) {
+    error = true;
+  }
+}
+
+BufferedWriter::~BufferedWriter() { flush(); }
+
+bool BufferedWriter::write(const void* data, const size_t len) {
+  const auto* src = static_cast<const uint8_t*>(data);
+
+  // Large payloads bypass the buffer once pending bytes are out of the way
+  if (len >= BUFFER_SIZE) {
+    if (!flush()) {
+      return false;
+    }
+    writeCalls++;
+    PERF_SCOPE(SD_WRITE);
+    const size_t written = file.write(src, len);
+    filePos += written;
+    if (written != len) {
+      error = true;
+      return false;
+    }
+    return true;
+  }
+
+  if (used + len > BUFFER_SIZE && !flush()) {
+    return false;
+  }
+  memcpy(buffer + used, src, len);
+  used += len;
+  return true;
+}
+
+bool BufferedWriter::flush() {
+  if (used > 0) {
+    writeCalls++;
+    PERF_SCOPE(SD_WRITE);
+    const size_t written = file.write(buffer, used);
+    filePos += written;
+    if (written != used) {
+      error = true;
+    }
+    used = 0;
+  }
+  return !error;
+}
+
+bool BufferedWriter::seek(const uint32_t pos) {
+  flush();
+  if (!file.seek(base + pos)) {
+    error = true;
+    return false;
+  }
+  filePos = pos;
+  return !error;
+}
+
+/* ============= BufferedReader ================ */
+
+BufferedReader::BufferedReader(FsFile& file) : file(file) {
+  if (file) {
+    fileSize = file.size();
+    bufferStart = file.position();
+  } else {
+    error = true;
+  }
+}
+
+BufferedReader::BufferedReader(FsFile& file, const uint32_t base, const uint32_t size)
+    : file(file), base(base), fileSize(size) {
+  if (!file || !file.seek(base) || base + size > file.size()) {
+    error = true;
+  }
+}
+
+bool BufferedReader::fill() {
+  bufferStart += filled;
+  cursor = 0;
+  filled = 0;
+  if (bufferStart >= fileSize) {
+    return false;
+  }
+  readCalls++;
+  PERF_SCOPE(SD_READ);
+  const int n = file.read(buffer, BUFFER_SIZE);
+  if (n <= 0) {
+    return false;
+  }
+  filled = n;
+  return true;
+}
+
+bool BufferedReader::read(void* data, size_t len) {
+  auto* dst = static_cast<uint8_t*>(data);
+  if (error || len > remaining()) {
+    memset(dst, 0, len);
+    error = true;
+    return false;
+  }
+
+  while (len > 0) {
+    if (cursor == filled) {
+      // Large reads go straight into the destination
+      if (len >= BUFFER_SIZE) {
+        bufferStart += filled;
+        cursor = 0;
+        filled = 0;
+        readCalls++;
+        PERF_SCOPE(SD_READ);
+        const int n = file.read(dst, len);
+        if (n != static_cast<int>(len)) {
+          memset(dst, 0, len);
+          error = true;
+          return false;
+        }
+        bufferStart += len;
+        return true;
+      }
+      if (!fill()) {
+        memset(dst, 0, len);
+        error = true;
+        return false;
+      }
+    }
+    const size_t chunk = std::min(len, filled - cursor);
+    memcpy(dst, buffer + cursor, chunk);
+    cursor += chunk;
+    dst += chunk;
+    len -= chunk;
+  }
+  return true;
+}
+
+bool BufferedReader::skip(const size_t len) {
+  if (error || len > remaining()) {
+    error = true;
+    return false;
+  }
+  return seek(position() + len);
+}
+
+bool BufferedReader::seek(const uint32_t pos) {
+  if (error) {
+    return false;
+  }
+  if (pos > fileSize) {
+    error = true;
+    return false;
+  }
+  // Stay inside the current window if possible
+  if (pos >= bufferStart && pos <= bufferStart + filled) {
+    cursor = pos - bufferStart;
+    return true;
+  }
+  if (!file.seek(base + pos)) {
+    error = true;
+    return false;
+  }
+  bufferStart = pos;
+  cursor = 0;
+  filled = 0;
+  return true;
+}
+
+}  // namespace serialization
@@ -0,0 +1,189 @@
+#pragma once
+#include <HalStorage.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace serialization {
+
+/**
+ * Write-side buffer for cache files.
+ *
+ * Every HalFile call takes the storage mutex and goes through SdFat, so writing a cache format one field at a time
+ * costs one locked call per field. BufferedWriter collects fields in a fixed internal buffer and hands them to the
+ * file in sector-sized chunks. position() reports the logical position (file position + pending bytes) so callers
+ * can keep recording offsets for their lookup tables.
+ *
+ * The writer does not own the file; flush() (or destruction) must happen before the file is closed. A writer with a
+ * base offset treats that file offset as position 0, so a format can be written into a slice of a larger file (a
+ * PackFile entry) with the same offsets it would have in a file of its own.
+ */
+class BufferedWriter {
+ public:
+  static constexpr size_t BUFFER_SIZE = 512;
+
+  explicit BufferedWriter(FsFile& file);
+  BufferedWriter(FsFile& file, uint32_t base);
+  ~BufferedWriter();
+
+  BufferedWriter(const BufferedWriter&) = delete;
+  BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+  bool write(const void* data, size_t len);
+  bool write(uint8_t b) { return write(&b, 1); }
+  // Push any pending bytes to the file. Returns false if any write since construction has failed.
+  bool flush();
+  // Flushes pending bytes and moves the underlying file position (used to patch headers).
+  bool seek(uint32_t pos);
+  // Drop pending bytes without writing them (used when the file is being abandoned).
+  void discard() { used = 0; }
+  uint32_t position() const { return filePos + used; }
+
+  bool hasError() const { return error; }
+  // Number of HalFile::write calls issued so far (for benchmarking)
+  uint32_t getWriteCalls() const { return writeCalls; }
+
+ private:
+  FsFile& file;
+  uint8_t buffer[BUFFER_SIZE];
+  size_t used = 0;
+  uint32_t base = 0;     // file offset of position 0
+  uint32_t filePos = 0;  // relative to base
+  uint32_t writeCalls = 0;
+  bool error = false;
+};
+
+/**
+ * Read-side buffer for cache files.
+ *
+ * Reads are served from a fixed internal buffer refilled in BUFFER_SIZE chunks. Seeks that land inside the currently
+ * buffered window do not touch the file. All reads are bounds-checked against the file size: a short or out-of-range
+ * read zero-fills the destination and latches the error flag, so deserializers can read a whole record and check
+ * ok() once instead of testing every field.
+ *
+ * A reader with a window sees only [base, base + size) of the file, with base as position 0.
+ */
+class BufferedReader {
+ public:
+  static constexpr size_t BUFFER_SIZE = 512;
+
+  explicit BufferedReader(FsFile& file);
+  BufferedReader(FsFile& file, uint32_t base, uint32_t size);
+
+  BufferedReader(const BufferedReader&) = delete;
+  BufferedReader& operator=(const BufferedReader&) = delete;
+
+  bool read(void* data, size_t len);
+  bool skip(size_t len);
+  bool seek(uint32_t pos);
+  uint32_t position() const { return bufferStart + cursor; }
+  uint32_t size() const { return fileSize; }
+  uint32_t remaining() const { return fileSize > position() ? fileSize - position() : 0; }
+
+  bool ok() const { return !error; }
+  bool hasError() const { return error; }
+  // Number of HalFile::read calls issued so far (for benchmarking)
+  uint32_t getReadCalls() const { return readCalls; }
+
+ private:
+  bool fill();
+
+  FsFile& file;
+  uint8_t buffer[BUFFER_SIZE];
+  uint32_t base = 0;         // file offset of position 0
+  uint32_t fileSize = 0;     // size of the window
+  uint32_t bufferStart = 0;  // position of buffer[0]
+  size_t cursor = 0;         // read position within buffer
+  size_t filled = 0;         // valid bytes in buffer
+  uint32_t readCalls = 0;
+  bool error = false;
+};
+
+// Fixed-width fields
+
+template <typename T>
+static void writePod(BufferedWriter& writer, const T& value) {
+  writer.write(&value, sizeof(T));
+}
+
+template <typename T>
+static bool readPod(BufferedReader& reader, T& value) {
+  return reader.read(&value, sizeof(T));
+}
+
+// LEB128 varint (7 bits per byte, high bit = continuation)
+
+static void writeVarint(BufferedWriter& writer, uint32_t value) {
+  uint8_t bytes[5];
+  size_t n = 0;
+  do {
+    uint8_t b = value & 0x7F;
+    value >>= 7;
+    if (value) b |= 0x80;
+    bytes[n++] = b;
+  } while (value);
+  writer.write(bytes, n);
+}
+
+static bool readVarint(BufferedReader& reader, uint32_t& value) {
+  value = 0;
+  for (int shift = 0; shift < 35; shift += 7) {
+    uint8_t b;
+    if (!reader.read(&b, 1)) {
+      value = 0;
+      return false;
+    }
+    value |= static_cast<uint32_t>(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      return true;
+    }
+  }
+  value = 0;
+  return false;
+}
+
+// Length-prefixed strings. writeString/readString use the same uint32_t prefix as the FsFile overloads so existing
+// formats stay readable; writeVarString/readVarString use a varint prefix for compact formats with many short strings.
+// Reads reject lengths larger than the remaining file instead of allocating them.
+
+static void writeString(BufferedWriter& writer, const std::string& s) {
+  const uint32_t len = s.size();
+  writePod(writer, len);
+  writer.write(s.data(), len);
+}
+
+static bool readStringBody(BufferedReader& reader, std::string& s, const uint32_t len) {
+  if (len > reader.remaining()) {
+    s.clear();
+    reader.skip(len);  // latches the error flag
+    return false;
+  }
+  s.resize(len);
+  return len == 0 || reader.read(&s[0], len);
+}
+
+static bool readString(BufferedReader& reader, std::string& s) {
+  uint32_t len = 0;
+  if (!readPod(reader, len)) {
+    s.clear();
+    return false;
+  }
+  return readStringBody(reader, s, len);
+}
+
+static void writeVarString(BufferedWriter& writer, const std::string& s) {
+  writeVarint(writer, s.size());
+  writer.write(s.data(), s.size());
+}
+
+static bool readVarString(BufferedReader& reader, std::string& s) {
+  uint32_t len = 0;
+  if (!readVarint(reader, len)) {
+    s.clear();
+    return false;
+  }
+  return readStringBody(reader, s, len);
+}
+
+}  // namespace serialization
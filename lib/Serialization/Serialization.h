@@ -3,6 +3,8 @@
 
 #include <iostream>
 
+#include "BufferedIO.h"
+
 namespace serialization {
 template <typename T>
 static void writePod(std::ostream& os, const T& value) {
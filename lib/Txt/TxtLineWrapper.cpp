@@ -0,0 +1,89 @@
+#include "TxtLineWrapper.h"
+
+namespace {
+// End of the UTF-8 character starting at text[pos]
+size_t nextCharEnd(const char* text, size_t pos, const size_t end) {
+  pos++;
+  while (pos < end && (static_cast<unsigned char>(text[pos]) & 0xC0) == 0x80) {
+    pos++;
+  }
+  return pos;
+}
+}  // namespace
+
+int TxtLineWrapper::measureWord(const char* word, const size_t len) {
+  if (word != cachedWord || len != cachedWordLen) {
+    cachedWord = word;
+    cachedWordLen = len;
+    cachedWordWidth = len > 0 ? measure(word, len) : 0;
+  }
+  return cachedWordWidth;
+}
+
+int TxtLineWrapper::measureChars(const char* text, const size_t start, const size_t end, const int limit,
+                                 size_t& fitEnd) const {
+  int width = 0;
+  size_t pos = start;
+  while (pos < end) {
+    const size_t next = nextCharEnd(text, pos, end);
+    const int charWidth = measure(text + pos, next - pos);
+    if (width + charWidth > limit) {
+      break;
+    }
+    width += charWidth;
+    pos = next;
+  }
+  fitEnd = pos;
+  return width;
+}
+
+size_t TxtLineWrapper::nextLine(const char* text, const size_t len, size_t& lineLen) {
+  int width = 0;
+  size_t breakPos = 0;  // last space the line can be broken at (never the first byte)
+  size_t pos = 0;
+
+  while (true) {
+    size_t wordEnd = pos;
+    while (wordEnd < len && text[wordEnd] != ' ') {
+      wordEnd++;
+    }
+    const int lead = pos > 0 ? spaceWidth : 0;
+    const int available = maxWidth - width - lead;
+
+    int wordWidth;
+    size_t fitEnd = pos;
+    bool fits;
+    if (wordEnd - pos <= MAX_WHOLE_WORD_BYTES) {
+      wordWidth = measureWord(text + pos, wordEnd - pos);
+      fits = wordWidth <= available;
+    } else {
+      wordWidth = measureChars(text, pos, wordEnd, available, fitEnd);
+      fits = fitEnd == wordEnd;
+    }
+
+    if (!fits) {
+      if (breakPos > 0) {
+        // Break at the space before this word and drop it
+        lineLen = breakPos;
+        return breakPos + 1;
+      }
+      // Nothing before this word can end the line: split the word at the last character that fits
+      if (wordEnd - pos <= MAX_WHOLE_WORD_BYTES) {
+        measureChars(text, pos, wordEnd, available, fitEnd);
+      }
+      if (fitEnd == 0) {
+        fitEnd = nextCharEnd(text, 0, len);
+      }
+      lineLen = fitEnd;
+      return fitEnd;
+    }
+
+    width += lead + wordWidth;
+    if (wordEnd >= len) {
+      lineLen = len;
+      return len;
+    }
+    breakPos = wordEnd;
+    pos = wordEnd + 1;
+  }
+}
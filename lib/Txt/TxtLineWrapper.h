@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+/**
+ * Greedy word wrap for plain text lines in a single forward pass.
+ *
+ * Words are measured once each and a line's width is accumulated from word advances plus a fixed space width, so
+ * wrapping a source line costs time linear in its length. Words longer than MAX_WHOLE_WORD_BYTES (unbroken CJK runs,
+ * URLs) are measured one character at a time and only as far as the line reaches.
+ *
+ * The wrapper caches the width of the word that ended the previous line, keyed by its address, so one wrapper must
+ * only be used with a single text buffer.
+ */
+class TxtLineWrapper {
+ public:
+  // Advance width in pixels of text[0, len), which never contains a space
+  using MeasureFn = std::function<int(const char* text, size_t len)>;
+
+  static constexpr size_t MAX_WHOLE_WORD_BYTES = 64;
+
+  TxtLineWrapper(MeasureFn measure, int spaceWidth, int maxWidth)
+      : measure(std::move(measure)), spaceWidth(spaceWidth), maxWidth(maxWidth) {}
+
+  // Lays out the next display line from the start of text[0, len), one source line without its line break. Sets
+  // lineLen to the bytes shown on the display line and returns the bytes consumed, which includes the space the line
+  // was broken at. Always consumes at least one character of non-empty text.
+  size_t nextLine(const char* text, size_t len, size_t& lineLen);
+
+ private:
+  int measureWord(const char* word, size_t len);
+  // Width of the characters of text[start, end) that fit in limit; fitEnd is set to the end of the last one
+  int measureChars(const char* text, size_t start, size_t end, int limit, size_t& fitEnd) const;
+
+  MeasureFn measure;
+  int spaceWidth;
+  int maxWidth;
+
+  const char* cachedWord = nullptr;
+  size_t cachedWordLen = 0;
+  int cachedWordWidth = 0;
+};
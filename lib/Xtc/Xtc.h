@@ -58,6 +58,7 @@ class Xtc {
   std::string getTitle() const;
   std::string getAuthor() const;
   bool hasChapters() const;
+  // Reads the chapter list from the file on first use
   const std::vector<xtc::ChapterInfo>& getChapters() const;
 
   // Cover image support (for sleep screen)
@@ -10,13 +10,20 @@
 #include <FsHelpers.h>
 #include <HalStorage.h>
 #include <Logging.h>
+#include <PerfTrace.h>
 
+#include <algorithm>
 #include <cstring>
 
 namespace xtc {
 
 XtcParser::XtcParser()
     : m_isOpen(false),
+      m_pageWindowStart(0),
+      m_pageWindowCount(0),
+      m_chapterOffset(0),
+      m_chapterSlots(0),
+      m_chaptersLoaded(false),
       m_defaultWidth(DISPLAY_WIDTH),
       m_defaultHeight(DISPLAY_HEIGHT),
       m_bitDepth(1),
@@ -71,8 +78,8 @@ XtcError XtcParser::open(const char* filepath) {
     return m_lastError;
   }
 
-  // Read chapters if present
-  m_lastError = readChapters();
+  // Find the chapter table if present; the chapters themselves are read when first needed
+  m_lastError = locateChapters();
   if (m_lastError != XtcError::OK) {
     LOG_DBG("XTC", "Failed to read chapters: %s", errorToString(m_lastError));
     m_file.close();
@@ -89,8 +96,12 @@ void XtcParser::close() {
     m_file.close();
     m_isOpen = false;
   }
-  m_pageTable.clear();
+  m_pageWindowStart = 0;
+  m_pageWindowCount = 0;
   m_chapters.clear();
+  m_chapterOffset = 0;
+  m_chapterSlots = 0;
+  m_chaptersLoaded = false;
   m_title.clear();
   m_hasChapters = false;
   memset(&m_header, 0, sizeof(m_header));
@@ -169,43 +180,65 @@ XtcError XtcParser::readPageTable() {
     return XtcError::CORRUPTED_HEADER;
   }
 
-  // Seek to page table
-  if (!m_file.seek(m_header.pageTableOffset)) {
-    LOG_DBG("XTC", "Failed to seek to page table at %llu", m_header.pageTableOffset);
-    return XtcError::READ_ERROR;
+  const uint64_t tableSize = static_cast<uint64_t>(m_header.pageCount) * sizeof(PageTableEntry);
+  if (m_header.pageTableOffset + tableSize > m_file.size()) {
+    LOG_DBG("XTC", "Page table at %llu does not fit in the file", m_header.pageTableOffset);
+    return XtcError::CORRUPTED_HEADER;
   }
 
-  m_pageTable.resize(m_header.pageCount);
+  // Only the first window is read here, for the default page dimensions
+  const XtcError err = readPageTableWindow(0);
+  if (err != XtcError::OK) {
+    return err;
+  }
+  m_defaultWidth = m_pageWindow[0].width;
+  m_defaultHeight = m_pageWindow[0].height;
+  return XtcError::OK;
+}
 
-  // Read page table entries
-  for (uint16_t i = 0; i < m_header.pageCount; i++) {
-    PageTableEntry entry;
-    size_t bytesRead = m_file.read(reinterpret_cast<uint8_t*>(&entry), sizeof(PageTableEntry));
-    if (bytesRead != sizeof(PageTableEntry)) {
-      LOG_DBG("XTC", "Failed to read page table entry %u", i);
-      return XtcError::READ_ERROR;
-    }
+XtcError XtcParser::readPageTableWindow(const uint32_t pageIndex) {
+  // Start a little before the requested page so turning back a few pages stays inside the window, and keep the window
+  // full at the end of the book
+  uint32_t start = pageIndex > PAGE_TABLE_WINDOW / 4 ? pageIndex - PAGE_TABLE_WINDOW / 4 : 0;
+  if (m_header.pageCount > PAGE_TABLE_WINDOW) {
+    start = std::min<uint32_t>(start, m_header.pageCount - PAGE_TABLE_WINDOW);
+  } else {
+    start = 0;
+  }
+  const uint32_t count = std::min<uint32_t>(PAGE_TABLE_WINDOW, m_header.pageCount - start);
 
-    m_pageTable[i].offset = static_cast<uint32_t>(entry.dataOffset);
-    m_pageTable[i].size = entry.dataSize;
-    m_pageTable[i].width = entry.width;
-    m_pageTable[i].height = entry.height;
-    m_pageTable[i].bitDepth = m_bitDepth;
+  m_pageWindowCount = 0;
+  if (!m_file.seek(m_header.pageTableOffset + static_cast<uint64_t>(start) * sizeof(PageTableEntry))) {
+    LOG_DBG("XTC", "Failed to seek to page table entry %lu", start);
+    return XtcError::READ_ERROR;
+  }
 
-    // Update default dimensions from first page
-    if (i == 0) {
-      m_defaultWidth = entry.width;
-      m_defaultHeight = entry.height;
-    }
+  PageTableEntry entries[PAGE_TABLE_WINDOW];
+  const size_t bytes = count * sizeof(PageTableEntry);
+  const size_t bytesRead = m_file.read(reinterpret_cast<uint8_t*>(entries), bytes);
+  if (bytesRead != bytes) {
+    LOG_DBG("XTC", "Failed to read page table entries %lu-%lu", start, start + count - 1);
+    return XtcError::READ_ERROR;
   }
 
-  LOG_DBG("XTC", "Read %u page table entries", m_header.pageCount);
+  for (uint32_t i = 0; i < count; i++) {
+    m_pageWindow[i].offset = static_cast<uint32_t>(entries[i].dataOffset);
+    m_pageWindow[i].size = entries[i].dataSize;
+    m_pageWindow[i].width = entries[i].width;
+    m_pageWindow[i].height = entries[i].height;
+    m_pageWindow[i].bitDepth = m_bitDepth;
+  }
+  m_pageWindowStart = start;
+  m_pageWindowCount = count;
   return XtcError::OK;
 }
 
-XtcError XtcParser::readChapters() {
+XtcError XtcParser::locateChapters() {
   m_hasChapters = false;
   m_chapters.clear();
+  m_chapterOffset = 0;
+  m_chapterSlots = 0;
+  m_chaptersLoaded = false;
 
   uint8_t hasChaptersFlag = 0;
   if (!m_file.seek(0x0B)) {
@@ -250,13 +283,21 @@ XtcError XtcParser::readChapters() {
   }
 
   constexpr size_t chapterSize = 96;
-  const uint64_t available = maxOffset - chapterOffset;
-  const size_t chapterCount = static_cast<size_t>(available / chapterSize);
-  if (chapterCount == 0) {
+  m_chapterOffset = chapterOffset;
+  m_chapterSlots = static_cast<size_t>((maxOffset - chapterOffset) / chapterSize);
+  m_hasChapters = m_chapterSlots > 0;
+  return XtcError::OK;
+}
+
+XtcError XtcParser::readChapters() {
+  m_chapters.clear();
+  if (!m_hasChapters) {
     return XtcError::OK;
   }
 
-  if (!m_file.seek(chapterOffset)) {
+  constexpr size_t chapterSize = 96;
+  const size_t chapterCount = m_chapterSlots;
+  if (!m_file.seek(m_chapterOffset)) {
     return XtcError::READ_ERROR;
   }
 
@@ -304,20 +345,37 @@ XtcError XtcParser::readChapters() {
     m_chapters.push_back(std::move(chapter));
   }
 
-  m_hasChapters = !m_chapters.empty();
   LOG_DBG("XTC", "Chapters: %u", static_cast<unsigned int>(m_chapters.size()));
   return XtcError::OK;
 }
 
-bool XtcParser::getPageInfo(uint32_t pageIndex, PageInfo& info) const {
-  if (pageIndex >= m_pageTable.size()) {
+const std::vector<ChapterInfo>& XtcParser::getChapters() {
+  if (!m_chaptersLoaded && m_isOpen) {
+    m_chaptersLoaded = true;
+    const XtcError err = readChapters();
+    if (err != XtcError::OK) {
+      LOG_DBG("XTC", "Failed to read chapters: %s", errorToString(err));
+      m_chapters.clear();
+    }
+  }
+  return m_chapters;
+}
+
+bool XtcParser::getPageInfo(const uint32_t pageIndex, PageInfo& info) {
+  if (pageIndex >= m_header.pageCount) {
     return false;
   }
-  info = m_pageTable[pageIndex];
+  if (pageIndex < m_pageWindowStart || pageIndex >= m_pageWindowStart + m_pageWindowCount) {
+    if (readPageTableWindow(pageIndex) != XtcError::OK) {
+      return false;
+    }
+  }
+  info = m_pageWindow[pageIndex - m_pageWindowStart];
   return true;
 }
 
 size_t XtcParser::loadPage(uint32_t pageIndex, uint8_t* buffer, size_t bufferSize) {
+  PERF_SCOPE(PAGE_LOAD);
   if (!m_isOpen) {
     m_lastError = XtcError::FILE_NOT_FOUND;
     return 0;
@@ -328,7 +386,11 @@ size_t XtcParser::loadPage(uint32_t pageIndex, uint8_t* buffer, size_t bufferSiz
     return 0;
   }
 
-  const PageInfo& page = m_pageTable[pageIndex];
+  PageInfo page;
+  if (!getPageInfo(pageIndex, page)) {
+    m_lastError = XtcError::READ_ERROR;
+    return 0;
+  }
 
   // Seek to page data
   if (!m_file.seek(page.offset)) {
@@ -396,7 +458,10 @@ XtcError XtcParser::loadPageStreaming(uint32_t pageIndex,
     return XtcError::PAGE_OUT_OF_RANGE;
   }
 
-  const PageInfo& page = m_pageTable[pageIndex];
+  PageInfo page;
+  if (!getPageInfo(pageIndex, page)) {
+    return XtcError::READ_ERROR;
+  }
 
   // Seek to page data
   if (!m_file.seek(page.offset)) {
@@ -41,8 +41,9 @@ class XtcParser {
   uint16_t getHeight() const { return m_defaultHeight; }
   uint8_t getBitDepth() const { return m_bitDepth; }  // 1 = XTC/XTG, 2 = XTCH/XTH
 
-  // Page information
-  bool getPageInfo(uint32_t pageIndex, PageInfo& info) const;
+  // Page information. The page table is not kept in memory; entries are read in small windows around the requested
+  // page, so this may seek the file.
+  bool getPageInfo(uint32_t pageIndex, PageInfo& info);
 
   /**
    * Load page bitmap (raw 1-bit data, skipping XTG header)
@@ -71,8 +72,9 @@ class XtcParser {
   std::string getTitle() const { return m_title; }
   std::string getAuthor() const { return m_author; }
 
+  // hasChapters() only reflects the header; the chapter list is read on the first getChapters() call
   bool hasChapters() const { return m_hasChapters; }
-  const std::vector<ChapterInfo>& getChapters() const { return m_chapters; }
+  const std::vector<ChapterInfo>& getChapters();
 
   // Validation
   static bool isValidXtcFile(const char* filepath);
@@ -81,11 +83,19 @@ class XtcParser {
   XtcError getLastError() const { return m_lastError; }
 
  private:
+  // Page table entries cached around the last requested page
+  static constexpr uint32_t PAGE_TABLE_WINDOW = 32;
+
   FsFile m_file;
   bool m_isOpen;
   XtcHeader m_header;
-  std::vector<PageInfo> m_pageTable;
+  PageInfo m_pageWindow[PAGE_TABLE_WINDOW];
+  uint32_t m_pageWindowStart;
+  uint32_t m_pageWindowCount;
   std::vector<ChapterInfo> m_chapters;
+  uint64_t m_chapterOffset;
+  size_t m_chapterSlots;  // chapter records that fit in the chapter area
+  bool m_chaptersLoaded;
   std::string m_title;
   std::string m_author;
   uint16_t m_defaultWidth;
@@ -97,8 +107,10 @@ class XtcParser {
   // Internal helper functions
   XtcError readHeader();
   XtcError readPageTable();
+  XtcError readPageTableWindow(uint32_t pageIndex);
   XtcError readTitle();
   XtcError readAuthor();
+  XtcError locateChapters();
   XtcError readChapters();
 };
 
@@ -3,8 +3,10 @@
 #include <HalStorage.h>
 #include <InflateReader.h>
 #include <Logging.h>
+#include <PerfTrace.h>
 
 #include <algorithm>
+#include <new>
 
 struct ZipInflateCtx {
   InflateReader reader;  // Must be first — callback casts uzlib_uncomp* to ZipInflateCtx*
@@ -96,6 +98,7 @@ bool ZipFile::loadAllFileStatSlims() {
 }
 
 bool ZipFile::loadFileStatSlim(const char* filename, FileStatSlim* fileStat) {
+  PERF_SCOPE(ZIP_LOOKUP);
   if (!fileStatSlimCache.empty()) {
     const auto it = fileStatSlimCache.find(filename);
     if (it != fileStatSlimCache.end()) {
@@ -466,6 +469,7 @@ uint8_t* ZipFile::readFileToMemory(const char* filename, size_t* size, const boo
 
     bool success = false;
     {
+      PERF_SCOPE(INFLATE);
       InflateReader r;
       r.init(false);
       r.setSource(deflatedData, deflatedDataSize);
@@ -589,7 +593,11 @@ bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t ch
 
     while (true) {
       size_t produced;
-      const InflateStatus status = ctx.reader.readAtMost(outputBuffer, chunkSize, &produced);
+      InflateStatus status;
+      {
+        PERF_SCOPE(INFLATE);
+        status = ctx.reader.readAtMost(outputBuffer, chunkSize, &produced);
+      }
 
       totalProduced += produced;
       if (totalProduced > static_cast<size_t>(inflatedDataSize)) {
@@ -638,3 +646,151 @@ bool ZipFile::readFileToStream(const char* filename, Print& out, const size_t ch
   LOG_ERR("ZIP", "Unsupported compression method");
   return false;
 }
+
+namespace {
+constexpr size_t ENTRY_READ_BUFFER_SIZE = 1024;
+}
+
+bool ZipEntryReader::open(const char* filename) {
+  close();
+  if (!zip.open()) {
+    return false;
+  }
+
+  ZipFile::FileStatSlim fileStat = {};
+  if (!zip.loadFileStatSlim(filename, &fileStat)) {
+    close();
+    return false;
+  }
+
+  const long fileOffset = zip.getDataOffset(fileStat);
+  if (fileOffset < 0) {
+    close();
+    return false;
+  }
+
+  if (fileStat.method != ZIP_METHOD_STORED && fileStat.method != ZIP_METHOD_DEFLATED) {
+    LOG_ERR("ZIP", "Unsupported compression method");
+    close();
+    return false;
+  }
+
+  dataOffset = fileOffset;
+  compressedSize = fileStat.compressedSize;
+  uncompressedSize = fileStat.uncompressedSize;
+  method = fileStat.method;
+
+  if (method == ZIP_METHOD_DEFLATED) {
+    readBuf = static_cast<uint8_t*>(malloc(ENTRY_READ_BUFFER_SIZE));
+    inflate = new (std::nothrow) ZipInflateCtx();
+    if (!readBuf || !inflate) {
+      LOG_ERR("ZIP", "Failed to allocate entry reader buffers");
+      close();
+      return false;
+    }
+  }
+
+  entryOpen = true;
+  if (!rewind()) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+void ZipEntryReader::close() {
+  delete inflate;  // frees the inflate ring buffer
+  inflate = nullptr;
+  free(readBuf);
+  readBuf = nullptr;
+  if (zip.isOpen()) {
+    zip.close();
+  }
+  pos = 0;
+  entryOpen = false;
+}
+
+bool ZipEntryReader::rewind() {
+  if (!zip.file.seek(dataOffset)) {
+    return false;
+  }
+  pos = 0;
+
+  if (method == ZIP_METHOD_DEFLATED) {
+    if (!inflate->reader.init(true)) {
+      LOG_ERR("ZIP", "Failed to init inflate reader");
+      return false;
+    }
+    inflate->reader.setReadCallback(zipReadCallback);
+    inflate->file = &zip.file;
+    inflate->fileRemaining = compressedSize;
+    inflate->readBuf = readBuf;
+    inflate->readBufSize = ENTRY_READ_BUFFER_SIZE;
+  }
+  return true;
+}
+
+int ZipEntryReader::read(uint8_t* buf, size_t len) {
+  if (!entryOpen) {
+    return -1;
+  }
+  if (len > uncompressedSize - pos) {
+    len = uncompressedSize - pos;
+  }
+  if (len == 0) {
+    return 0;
+  }
+
+  if (method == ZIP_METHOD_STORED) {
+    const int bytesRead = zip.file.read(buf, len);
+    if (bytesRead < 0) {
+      return -1;
+    }
+    pos += bytesRead;
+    return bytesRead;
+  }
+
+  PERF_SCOPE(INFLATE);
+  size_t total = 0;
+  while (total < len) {
+    size_t produced = 0;
+    const InflateStatus status = inflate->reader.readAtMost(buf + total, len - total, &produced);
+    total += produced;
+    if (status == InflateStatus::Error) {
+      LOG_ERR("ZIP", "Decompression failed at offset %lu", static_cast<unsigned long>(pos + total));
+      return -1;
+    }
+    if (status == InflateStatus::Done) {
+      break;
+    }
+  }
+  pos += total;
+  return static_cast<int>(total);
+}
+
+bool ZipEntryReader::seek(const uint32_t target) {
+  if (!entryOpen || target > uncompressedSize) {
+    return false;
+  }
+
+  if (method == ZIP_METHOD_STORED) {
+    if (!zip.file.seek(dataOffset + target)) {
+      return false;
+    }
+    pos = target;
+    return true;
+  }
+
+  if (target < pos && !rewind()) {
+    return false;
+  }
+
+  uint8_t skipBuf[256];
+  while (pos < target) {
+    const size_t chunk = std::min<size_t>(sizeof(skipBuf), target - pos);
+    if (read(skipBuf, chunk) <= 0) {
+      return false;
+    }
+  }
+  return true;
+}
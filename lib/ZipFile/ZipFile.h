@@ -5,6 +5,8 @@
 #include <unordered_map>
 #include <vector>
 
+struct ZipInflateCtx;
+
 class ZipFile {
  public:
   struct FileStatSlim {
@@ -51,6 +53,8 @@ class ZipFile {
   long getDataOffset(const FileStatSlim& fileStat);
   bool loadZipDetails();
 
+  friend class ZipEntryReader;
+
  public:
   explicit ZipFile(const std::string& filePath) : filePath(filePath) {}
   ~ZipFile() = default;
@@ -70,3 +74,45 @@ class ZipFile {
   uint8_t* readFileToMemory(const char* filename, size_t* size = nullptr, bool trailingNullByte = false);
   bool readFileToStream(const char* filename, Print& out, size_t chunkSize);
 };
+
+/**
+ * Pull-based reader over a single ZIP entry.
+ *
+ * Where readFileToStream pushes a whole entry into a Print, this lets a consumer such as an image decoder ask for
+ * bytes as it needs them, so the entry never has to be extracted to SD first. Deflated entries are inflated on demand
+ * through the same 32KB streaming window readFileToStream uses. Seeking forward skips output; seeking backwards
+ * restarts the inflate from the start of the entry, so callers should keep to mostly-forward access.
+ */
+class ZipEntryReader {
+ public:
+  explicit ZipEntryReader(std::string zipPath) : zipPath(std::move(zipPath)), zip(this->zipPath) {}
+  ~ZipEntryReader() { close(); }
+
+  ZipEntryReader(const ZipEntryReader&) = delete;
+  ZipEntryReader& operator=(const ZipEntryReader&) = delete;
+
+  // Opens the archive and positions the reader at the start of `filename`
+  bool open(const char* filename);
+  void close();
+  bool isOpen() const { return entryOpen; }
+
+  // Returns the number of bytes read (0 at end of entry), or -1 on error
+  int read(uint8_t* buf, size_t len);
+  bool seek(uint32_t pos);
+  uint32_t position() const { return pos; }
+  uint32_t size() const { return uncompressedSize; }
+
+ private:
+  bool rewind();
+
+  std::string zipPath;  // Must be declared before zip, which keeps a reference to it
+  ZipFile zip;
+  ZipInflateCtx* inflate = nullptr;
+  uint8_t* readBuf = nullptr;
+  uint32_t dataOffset = 0;
+  uint32_t compressedSize = 0;
+  uint32_t uncompressedSize = 0;
+  uint32_t pos = 0;
+  uint16_t method = 0;
+  bool entryOpen = false;
+};
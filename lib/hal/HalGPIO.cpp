@@ -1,25 +1,102 @@
 #include <HalGPIO.h>
 #include <SPI.h>
 
+#include <cassert>
+
+namespace {
+// Room for a burst of presses while the main loop is busy with a page or a book load
+constexpr UBaseType_t EVENT_QUEUE_LENGTH = 32;
+}  // namespace
+
 void HalGPIO::begin() {
   inputMgr.begin();
   SPI.begin(EPD_SCLK, SPI_MISO, EPD_MOSI, EPD_CS);
   pinMode(UART0_RXD, INPUT);
+
+  eventQueue = xQueueCreate(EVENT_QUEUE_LENGTH, sizeof(ButtonEvent));
+  assert(eventQueue != nullptr && "Failed to create button event queue");
+  // Above the main loop, so a long activity loop does not delay sampling
+  TaskHandle_t inputTask = nullptr;
+  xTaskCreate(&inputTaskTrampoline, "InputSampler",
+              2048,       // Stack size
+              this,       // Parameters
+              2,          // Priority
+              &inputTask  // Task handle
+  );
+  assert(inputTask != nullptr && "Failed to create input task");
+}
+
+void HalGPIO::inputTaskTrampoline(void* param) {
+  auto* self = static_cast<HalGPIO*>(param);
+  self->inputTaskLoop();
+}
+
+void HalGPIO::inputTaskLoop() {
+  uint8_t previous = 0;
+  uint32_t lastHeld = millis();
+  TickType_t lastWake = xTaskGetTickCount();
+  while (true) {
+    inputMgr.update();
+    uint8_t sample = 0;
+    for (uint8_t button = BTN_BACK; button <= BTN_POWER; button++) {
+      if (inputMgr.isPressed(button)) {
+        sample |= 1 << button;
+      }
+    }
+    const uint32_t now = millis();
+    lastSample = sample;
+    ButtonEvents::diff(previous, sample, now, [this](const ButtonEvent& event) {
+      if (xQueueSend(eventQueue, &event, 0) != pdTRUE) {
+        eventsDropped = true;
+      }
+    });
+    previous = sample;
+    if (sample != 0) {
+      lastHeld = now;
+    }
+    // Full rate while buttons are in use, for press timing; while idle, the first press of the next burst may be seen
+    // up to INPUT_IDLE_SAMPLE_MS late
+    const bool idle = sample == 0 && now - lastHeld >= INPUT_IDLE_AFTER_MS;
+    vTaskDelayUntil(&lastWake, pdMS_TO_TICKS(idle ? INPUT_IDLE_SAMPLE_MS : INPUT_SAMPLE_MS));
+  }
+}
+
+void HalGPIO::update() {
+  buttons.beginFrame();
+  ButtonEvent event;
+  while (xQueueReceive(eventQueue, &event, 0) == pdTRUE) {
+    buttons.apply(event);
+  }
+  if (eventsDropped) {
+    eventsDropped = false;
+    buttons.resync(lastSample, millis());
+  }
+}
+
+void HalGPIO::waitForInput(const uint32_t timeoutMs) {
+  ButtonEvent event;
+  // Peek so that update() still sees the event
+  xQueuePeek(eventQueue, &event, pdMS_TO_TICKS(timeoutMs));
+}
+
+void HalGPIO::interruptWait() {
+  const ButtonEvent wake{ButtonEvents::NO_BUTTON, false, millis()};
+  xQueueSend(eventQueue, &wake, 0);
 }
 
-void HalGPIO::update() { inputMgr.update(); }
+bool HalGPIO::isAnyPressed() const { return buttons.isAnyPressed(); }
 
-bool HalGPIO::isPressed(uint8_t buttonIndex) const { return inputMgr.isPressed(buttonIndex); }
+bool HalGPIO::isPressed(uint8_t buttonIndex) const { return buttons.isPressed(buttonIndex); }
 
-bool HalGPIO::wasPressed(uint8_t buttonIndex) const { return inputMgr.wasPressed(buttonIndex); }
+bool HalGPIO::wasPressed(uint8_t buttonIndex) const { return buttons.wasPressed(buttonIndex); }
 
-bool HalGPIO::wasAnyPressed() const { return inputMgr.wasAnyPressed(); }
+bool HalGPIO::wasAnyPressed() const { return buttons.wasAnyPressed(); }
 
-bool HalGPIO::wasReleased(uint8_t buttonIndex) const { return inputMgr.wasReleased(buttonIndex); }
+bool HalGPIO::wasReleased(uint8_t buttonIndex) const { return buttons.wasReleased(buttonIndex); }
 
-bool HalGPIO::wasAnyReleased() const { return inputMgr.wasAnyReleased(); }
+bool HalGPIO::wasAnyReleased() const { return buttons.wasAnyReleased(); }
 
-unsigned long HalGPIO::getHeldTime() const { return inputMgr.getHeldTime(); }
+unsigned long HalGPIO::getHeldTime() const { return buttons.getHeldTime(millis()); }
 
 bool HalGPIO::isUsbConnected() const {
   // U0RXD/GPIO20 reads HIGH when USB is connected
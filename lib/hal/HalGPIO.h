@@ -2,7 +2,10 @@
 
 #include <Arduino.h>
 #include <BatteryMonitor.h>
+#include <ButtonEvents.h>
 #include <InputManager.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
 
 // Display SPI pins (custom pins for XteinkX4, not hardware SPI defaults)
 #define EPD_SCLK 8   // SPI Clock
@@ -22,15 +25,36 @@ class HalGPIO {
 #if CROSSPOINT_EMULATED == 0
   InputManager inputMgr;
 #endif
+  // The front buttons sit on a resistor ladder read through the ADC, so they cannot raise an interrupt. A task of its
+  // own samples them and queues an event per change; the main loop applies the events in update() and can block on
+  // the queue in between instead of polling.
+  ButtonEvents buttons;
+  QueueHandle_t eventQueue = nullptr;
+  volatile uint8_t lastSample = 0;      // written by the input task
+  volatile bool eventsDropped = false;  // the queue was full; update() resyncs from lastSample
+
+  static void inputTaskTrampoline(void* param);
+  void inputTaskLoop();
 
  public:
+  static constexpr uint32_t INPUT_SAMPLE_MS = 10;
+  // Once every button has been released for INPUT_IDLE_AFTER_MS, the sampler slows down until the next press
+  static constexpr uint32_t INPUT_IDLE_SAMPLE_MS = 50;
+  static constexpr uint32_t INPUT_IDLE_AFTER_MS = 1000;
+
   HalGPIO() = default;
 
   // Start button GPIO and setup SPI for screen and SD card
   void begin();
 
   // Button input methods
+  // Apply the button events queued since the previous call
   void update();
+  // Block until a button event is queued, interruptWait() is called or timeoutMs has passed
+  void waitForInput(uint32_t timeoutMs);
+  // End a waitForInput() early, e.g. when another task has work for the main loop
+  void interruptWait();
+  bool isAnyPressed() const;
   bool isPressed(uint8_t buttonIndex) const;
   bool wasPressed(uint8_t buttonIndex) const;
   bool wasAnyPressed() const;
@@ -146,6 +146,11 @@ int HalFile::read(void* buf, size_t count) { HAL_FILE_WRAPPED_CALL(read, buf, co
 int HalFile::read() { HAL_FILE_WRAPPED_CALL(read, ); }
 size_t HalFile::write(const void* buf, size_t count) { HAL_FILE_WRAPPED_CALL(write, buf, count); }
 size_t HalFile::write(uint8_t b) { HAL_FILE_WRAPPED_CALL(write, b); }
+bool HalFile::preAllocate(size_t length) { HAL_FILE_WRAPPED_CALL(preAllocate, length); }
+bool HalFile::truncate(size_t length) { HAL_FILE_WRAPPED_CALL(truncate, length); }
+bool HalFile::getModifyDateTime(uint16_t* date, uint16_t* time) {
+  HAL_FILE_WRAPPED_CALL(getModifyDateTime, date, time);
+}
 bool HalFile::rename(const char* newPath) { HAL_FILE_WRAPPED_CALL(rename, newPath); }
 bool HalFile::isDirectory() const { HAL_FILE_FORWARD_CALL(isDirectory, ); }  // already thread-safe, no need to wrap
 void HalFile::rewindDirectory() { HAL_FILE_WRAPPED_CALL(rewindDirectory, ); }
@@ -85,6 +85,11 @@ class HalFile : public Print {
   int read();  // read a single byte
   size_t write(const void* buf, size_t count);
   size_t write(uint8_t b) override;
+  // Reserve contiguous clusters for a file about to be written (may fail on a fragmented card)
+  bool preAllocate(size_t length);
+  bool truncate(size_t length);
+  // FAT date and time of the last modification
+  bool getModifyDateTime(uint16_t* date, uint16_t* time);
   bool rename(const char* newPath);
   bool isDirectory() const;
   void rewindDirectory();
@@ -223,6 +223,8 @@ static pjpeg_need_bytes_callback_t g_pNeedBytesCallback;
 static void* g_pCallback_data;
 static uint8 gCallbackStatus;
 static uint8 gReduce;
+static uint8 gGrayOnly;   // decode the luma component only (pjpeg_decode_init_gray)
+static uint8 gGrayShift;  // gray mode output scale: 8 >> gGrayShift pixels per block side
 //------------------------------------------------------------------------------
 static void fillInBuf(void) {
   unsigned char status;
@@ -1324,6 +1326,53 @@ static void idctCols(void) {
   }
 }
 
+/*----------------------------------------------------------------------------*/
+// Reduced-size IDCT for gray mode. An N-point IDCT over the lowest N coefficients of each axis samples the 8x8
+// block's band-limited signal at the centres of N equal cells, so a block can be shrunk by 2 or 4 without computing
+// the full-resolution pixels. Entries are C(u) * cos((2x+1)u*pi/2N) / (2 * Winograd scale(u)), in 4.12 fixed point;
+// the Winograd factors are undone here because the quantization tables already include them.
+static const int16 gReduceIDCT4[4][4] = {
+    {1448, 1364, 1108, 667},
+    {1448, 565, -1108, -1609},
+    {1448, -565, -1108, 1609},
+    {1448, -1364, 1108, -667},
+};
+static const int16 gReduceIDCT2[2][2] = {
+    {1448, 1044},
+    {1448, -1044},
+};
+
+#define PJPG_REDUCE_IDCT_BITS 12
+
+// Reads the top-left n x n coefficients of gCoeffBuf and writes n x n pixels with an 8 byte row stride to pDst
+static void idctReduced(uint8* pDst, uint8 n) {
+  long tmp[4][4];
+  uint8 u, v, x, y;
+
+  // Rows: horizontal frequencies to horizontal positions, one coefficient row at a time
+  for (v = 0; v < n; v++) {
+    const int16* pSrc = gCoeffBuf + v * 8;
+    for (x = 0; x < n; x++) {
+      long sum = 0;
+      for (u = 0; u < n; u++) {
+        sum += (long)pSrc[u] * (n == 4 ? gReduceIDCT4[x][u] : gReduceIDCT2[x][u]);
+      }
+      tmp[v][x] = (sum + (1L << (PJPG_REDUCE_IDCT_BITS - 1))) >> PJPG_REDUCE_IDCT_BITS;
+    }
+  }
+
+  // Columns, then the same 1/16 descale as the DC-only path (DC / 128 overall)
+  for (y = 0; y < n; y++) {
+    for (x = 0; x < n; x++) {
+      long sum = 0;
+      for (v = 0; v < n; v++) {
+        sum += tmp[v][x] * (n == 4 ? gReduceIDCT4[y][v] : gReduceIDCT2[y][v]);
+      }
+      sum = (sum + (1L << (PJPG_REDUCE_IDCT_BITS + 3))) >> (PJPG_REDUCE_IDCT_BITS + 4);
+      pDst[y * 8 + x] = clamp((int16)(sum + 128));
+    }
+  }
+}
 /*----------------------------------------------------------------------------*/
 static PJPG_INLINE uint8 addAndClamp(uint8 a, int16 b) {
   b = a + b;
@@ -1907,6 +1956,30 @@ static void transformBlockReduce(uint8 mcuBlock) {
   }
 }
 //------------------------------------------------------------------------------
+// Gray mode: luma block mcuBlock goes to its usual slot in gMCUBufR (8x16 MCUs stack their blocks 128 bytes apart)
+static void transformBlockGray(uint8 mcuBlock) {
+  uint8* pDst = gMCUBufR + (gScanType == PJPG_YH1V2 ? mcuBlock * 128 : mcuBlock * 64);
+
+  switch (gGrayShift) {
+    case 0: {
+      uint8 i;
+      idctRows();
+      idctCols();
+      for (i = 0; i < 64; i++) pDst[i] = (uint8)gCoeffBuf[i];
+      break;
+    }
+    case 1:
+      idctReduced(pDst, 4);
+      break;
+    case 2:
+      idctReduced(pDst, 2);
+      break;
+    default:
+      pDst[0] = clamp(PJPG_DESCALE(gCoeffBuf[0]) + 128);
+      break;
+  }
+}
+//------------------------------------------------------------------------------
 static uint8 decodeNextMCU(void) {
   uint8 status;
   uint8 mcuBlock;
@@ -1941,7 +2014,7 @@ static uint8 decodeNextMCU(void) {
 
     compACTab = gCompACTab[componentID];
 
-    if (gReduce) {
+    if (gReduce || (gGrayOnly && (componentID || gGrayShift == 3))) {
       // Decode, but throw out the AC coefficients in reduce mode.
       for (k = 1; k < 64; k++) {
         s = huffDecode(compACTab ? &gHuffTab3 : &gHuffTab2, compACTab ? gHuffVal3 : gHuffVal2);
@@ -1968,7 +2041,54 @@ static uint8 decodeNextMCU(void) {
         }
       }
 
-      transformBlockReduce(mcuBlock);
+      if (!gGrayOnly) {
+        transformBlockReduce(mcuBlock);
+      } else if (!componentID) {
+        transformBlockGray(mcuBlock);
+      }
+    } else if (gGrayOnly && gGrayShift) {
+      // Reduced gray decode: only the top-left (8 >> gGrayShift)^2 coefficients are dequantized and kept
+      const uint8 n = 8 >> gGrayShift;
+      for (k = 0; k < n; k++) {
+        uint8 j;
+        for (j = 0; j < n; j++) gCoeffBuf[k * 8 + j] = 0;
+      }
+      gCoeffBuf[0] = dc * pQ[0];
+
+      for (k = 1; k < 64; k++) {
+        uint16 extraBits;
+
+        s = huffDecode(compACTab ? &gHuffTab3 : &gHuffTab2, compACTab ? gHuffVal3 : gHuffVal2);
+
+        extraBits = 0;
+        numExtraBits = s & 0xF;
+        if (numExtraBits) extraBits = getBits2(numExtraBits);
+
+        r = s >> 4;
+        s &= 15;
+
+        if (s) {
+          uint8 pos;
+
+          if (r) {
+            if ((k + r) > 63) return PJPG_DECODE_ERROR;
+
+            k = (uint8)(k + r);
+          }
+
+          pos = ZAG[k];
+          if (((pos & 7) < n) && ((pos >> 3) < n)) gCoeffBuf[pos] = huffExtend(extraBits, s) * pQ[k];
+        } else {
+          if (r == 15) {
+            if ((k + 16) > 64) return PJPG_DECODE_ERROR;
+
+            k += (16 - 1);  // - 1 because the loop counter is k
+          } else
+            break;
+        }
+      }
+
+      transformBlockGray(mcuBlock);
     } else {
       // Decode and dequantize AC coefficients
       for (k = 1; k < 64; k++) {
@@ -2012,7 +2132,11 @@ static uint8 decodeNextMCU(void) {
 
       while (k < 64) gCoeffBuf[ZAG[k++]] = 0;
 
-      transformBlock(mcuBlock);
+      if (gGrayOnly) {
+        transformBlockGray(mcuBlock);
+      } else {
+        transformBlock(mcuBlock);
+      }
     }
   }
 
@@ -2038,8 +2162,8 @@ unsigned char pjpeg_decode_mcu(void) {
   return 0;
 }
 //------------------------------------------------------------------------------
-unsigned char pjpeg_decode_init(pjpeg_image_info_t* pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback,
-                                void* pCallback_data, unsigned char reduce) {
+static unsigned char decodeInit(pjpeg_image_info_t* pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback,
+                                void* pCallback_data, unsigned char reduce, unsigned char grayShift) {
   uint8 status;
 
   pInfo->m_width = 0;
@@ -2058,6 +2182,8 @@ unsigned char pjpeg_decode_init(pjpeg_image_info_t* pInfo, pjpeg_need_bytes_call
   g_pCallback_data = pCallback_data;
   gCallbackStatus = 0;
   gReduce = reduce;
+  gGrayOnly = grayShift != 0xFF;
+  gGrayShift = gGrayOnly ? grayShift : 0;
 
   status = init();
   if ((status) || (gCallbackStatus)) return gCallbackStatus ? gCallbackStatus : status;
@@ -2080,8 +2206,19 @@ unsigned char pjpeg_decode_init(pjpeg_image_info_t* pInfo, pjpeg_need_bytes_call
   pInfo->m_MCUWidth = gMaxMCUXSize;
   pInfo->m_MCUHeight = gMaxMCUYSize;
   pInfo->m_pMCUBufR = gMCUBufR;
-  pInfo->m_pMCUBufG = gMCUBufG;
-  pInfo->m_pMCUBufB = gMCUBufB;
+  pInfo->m_pMCUBufG = gGrayOnly ? gMCUBufR : gMCUBufG;
+  pInfo->m_pMCUBufB = gGrayOnly ? gMCUBufR : gMCUBufB;
 
   return 0;
 }
+//------------------------------------------------------------------------------
+unsigned char pjpeg_decode_init(pjpeg_image_info_t* pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback,
+                                void* pCallback_data, unsigned char reduce) {
+  return decodeInit(pInfo, pNeed_bytes_callback, pCallback_data, reduce, 0xFF);
+}
+//------------------------------------------------------------------------------
+unsigned char pjpeg_decode_init_gray(pjpeg_image_info_t* pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback,
+                                     void* pCallback_data, unsigned char scaleShift) {
+  if (scaleShift > 3) return PJPG_UNSUPPORTED_MODE;
+  return decodeInit(pInfo, pNeed_bytes_callback, pCallback_data, 0, scaleShift);
+}
@@ -112,6 +112,14 @@ typedef unsigned char (*pjpeg_need_bytes_callback_t)(unsigned char* pBuf, unsign
 unsigned char pjpeg_decode_init(pjpeg_image_info_t* pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback,
                                 void* pCallback_data, unsigned char reduce);
 
+// Initializes the decompressor for grayscale output, optionally shrunk in the DCT domain. Only the luma component is
+// dequantized and transformed; chroma blocks are entropy decoded and discarded. scaleShift 0-3 selects 1/1, 1/2, 1/4
+// or 1/8 output: each 8x8 block yields (8 >> scaleShift)^2 pixels computed from its lowest-frequency coefficients,
+// stored at the start of the block's usual slot in m_pMCUBufR with a row stride of 8 (m_pMCUBufG/B alias
+// m_pMCUBufR). m_width, m_height and the MCU sizes still describe the full-resolution image. Not thread safe.
+unsigned char pjpeg_decode_init_gray(pjpeg_image_info_t* pInfo, pjpeg_need_bytes_callback_t pNeed_bytes_callback,
+                                     void* pCallback_data, unsigned char scaleShift);
+
 // Decompresses the file's next MCU. Returns 0 on success, PJPG_NO_MORE_BLOCKS if no more blocks are available, or an
 // error code. Must be called a total of m_MCUSPerRow*m_MCUSPerCol times to completely decompress the image. Not thread
 // safe.
@@ -0,0 +1,158 @@
+#include "BackgroundJobQueue.h"
+
+#include <Arduino.h>
+#include <Logging.h>
+
+#include <cassert>
+
+BackgroundJobQueue BackgroundJobQueue::instance;
+
+void BackgroundJobQueue::begin() {
+  queueMutex = xSemaphoreCreateMutex();
+  runMutex = xSemaphoreCreateMutex();
+  assert(queueMutex != nullptr && runMutex != nullptr && "Failed to create background job mutexes");
+
+  // Priority 0 so jobs only get the CPU while the main loop and render task are idle
+  xTaskCreate(&taskTrampoline, "BackgroundJobs",
+              8192,        // Stack size
+              this,        // Parameters
+              0,           // Priority
+              &taskHandle  // Task handle
+  );
+  assert(taskHandle != nullptr && "Failed to create background job task");
+}
+
+void BackgroundJobQueue::taskTrampoline(void* param) {
+  auto* self = static_cast<BackgroundJobQueue*>(param);
+  self->taskLoop();
+}
+
+void BackgroundJobQueue::taskLoop() {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+    while (true) {
+      // The pause check and job start happen under runMutex, so pause() cannot miss a job that is about to start
+      xSemaphoreTake(runMutex, portMAX_DELAY);
+
+      Job job;
+      xSemaphoreTake(queueMutex, portMAX_DELAY);
+      const bool haveJob = !paused && holds == 0 && !jobs.empty();
+      if (haveJob) {
+        job = std::move(jobs.front());
+        jobs.pop_front();
+        runningKey = job.key;
+      }
+      xSemaphoreGive(queueMutex);
+
+      if (!haveJob) {
+        xSemaphoreGive(runMutex);
+        break;
+      }
+
+      const auto start = millis();
+      job.run();
+      LOG_DBG("BGJ", "Finished %s in %lums", job.key.c_str(), millis() - start);
+
+      xSemaphoreTake(queueMutex, portMAX_DELAY);
+      runningKey.clear();
+      xSemaphoreGive(queueMutex);
+      xSemaphoreGive(runMutex);
+    }
+  }
+}
+
+bool BackgroundJobQueue::enqueue(std::string key, std::function<void()> run) {
+  if (!queueMutex) {
+    return false;
+  }
+
+  xSemaphoreTake(queueMutex, portMAX_DELAY);
+  // A job stopped early by a pause may queue itself again to finish later
+  bool duplicate = key == runningKey && xTaskGetCurrentTaskHandle() != taskHandle;
+  for (const auto& job : jobs) {
+    if (duplicate) break;
+    duplicate = job.key == key;
+  }
+  if (!duplicate) {
+    jobs.push_back({std::move(key), std::move(run)});
+  }
+  const bool notify = !duplicate && !paused && holds == 0;
+  xSemaphoreGive(queueMutex);
+
+  if (notify) {
+    xTaskNotifyGive(taskHandle);
+  }
+  return !duplicate;
+}
+
+void BackgroundJobQueue::pause() {
+  if (!queueMutex) {
+    return;
+  }
+
+  xSemaphoreTake(queueMutex, portMAX_DELAY);
+  paused = true;
+  xSemaphoreGive(queueMutex);
+
+  // Wait for a running job to finish
+  xSemaphoreTake(runMutex, portMAX_DELAY);
+  xSemaphoreGive(runMutex);
+}
+
+void BackgroundJobQueue::resume() {
+  if (!queueMutex) {
+    return;
+  }
+
+  xSemaphoreTake(queueMutex, portMAX_DELAY);
+  const bool notify = paused && holds == 0 && !jobs.empty();
+  paused = false;
+  xSemaphoreGive(queueMutex);
+
+  if (notify) {
+    xTaskNotifyGive(taskHandle);
+  }
+}
+
+void BackgroundJobQueue::hold() {
+  if (!queueMutex) {
+    return;
+  }
+
+  xSemaphoreTake(queueMutex, portMAX_DELAY);
+  holds = holds + 1;
+  xSemaphoreGive(queueMutex);
+
+  // Wait for a running job to finish
+  xSemaphoreTake(runMutex, portMAX_DELAY);
+  xSemaphoreGive(runMutex);
+}
+
+void BackgroundJobQueue::release() {
+  if (!queueMutex) {
+    return;
+  }
+
+  xSemaphoreTake(queueMutex, portMAX_DELAY);
+  if (holds > 0) {
+    holds = holds - 1;
+  }
+  const bool notify = holds == 0 && !paused && !jobs.empty();
+  xSemaphoreGive(queueMutex);
+
+  if (notify) {
+    xTaskNotifyGive(taskHandle);
+  }
+}
+
+bool BackgroundJobQueue::hasPendingJobs() const {
+  if (!queueMutex) {
+    return false;
+  }
+
+  xSemaphoreTake(queueMutex, portMAX_DELAY);
+  const bool pending = !jobs.empty() || !runningKey.empty();
+  xSemaphoreGive(queueMutex);
+  return pending;
+}
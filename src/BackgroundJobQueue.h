@@ -0,0 +1,71 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+
+/**
+ * Low-priority worker task for cache generation that should never block the UI (cover thumbnails, book indexing).
+ *
+ * Jobs are keyed so the same work is never queued twice. The ActivityManager pauses the queue around every activity
+ * switch and only resumes it for activities that allow background work, so a reader or the sleep screen always has
+ * the SD card, the image decoders and the book caches to itself. pause() waits for the running job to finish.
+ *
+ * The file transfer screens allow jobs between transfers, but a job never runs while a book or its cache directory
+ * is being replaced, removed or renamed: uploads and file operations take a Hold for their whole duration, which
+ * waits for the running job like pause() and keeps new ones from starting until it is released.
+ */
+class BackgroundJobQueue {
+  // Static instance
+  static BackgroundJobQueue instance;
+
+  struct Job {
+    std::string key;
+    std::function<void()> run;
+  };
+
+  std::deque<Job> jobs;
+  std::string runningKey;
+  SemaphoreHandle_t queueMutex = nullptr;  // guards jobs, runningKey and paused
+  SemaphoreHandle_t runMutex = nullptr;    // held by the worker while a job runs
+  TaskHandle_t taskHandle = nullptr;
+  volatile bool paused = true;
+  volatile uint8_t holds = 0;
+
+  static void taskTrampoline(void* param);
+  [[noreturn]] void taskLoop();
+
+ public:
+  static BackgroundJobQueue& getInstance() { return instance; }
+
+  void begin();
+
+  // Returns false if a job with the same key is already queued or running, unless the running job queues itself
+  bool enqueue(std::string key, std::function<void()> run);
+
+  // Stop starting new jobs and wait for the running one to finish
+  void pause();
+  void resume();
+
+  // Keeps jobs from running while held, independently of pause()/resume(); see the class comment
+  class Hold {
+   public:
+    Hold() { getInstance().hold(); }
+    ~Hold() { getInstance().release(); }
+    Hold(const Hold&) = delete;
+    Hold& operator=(const Hold&) = delete;
+  };
+  void hold();
+  void release();
+
+  bool hasPendingJobs() const;
+  // Set while an activity switch waits in pause(); long jobs check it to stop early and leave the rest for later
+  bool isPauseRequested() const { return paused || holds > 0; }
+};
+
+// Helper macro to access the background job queue
+#define BACKGROUND_JOBS BackgroundJobQueue::getInstance()
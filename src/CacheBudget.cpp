@@ -0,0 +1,362 @@
+#include "CacheBudget.h"
+
+#include <BufferedIO.h>
+#include <Epub.h>
+#include <HalStorage.h>
+#include <Logging.h>
+#include <PackFile.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "BackgroundJobQueue.h"
+#include "CrossPointSettings.h"
+
+namespace {
+constexpr uint8_t LEDGER_FILE_VERSION = 1;
+constexpr char LEDGER_FILE[] = "/.crosspoint/cache_ledger.bin";
+constexpr char CACHE_DIR[] = "/.crosspoint";
+
+bool isBookCacheDir(const char* name) {
+  return strncmp(name, "epub_", 5) == 0 || strncmp(name, "xtc_", 4) == 0 || strncmp(name, "txt_", 4) == 0;
+}
+
+bool hasSuffix(const char* name, const char* suffix) {
+  const size_t nameLen = strlen(name);
+  const size_t suffixLen = strlen(suffix);
+  return nameLen >= suffixLen && strcasecmp(name + nameLen - suffixLen, suffix) == 0;
+}
+
+// Bytes used by a cache directory and its sections folder
+uint32_t measure(const std::string& path) {
+  FsFile dir = Storage.open(path.c_str());
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    return 0;
+  }
+  uint32_t total = 0;
+  char name[64];
+  for (auto file = dir.openNextFile(); file; file = dir.openNextFile()) {
+    if (file.isDirectory()) {
+      file.getName(name, sizeof(name));
+      file.close();
+      total += measure(path + "/" + name);
+    } else {
+      total += file.size();
+      file.close();
+    }
+  }
+  dir.close();
+  return total;
+}
+
+// Spine index of the chapter being read, from an EPUB's progress.bin; -1 if unknown. XTC and TXT caches keep a page
+// number or byte offset there, and have no sections.
+int currentSection(const std::string& dir, const std::string& path) {
+  if (strncmp(dir.c_str(), "epub_", 5) != 0) {
+    return -1;
+  }
+  FsFile f = Storage.open((path + "/progress.bin").c_str());
+  if (!f) {
+    return -1;
+  }
+  uint8_t data[2];
+  const bool ok = f.read(data, 2) == 2;
+  f.close();
+  return ok ? data[0] | (data[1] << 8) : -1;
+}
+}  // namespace
+
+CacheBudget CacheBudget::instance;
+
+void CacheBudget::begin() {
+  mutex = xSemaphoreCreateMutex();
+  loadLedger();
+  schedule();
+}
+
+void CacheBudget::loadLedger() {
+  FsFile f;
+  if (!Storage.exists(LEDGER_FILE) || !Storage.openFileForRead("CBM", LEDGER_FILE, f)) {
+    return;
+  }
+  serialization::BufferedReader reader(f);
+  uint8_t version = 0;
+  uint32_t count = 0;
+  serialization::readPod(reader, version);
+  serialization::readPod(reader, useCounter);
+  serialization::readPod(reader, count);
+  if (version == LEDGER_FILE_VERSION) {
+    for (uint32_t i = 0; i < count && reader.ok(); i++) {
+      Book book;
+      uint8_t measured = 0;
+      serialization::readVarString(reader, book.dir);
+      serialization::readPod(reader, book.lastUse);
+      serialization::readPod(reader, book.size);
+      serialization::readPod(reader, measured);
+      serialization::readPod(reader, book.trimmed);
+      book.measured = measured != 0;
+      if (reader.ok()) {
+        books.push_back(std::move(book));
+      }
+    }
+  }
+  f.close();
+}
+
+// Called with mutex held
+void CacheBudget::saveLedger() const {
+  FsFile f;
+  if (!Storage.openFileForWrite("CBM", LEDGER_FILE, f)) {
+    LOG_ERR("CBM", "Failed to save cache ledger");
+    return;
+  }
+  serialization::BufferedWriter writer(f);
+  serialization::writePod(writer, LEDGER_FILE_VERSION);
+  serialization::writePod(writer, useCounter);
+  serialization::writePod(writer, static_cast<uint32_t>(books.size()));
+  for (const auto& book : books) {
+    serialization::writeVarString(writer, book.dir);
+    serialization::writePod(writer, book.lastUse);
+    serialization::writePod(writer, book.size);
+    serialization::writePod(writer, static_cast<uint8_t>(book.measured));
+    serialization::writePod(writer, book.trimmed);
+  }
+  writer.flush();
+  f.close();
+}
+
+void CacheBudget::touch(const std::string& cachePath) {
+  if (!mutex) {
+    return;
+  }
+  const std::string dir = cachePath.substr(cachePath.find_last_of('/') + 1);
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  auto it = std::find_if(books.begin(), books.end(), [&dir](const Book& book) { return book.dir == dir; });
+  if (it == books.end()) {
+    books.push_back({dir});
+    it = books.end() - 1;
+  }
+  it->lastUse = ++useCounter;
+  // Reading adds sections and images; the size is measured again on the next pass
+  it->measured = false;
+  it->trimmed = TRIM_NONE;
+  saveLedger();
+  xSemaphoreGive(mutex);
+
+  schedule();
+}
+
+void CacheBudget::schedule() {
+  if (!mutex) {
+    return;
+  }
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  if (!passRunning) {
+    passRunning = true;
+    enqueueStep();
+  }
+  xSemaphoreGive(mutex);
+}
+
+// Called with mutex held. Each step gets its own key because a running job cannot queue itself again.
+void CacheBudget::enqueueStep() {
+  if (!BACKGROUND_JOBS.enqueue("cache:" + std::to_string(stepCounter++), [this] { runStep(); })) {
+    passRunning = false;
+  }
+}
+
+void CacheBudget::trim(const std::string& dir, const uint8_t level) {
+  const std::string path = std::string(CACHE_DIR) + "/" + dir;
+  const int section = currentSection(dir, path);
+  const auto layouts = Epub::readSectionLayouts(path);
+  const std::string keepLayout = layouts.empty() ? "" : Epub::getSectionLayoutName(layouts.front());
+  const std::string keepSection = std::to_string(section) + ".bin";
+
+  // Chapter sections, loose or packed, except the one being read in the layout used last
+  const std::string sectionsPath = path + "/sections";
+  FsFile sections = Storage.open(sectionsPath.c_str());
+  if (sections && sections.isDirectory()) {
+    char name[32];
+    std::vector<std::string> layoutDirs;
+    std::vector<std::string> looseFiles;  // from before sections were kept per layout
+    for (auto file = sections.openNextFile(); file; file = sections.openNextFile()) {
+      file.getName(name, sizeof(name));
+      const bool isDirectory = file.isDirectory();
+      file.close();
+      if (isDirectory) {
+        layoutDirs.emplace_back(name);
+      } else if (strcmp(name, "layouts.bin") != 0) {
+        looseFiles.emplace_back(name);
+      }
+    }
+    sections.close();
+    for (const auto& file : looseFiles) {
+      Storage.remove((sectionsPath + "/" + file).c_str());
+    }
+    for (const auto& layoutDir : layoutDirs) {
+      if (layoutDir != keepLayout) {
+        Storage.removeDir((sectionsPath + "/" + layoutDir).c_str());
+        continue;
+      }
+      std::vector<std::string> doomed;
+      FsFile current = Storage.open((sectionsPath + "/" + layoutDir).c_str());
+      for (auto file = current.openNextFile(); file; file = current.openNextFile()) {
+        file.getName(name, sizeof(name));
+        file.close();
+        if (keepSection != name && strcmp(name, "pages.bin") != 0) doomed.emplace_back(name);
+      }
+      current.close();
+      for (const auto& file : doomed) {
+        Storage.remove((sectionsPath + "/" + layoutDir + "/" + file).c_str());
+      }
+    }
+  } else if (sections) {
+    sections.close();
+  }
+  const std::string packPath = path + "/pack.bin";
+  if (Storage.exists(packPath.c_str())) {
+    PackFile pack(packPath);
+    pack.removePrefix("section/", "section/" + keepLayout + "/" + std::to_string(section));
+    pack.compact();
+  }
+  if (level < TRIM_IMAGES) {
+    return;
+  }
+
+  // Images, covers and thumbnails, then everything but the reading position. The kept section's inline images stay:
+  // their pixel caches are often the only copy, and the section is not rebuilt to bring them back.
+  const std::string keepImages =
+      section >= 0 ? "img_" + std::to_string(section) + "_" + (keepLayout.empty() ? "" : keepLayout + "_") : "";
+  FsFile bookDir = Storage.open(path.c_str());
+  if (!bookDir || !bookDir.isDirectory()) {
+    if (bookDir) bookDir.close();
+    return;
+  }
+  char name[64];
+  std::vector<std::string> doomed;
+  for (auto file = bookDir.openNextFile(); file; file = bookDir.openNextFile()) {
+    file.getName(name, sizeof(name));
+    const bool isDirectory = file.isDirectory();
+    file.close();
+    if (isDirectory || strcmp(name, "progress.bin") == 0 || strcmp(name, "pack.bin") == 0) {
+      continue;
+    }
+    if (!keepImages.empty() && strncmp(name, keepImages.c_str(), keepImages.size()) == 0) {
+      continue;
+    }
+    const bool isImage = strncmp(name, "img_", 4) == 0 || hasSuffix(name, ".pxc") || hasSuffix(name, ".bmp") ||
+                         hasSuffix(name, ".pln");
+    if (isImage || level >= TRIM_METADATA) {
+      doomed.emplace_back(name);
+    }
+  }
+  bookDir.close();
+  for (const auto& file : doomed) {
+    Storage.remove((path + "/" + file).c_str());
+  }
+}
+
+void CacheBudget::runStep() {
+  xSemaphoreTake(mutex, portMAX_DELAY);
+
+  // First pass since boot: pick up caches created or removed without the ledger (cache clearing, older firmware)
+  if (!listed) {
+    xSemaphoreGive(mutex);
+    std::vector<std::string> dirs;
+    FsFile root = Storage.open(CACHE_DIR);
+    if (root && root.isDirectory()) {
+      char name[64];
+      for (auto file = root.openNextFile(); file; file = root.openNextFile()) {
+        file.getName(name, sizeof(name));
+        if (file.isDirectory() && isBookCacheDir(name)) dirs.emplace_back(name);
+        file.close();
+      }
+    }
+    if (root) root.close();
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    books.erase(std::remove_if(books.begin(), books.end(),
+                               [&dirs](const Book& book) {
+                                 return std::find(dirs.begin(), dirs.end(), book.dir) == dirs.end();
+                               }),
+                books.end());
+    for (const auto& dir : dirs) {
+      if (std::none_of(books.begin(), books.end(), [&dir](const Book& book) { return book.dir == dir; })) {
+        books.push_back({dir});
+      }
+    }
+    listed = true;
+    saveLedger();
+    enqueueStep();
+    xSemaphoreGive(mutex);
+    return;
+  }
+
+  // Then one unmeasured directory per step
+  auto unmeasured = std::find_if(books.begin(), books.end(), [](const Book& book) { return !book.measured; });
+  if (unmeasured != books.end()) {
+    const std::string dir = unmeasured->dir;
+    xSemaphoreGive(mutex);
+    const uint32_t size = measure(std::string(CACHE_DIR) + "/" + dir);
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (auto& book : books) {
+      if (book.dir == dir) {
+        book.size = size;
+        book.measured = true;
+      }
+    }
+    saveLedger();
+    enqueueStep();
+    xSemaphoreGive(mutex);
+    return;
+  }
+
+  uint64_t total = 0;
+  for (const auto& book : books) {
+    total += book.size;
+  }
+  const uint64_t limit = SETTINGS.getCacheLimitBytes();
+  if (limit == 0 || total <= limit) {
+    passRunning = false;
+    xSemaphoreGive(mutex);
+    return;
+  }
+
+  // Least recently read book that still has something to give, never the one read last
+  const auto newest = std::max_element(books.begin(), books.end(),
+                                       [](const Book& a, const Book& b) { return a.lastUse < b.lastUse; });
+  Book* victim = nullptr;
+  for (auto& book : books) {
+    if (&book != &*newest && book.trimmed < TRIM_METADATA && (!victim || book.lastUse < victim->lastUse)) {
+      victim = &book;
+    }
+  }
+  if (!victim) {
+    LOG_DBG("CBM", "Cache over its limit (%lu KB) with nothing left to trim", static_cast<unsigned long>(total / 1024));
+    passRunning = false;
+    xSemaphoreGive(mutex);
+    return;
+  }
+
+  const std::string dir = victim->dir;
+  const uint8_t level = victim->trimmed + 1;
+  xSemaphoreGive(mutex);
+  trim(dir, level);
+  const uint32_t size = measure(std::string(CACHE_DIR) + "/" + dir);
+  LOG_DBG("CBM", "Trimmed %s to level %u: %lu bytes left", dir.c_str(), level, static_cast<unsigned long>(size));
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  for (auto& book : books) {
+    if (book.dir == dir) {
+      book.size = size;
+      book.measured = true;
+      book.trimmed = level;
+    }
+  }
+  saveLedger();
+  enqueueStep();
+  xSemaphoreGive(mutex);
+}
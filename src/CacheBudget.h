@@ -0,0 +1,61 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Keeps the book caches under /.crosspoint within the size limit chosen in the settings.
+ *
+ * A small ledger records every book cache directory with its size and the last time its book was opened. When the
+ * total is over the limit, the least recently read books give up their caches in three steps: chapter sections other
+ * than the one being read (in every layout but the last one used, all of them), then images, covers and thumbnails,
+ * then the remaining metadata. progress.bin and the current section of an EPUB, with its inline images, are never
+ * removed, and the book read last is left alone.
+ *
+ * The work runs on the background job queue one directory per job, so it only happens while a library screen sits
+ * idle and an activity switch never waits for more than one step.
+ */
+class CacheBudget {
+  // Static instance
+  static CacheBudget instance;
+
+  // Trim levels, in eviction order
+  enum Trim : uint8_t { TRIM_NONE, TRIM_SECTIONS, TRIM_IMAGES, TRIM_METADATA };
+
+  struct Book {
+    std::string dir;       // cache directory name, e.g. epub_1234
+    uint32_t lastUse = 0;  // value of useCounter when the book was last opened; 0 if never seen opened
+    uint32_t size = 0;     // bytes, valid when measured
+    bool measured = false;
+    uint8_t trimmed = TRIM_NONE;
+  };
+
+  SemaphoreHandle_t mutex = nullptr;  // guards everything below
+  std::vector<Book> books;
+  uint32_t useCounter = 0;
+  bool listed = false;       // ledger reconciled with the cache directory since boot
+  bool passRunning = false;  // a chain of steps is queued
+  uint32_t stepCounter = 0;
+
+  void loadLedger();
+  void saveLedger() const;
+  void enqueueStep();
+  void runStep();
+  static void trim(const std::string& dir, uint8_t level);
+
+ public:
+  static CacheBudget& getInstance() { return instance; }
+
+  void begin();
+
+  // The book cached in cachePath was opened; also starts a pass if the budget may be exceeded
+  void touch(const std::string& cachePath);
+  // Queue an incremental pass unless one is running
+  void schedule();
+};
+
+// Helper macro to access the cache budget
+#define CACHE_BUDGET CacheBudget::getInstance()
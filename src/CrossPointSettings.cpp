@@ -277,6 +277,23 @@ unsigned long CrossPointSettings::getSleepTimeoutMs() const {
   }
 }
 
+uint64_t CrossPointSettings::getCacheLimitBytes() const {
+  constexpr uint64_t MB = 1024 * 1024;
+  switch (cacheLimit) {
+    case CACHE_250_MB:
+      return 250 * MB;
+    case CACHE_500_MB:
+      return 500 * MB;
+    case CACHE_1_GB:
+    default:
+      return 1024 * MB;
+    case CACHE_2_GB:
+      return 2048 * MB;
+    case CACHE_UNLIMITED:
+      return 0;
+  }
+}
+
 int CrossPointSettings::getRefreshFrequency() const {
   switch (refreshFrequency) {
     case REFRESH_1:
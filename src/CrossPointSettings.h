@@ -137,6 +137,19 @@ class CrossPointSettings {
   // Image rendering in EPUB reader
   enum IMAGE_RENDERING { IMAGES_DISPLAY = 0, IMAGES_PLACEHOLDER = 1, IMAGES_SUPPRESS = 2, IMAGE_RENDERING_COUNT };
 
+  // File browser order (same values as LibraryIndex::Order)
+  enum FILE_BROWSER_SORT { SORT_NAME = 0, SORT_TITLE = 1, SORT_AUTHOR = 2, FILE_BROWSER_SORT_COUNT };
+
+  // Size limit for the book caches under /.crosspoint
+  enum CACHE_LIMIT {
+    CACHE_250_MB = 0,
+    CACHE_500_MB = 1,
+    CACHE_1_GB = 2,
+    CACHE_2_GB = 3,
+    CACHE_UNLIMITED = 4,
+    CACHE_LIMIT_COUNT
+  };
+
   // Sleep screen settings
   uint8_t sleepScreen = DARK;
   // Sleep screen cover mode settings
@@ -199,6 +212,14 @@ class CrossPointSettings {
   uint8_t showHiddenFiles = 0;
   // Image rendering mode in EPUB reader
   uint8_t imageRendering = IMAGES_DISPLAY;
+  // Order of books in the file browser
+  uint8_t fileBrowserSort = SORT_NAME;
+  // Keep each book's chapter caches in a single pack file (1 = pack, 0 = one file per chapter)
+  uint8_t packBookCaches = 0;
+  // Book caches beyond this size are trimmed, least recently read books first
+  uint8_t cacheLimit = CACHE_1_GB;
+  // Number pages across the whole book once every chapter has been laid out (1 = book pages, 0 = chapter pages)
+  uint8_t bookPageNumbers = 0;
 
   ~CrossPointSettings() = default;
 
@@ -224,6 +245,8 @@ class CrossPointSettings {
  public:
   float getReaderLineCompression() const;
   unsigned long getSleepTimeoutMs() const;
+  // 0 when unlimited
+  uint64_t getCacheLimitBytes() const;
   int getRefreshFrequency() const;
 };
 
@@ -0,0 +1,700 @@
+#include "LibraryIndex.h"
+
+#include <BufferedIO.h>
+#include <Epub.h>
+#include <FsHelpers.h>
+#include <HalStorage.h>
+#include <Logging.h>
+#include <Txt.h>
+#include <Xtc.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <functional>
+
+#include "BackgroundJobQueue.h"
+#include "components/UITheme.h"
+
+namespace {
+constexpr uint8_t INDEX_FILE_VERSION = 1;
+constexpr char INDEX_DIR[] = "/.crosspoint/library";
+constexpr char CACHE_DIR[] = "/.crosspoint";
+// Orderings are stored as uint16_t positions
+constexpr size_t MAX_ENTRIES = UINT16_MAX;
+
+constexpr uint8_t FLAG_THUMB = 1 << 0;
+constexpr uint8_t FLAG_LOOKED_UP = 1 << 1;
+constexpr uint8_t FLAG_NO_COVER = 1 << 2;
+
+/*
+ * Index file layout:
+ *   u8 version, u32 signature, u8 complete, string dirPath, u32 count
+ *   u32 recordOffset[count]      records in browser (name) order
+ *   u16 byTitle[count], u16 byAuthor[count]
+ *   records: varstring name, u32 size, u32 modified, u8 format, u8 progress, u8 flags,
+ *            varstring title, varstring author, varstring language
+ */
+struct Header {
+  uint32_t signature = 0;
+  bool complete = false;  // every entry looked up and every book has its thumbnail or none can be made
+  uint32_t count = 0;
+  uint32_t offsetsPos = 0;
+};
+
+std::string indexPathFor(const std::string& dirPath) {
+  return std::string(INDEX_DIR) + "/" + std::to_string(std::hash<std::string>{}(dirPath)) + ".idx";
+}
+
+std::string trimSlash(std::string path) {
+  while (path.size() > 1 && path.back() == '/') path.pop_back();
+  return path;
+}
+
+std::string parentOf(const std::string& path) {
+  const std::string trimmed = trimSlash(path);
+  const size_t slash = trimmed.find_last_of('/');
+  return slash == 0 || slash == std::string::npos ? "/" : trimmed.substr(0, slash);
+}
+
+std::string childPath(const std::string& dirPath, const LibraryIndex::Entry& entry) {
+  std::string path = dirPath;
+  if (path.back() != '/') path += '/';
+  path += entry.name;
+  return trimSlash(path);
+}
+
+// The file types the browser lists
+bool formatOf(const char* name, const bool isDirectory, LibraryIndex::Format& format) {
+  if (isDirectory) {
+    format = LibraryIndex::Format::Directory;
+    return true;
+  }
+  const std::string_view filename{name};
+  if (FsHelpers::hasEpubExtension(filename)) {
+    format = LibraryIndex::Format::Epub;
+  } else if (FsHelpers::hasXtcExtension(filename)) {
+    format = LibraryIndex::Format::Xtc;
+  } else if (FsHelpers::hasTxtExtension(filename)) {
+    format = LibraryIndex::Format::Txt;
+  } else if (FsHelpers::hasMarkdownExtension(filename)) {
+    format = LibraryIndex::Format::Markdown;
+  } else if (FsHelpers::hasBmpExtension(filename)) {
+    format = LibraryIndex::Format::Bmp;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool isBook(const LibraryIndex::Format format) {
+  return format == LibraryIndex::Format::Epub || format == LibraryIndex::Format::Xtc;
+}
+
+uint32_t fnv1a(uint32_t hash, const void* data, const size_t len) {
+  const auto* bytes = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+uint32_t nameHash(const std::string& name) { return fnv1a(2166136261u, name.data(), name.size()); }
+
+bool readHeader(serialization::BufferedReader& reader, const std::string& dirPath, Header& header) {
+  uint8_t version = 0;
+  uint8_t complete = 0;
+  std::string storedPath;
+  serialization::readPod(reader, version);
+  serialization::readPod(reader, header.signature);
+  serialization::readPod(reader, complete);
+  serialization::readString(reader, storedPath);
+  serialization::readPod(reader, header.count);
+  header.complete = complete != 0;
+  header.offsetsPos = reader.position();
+  // The path guards against hash collisions between folders
+  return reader.ok() && version == INDEX_FILE_VERSION && storedPath == dirPath && header.count <= MAX_ENTRIES;
+}
+
+// Records are in name order, so an entry is found by binary search over the offset table. On success the reader is
+// positioned just after the record's name.
+bool findByName(serialization::BufferedReader& reader, const Header& header, const std::string& name,
+                uint32_t& position) {
+  uint32_t low = 0;
+  uint32_t high = header.count;
+  std::string candidate;
+  while (low < high && reader.ok()) {
+    const uint32_t mid = low + (high - low) / 2;
+    uint32_t offset = 0;
+    reader.seek(header.offsetsPos + mid * sizeof(uint32_t));
+    serialization::readPod(reader, offset);
+    reader.seek(offset);
+    serialization::readVarString(reader, candidate);
+    if (candidate == name) {
+      position = mid;
+      return reader.ok();
+    }
+    if (LibraryIndex::naturalLess(candidate, name)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return false;
+}
+
+void writeRecord(serialization::BufferedWriter& writer, const LibraryIndex::Entry& entry) {
+  const uint8_t flags = (entry.hasThumb ? FLAG_THUMB : 0) | (entry.lookedUp ? FLAG_LOOKED_UP : 0) |
+                        (entry.noCover ? FLAG_NO_COVER : 0);
+  serialization::writeVarString(writer, entry.name);
+  serialization::writePod(writer, entry.size);
+  serialization::writePod(writer, entry.modified);
+  serialization::writePod(writer, static_cast<uint8_t>(entry.format));
+  serialization::writePod(writer, entry.progress);
+  serialization::writePod(writer, flags);
+  serialization::writeVarString(writer, entry.title);
+  serialization::writeVarString(writer, entry.author);
+  serialization::writeVarString(writer, entry.language);
+}
+
+bool readRecord(serialization::BufferedReader& reader, LibraryIndex::Entry& entry) {
+  uint8_t format = 0;
+  uint8_t flags = 0;
+  serialization::readVarString(reader, entry.name);
+  serialization::readPod(reader, entry.size);
+  serialization::readPod(reader, entry.modified);
+  serialization::readPod(reader, format);
+  serialization::readPod(reader, entry.progress);
+  serialization::readPod(reader, flags);
+  serialization::readVarString(reader, entry.title);
+  serialization::readVarString(reader, entry.author);
+  serialization::readVarString(reader, entry.language);
+  entry.format = static_cast<LibraryIndex::Format>(format);
+  entry.hasThumb = flags & FLAG_THUMB;
+  entry.lookedUp = flags & FLAG_LOOKED_UP;
+  entry.noCover = flags & FLAG_NO_COVER;
+  return reader.ok();
+}
+
+// Opens the index of the book's folder for writing, positioned at the book's progress byte (its flags follow).
+// Called with fileMutex held.
+bool openRecord(const std::string& bookPath, FsFile& f) {
+  const std::string dirPath = parentOf(bookPath);
+  const std::string indexPath = indexPathFor(dirPath);
+  const std::string name = bookPath.substr(bookPath.find_last_of('/') + 1);
+  if (!Storage.exists(indexPath.c_str())) {
+    return false;
+  }
+  f = Storage.open(indexPath.c_str(), O_RDWR);
+  if (!f) {
+    return false;
+  }
+
+  serialization::BufferedReader reader(f);
+  Header header;
+  uint32_t position = 0;
+  if (!readHeader(reader, dirPath, header) || !findByName(reader, header, name, position)) {
+    return false;
+  }
+  // Skip size, modified and format
+  return f.seek(reader.position() + 2 * sizeof(uint32_t) + 1);
+}
+
+bool readProgressFile(const std::string& cachePath, uint8_t* data, const int len) {
+  // Most books have never been opened, so a missing file is not worth a log line
+  FsFile f = Storage.open((cachePath + "/progress.bin").c_str());
+  if (!f) {
+    return false;
+  }
+  const bool ok = f.read(data, len) == len;
+  f.close();
+  return ok;
+}
+
+uint8_t toPercent(const float fraction) {
+  return static_cast<uint8_t>(std::clamp(static_cast<int>(fraction * 100.0f + 0.5f), 0, 100));
+}
+
+bool thumbExists(const std::string& thumbBmpPath) {
+  const int height = UITheme::getInstance().getMetrics().homeCoverHeight;
+  return Storage.exists(UITheme::getCoverThumbPath(thumbBmpPath, height).c_str());
+}
+
+// Fills in what the book's existing caches know; nothing is built here
+void lookUp(const std::string& path, LibraryIndex::Entry& entry) {
+  uint8_t data[8];
+  switch (entry.format) {
+    case LibraryIndex::Format::Epub: {
+      Epub epub(path, CACHE_DIR);
+      if (!epub.load(false, true)) {
+        break;
+      }
+      entry.title = epub.getTitle();
+      entry.author = epub.getAuthor();
+      entry.language = epub.getLanguage();
+      entry.hasThumb = thumbExists(epub.getThumbBmpPath());
+      // Same estimate as the reader: spine index, page and page count of the open chapter
+      if (readProgressFile(epub.getCachePath(), data, 6) && epub.getBookSize() > 0) {
+        const int spineIndex = data[0] | (data[1] << 8);
+        const int page = data[2] | (data[3] << 8);
+        const int pageCount = data[4] | (data[5] << 8);
+        const float chapterProgress = pageCount > 0 ? static_cast<float>(page) / pageCount : 0.0f;
+        entry.progress = toPercent(epub.calculateProgress(spineIndex, chapterProgress));
+      }
+      break;
+    }
+    case LibraryIndex::Format::Xtc: {
+      Xtc xtc(path, CACHE_DIR);
+      if (!xtc.load()) {
+        break;
+      }
+      entry.title = xtc.getTitle();
+      entry.author = xtc.getAuthor();
+      entry.hasThumb = thumbExists(xtc.getThumbBmpPath());
+      if (readProgressFile(xtc.getCachePath(), data, 4) && xtc.getPageCount() > 0) {
+        const uint32_t page = data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24);
+        entry.progress = toPercent(static_cast<float>(page + 1) / xtc.getPageCount());
+      }
+      break;
+    }
+    case LibraryIndex::Format::Txt:
+    case LibraryIndex::Format::Markdown: {
+      // Page followed by the byte offset of the page
+      const Txt txt(path, CACHE_DIR);
+      if (readProgressFile(txt.getCachePath(), data, 8) && entry.size > 0) {
+        const uint32_t offset = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<uint32_t>(data[7]) << 24);
+        entry.progress = toPercent(static_cast<float>(offset) / entry.size);
+      }
+      break;
+    }
+    default:
+      break;
+  }
+  entry.lookedUp = true;
+}
+
+const std::string& titleKey(const LibraryIndex::Entry& entry) { return entry.title.empty() ? entry.name : entry.title; }
+}  // namespace
+
+LibraryIndex LibraryIndex::instance;
+
+void LibraryIndex::begin() { fileMutex = xSemaphoreCreateMutex(); }
+
+bool LibraryIndex::naturalLess(const std::string& a, const std::string& b) {
+  // Directories first
+  const bool isDir1 = !a.empty() && a.back() == '/';
+  const bool isDir2 = !b.empty() && b.back() == '/';
+  if (isDir1 != isDir2) return isDir1;
+
+  const char* s1 = a.c_str();
+  const char* s2 = b.c_str();
+
+  while (*s1 && *s2) {
+    if (isdigit(*s1) && isdigit(*s2)) {
+      // Compare digit runs by value: skip leading zeros, then the longer run is larger
+      while (*s1 == '0') s1++;
+      while (*s2 == '0') s2++;
+      int len1 = 0, len2 = 0;
+      while (isdigit(s1[len1])) len1++;
+      while (isdigit(s2[len2])) len2++;
+      if (len1 != len2) return len1 < len2;
+      for (int i = 0; i < len1; i++) {
+        if (s1[i] != s2[i]) return s1[i] < s2[i];
+      }
+      s1 += len1;
+      s2 += len2;
+    } else {
+      const char c1 = tolower(*s1);
+      const char c2 = tolower(*s2);
+      if (c1 != c2) return c1 < c2;
+      s1++;
+      s2++;
+    }
+  }
+
+  // One string is prefix of other
+  return *s1 == '\0' && *s2 != '\0';
+}
+
+bool LibraryIndex::readCount(const std::string& dirPath, uint32_t& count) {
+  const std::string indexPath = indexPathFor(dirPath);
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    xSemaphoreTake(fileMutex, portMAX_DELAY);
+    FsFile f;
+    bool loaded = false;
+    if (Storage.exists(indexPath.c_str()) && Storage.openFileForRead("LIB", indexPath, f)) {
+      serialization::BufferedReader reader(f);
+      Header header;
+      loaded = readHeader(reader, dirPath, header);
+      count = header.count;
+      f.close();
+    }
+    xSemaphoreGive(fileMutex);
+
+    if (loaded) {
+      return true;
+    }
+    // First visit (or an unreadable index): list the folder now; titles follow from the background refresh
+    if (attempt == 0 && !rebuild(dirPath, false)) {
+      break;
+    }
+  }
+  count = 0;
+  return false;
+}
+
+bool LibraryIndex::readRange(const std::string& dirPath, const Order order, const uint32_t first, const uint32_t count,
+                             std::vector<Entry>& out) {
+  const std::string indexPath = indexPathFor(dirPath);
+  bool ok = false;
+
+  xSemaphoreTake(fileMutex, portMAX_DELAY);
+  FsFile f;
+  if (Storage.exists(indexPath.c_str()) && Storage.openFileForRead("LIB", indexPath, f)) {
+    serialization::BufferedReader reader(f);
+    Header header;
+    if (readHeader(reader, dirPath, header)) {
+      // The index may have been rewritten since the listing was opened; the listing reopens on the new revision
+      const uint32_t end = std::min(header.count, first + count);
+      const uint32_t tablePos = header.offsetsPos + header.count * sizeof(uint32_t);
+      Entry entry;
+      for (uint32_t i = first; i < end && reader.ok(); i++) {
+        uint16_t position = i;
+        if (order != Order::Name) {
+          reader.seek(tablePos + ((order == Order::Author ? header.count : 0) + i) * sizeof(uint16_t));
+          serialization::readPod(reader, position);
+        }
+        uint32_t offset = 0;
+        reader.seek(header.offsetsPos + position * sizeof(uint32_t));
+        serialization::readPod(reader, offset);
+        reader.seek(offset);
+        if (readRecord(reader, entry)) {
+          out.push_back(std::move(entry));
+        }
+      }
+      ok = reader.ok();
+    }
+    f.close();
+  }
+  xSemaphoreGive(fileMutex);
+  return ok;
+}
+
+int32_t LibraryIndex::findPosition(const std::string& dirPath, const Order order, const std::string& name) {
+  const std::string indexPath = indexPathFor(dirPath);
+  int32_t found = -1;
+
+  xSemaphoreTake(fileMutex, portMAX_DELAY);
+  FsFile f;
+  if (Storage.exists(indexPath.c_str()) && Storage.openFileForRead("LIB", indexPath, f)) {
+    serialization::BufferedReader reader(f);
+    Header header;
+    uint32_t position = 0;
+    if (readHeader(reader, dirPath, header) && findByName(reader, header, name, position)) {
+      if (order == Order::Name) {
+        found = position;
+      } else {
+        // Scan the ordering table for the record; no record is read
+        const uint32_t tablePos = header.offsetsPos + header.count * sizeof(uint32_t);
+        reader.seek(tablePos + (order == Order::Author ? header.count * sizeof(uint16_t) : 0));
+        for (uint32_t i = 0; i < header.count && reader.ok(); i++) {
+          uint16_t entry = 0;
+          serialization::readPod(reader, entry);
+          if (entry == position) {
+            found = i;
+            break;
+          }
+        }
+      }
+    }
+    f.close();
+  }
+  xSemaphoreGive(fileMutex);
+  return found;
+}
+
+bool LibraryIndex::Listing::open(const std::string& path, const Order listOrder) {
+  dirPath = path;
+  order = listOrder;
+  hidden.clear();
+  uint32_t entries = 0;
+  const bool ok = LIBRARY_INDEX.readCount(dirPath, entries);
+  count = static_cast<int>(entries);
+  return ok;
+}
+
+int LibraryIndex::Listing::toPosition(const int index) const {
+  int position = index;
+  for (const int h : hidden) {
+    if (h > position) break;
+    position++;
+  }
+  return position;
+}
+
+bool LibraryIndex::Listing::fetch(const int first, const int rows, std::vector<Entry>& out) {
+  if (rows <= 0) {
+    return true;
+  }
+  const int start = toPosition(first);
+  const int end = toPosition(first + rows - 1) + 1;
+  if (hidden.empty()) {
+    return LIBRARY_INDEX.readRange(dirPath, order, start, end - start, out);
+  }
+
+  std::vector<Entry> entries;
+  if (!LIBRARY_INDEX.readRange(dirPath, order, start, end - start, entries)) {
+    return false;
+  }
+  for (int i = 0; i < static_cast<int>(entries.size()); i++) {
+    if (!std::binary_search(hidden.begin(), hidden.end(), start + i)) {
+      out.push_back(std::move(entries[i]));
+    }
+  }
+  return true;
+}
+
+int LibraryIndex::Listing::find(const std::string& name) const {
+  const int32_t position = LIBRARY_INDEX.findPosition(dirPath, order, name);
+  if (position < 0 || std::binary_search(hidden.begin(), hidden.end(), position)) {
+    return 0;
+  }
+  return position - static_cast<int>(std::lower_bound(hidden.begin(), hidden.end(), position) - hidden.begin());
+}
+
+void LibraryIndex::Listing::hide(const int index) {
+  if (index < 0 || index >= size()) {
+    return;
+  }
+  const int position = toPosition(index);
+  hidden.insert(std::lower_bound(hidden.begin(), hidden.end(), position), position);
+}
+
+bool LibraryIndex::rebuild(const std::string& dirPath, const bool lookUpMetadata) {
+  const std::string indexPath = indexPathFor(dirPath);
+
+  FsFile dir = Storage.open(dirPath.c_str());
+  if (!dir || !dir.isDirectory()) {
+    if (dir) dir.close();
+    // The folder is gone; so is its index
+    xSemaphoreTake(fileMutex, portMAX_DELAY);
+    Storage.remove(indexPath.c_str());
+    xSemaphoreGive(fileMutex);
+    return false;
+  }
+
+  // Walk the folder without opening any book. The signature covers everything the walk sees.
+  std::vector<Entry> entries;
+  uint32_t signature = 2166136261u;
+  char name[500];
+  dir.rewindDirectory();
+  for (auto file = dir.openNextFile(); file; file = dir.openNextFile()) {
+    file.getName(name, sizeof(name));
+    Format format;
+    const bool isDirectory = file.isDirectory();
+    if (name[0] == '.' || strcmp(name, "System Volume Information") == 0 || !formatOf(name, isDirectory, format) ||
+        entries.size() >= MAX_ENTRIES) {
+      file.close();
+      continue;
+    }
+
+    Entry entry;
+    entry.name = isDirectory ? std::string(name) + "/" : std::string(name);
+    entry.format = format;
+    entry.size = isDirectory ? 0 : file.size();
+    uint16_t date = 0, time = 0;
+    if (file.getModifyDateTime(&date, &time)) {
+      entry.modified = (static_cast<uint32_t>(date) << 16) | time;
+    }
+    file.close();
+
+    signature = fnv1a(signature, entry.name.data(), entry.name.size());
+    signature = fnv1a(signature, &entry.size, sizeof(entry.size));
+    signature = fnv1a(signature, &entry.modified, sizeof(entry.modified));
+    entries.push_back(std::move(entry));
+  }
+  dir.close();
+
+  // Carry over everything known about entries that did not change
+  bool changed = true;
+  {
+    xSemaphoreTake(fileMutex, portMAX_DELAY);
+    FsFile f;
+    if (Storage.exists(indexPath.c_str()) && Storage.openFileForRead("LIB", indexPath, f)) {
+      serialization::BufferedReader reader(f);
+      Header header;
+      if (readHeader(reader, dirPath, header)) {
+        changed = header.signature != signature || header.count != entries.size();
+        if (!changed && (header.complete || !lookUpMetadata)) {
+          f.close();
+          xSemaphoreGive(fileMutex);
+          return false;
+        }
+
+        std::vector<std::pair<uint32_t, uint32_t>> oldRecords;  // name hash, record offset
+        oldRecords.reserve(header.count);
+        for (uint32_t i = 0; i < header.count && reader.ok(); i++) {
+          uint32_t offset = 0;
+          serialization::readPod(reader, offset);
+          oldRecords.emplace_back(0, offset);
+        }
+        Entry old;
+        for (auto& record : oldRecords) {
+          reader.seek(record.second);
+          serialization::readVarString(reader, old.name);
+          record.first = nameHash(old.name);
+        }
+        std::sort(oldRecords.begin(), oldRecords.end());
+
+        for (auto& entry : entries) {
+          const uint32_t hash = nameHash(entry.name);
+          auto it = std::lower_bound(oldRecords.begin(), oldRecords.end(), std::make_pair(hash, 0u));
+          for (; it != oldRecords.end() && it->first == hash; ++it) {
+            reader.seek(it->second);
+            if (readRecord(reader, old) && old.name == entry.name && old.size == entry.size &&
+                old.modified == entry.modified) {
+              entry = std::move(old);
+              break;
+            }
+          }
+        }
+      }
+      f.close();
+    }
+    xSemaphoreGive(fileMutex);
+  }
+
+  // Titles and progress from the book caches; a pending activity switch leaves the rest for the next refresh
+  bool complete = true;
+  for (auto& entry : entries) {
+    const bool waitsForThumb = isBook(entry.format) && !entry.hasThumb && !entry.noCover;
+    const bool needsLookUp = !entry.lookedUp || waitsForThumb;
+    if (!needsLookUp) {
+      continue;
+    }
+    if (!lookUpMetadata || BACKGROUND_JOBS.isPauseRequested()) {
+      complete = false;
+      continue;
+    }
+    const Entry before = entry;
+    lookUp(childPath(dirPath, entry), entry);
+    changed = changed || entry.title != before.title || entry.author != before.author ||
+              entry.hasThumb != before.hasThumb || entry.progress != before.progress || !before.lookedUp;
+    if (isBook(entry.format) && !entry.hasThumb && !entry.noCover) {
+      complete = false;
+    }
+  }
+  if (!changed) {
+    return false;
+  }
+
+  std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return naturalLess(a.name, b.name); });
+
+  const uint16_t count = entries.size();
+  std::vector<uint16_t> byTitle(count);
+  std::vector<uint16_t> byAuthor(count);
+  for (uint16_t i = 0; i < count; i++) {
+    byTitle[i] = i;
+    byAuthor[i] = i;
+  }
+  // Folders keep their place ahead of files; titles fall back to file names
+  std::stable_sort(byTitle.begin(), byTitle.end(), [&entries](const uint16_t a, const uint16_t b) {
+    const bool isDir1 = entries[a].format == Format::Directory;
+    const bool isDir2 = entries[b].format == Format::Directory;
+    if (isDir1 != isDir2) return isDir1;
+    return naturalLess(titleKey(entries[a]), titleKey(entries[b]));
+  });
+  // Books without an author go last
+  std::stable_sort(byAuthor.begin(), byAuthor.end(), [&entries](const uint16_t a, const uint16_t b) {
+    const bool isDir1 = entries[a].format == Format::Directory;
+    const bool isDir2 = entries[b].format == Format::Directory;
+    if (isDir1 != isDir2) return isDir1;
+    const std::string& author1 = entries[a].author;
+    const std::string& author2 = entries[b].author;
+    if (author1.empty() != author2.empty()) return author2.empty();
+    if (author1 != author2) return naturalLess(author1, author2);
+    return naturalLess(titleKey(entries[a]), titleKey(entries[b]));
+  });
+
+  const std::string tempPath = indexPath + ".tmp";
+  Storage.mkdir(INDEX_DIR);
+  FsFile f;
+  if (!Storage.openFileForWrite("LIB", tempPath, f)) {
+    return false;
+  }
+  serialization::BufferedWriter writer(f);
+  serialization::writePod(writer, INDEX_FILE_VERSION);
+  serialization::writePod(writer, signature);
+  serialization::writePod(writer, static_cast<uint8_t>(complete));
+  serialization::writeString(writer, dirPath);
+  serialization::writePod(writer, static_cast<uint32_t>(count));
+  const uint32_t offsetsPos = writer.position();
+  std::vector<uint32_t> offsets(count);
+  writer.write(offsets.data(), count * sizeof(uint32_t));  // patched below
+  writer.write(byTitle.data(), count * sizeof(uint16_t));
+  writer.write(byAuthor.data(), count * sizeof(uint16_t));
+  for (uint16_t i = 0; i < count; i++) {
+    offsets[i] = writer.position();
+    writeRecord(writer, entries[i]);
+  }
+  writer.seek(offsetsPos);
+  writer.write(offsets.data(), count * sizeof(uint32_t));
+  const bool ok = writer.flush();
+  f.close();
+  if (!ok) {
+    LOG_ERR("LIB", "Failed to write library index for %s", dirPath.c_str());
+    Storage.remove(tempPath.c_str());
+    return false;
+  }
+
+  xSemaphoreTake(fileMutex, portMAX_DELAY);
+  Storage.remove(indexPath.c_str());
+  Storage.rename(tempPath.c_str(), indexPath.c_str());
+  revision = revision + 1;
+  xSemaphoreGive(fileMutex);
+
+  LOG_DBG("LIB", "Indexed %s: %u entries%s", dirPath.c_str(), count, complete ? "" : " (metadata pending)");
+  return true;
+}
+
+void LibraryIndex::refresh(const std::string& dirPath) {
+  BACKGROUND_JOBS.enqueue("library:" + dirPath, [this, dirPath] { rebuild(dirPath, true); });
+}
+
+void LibraryIndex::noteChanged(const std::string& path) {
+  // Only folders that have been browsed have an index to maintain
+  const std::string parent = parentOf(path);
+  if (Storage.exists(indexPathFor(parent).c_str())) {
+    refresh(parent);
+  }
+  // A folder that was removed or replaced takes its own index with it on the next refresh
+  const std::string self = trimSlash(path);
+  if (self != "/" && Storage.exists(indexPathFor(self).c_str())) {
+    refresh(self);
+  }
+}
+
+void LibraryIndex::updateProgress(const std::string& bookPath, const uint8_t percent) {
+  xSemaphoreTake(fileMutex, portMAX_DELAY);
+  FsFile f;
+  if (openRecord(bookPath, f)) {
+    f.write(&percent, 1);
+  }
+  f.close();
+  xSemaphoreGive(fileMutex);
+}
+
+void LibraryIndex::noteNoCover(const std::string& bookPath) {
+  xSemaphoreTake(fileMutex, portMAX_DELAY);
+  FsFile f;
+  uint8_t record[2];  // progress, flags
+  if (openRecord(bookPath, f) && f.read(record, sizeof(record)) == sizeof(record) &&
+      !(record[1] & FLAG_NO_COVER)) {
+    record[1] |= FLAG_NO_COVER;
+    f.seek(f.position() - 1);
+    f.write(&record[1], 1);
+  }
+  f.close();
+  xSemaphoreGive(fileMutex);
+}
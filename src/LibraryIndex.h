@@ -0,0 +1,98 @@
+#pragma once
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "util/ListWindow.h"
+
+/**
+ * Persistent index of the folders shown in the file browser.
+ *
+ * Every folder that has been browsed gets a file in /.crosspoint/library with one record per visible entry (name,
+ * size, FAT modification time, format, title, author, language, thumbnail presence, reading progress) in browser
+ * order, followed by the title and author orderings. A Listing reads the entries of one screen from that file instead
+ * of opening every directory entry and sorting them.
+ *
+ * The index is kept current by refresh(), which runs on the background job queue: it walks the folder, compares a
+ * signature of the listing with the stored one and only rewrites the file when something changed. Metadata of
+ * unchanged entries is carried over, and books are only looked up in their existing caches, never parsed. File
+ * transfers and deletions call noteChanged(); readers report progress with updateProgress().
+ */
+class LibraryIndex {
+ public:
+  enum class Format : uint8_t { Directory, Epub, Xtc, Txt, Markdown, Bmp };
+  enum class Order : uint8_t { Name, Title, Author };
+  static constexpr uint8_t NO_PROGRESS = 0xFF;
+
+  struct Entry {
+    std::string name;  // directories end with '/'
+    uint32_t size = 0;
+    uint32_t modified = 0;  // FAT date << 16 | FAT time
+    Format format = Format::Directory;
+    uint8_t progress = NO_PROGRESS;  // percent read
+    bool hasThumb = false;
+    bool lookedUp = false;  // title, author, language and progress were read from the book's caches
+    bool noCover = false;   // cover generation failed, so there is no thumbnail to wait for
+    std::string title;
+    std::string author;
+    std::string language;
+  };
+
+ private:
+  // Static instance
+  static LibraryIndex instance;
+
+  SemaphoreHandle_t fileMutex = nullptr;  // held while an index file is read, patched or replaced
+  volatile uint32_t revision = 0;
+
+  bool rebuild(const std::string& dirPath, bool lookUpMetadata);
+  bool readCount(const std::string& dirPath, uint32_t& count);
+  bool readRange(const std::string& dirPath, Order order, uint32_t first, uint32_t count, std::vector<Entry>& out);
+  int32_t findPosition(const std::string& dirPath, Order order, const std::string& name);
+
+ public:
+  // The entries of one folder in one order, fetched from its index a window at a time
+  class Listing final : public ListDataSource<Entry> {
+    std::string dirPath;
+    Order order = Order::Name;
+    int count = 0;
+    std::vector<int> hidden;  // positions left out until the index catches up, ascending
+
+    int toPosition(int index) const;
+
+   public:
+    // Without an index yet, the folder is scanned (names only) and indexed first
+    bool open(const std::string& dirPath, Order order);
+    int size() const override { return count - static_cast<int>(hidden.size()); }
+    bool fetch(int first, int count, std::vector<Entry>& out) override;
+    // Index of the entry called name, or 0 if there is none
+    int find(const std::string& name) const;
+    // Leave out the entry at index, e.g. after its file was deleted
+    void hide(int index);
+  };
+
+  static LibraryIndex& getInstance() { return instance; }
+
+  void begin();
+
+  // Queue a background check of dirPath against its index
+  void refresh(const std::string& dirPath);
+  // The file or folder at path was created, removed or replaced
+  void noteChanged(const std::string& path);
+  // Record the reading progress of a book in its folder's index without a rescan
+  void updateProgress(const std::string& bookPath, uint8_t percent);
+  // Record that no thumbnail can be made for a book, so rescans stop looking for one
+  void noteNoCover(const std::string& bookPath);
+
+  // Incremented whenever an index file is rewritten
+  uint32_t getRevision() const { return revision; }
+
+  // Browser order: folders first, then case-insensitive with digit runs compared by value
+  static bool naturalLess(const std::string& a, const std::string& b);
+};
+
+// Helper macro to access the library index
+#define LIBRARY_INDEX LibraryIndex::getInstance()
@@ -16,6 +16,8 @@ class MappedInputManager {
   explicit MappedInputManager(HalGPIO& gpio) : gpio(gpio) {}
 
   void update() const { gpio.update(); }
+  // Wake the main loop if it is waiting for input, e.g. when the render task queued work for it
+  void interruptWait() const { gpio.interruptWait(); }
   bool wasPressed(Button button) const;
   bool wasReleased(Button button) const;
   bool isPressed(Button button) const;
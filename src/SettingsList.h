@@ -65,6 +65,8 @@ inline const std::vector<SettingInfo>& getSettingsList() {
       SettingInfo::Enum(StrId::STR_IMAGES, &CrossPointSettings::imageRendering,
                         {StrId::STR_IMAGES_DISPLAY, StrId::STR_IMAGES_PLACEHOLDER, StrId::STR_IMAGES_SUPPRESS},
                         "imageRendering", StrId::STR_CAT_READER),
+      SettingInfo::Toggle(StrId::STR_BOOK_PAGE_NUMBERS, &CrossPointSettings::bookPageNumbers, "bookPageNumbers",
+                          StrId::STR_CAT_READER),
       // --- Controls ---
       SettingInfo::Enum(StrId::STR_SIDE_BTN_LAYOUT, &CrossPointSettings::sideButtonLayout,
                         {StrId::STR_PREV_NEXT, StrId::STR_NEXT_PREV}, "sideButtonLayout", StrId::STR_CAT_CONTROLS),
@@ -78,6 +80,15 @@ inline const std::vector<SettingInfo>& getSettingsList() {
       SettingInfo::Enum(StrId::STR_TIME_TO_SLEEP, &CrossPointSettings::sleepTimeout,
                         {StrId::STR_MIN_1, StrId::STR_MIN_5, StrId::STR_MIN_10, StrId::STR_MIN_15, StrId::STR_MIN_30},
                         "sleepTimeout", StrId::STR_CAT_SYSTEM),
+      SettingInfo::Enum(StrId::STR_SORT_FILES_BY, &CrossPointSettings::fileBrowserSort,
+                        {StrId::STR_FILENAME, StrId::STR_TITLE, StrId::STR_AUTHOR}, "fileBrowserSort",
+                        StrId::STR_CAT_SYSTEM),
+      SettingInfo::Toggle(StrId::STR_PACK_BOOK_CACHES, &CrossPointSettings::packBookCaches, "packBookCaches",
+                          StrId::STR_CAT_SYSTEM),
+      SettingInfo::Enum(StrId::STR_CACHE_LIMIT, &CrossPointSettings::cacheLimit,
+                        {StrId::STR_SIZE_250_MB, StrId::STR_SIZE_500_MB, StrId::STR_SIZE_1_GB, StrId::STR_SIZE_2_GB,
+                         StrId::STR_UNLIMITED},
+                        "cacheLimit", StrId::STR_CAT_SYSTEM),
 
       // --- KOReader Sync (web-only, uses KOReaderCredentialStore) ---
       SettingInfo::DynamicString(
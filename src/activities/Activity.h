@@ -42,7 +42,12 @@ class Activity {
 
   virtual bool skipLoopDelay() { return false; }
   virtual bool preventAutoSleep() { return false; }
+  // Nothing happens in loop() but reactions to buttons (no timers, polling or work in slices), so the main loop may
+  // block until the next button event instead of waking every few milliseconds
+  virtual bool isInputDriven() const { return false; }
   virtual bool isReaderActivity() const { return false; }
+  // Library screens let the background job queue run; everything else gets the SD card and decoders to itself
+  virtual bool allowsBackgroundJobs() const { return false; }
 
   // Start a new activity without destroying the current one
   // Note: requestUpdate() will be invoked automatically once resultHandler finishes
@@ -2,6 +2,7 @@
 
 #include <HalPowerManager.h>
 
+#include "BackgroundJobQueue.h"
 #include "boot_sleep/BootActivity.h"
 #include "boot_sleep/SleepActivity.h"
 #include "browser/OpdsBookBrowserActivity.h"
@@ -56,6 +57,12 @@ void ActivityManager::loop() {
     currentActivity->loop();
   }
 
+  if (pendingAction != PendingAction::None && backgroundJobsRunning) {
+    // Let a running job finish before the next activity starts using the SD card
+    BACKGROUND_JOBS.pause();
+    backgroundJobsRunning = false;
+  }
+
   while (pendingAction != PendingAction::None) {
     if (pendingAction == PendingAction::Pop) {
       RenderLock lock;
@@ -131,6 +138,16 @@ void ActivityManager::loop() {
     }
   }
 
+  const bool allowJobs = currentActivity && currentActivity->allowsBackgroundJobs();
+  if (allowJobs != backgroundJobsRunning) {
+    if (allowJobs) {
+      BACKGROUND_JOBS.resume();
+    } else {
+      BACKGROUND_JOBS.pause();
+    }
+    backgroundJobsRunning = allowJobs;
+  }
+
   if (requestedUpdate) {
     requestedUpdate = false;
     // Using direct notification to signal the render task to update
@@ -223,6 +240,8 @@ bool ActivityManager::isReaderActivity() const { return currentActivity && curre
 
 bool ActivityManager::skipLoopDelay() const { return currentActivity && currentActivity->skipLoopDelay(); }
 
+bool ActivityManager::isInputDriven() const { return currentActivity && currentActivity->isInputDriven(); }
+
 void ActivityManager::requestUpdate(bool immediate) {
   if (immediate) {
     if (renderTaskHandle) {
@@ -137,7 +137,8 @@ void SleepActivity::renderDefaultSleepScreen() const {
   renderer.displayBuffer(HalDisplay::HALF_REFRESH);
 }
 
-void SleepActivity::renderBitmapSleepScreen(const Bitmap& bitmap) const {
+void SleepActivity::renderBitmapSleepScreen(const Bitmap& bitmap, const std::string& planeCachePath,
+                                            const uint32_t sourceTag) const {
   int x, y;
   const auto pageWidth = renderer.getScreenWidth();
   const auto pageHeight = renderer.getScreenHeight();
@@ -177,36 +178,98 @@ void SleepActivity::renderBitmapSleepScreen(const Bitmap& bitmap) const {
     y = (pageHeight - bitmap.getHeight()) / 2;
   }
 
-  LOG_DBG("SLP", "drawing to %d x %d", x, y);
-  renderer.clearScreen();
-
   const bool hasGreyscale = bitmap.hasGreyscale() &&
                             SETTINGS.sleepScreenCoverFilter == CrossPointSettings::SLEEP_SCREEN_COVER_FILTER::NO_FILTER;
 
+  // Whole screen is cached, one plane per render pass
+  const PlaneCache::Key cacheKey{0, 0, pageWidth, pageHeight, static_cast<uint8_t>(hasGreyscale ? 3 : 1), sourceTag};
+  if (!planeCachePath.empty() && renderCachedSleepScreen(planeCachePath, cacheKey)) {
+    return;
+  }
+
+  FsFile planeFile;
+  const bool writePlanes =
+      !planeCachePath.empty() && PlaneCache::openForWrite(planeCachePath, renderer, cacheKey, planeFile);
+  bool planesOk = writePlanes;
+
+  LOG_DBG("SLP", "drawing to %d x %d", x, y);
+  const auto start = millis();
+  renderer.clearScreen();
+
   renderer.drawBitmap(bitmap, x, y, pageWidth, pageHeight, cropX, cropY);
+  LOG_DBG("SLP", "Drew BW sleep bitmap in %lums", millis() - start);
 
   if (SETTINGS.sleepScreenCoverFilter == CrossPointSettings::SLEEP_SCREEN_COVER_FILTER::INVERTED_BLACK_AND_WHITE) {
     renderer.invertScreen();
   }
+  if (planesOk) {
+    planesOk = renderer.writeRegion(planeFile, 0, 0, pageWidth, pageHeight);
+  }
 
   renderer.displayBuffer(HalDisplay::HALF_REFRESH);
 
   if (hasGreyscale) {
+    const auto grayStart = millis();
     bitmap.rewindToData();
     renderer.clearScreen(0x00);
     renderer.setRenderMode(GfxRenderer::GRAYSCALE_LSB);
     renderer.drawBitmap(bitmap, x, y, pageWidth, pageHeight, cropX, cropY);
+    if (planesOk) {
+      planesOk = renderer.writeRegion(planeFile, 0, 0, pageWidth, pageHeight);
+    }
     renderer.copyGrayscaleLsbBuffers();
 
     bitmap.rewindToData();
     renderer.clearScreen(0x00);
     renderer.setRenderMode(GfxRenderer::GRAYSCALE_MSB);
     renderer.drawBitmap(bitmap, x, y, pageWidth, pageHeight, cropX, cropY);
+    if (planesOk) {
+      planesOk = renderer.writeRegion(planeFile, 0, 0, pageWidth, pageHeight);
+    }
     renderer.copyGrayscaleMsbBuffers();
+    LOG_DBG("SLP", "Drew grayscale sleep bitmap planes in %lums", millis() - grayStart);
 
     renderer.displayGrayBuffer();
     renderer.setRenderMode(GfxRenderer::BW);
   }
+
+  if (writePlanes) {
+    PlaneCache::finish(planeCachePath, planeFile, planesOk);
+  }
+}
+
+bool SleepActivity::renderCachedSleepScreen(const std::string& planeCachePath, const PlaneCache::Key& key) const {
+  FsFile file;
+  if (!PlaneCache::openForRead(planeCachePath, renderer, key, file)) {
+    return false;
+  }
+
+  const auto start = millis();
+  if (!renderer.readRegion(file, key.x, key.y, key.width, key.height)) {
+    LOG_ERR("SLP", "Failed to read cached sleep screen");
+    file.close();
+    return false;
+  }
+  LOG_DBG("SLP", "Loaded cached BW sleep screen in %lums", millis() - start);
+  renderer.displayBuffer(HalDisplay::HALF_REFRESH);
+
+  if (key.planes == PlaneCache::MAX_PLANES) {
+    // Planes are stored in render pass order: BW, LSB, MSB
+    const auto grayStart = millis();
+    bool ok = renderer.readRegion(file, key.x, key.y, key.width, key.height);
+    renderer.copyGrayscaleLsbBuffers();
+    ok = ok && renderer.readRegion(file, key.x, key.y, key.width, key.height);
+    renderer.copyGrayscaleMsbBuffers();
+    if (ok) {
+      LOG_DBG("SLP", "Loaded cached grayscale planes in %lums", millis() - grayStart);
+      renderer.displayGrayBuffer();
+    } else {
+      LOG_ERR("SLP", "Failed to read cached grayscale planes");
+    }
+  }
+
+  file.close();
+  return true;
 }
 
 void SleepActivity::renderCoverSleepScreen() const {
@@ -280,7 +343,9 @@ void SleepActivity::renderCoverSleepScreen() const {
     Bitmap bitmap(file);
     if (bitmap.parseHeaders() == BmpReaderError::Ok) {
       LOG_DBG("SLP", "Rendering sleep cover: %s", coverBmpPath.c_str());
-      renderBitmapSleepScreen(bitmap);
+      // Cover mode and filter are baked into the cached planes
+      const uint8_t variant = SETTINGS.sleepScreenCoverMode << 4 | SETTINGS.sleepScreenCoverFilter;
+      renderBitmapSleepScreen(bitmap, PlaneCache::getPathFor(coverBmpPath), PlaneCache::makeSourceTag(file, variant));
       file.close();
       return;
     }
@@ -1,4 +1,8 @@
 #pragma once
+#include <PlaneCache.h>
+
+#include <string>
+
 #include "../Activity.h"
 
 class Bitmap;
@@ -13,6 +17,9 @@ class SleepActivity final : public Activity {
   void renderDefaultSleepScreen() const;
   void renderCustomSleepScreen() const;
   void renderCoverSleepScreen() const;
-  void renderBitmapSleepScreen(const Bitmap& bitmap) const;
+  // planeCachePath: optional panel-native snapshot of the drawn screen (see PlaneCache), keyed by sourceTag
+  void renderBitmapSleepScreen(const Bitmap& bitmap, const std::string& planeCachePath = "",
+                               uint32_t sourceTag = 0) const;
+  bool renderCachedSleepScreen(const std::string& planeCachePath, const PlaneCache::Key& key) const;
   void renderBlankSleepScreen() const;
 };
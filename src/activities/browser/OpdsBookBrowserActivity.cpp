@@ -8,11 +8,13 @@
 #include <WiFi.h>
 
 #include "CrossPointSettings.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "activities/network/WifiSelectionActivity.h"
 #include "components/UITheme.h"
 #include "fontIds.h"
 #include "network/HttpDownloader.h"
+#include "util/BookPrepJobs.h"
 #include "util/StringUtils.h"
 #include "util/UrlUtils.h"
 
@@ -339,6 +341,8 @@ void OpdsBookBrowserActivity::downloadBook(const OpdsEntry& book) {
     Epub epub(filename, "/.crosspoint");
     epub.clearCache();
     LOG_DBG("OPDS", "Cleared cache for: %s", filename.c_str());
+    BookPrepJobs::queue(filename);
+    LIBRARY_INDEX.noteChanged(filename);
 
     state = BrowserState::BROWSING;
     requestUpdate();
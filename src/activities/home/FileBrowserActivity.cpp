@@ -9,6 +9,7 @@
 #include <algorithm>
 
 #include "../util/ConfirmationActivity.h"
+#include "CrossPointSettings.h"
 #include "MappedInputManager.h"
 #include "components/UITheme.h"
 #include "fontIds.h"
@@ -17,91 +18,29 @@ namespace {
 constexpr unsigned long GO_HOME_MS = 1000;
 }  // namespace
 
-void sortFileList(std::vector<std::string>& strs) {
-  std::sort(begin(strs), end(strs), [](const std::string& str1, const std::string& str2) {
-    // Directories first
-    bool isDir1 = str1.back() == '/';
-    bool isDir2 = str2.back() == '/';
-    if (isDir1 != isDir2) return isDir1;
-
-    // Start naive natural sort
-    const char* s1 = str1.c_str();
-    const char* s2 = str2.c_str();
-
-    // Iterate while both strings have characters
-    while (*s1 && *s2) {
-      // Check if both are at the start of a number
-      if (isdigit(*s1) && isdigit(*s2)) {
-        // Skip leading zeros and track them
-        const char* start1 = s1;
-        const char* start2 = s2;
-        while (*s1 == '0') s1++;
-        while (*s2 == '0') s2++;
-
-        // Count digits to compare lengths first
-        int len1 = 0, len2 = 0;
-        while (isdigit(s1[len1])) len1++;
-        while (isdigit(s2[len2])) len2++;
-
-        // Different length so return smaller integer value
-        if (len1 != len2) return len1 < len2;
-
-        // Same length so compare digit by digit
-        for (int i = 0; i < len1; i++) {
-          if (s1[i] != s2[i]) return s1[i] < s2[i];
-        }
-
-        // Numbers equal so advance pointers
-        s1 += len1;
-        s2 += len2;
-      } else {
-        // Regular case-insensitive character comparison
-        char c1 = tolower(*s1);
-        char c2 = tolower(*s2);
-        if (c1 != c2) return c1 < c2;
-        s1++;
-        s2++;
-      }
-    }
-
-    // One string is prefix of other
-    return *s1 == '\0' && *s2 != '\0';
-  });
-}
-
 void FileBrowserActivity::loadFiles() {
-  files.clear();
-
-  auto root = Storage.open(basepath.c_str());
-  if (!root || !root.isDirectory()) {
-    if (root) root.close();
-    return;
+  order = static_cast<LibraryIndex::Order>(SETTINGS.fileBrowserSort);
+  indexRevision = LIBRARY_INDEX.getRevision();
+  {
+    RenderLock lock(*this);
+    listing.open(basepath, order);
+    files.setSource(&listing);
   }
+  // Picks up changes made while the card was elsewhere; the list reloads when the index is rewritten
+  LIBRARY_INDEX.refresh(basepath);
+}
 
-  root.rewindDirectory();
-
-  char name[500];
-  for (auto file = root.openNextFile(); file; file = root.openNextFile()) {
-    file.getName(name, sizeof(name));
-    if (name[0] == '.' || strcmp(name, "System Volume Information") == 0) {
-      file.close();
-      continue;
-    }
+int FileBrowserActivity::getPageItems() const {
+  return UITheme::getInstance().getNumberOfItemsPerPage(renderer, true, false, true,
+                                                        order != LibraryIndex::Order::Name);
+}
 
-    if (file.isDirectory()) {
-      files.emplace_back(std::string(name) + "/");
-    } else {
-      std::string_view filename{name};
-      if (FsHelpers::hasEpubExtension(filename) || FsHelpers::hasXtcExtension(filename) ||
-          FsHelpers::hasTxtExtension(filename) || FsHelpers::hasMarkdownExtension(filename) ||
-          FsHelpers::hasBmpExtension(filename)) {
-        files.emplace_back(filename);
-      }
-    }
-    file.close();
+void FileBrowserActivity::showSelection() {
+  const int pageItems = getPageItems();
+  if (!files.covers(static_cast<int>(selectorIndex), pageItems)) {
+    RenderLock lock(*this);
+    files.show(static_cast<int>(selectorIndex), pageItems);
   }
-  root.close();
-  sortFileList(files);
 }
 
 void FileBrowserActivity::onEnter() {
@@ -109,13 +48,14 @@ void FileBrowserActivity::onEnter() {
 
   loadFiles();
   selectorIndex = 0;
+  showSelection();
 
   requestUpdate();
 }
 
 void FileBrowserActivity::onExit() {
   Activity::onExit();
-  files.clear();
+  files.setSource(nullptr);
 }
 
 void FileBrowserActivity::clearFileMetadata(const std::string& fullPath) {
@@ -127,21 +67,43 @@ void FileBrowserActivity::clearFileMetadata(const std::string& fullPath) {
 }
 
 void FileBrowserActivity::loop() {
+  if (LIBRARY_INDEX.getRevision() != indexRevision) {
+    std::string selected;
+    {
+      // The render task reads the same listing and rows
+      RenderLock lock(*this);
+      selected = files.empty() ? "" : files.at(selectorIndex).name;
+    }
+    loadFiles();
+    {
+      RenderLock lock(*this);
+      selectorIndex = selected.empty() ? 0 : listing.find(selected);
+    }
+    showSelection();
+    requestUpdate();
+  }
+
   // Long press BACK (1s+) goes to root folder
   if (mappedInput.isPressed(MappedInputManager::Button::Back) && mappedInput.getHeldTime() >= GO_HOME_MS &&
       basepath != "/") {
     basepath = "/";
     loadFiles();
     selectorIndex = 0;
+    showSelection();
     return;
   }
 
-  const int pageItems = UITheme::getInstance().getNumberOfItemsPerPage(renderer, true, false, true, false);
+  const int pageItems = getPageItems();
 
   if (mappedInput.wasReleased(MappedInputManager::Button::Confirm)) {
-    if (files.empty()) return;
-
-    const std::string& entry = files[selectorIndex];
+    std::string entry;
+    {
+      RenderLock lock(*this);
+      if (!files.empty()) {
+        entry = files.at(selectorIndex).name;
+      }
+    }
+    if (entry.empty()) return;
     bool isDirectory = (entry.back() == '/');
 
     if (mappedInput.getHeldTime() >= GO_HOME_MS && !isDirectory) {
@@ -150,19 +112,28 @@ void FileBrowserActivity::loop() {
       if (cleanBasePath.back() != '/') cleanBasePath += "/";
       const std::string fullPath = cleanBasePath + entry;
 
-      auto handler = [this, fullPath](const ActivityResult& res) {
+      auto handler = [this, fullPath, entry, index = static_cast<int>(selectorIndex)](const ActivityResult& res) {
         if (!res.isCancelled) {
           LOG_DBG("FileBrowser", "Attempting to delete: %s", fullPath.c_str());
           clearFileMetadata(fullPath);
           if (Storage.remove(fullPath.c_str())) {
             LOG_DBG("FileBrowser", "Deleted successfully");
-            loadFiles();
-            if (files.empty()) {
-              selectorIndex = 0;
-            } else if (selectorIndex >= files.size()) {
-              // Move selection to the new "last" item
-              selectorIndex = files.size() - 1;
+            // The index catches up in the background
+            LIBRARY_INDEX.noteChanged(fullPath);
+            {
+              RenderLock lock(*this);
+              if (files.at(index).name == entry) {
+                listing.hide(index);
+                files.invalidate();
+              }
+              if (files.empty()) {
+                selectorIndex = 0;
+              } else if (selectorIndex >= static_cast<size_t>(files.size())) {
+                // Move selection to the new "last" item
+                selectorIndex = files.size() - 1;
+              }
             }
+            showSelection();
 
             requestUpdate(true);
           } else {
@@ -185,6 +156,7 @@ void FileBrowserActivity::loop() {
         basepath += entry.substr(0, entry.length() - 1);
         loadFiles();
         selectorIndex = 0;
+        showSelection();
         requestUpdate();
       } else {
         onSelectBook(basepath + entry);
@@ -205,7 +177,11 @@ void FileBrowserActivity::loop() {
 
         const auto pos = oldPath.find_last_of('/');
         const std::string dirName = oldPath.substr(pos + 1) + "/";
-        selectorIndex = findEntry(dirName);
+        {
+          RenderLock lock(*this);
+          selectorIndex = listing.find(dirName);
+        }
+        showSelection();
 
         requestUpdate();
       } else {
@@ -214,24 +190,28 @@ void FileBrowserActivity::loop() {
     }
   }
 
-  int listSize = static_cast<int>(files.size());
+  int listSize = files.size();
   buttonNavigator.onNextRelease([this, listSize] {
     selectorIndex = ButtonNavigator::nextIndex(static_cast<int>(selectorIndex), listSize);
+    showSelection();
     requestUpdate();
   });
 
   buttonNavigator.onPreviousRelease([this, listSize] {
     selectorIndex = ButtonNavigator::previousIndex(static_cast<int>(selectorIndex), listSize);
+    showSelection();
     requestUpdate();
   });
 
   buttonNavigator.onNextContinuous([this, listSize, pageItems] {
     selectorIndex = ButtonNavigator::nextPageIndex(static_cast<int>(selectorIndex), listSize, pageItems);
+    showSelection();
     requestUpdate();
   });
 
   buttonNavigator.onPreviousContinuous([this, listSize, pageItems] {
     selectorIndex = ButtonNavigator::previousPageIndex(static_cast<int>(selectorIndex), listSize, pageItems);
+    showSelection();
     requestUpdate();
   });
 }
@@ -259,10 +239,18 @@ void FileBrowserActivity::render(RenderLock&&) {
   if (files.empty()) {
     renderer.drawText(UI_10_FONT_ID, metrics.contentSidePadding, contentTop + 20, tr(STR_NO_FILES_FOUND));
   } else {
+    // Title and author orders show book metadata the way the recent books list does
+    const bool bookView = order != LibraryIndex::Order::Name;
     GUI.drawList(
         renderer, Rect{0, contentTop, pageWidth, contentHeight}, files.size(), selectorIndex,
-        [this](int index) { return getFileName(files[index]); }, nullptr,
-        [this](int index) { return UITheme::getFileIcon(files[index]); });
+        [this](int index) { return rowTitle(files.at(index)); },
+        bookView ? std::function<std::string(int)>([this](int index) { return files.at(index).author; }) : nullptr,
+        [this](int index) { return UITheme::getFileIcon(files.at(index).name); },
+        [this](int index) {
+          const uint8_t progress = files.at(index).progress;
+          const bool started = progress != LibraryIndex::NO_PROGRESS && progress > 0;
+          return started ? std::to_string(progress) + "%" : std::string();
+        });
   }
 
   // Help text
@@ -274,8 +262,9 @@ void FileBrowserActivity::render(RenderLock&&) {
   renderer.displayBuffer();
 }
 
-size_t FileBrowserActivity::findEntry(const std::string& name) const {
-  for (size_t i = 0; i < files.size(); i++)
-    if (files[i] == name) return i;
-  return 0;
+std::string FileBrowserActivity::rowTitle(const LibraryIndex::Entry& entry) const {
+  if (order != LibraryIndex::Order::Name && !entry.title.empty()) {
+    return entry.title;
+  }
+  return getFileName(entry.name);
 }
\ No newline at end of file
@@ -5,8 +5,10 @@
 #include <vector>
 
 #include "../Activity.h"
+#include "LibraryIndex.h"
 #include "RecentBooksStore.h"
 #include "util/ButtonNavigator.h"
+#include "util/ListWindow.h"
 
 class FileBrowserActivity final : public Activity {
  private:
@@ -19,11 +21,17 @@ class FileBrowserActivity final : public Activity {
 
   // Files state
   std::string basepath = "/";
-  std::vector<std::string> files;
+  LibraryIndex::Listing listing;
+  ListWindow<LibraryIndex::Entry> files;
+  LibraryIndex::Order order = LibraryIndex::Order::Name;
+  uint32_t indexRevision = 0;
 
   // Data loading
   void loadFiles();
-  size_t findEntry(const std::string& name) const;
+  int getPageItems() const;
+  // Fetch the page holding the selection before it is rendered
+  void showSelection();
+  std::string rowTitle(const LibraryIndex::Entry& entry) const;
 
  public:
   explicit FileBrowserActivity(GfxRenderer& renderer, MappedInputManager& mappedInput, std::string initialPath = "/")
@@ -32,4 +40,5 @@ class FileBrowserActivity final : public Activity {
   void onExit() override;
   void loop() override;
   void render(RenderLock&&) override;
+  bool allowsBackgroundJobs() const override { return true; }
 };
@@ -15,17 +15,41 @@ namespace {
 constexpr unsigned long GO_HOME_MS = 1000;
 }  // namespace
 
-void RecentBooksActivity::loadRecentBooks() {
-  recentBooks.clear();
+void RecentBooksActivity::RecentSource::load() {
+  positions.clear();
   const auto& books = RECENT_BOOKS.getBooks();
-  recentBooks.reserve(books.size());
+  positions.reserve(books.size());
 
-  for (const auto& book : books) {
+  for (size_t i = 0; i < books.size(); i++) {
     // Skip if file no longer exists
-    if (!Storage.exists(book.path.c_str())) {
+    if (!Storage.exists(books[i].path.c_str())) {
       continue;
     }
-    recentBooks.push_back(book);
+    positions.push_back(i);
+  }
+}
+
+bool RecentBooksActivity::RecentSource::fetch(const int first, const int count, std::vector<RecentBook>& out) {
+  const auto& books = RECENT_BOOKS.getBooks();
+  for (int i = first; i < first + count; i++) {
+    if (positions[i] >= books.size()) {
+      return false;
+    }
+    out.push_back(books[positions[i]]);
+  }
+  return true;
+}
+
+void RecentBooksActivity::loadRecentBooks() {
+  recentSource.load();
+  recentBooks.setSource(&recentSource);
+}
+
+void RecentBooksActivity::showSelection() {
+  const int pageItems = UITheme::getInstance().getNumberOfItemsPerPage(renderer, true, false, true, true);
+  if (!recentBooks.covers(static_cast<int>(selectorIndex), pageItems)) {
+    RenderLock lock(*this);
+    recentBooks.show(static_cast<int>(selectorIndex), pageItems);
   }
 }
 
@@ -36,21 +60,23 @@ void RecentBooksActivity::onEnter() {
   loadRecentBooks();
 
   selectorIndex = 0;
+  showSelection();
   requestUpdate();
 }
 
 void RecentBooksActivity::onExit() {
   Activity::onExit();
-  recentBooks.clear();
+  recentBooks.setSource(nullptr);
 }
 
 void RecentBooksActivity::loop() {
   const int pageItems = UITheme::getInstance().getNumberOfItemsPerPage(renderer, true, false, true, true);
 
   if (mappedInput.wasReleased(MappedInputManager::Button::Confirm)) {
-    if (!recentBooks.empty() && selectorIndex < static_cast<int>(recentBooks.size())) {
-      LOG_DBG("RBA", "Selected recent book: %s", recentBooks[selectorIndex].path.c_str());
-      onSelectBook(recentBooks[selectorIndex].path);
+    if (!recentBooks.empty() && selectorIndex < static_cast<size_t>(recentBooks.size())) {
+      const std::string path = recentBooks.at(selectorIndex).path;
+      LOG_DBG("RBA", "Selected recent book: %s", path.c_str());
+      onSelectBook(path);
       return;
     }
   }
@@ -59,25 +85,29 @@ void RecentBooksActivity::loop() {
     onGoHome();
   }
 
-  int listSize = static_cast<int>(recentBooks.size());
+  int listSize = recentBooks.size();
 
   buttonNavigator.onNextRelease([this, listSize] {
     selectorIndex = ButtonNavigator::nextIndex(static_cast<int>(selectorIndex), listSize);
+    showSelection();
     requestUpdate();
   });
 
   buttonNavigator.onPreviousRelease([this, listSize] {
     selectorIndex = ButtonNavigator::previousIndex(static_cast<int>(selectorIndex), listSize);
+    showSelection();
     requestUpdate();
   });
 
   buttonNavigator.onNextContinuous([this, listSize, pageItems] {
     selectorIndex = ButtonNavigator::nextPageIndex(static_cast<int>(selectorIndex), listSize, pageItems);
+    showSelection();
     requestUpdate();
   });
 
   buttonNavigator.onPreviousContinuous([this, listSize, pageItems] {
     selectorIndex = ButtonNavigator::previousPageIndex(static_cast<int>(selectorIndex), listSize, pageItems);
+    showSelection();
     requestUpdate();
   });
 }
@@ -100,8 +130,9 @@ void RecentBooksActivity::render(RenderLock&&) {
   } else {
     GUI.drawList(
         renderer, Rect{0, contentTop, pageWidth, contentHeight}, recentBooks.size(), selectorIndex,
-        [this](int index) { return recentBooks[index].title; }, [this](int index) { return recentBooks[index].author; },
-        [this](int index) { return UITheme::getFileIcon(recentBooks[index].path); });
+        [this](int index) { return recentBooks.at(index).title; },
+        [this](int index) { return recentBooks.at(index).author; },
+        [this](int index) { return UITheme::getFileIcon(recentBooks.at(index).path); });
   }
 
   // Help text
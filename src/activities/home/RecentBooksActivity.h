@@ -8,18 +8,32 @@
 #include "../Activity.h"
 #include "RecentBooksStore.h"
 #include "util/ButtonNavigator.h"
+#include "util/ListWindow.h"
 
 class RecentBooksActivity final : public Activity {
  private:
+  // Recent books whose file still exists, copied from the store a page at a time
+  class RecentSource final : public ListDataSource<RecentBook> {
+    std::vector<uint8_t> positions;  // into RECENT_BOOKS.getBooks()
+
+   public:
+    void load();
+    int size() const override { return static_cast<int>(positions.size()); }
+    bool fetch(int first, int count, std::vector<RecentBook>& out) override;
+  };
+
   ButtonNavigator buttonNavigator;
 
   size_t selectorIndex = 0;
 
   // Recent tab state
-  std::vector<RecentBook> recentBooks;
+  RecentSource recentSource;
+  ListWindow<RecentBook> recentBooks;
 
   // Data loading
   void loadRecentBooks();
+  // Fetch the page holding the selection before it is rendered
+  void showSelection();
 
  public:
   explicit RecentBooksActivity(GfxRenderer& renderer, MappedInputManager& mappedInput)
@@ -28,4 +42,5 @@ class RecentBooksActivity final : public Activity {
   void onExit() override;
   void loop() override;
   void render(RenderLock&&) override;
+  bool allowsBackgroundJobs() const override { return true; }
 };
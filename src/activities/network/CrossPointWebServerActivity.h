@@ -59,6 +59,9 @@ class CrossPointWebServerActivity final : public Activity {
   void onExit() override;
   void loop() override;
   void render(RenderLock&&) override;
-  bool skipLoopDelay() override { return webServer && webServer->isRunning(); }
+  bool skipLoopDelay() override { return webServer && webServer->isRunning() && webServer->needsFastLoop(); }
   bool preventAutoSleep() override { return webServer && webServer->isRunning(); }
+  // Received books are prepared while the device waits for the next transfer; uploads and file operations hold the
+  // queue (BackgroundJobQueue::Hold)
+  bool allowsBackgroundJobs() const override { return true; }
 };
@@ -1,6 +1,5 @@
 #include "EpubReaderActivity.h"
 
-#include <Epub/Page.h>
 #include <Epub/blocks/TextBlock.h>
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
@@ -8,6 +7,8 @@
 #include <I18n.h>
 #include <Logging.h>
 
+#include "BackgroundJobQueue.h"
+#include "CacheBudget.h"
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
 #include "EpubReaderChapterSelectionActivity.h"
@@ -15,17 +16,21 @@
 #include "EpubReaderPercentSelectionActivity.h"
 #include "KOReaderCredentialStore.h"
 #include "KOReaderSyncActivity.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "QrDisplayActivity.h"
 #include "ReaderUtils.h"
 #include "RecentBooksStore.h"
 #include "components/UITheme.h"
 #include "fontIds.h"
+#include "util/BookPrepJobs.h"
 #include "util/ScreenshotUtil.h"
 
 namespace {
 // pagesPerRefresh now comes from SETTINGS.getRefreshFrequency()
 constexpr unsigned long skipChapterMs = 700;
+// The next page is only prepared while this much heap is free; the grayscale pass needs 48KB to back up the BW buffer
+constexpr size_t prepHeapReserve = 64 * 1024;
 // pages per minute, first item is 1 to prevent division by zero if accessed
 const std::vector<int> PAGE_TURN_LABELS = {1, 1, 3, 6, 12};
 
@@ -53,6 +58,8 @@ void EpubReaderActivity::onEnter() {
   ReaderUtils::applyOrientation(renderer, SETTINGS.orientation);
 
   epub->setupCacheDir();
+  CACHE_BUDGET.touch(epub->getCachePath());
+  prepMutex = xSemaphoreCreateMutex();
 
   FsFile f;
   if (Storage.openFileForRead("ERS", epub->getCachePath() + "/progress.bin", f)) {
@@ -94,8 +101,31 @@ void EpubReaderActivity::onExit() {
   // Reset orientation back to portrait for the rest of the UI
   renderer.setOrientation(GfxRenderer::Orientation::Portrait);
 
+  // Progress shown next to the book in the file browser
+  if (epub && epub->getBookSize() > 0) {
+    const float bookProgress = section ? getBookProgress(section->currentPage)
+                                       : epub->calculateProgress(currentSpineIndex, 0.0f) * 100.0f;
+    LIBRARY_INDEX.updateProgress(epub->getPath(), clampPercent(static_cast<int>(bookProgress + 0.5f)));
+  }
+
+  // Count the chapters not laid out yet once back in the library
+  if (epub && SETTINGS.bookPageNumbers && !pageIndex.isComplete()) {
+    BookPrepJobs::queuePageIndex(epub->getPath(), pageIndex.getFirstMissing());
+  }
+
+  // Sections rebuilt after a settings change leave dead records behind in the pack
+  if (epub && epub->getPack()) {
+    const std::string packPath = epub->getPackPath();
+    BACKGROUND_JOBS.enqueue("compact:" + packPath, [packPath] { PackFile(packPath).compactIfWorthwhile(); });
+  }
+
   APP_STATE.readerActivityLoadCount = 0;
   APP_STATE.saveToFile();
+  preparedPage.reset();
+  if (prepMutex) {
+    vSemaphoreDelete(prepMutex);
+    prepMutex = nullptr;
+  }
   section.reset();
   epub.reset();
 }
@@ -107,6 +137,9 @@ void EpubReaderActivity::loop() {
     return;
   }
 
+  // The render task hands over work while it waits for the panel refresh
+  servicePagePrep();
+
   if (automaticPageTurnActive) {
     if (mappedInput.wasReleased(MappedInputManager::Button::Confirm) ||
         mappedInput.wasReleased(MappedInputManager::Button::Back)) {
@@ -139,8 +172,7 @@ void EpubReaderActivity::loop() {
     const int totalPages = section ? section->pageCount : 0;
     float bookProgress = 0.0f;
     if (epub->getBookSize() > 0 && section && section->pageCount > 0) {
-      const float chapterProgress = static_cast<float>(section->currentPage) / static_cast<float>(section->pageCount);
-      bookProgress = epub->calculateProgress(currentSpineIndex, chapterProgress) * 100.0f;
+      bookProgress = getBookProgress(section->currentPage);
     }
     const int bookProgressPercent = clampPercent(static_cast<int>(bookProgress + 0.5f));
     startActivityForResult(std::make_unique<EpubReaderMenuActivity>(
@@ -230,6 +262,21 @@ void EpubReaderActivity::jumpToPercent(int percent) {
   // Normalize input to 0-100 to avoid invalid jumps.
   percent = clampPercent(percent);
 
+  // With every chapter's page count known the target page is exact
+  if (pageIndex.isComplete() && pageIndex.getTotalPages() > 0) {
+    int targetSpineIndex, targetPage;
+    pageIndex.locate(pageIndex.getTotalPages() * percent / 100, targetSpineIndex, targetPage);
+    // Middle of the page, so the conversion back to a page number cannot round down
+    pendingSpineProgress = (static_cast<float>(targetPage) + 0.5f) / pageIndex.getPageCount(targetSpineIndex);
+
+    RenderLock lock(*this);
+    currentSpineIndex = targetSpineIndex;
+    nextPageNumber = 0;
+    pendingPercentJump = true;
+    section.reset();
+    return;
+  }
+
   // Convert percent into a byte-like absolute position across the spine sizes.
   // Use an overflow-safe computation: (bookSize / 100) * percent + (bookSize % 100) * percent / 100
   size_t targetSize =
@@ -309,8 +356,7 @@ void EpubReaderActivity::onReaderMenuConfirm(EpubReaderMenuActivity::MenuAction
     case EpubReaderMenuActivity::MenuAction::GO_TO_PERCENT: {
       float bookProgress = 0.0f;
       if (epub && epub->getBookSize() > 0 && section && section->pageCount > 0) {
-        const float chapterProgress = static_cast<float>(section->currentPage) / static_cast<float>(section->pageCount);
-        bookProgress = epub->calculateProgress(currentSpineIndex, chapterProgress) * 100.0f;
+        bookProgress = getBookProgress(section->currentPage);
       }
       const int initialPercent = clampPercent(static_cast<int>(bookProgress + 0.5f));
       startActivityForResult(
@@ -455,6 +501,7 @@ void EpubReaderActivity::toggleAutoPageTurn(const uint8_t selectedPageTurnOption
 }
 
 void EpubReaderActivity::pageTurn(bool isForwardTurn) {
+  pageDirection = isForwardTurn ? 1 : -1;
   if (isForwardTurn) {
     if (section->currentPage < section->pageCount - 1) {
       section->currentPage++;
@@ -556,6 +603,10 @@ void EpubReaderActivity::render(RenderLock&& lock) {
       LOG_DBG("ERS", "Cache found, skipping build...");
     }
 
+    if (SETTINGS.bookPageNumbers) {
+      pageIndex.load(epub->getCachePath(), section->getLayout(), epub->getSpineItemsCount());
+    }
+
     if (nextPageNumber == UINT16_MAX) {
       section->currentPage = section->pageCount - 1;
     } else {
@@ -615,7 +666,10 @@ void EpubReaderActivity::render(RenderLock&& lock) {
   }
 
   {
-    auto p = section->loadPageFromSectionFile();
+    auto p = takePreparedPage();
+    if (!p) {
+      p = section->loadPageFromSectionFile();
+    }
     if (!p) {
       LOG_ERR("ERS", "Failed to load page from SD - clearing section cache");
       section->clearCache();
@@ -634,7 +688,6 @@ void EpubReaderActivity::render(RenderLock&& lock) {
     LOG_DBG("ERS", "Rendered page in %dms", millis() - start);
     renderer.clearFontCache();
   }
-  saveProgress(currentSpineIndex, section->currentPage, section->pageCount);
 
   if (pendingScreenshot) {
     pendingScreenshot = false;
@@ -646,8 +699,8 @@ void EpubReaderActivity::saveProgress(int spineIndex, int currentPage, int pageC
   FsFile f;
   if (Storage.openFileForWrite("ERS", epub->getCachePath() + "/progress.bin", f)) {
     uint8_t data[6];
-    data[0] = currentSpineIndex & 0xFF;
-    data[1] = (currentSpineIndex >> 8) & 0xFF;
+    data[0] = spineIndex & 0xFF;
+    data[1] = (spineIndex >> 8) & 0xFF;
     data[2] = currentPage & 0xFF;
     data[3] = (currentPage >> 8) & 0xFF;
     data[4] = pageCount & 0xFF;
@@ -659,6 +712,69 @@ void EpubReaderActivity::saveProgress(int spineIndex, int currentPage, int pageC
     LOG_ERR("ERS", "Could not save progress!");
   }
 }
+
+void EpubReaderActivity::requestPagePrep() {
+  const int nextPage = section->currentPage + pageDirection;
+  xSemaphoreTake(prepMutex, portMAX_DELAY);
+  pagePrep.spineIndex = currentSpineIndex;
+  pagePrep.currentPage = section->currentPage;
+  pagePrep.pageCount = section->pageCount;
+  pagePrep.nextPage = -1;
+  if (nextPage >= 0 && nextPage < section->pageCount && ESP.getFreeHeap() >= prepHeapReserve) {
+    pagePrep.nextPage = nextPage;
+  }
+  pagePrepPending = true;
+  xSemaphoreGive(prepMutex);
+  // The main loop may be waiting for a button
+  mappedInput.interruptWait();
+}
+
+void EpubReaderActivity::finishPagePrep() {
+  xSemaphoreTake(prepMutex, portMAX_DELAY);
+  if (pagePrepPending) {
+    // loop() did not get to it during the refresh; the next page will be read when it is shown
+    pagePrepPending = false;
+    saveProgress(pagePrep.spineIndex, pagePrep.currentPage, pagePrep.pageCount);
+  }
+  xSemaphoreGive(prepMutex);
+}
+
+void EpubReaderActivity::servicePagePrep() {
+  if (!pagePrepPending || !prepMutex) {
+    return;
+  }
+
+  xSemaphoreTake(prepMutex, portMAX_DELAY);
+  if (pagePrepPending) {
+    pagePrepPending = false;
+    saveProgress(pagePrep.spineIndex, pagePrep.currentPage, pagePrep.pageCount);
+    // The render task does not touch the section until it has this mutex back
+    if (pagePrep.nextPage >= 0 && section) {
+      const unsigned long start = millis();
+      preparedPage = section->loadPage(pagePrep.nextPage);
+      preparedSpineIndex = pagePrep.spineIndex;
+      preparedLayout = section->getLayout();
+      preparedPageNumber = pagePrep.nextPage;
+      if (preparedPage) {
+        LOG_DBG("ERS", "Prepared page %d during refresh in %lums", pagePrep.nextPage, millis() - start);
+      }
+    }
+  }
+  xSemaphoreGive(prepMutex);
+}
+
+std::unique_ptr<Page> EpubReaderActivity::takePreparedPage() {
+  std::unique_ptr<Page> page;
+  xSemaphoreTake(prepMutex, portMAX_DELAY);
+  if (preparedPage && preparedSpineIndex == currentSpineIndex && preparedLayout == section->getLayout() &&
+      preparedPageNumber == section->currentPage) {
+    page = std::move(preparedPage);
+  }
+  // Any other prepared page is for a turn that did not happen
+  preparedPage.reset();
+  xSemaphoreGive(prepMutex);
+  return page;
+}
 void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int orientedMarginTop,
                                         const int orientedMarginRight, const int orientedMarginBottom,
                                         const int orientedMarginLeft) {
@@ -681,14 +797,19 @@ void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int or
       // Re-render page content to restore images into the blanked area
       page->render(renderer, SETTINGS.getReaderFontId(), orientedMarginLeft, orientedMarginTop);
       renderStatusBar();
+      requestPagePrep();
       renderer.displayBuffer(HalDisplay::FAST_REFRESH);
     } else {
+      requestPagePrep();
       renderer.displayBuffer(HalDisplay::HALF_REFRESH);
     }
     // Double FAST_REFRESH handles ghosting for image pages; don't count toward full refresh cadence
   } else {
+    requestPagePrep();
     ReaderUtils::displayWithRefreshCycle(renderer, pagesUntilFullRefresh);
   }
+  // The grayscale pass reads image caches from SD, so the prep must be done first
+  finishPagePrep();
 
   // Save bw buffer to reset buffer state after grayscale data sync
   renderer.storeBwBuffer();
@@ -716,12 +837,28 @@ void EpubReaderActivity::renderContents(std::unique_ptr<Page> page, const int or
   renderer.restoreBwBuffer();
 }
 
+float EpubReaderActivity::getBookProgress(const int pagesRead) const {
+  if (!section || section->pageCount == 0) {
+    return 0.0f;
+  }
+  if (pageIndex.isComplete() && pageIndex.getTotalPages() > 0) {
+    const int page = pageIndex.getFirstPage(currentSpineIndex) + pagesRead;
+    return static_cast<float>(page) * 100.0f / static_cast<float>(pageIndex.getTotalPages());
+  }
+  const float chapterProgress = static_cast<float>(pagesRead) / static_cast<float>(section->pageCount);
+  return epub->calculateProgress(currentSpineIndex, chapterProgress) * 100.0f;
+}
+
 void EpubReaderActivity::renderStatusBar() const {
   // Calculate progress in book
-  const int currentPage = section->currentPage + 1;
-  const float pageCount = section->pageCount;
-  const float sectionChapterProg = (pageCount > 0) ? (static_cast<float>(currentPage) / pageCount) : 0;
-  const float bookProgress = epub->calculateProgress(currentSpineIndex, sectionChapterProg) * 100;
+  int currentPage = section->currentPage + 1;
+  int pageCount = section->pageCount;
+  const float chapterProgress = pageCount > 0 ? static_cast<float>(currentPage) * 100.0f / pageCount : 0.0f;
+  const float bookProgress = getBookProgress(currentPage);
+  if (pageIndex.isComplete() && pageIndex.getTotalPages() > 0) {
+    currentPage += pageIndex.getFirstPage(currentSpineIndex);
+    pageCount = pageIndex.getTotalPages();
+  }
 
   std::string title;
 
@@ -750,7 +887,7 @@ void EpubReaderActivity::renderStatusBar() const {
     title = epub->getTitle();
   }
 
-  GUI.drawStatusBar(renderer, bookProgress, currentPage, pageCount, title, 0, textYOffset);
+  GUI.drawStatusBar(renderer, bookProgress, currentPage, pageCount, title, 0, textYOffset, chapterProgress);
 }
 
 void EpubReaderActivity::navigateToHref(const std::string& hrefStr, const bool savePosition) {
@@ -1,7 +1,11 @@
 #pragma once
 #include <Epub.h>
 #include <Epub/FootnoteEntry.h>
+#include <Epub/Page.h>
+#include <Epub/PageIndex.h>
 #include <Epub/Section.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 #include "EpubReaderMenuActivity.h"
 #include "activities/Activity.h"
@@ -9,6 +13,8 @@
 class EpubReaderActivity final : public Activity {
   std::shared_ptr<Epub> epub;
   std::unique_ptr<Section> section = nullptr;
+  // Page counts of all chapters for the current layout, loaded with each section when book page numbers are enabled
+  PageIndex pageIndex;
   int currentSpineIndex = 0;
   int nextPageNumber = 0;
   // Set when navigating to a footnote href with a fragment (e.g. #note1).
@@ -27,6 +33,24 @@ class EpubReaderActivity final : public Activity {
   bool pendingScreenshot = false;
   bool skipNextButtonCheck = false;  // Skip button processing for one frame after subactivity exit
   bool automaticPageTurnActive = false;
+  int pageDirection = 1;  // direction of the last page turn, decides which neighbour is prepared
+
+  // Work handed to loop() while the render task waits for the panel refresh: save the progress of the page on screen
+  // and read the page the reader will most likely turn to next
+  struct PagePrep {
+    int spineIndex = 0;
+    int currentPage = 0;
+    int pageCount = 0;
+    int nextPage = -1;  // -1 if the next page is in another section or memory is short
+  };
+  PagePrep pagePrep;
+  volatile bool pagePrepPending = false;
+  // The page read by the last prep and where it belongs; used by the next render if it shows that page
+  std::unique_ptr<Page> preparedPage;
+  int preparedSpineIndex = -1;
+  uint32_t preparedLayout = 0;
+  int preparedPageNumber = -1;
+  SemaphoreHandle_t prepMutex = nullptr;  // guards pagePrep, pagePrepPending and the prepared page
 
   // Footnote support
   std::vector<FootnoteEntry> currentPageFootnotes;
@@ -41,7 +65,16 @@ class EpubReaderActivity final : public Activity {
   void renderContents(std::unique_ptr<Page> page, int orientedMarginTop, int orientedMarginRight,
                       int orientedMarginBottom, int orientedMarginLeft);
   void renderStatusBar() const;
+  // Percent of the book read after pagesRead pages of the current section: exact once the page index is complete,
+  // otherwise estimated from the size of each chapter
+  float getBookProgress(int pagesRead) const;
   void saveProgress(int spineIndex, int currentPage, int pageCount);
+  // Render task, around the BW refresh of a page. finishPagePrep() waits for a prep loop() already started and does
+  // the rest of one it did not get to.
+  void requestPagePrep();
+  void finishPagePrep();
+  void servicePagePrep();
+  std::unique_ptr<Page> takePreparedPage();
   // Jump to a percentage of the book (0-100), mapping it to spine and page.
   void jumpToPercent(int percent);
   void onReaderMenuConfirm(EpubReaderMenuActivity::MenuAction action);
@@ -61,4 +94,5 @@ class EpubReaderActivity final : public Activity {
   void loop() override;
   void render(RenderLock&& lock) override;
   bool isReaderActivity() const override { return true; }
+  bool isInputDriven() const override { return !automaticPageTurnActive && !pagePrepPending; }
 };
@@ -7,7 +7,7 @@
 #include "components/UITheme.h"
 #include "fontIds.h"
 
-int EpubReaderChapterSelectionActivity::getTotalItems() const { return epub->getTocItemsCount(); }
+int EpubReaderChapterSelectionActivity::getTotalItems() const { return tocItems.size(); }
 
 int EpubReaderChapterSelectionActivity::getPageItems() const {
   // Layout constants used in renderScreen
@@ -36,12 +36,25 @@ void EpubReaderChapterSelectionActivity::onEnter() {
   if (selectorIndex == -1) {
     selectorIndex = 0;
   }
+  tocItems.setSource(&tocSource);
+  showSelection();
 
   // Trigger first update
   requestUpdate();
 }
 
-void EpubReaderChapterSelectionActivity::onExit() { Activity::onExit(); }
+void EpubReaderChapterSelectionActivity::onExit() {
+  Activity::onExit();
+  tocItems.setSource(nullptr);
+}
+
+void EpubReaderChapterSelectionActivity::showSelection() {
+  const int pageItems = getPageItems();
+  if (!tocItems.covers(selectorIndex, pageItems)) {
+    RenderLock lock(*this);
+    tocItems.show(selectorIndex, pageItems);
+  }
+}
 
 void EpubReaderChapterSelectionActivity::loop() {
   const int pageItems = getPageItems();
@@ -67,21 +80,25 @@ void EpubReaderChapterSelectionActivity::loop() {
 
   buttonNavigator.onNextRelease([this, totalItems] {
     selectorIndex = ButtonNavigator::nextIndex(selectorIndex, totalItems);
+    showSelection();
     requestUpdate();
   });
 
   buttonNavigator.onPreviousRelease([this, totalItems] {
     selectorIndex = ButtonNavigator::previousIndex(selectorIndex, totalItems);
+    showSelection();
     requestUpdate();
   });
 
   buttonNavigator.onNextContinuous([this, totalItems, pageItems] {
     selectorIndex = ButtonNavigator::nextPageIndex(selectorIndex, totalItems, pageItems);
+    showSelection();
     requestUpdate();
   });
 
   buttonNavigator.onPreviousContinuous([this, totalItems, pageItems] {
     selectorIndex = ButtonNavigator::previousPageIndex(selectorIndex, totalItems, pageItems);
+    showSelection();
     requestUpdate();
   });
 }
@@ -120,7 +137,7 @@ void EpubReaderChapterSelectionActivity::render(RenderLock&&) {
     const int displayY = 60 + contentY + i * 30;
     const bool isSelected = (itemIndex == selectorIndex);
 
-    auto item = epub->getTocItem(itemIndex);
+    const auto& item = tocItems.at(itemIndex);
 
     // Indent per TOC level while keeping content within the gutter-safe region.
     const int indentSize = contentX + 20 + (item.level - 1) * 15;
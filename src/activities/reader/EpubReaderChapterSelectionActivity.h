@@ -2,13 +2,30 @@
 #include <Epub.h>
 
 #include <memory>
+#include <utility>
+#include <vector>
 
 #include "../Activity.h"
 #include "util/ButtonNavigator.h"
+#include "util/ListWindow.h"
 
 class EpubReaderChapterSelectionActivity final : public Activity {
+  // TOC entries read from the book's metadata cache a page at a time
+  class TocSource final : public ListDataSource<BookMetadataCache::TocEntry> {
+    std::shared_ptr<Epub> epub;
+
+   public:
+    explicit TocSource(std::shared_ptr<Epub> epub) : epub(std::move(epub)) {}
+    int size() const override { return epub ? epub->getTocItemsCount() : 0; }
+    bool fetch(const int first, const int count, std::vector<BookMetadataCache::TocEntry>& out) override {
+      return epub->getTocItems(first, count, out);
+    }
+  };
+
   std::shared_ptr<Epub> epub;
   std::string epubPath;
+  TocSource tocSource;
+  ListWindow<BookMetadataCache::TocEntry> tocItems;
   ButtonNavigator buttonNavigator;
   int currentSpineIndex = 0;
   int selectorIndex = 0;
@@ -20,6 +37,9 @@ class EpubReaderChapterSelectionActivity final : public Activity {
   // Total TOC items count
   int getTotalItems() const;
 
+  // Fetch the page holding the selection before it is rendered
+  void showSelection();
+
  public:
   explicit EpubReaderChapterSelectionActivity(GfxRenderer& renderer, MappedInputManager& mappedInput,
                                               const std::shared_ptr<Epub>& epub, const std::string& epubPath,
@@ -27,6 +47,7 @@ class EpubReaderChapterSelectionActivity final : public Activity {
       : Activity("EpubReaderChapterSelection", renderer, mappedInput),
         epub(epub),
         epubPath(epubPath),
+        tocSource(epub),
         currentSpineIndex(currentSpineIndex) {}
   void onEnter() override;
   void onExit() override;
@@ -1,13 +1,21 @@
 #include "TxtReaderActivity.h"
 
+#include <BufferedIO.h>
 #include <GfxRenderer.h>
 #include <HalStorage.h>
+#include <HeapTrace.h>
 #include <I18n.h>
-#include <Serialization.h>
+#include <PerfTrace.h>
+#include <TxtLineWrapper.h>
 #include <Utf8.h>
 
+#include <algorithm>
+
+#include "CacheBudget.h"
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
+#include "EpubReaderPercentSelectionActivity.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "ReaderUtils.h"
 #include "RecentBooksStore.h"
@@ -18,7 +26,19 @@ namespace {
 constexpr size_t CHUNK_SIZE = 8 * 1024;  // 8KB chunk for reading
 // Cache file magic and version
 constexpr uint32_t CACHE_MAGIC = 0x54585449;  // "TXTI"
-constexpr uint8_t CACHE_VERSION = 2;          // Increment when cache format changes
+constexpr uint8_t CACHE_VERSION = 4;          // Increment when cache format changes
+// Background indexing reads two chunks at a time so consecutive pages are laid out from one read
+constexpr size_t INDEX_BUFFER_SIZE = 2 * CHUNK_SIZE;
+constexpr unsigned long INDEX_SLICE_MS = 30;      // Time spent indexing per idle loop iteration
+constexpr size_t INDEX_SAVE_INTERVAL_PAGES = 256;  // Write the partial index after this many new pages
+
+// Moves a byte offset forward to the start of a UTF-8 sequence
+size_t utf8Boundary(const uint8_t* buffer, const size_t len, size_t pos) {
+  while (pos < len && (buffer[pos] & 0xC0) == 0x80) {
+    pos++;
+  }
+  return pos;
+}
 }  // namespace
 
 void TxtReaderActivity::onEnter() {
@@ -31,6 +51,8 @@ void TxtReaderActivity::onEnter() {
   ReaderUtils::applyOrientation(renderer, SETTINGS.orientation);
 
   txt->setupCacheDir();
+  CACHE_BUDGET.touch(txt->getCachePath());
+  prepMutex = xSemaphoreCreateMutex();
 
   // Save current txt as last opened file and add to recent books
   auto filePath = txt->getPath();
@@ -49,14 +71,31 @@ void TxtReaderActivity::onExit() {
   // Reset orientation back to portrait for the rest of the UI
   renderer.setOrientation(GfxRenderer::Orientation::Portrait);
 
+  // Keep whatever was indexed so the next open resumes from there
+  if (txt && initialized && indexDirty) {
+    savePageIndexCache();
+  }
+  // Progress shown next to the file in the file browser
+  if (txt && initialized && txt->getFileSize() > 0) {
+    const uint64_t size = txt->getFileSize();
+    LIBRARY_INDEX.updateProgress(txt->getPath(), (static_cast<uint64_t>(currentOffset) * 100 + size / 2) / size);
+  }
   pageOffsets.clear();
   currentPageLines.clear();
+  preparedLines.clear();
+  if (prepMutex) {
+    vSemaphoreDelete(prepMutex);
+    prepMutex = nullptr;
+  }
   APP_STATE.readerActivityLoadCount = 0;
   APP_STATE.saveToFile();
   txt.reset();
 }
 
 void TxtReaderActivity::loop() {
+  // The render task hands over work while it waits for the panel refresh
+  servicePagePrep();
+
   // Long press BACK (1s+) goes to file selection
   if (mappedInput.isPressed(MappedInputManager::Button::Back) && mappedInput.getHeldTime() >= ReaderUtils::GO_HOME_MS) {
     activityManager.goToFileBrowser(txt ? txt->getPath() : "");
@@ -70,16 +109,38 @@ void TxtReaderActivity::loop() {
     return;
   }
 
+  // The first render lays out the viewport and loads the index
+  if (!initialized) {
+    return;
+  }
+
+  if (mappedInput.wasReleased(MappedInputManager::Button::Confirm) && txt->getFileSize() > 0) {
+    const int initialPercent = static_cast<int>(static_cast<uint64_t>(currentOffset) * 100 / txt->getFileSize());
+    startActivityForResult(std::make_unique<EpubReaderPercentSelectionActivity>(renderer, mappedInput, initialPercent),
+                           [this](const ActivityResult& result) {
+                             if (!result.isCancelled) {
+                               jumpToPercent(std::get<PercentResult>(result.data).percent);
+                             }
+                             requestUpdate();
+                           });
+    return;
+  }
+
   auto [prevTriggered, nextTriggered] = ReaderUtils::detectPageTurn(mappedInput);
   if (!prevTriggered && !nextTriggered) {
+    indexWhileIdle();
     return;
   }
 
-  if (prevTriggered && currentPage > 0) {
-    currentPage--;
+  // Page layout shares the font caches with render
+  RenderLock lock(*this);
+  if (prevTriggered && currentOffset > 0) {
+    pageDirection = -1;
+    setPosition(previousPageOffset());
     requestUpdate();
-  } else if (nextTriggered && currentPage < totalPages - 1) {
-    currentPage++;
+  } else if (nextTriggered && nextPageOffset > currentOffset && nextPageOffset < txt->getFileSize()) {
+    pageDirection = 1;
+    setPosition(nextPageOffset);
     requestUpdate();
   }
 }
@@ -112,12 +173,11 @@ void TxtReaderActivity::initializeReader() {
 
   LOG_DBG("TRS", "Viewport: %dx%d, lines per page: %d", viewportWidth, viewportHeight, linesPerPage);
 
-  // Try to load cached page index first
+  // Resume the saved (possibly partial) page index; the rest is built while the reader is idle
   if (!loadPageIndexCache()) {
-    // Cache not found, build page index
-    buildPageIndex();
-    // Save to cache for next time
-    savePageIndexCache();
+    pageOffsets.assign(1, 0);
+    indexComplete = false;
+    savedPageCount = 0;
   }
 
   // Load saved progress
@@ -126,33 +186,52 @@ void TxtReaderActivity::initializeReader() {
   initialized = true;
 }
 
-void TxtReaderActivity::buildPageIndex() {
-  pageOffsets.clear();
-  pageOffsets.push_back(0);  // First page starts at offset 0
+bool TxtReaderActivity::extendPageIndex(const size_t targetPages, const unsigned long timeBudgetMs) {
+  if (indexComplete) {
+    return false;
+  }
 
-  size_t offset = 0;
   const size_t fileSize = txt->getFileSize();
+  auto* buffer = static_cast<uint8_t*>(malloc(INDEX_BUFFER_SIZE));
+  if (!buffer) {
+    LOG_ERR("TRS", "Failed to allocate %zu bytes", INDEX_BUFFER_SIZE);
+    return false;
+  }
 
-  LOG_DBG("TRS", "Building page index for %zu bytes...", fileSize);
-
-  GUI.drawPopup(renderer, tr(STR_INDEXING));
-
-  while (offset < fileSize) {
-    std::vector<std::string> tempLines;
-    size_t nextOffset = offset;
+  const unsigned long startTime = millis();
+  const size_t pagesBefore = pageOffsets.size();
+  size_t bufferStart = 0;
+  size_t bufferLen = 0;
 
-    if (!loadPageAtOffset(offset, tempLines, nextOffset)) {
+  while (!indexComplete && pageOffsets.size() < targetPages) {
+    if (timeBudgetMs > 0 && millis() - startTime >= timeBudgetMs) {
       break;
     }
 
-    if (nextOffset <= offset) {
-      // No progress made, avoid infinite loop
+    // Lay out the page from the same bytes loadPageAtOffset would read, so page breaks match rendering
+    const size_t offset = pageOffsets.back();
+    const size_t pageLen = std::min(CHUNK_SIZE, fileSize - offset);
+    if (offset < bufferStart || offset + pageLen > bufferStart + bufferLen) {
+      bufferStart = offset;
+      bufferLen = std::min(INDEX_BUFFER_SIZE, fileSize - offset);
+      if (!txt->readContent(buffer, bufferStart, bufferLen)) {
+        LOG_ERR("TRS", "Failed to read %zu bytes at %zu while indexing", bufferLen, bufferStart);
+        indexFailed = true;
+        break;
+      }
+    }
+
+    size_t nextOffset;
+    if (!layoutPage(buffer + (offset - bufferStart), pageLen, offset, nullptr, nextOffset) || nextOffset <= offset) {
+      // No progress made, treat the rest of the file as the end of the book
+      indexComplete = true;
       break;
     }
 
-    offset = nextOffset;
-    if (offset < fileSize) {
-      pageOffsets.push_back(offset);
+    if (nextOffset < fileSize) {
+      pageOffsets.push_back(nextOffset);
+    } else {
+      indexComplete = true;
     }
 
     // Yield to other tasks periodically
@@ -161,12 +240,151 @@ void TxtReaderActivity::buildPageIndex() {
     }
   }
 
-  totalPages = pageOffsets.size();
-  LOG_DBG("TRS", "Built page index: %d pages", totalPages);
+  free(buffer);
+
+  if (pageOffsets.size() != pagesBefore || indexComplete) {
+    indexDirty = true;
+  }
+  if (indexComplete) {
+    LOG_DBG("TRS", "Built page index: %zu pages", pageOffsets.size());
+  }
+  return pageOffsets.size() != pagesBefore;
+}
+
+void TxtReaderActivity::indexWhileIdle() {
+  if (indexComplete || indexFailed) {
+    return;
+  }
+
+  RenderLock lock(*this);
+  extendPageIndex(SIZE_MAX, INDEX_SLICE_MS);
+
+  // Snap to the index once it reaches a position that was opened ahead of it
+  if (currentPage < 0) {
+    currentPage = pageAtOffset(currentOffset);
+  }
+
+  if (indexDirty && (indexComplete || pageOffsets.size() >= savedPageCount + INDEX_SAVE_INTERVAL_PAGES)) {
+    savePageIndexCache();
+  }
+}
+
+int TxtReaderActivity::pageAtOffset(const size_t offset) const {
+  const auto it = std::lower_bound(pageOffsets.begin(), pageOffsets.end(), offset);
+  if (it == pageOffsets.end() || *it != offset) {
+    return -1;
+  }
+  return static_cast<int>(it - pageOffsets.begin());
+}
+
+void TxtReaderActivity::setPosition(const size_t offset) {
+  currentOffset = offset;
+  currentPage = pageAtOffset(offset);
+}
+
+size_t TxtReaderActivity::previousPageOffset() {
+  if (currentPage > 0) {
+    return pageOffsets[currentPage - 1];
+  }
+
+  // Inside the indexed range: the indexed page holding the text just before the current position
+  if (indexComplete || currentOffset <= pageOffsets.back()) {
+    const auto it = std::lower_bound(pageOffsets.begin(), pageOffsets.end(), currentOffset);
+    return *(it - 1);
+  }
+
+  // Ahead of the index: lay pages out from a line start up to a chunk back and take the last one starting before the
+  // current position. The end of the index is used as the starting point when it is that close, which keeps the
+  // breaks identical to the ones indexing will find.
+  const size_t fileSize = txt->getFileSize();
+  size_t start = std::max(currentOffset > CHUNK_SIZE ? currentOffset - CHUNK_SIZE : 0, pageOffsets.back());
+  const size_t bufferLen = std::min(INDEX_BUFFER_SIZE, fileSize - start);
+  auto* buffer = static_cast<uint8_t*>(malloc(bufferLen));
+  if (!buffer) {
+    LOG_ERR("TRS", "Failed to allocate %zu bytes", bufferLen);
+    return currentOffset;
+  }
+  if (!txt->readContent(buffer, start, bufferLen)) {
+    free(buffer);
+    return currentOffset;
+  }
+
+  const size_t windowStart = start;
+  if (start != pageOffsets.back()) {
+    const size_t windowLen = currentOffset - start;
+    const auto* newline = static_cast<const uint8_t*>(memchr(buffer, '\n', windowLen));
+    if (newline && static_cast<size_t>(newline - buffer) + 1 < windowLen) {
+      start += newline - buffer + 1;
+    } else {
+      start += utf8Boundary(buffer, windowLen, 0);
+    }
+  }
+
+  size_t pageStart = start;
+  while (true) {
+    const size_t pageLen = std::min(CHUNK_SIZE, fileSize - pageStart);
+    size_t nextOffset;
+    if (!layoutPage(buffer + (pageStart - windowStart), pageLen, pageStart, nullptr, nextOffset) ||
+        nextOffset <= pageStart || nextOffset >= currentOffset) {
+      break;
+    }
+    pageStart = nextOffset;
+  }
+
+  free(buffer);
+  return pageStart;
+}
+
+size_t TxtReaderActivity::lineStartNear(const size_t offset) {
+  const size_t fileSize = txt->getFileSize();
+  const size_t len = std::min(CHUNK_SIZE, fileSize - offset);
+  auto* buffer = static_cast<uint8_t*>(malloc(len));
+  if (!buffer) {
+    LOG_ERR("TRS", "Failed to allocate %zu bytes", len);
+    return offset;
+  }
+  if (!txt->readContent(buffer, offset, len)) {
+    free(buffer);
+    return offset;
+  }
+
+  // Prefer the start of the next source line; very long lines fall back to the next character
+  size_t pos;
+  const auto* newline = static_cast<const uint8_t*>(memchr(buffer, '\n', len));
+  if (newline && offset + (newline - buffer) + 1 < fileSize) {
+    pos = newline - buffer + 1;
+  } else {
+    pos = utf8Boundary(buffer, len, 0);
+  }
+  free(buffer);
+  return std::min(offset + pos, fileSize - 1);
+}
+
+void TxtReaderActivity::jumpToPercent(int percent) {
+  const size_t fileSize = txt->getFileSize();
+  if (fileSize == 0) {
+    return;
+  }
+
+  percent = std::max(0, std::min(100, percent));
+  const size_t target = std::min(static_cast<size_t>(static_cast<uint64_t>(fileSize) * percent / 100), fileSize - 1);
+
+  RenderLock lock(*this);
+  if (indexComplete || target <= pageOffsets.back()) {
+    // Indexed: go to the page that holds the target byte
+    const auto it = std::upper_bound(pageOffsets.begin(), pageOffsets.end(), target);
+    setPosition(*(it - 1));
+  } else {
+    // Not indexed yet: start at the next line boundary and page from there until indexing catches up
+    setPosition(target == 0 ? 0 : lineStartNear(target));
+  }
+  LOG_DBG("TRS", "Jumped to %d%% (offset %zu, page %d)", percent, currentOffset, currentPage);
 }
 
 bool TxtReaderActivity::loadPageAtOffset(size_t offset, std::vector<std::string>& outLines, size_t& nextOffset) {
+  PERF_SCOPE(PAGE_LOAD);
   outLines.clear();
+  nextOffset = offset;
   const size_t fileSize = txt->getFileSize();
 
   if (offset >= fileSize) {
@@ -187,10 +405,30 @@ bool TxtReaderActivity::loadPageAtOffset(size_t offset, std::vector<std::string>
   }
   buffer[chunkSize] = '\0';
 
+  const bool hasLines = layoutPage(buffer, chunkSize, offset, &outLines, nextOffset);
+  free(buffer);
+  return hasLines;
+}
+
+bool TxtReaderActivity::layoutPage(const uint8_t* buffer, const size_t chunkSize, const size_t offset,
+                                   std::vector<std::string>* outLines, size_t& nextOffset) {
+  PERF_SCOPE(LAYOUT);
+  HEAP_SCOPE(LAYOUT);
+  const size_t fileSize = txt->getFileSize();
+
   // Parse lines from buffer
   size_t pos = 0;
+  int lineCount = 0;
 
-  while (pos < chunkSize && static_cast<int>(outLines.size()) < linesPerPage) {
+  std::string word;
+  TxtLineWrapper wrapper(
+      [this, &word](const char* text, const size_t len) {
+        word.assign(text, len);
+        return renderer.getTextAdvanceX(cachedFontId, word.c_str(), EpdFontFamily::REGULAR);
+      },
+      renderer.getSpaceWidth(cachedFontId), viewportWidth);
+
+  while (pos < chunkSize && lineCount < linesPerPage) {
     // Find end of line
     size_t lineEnd = pos;
     while (lineEnd < chunkSize && buffer[lineEnd] != '\n') {
@@ -200,7 +438,7 @@ bool TxtReaderActivity::loadPageAtOffset(size_t offset, std::vector<std::string>
     // Check if we have a complete line
     bool lineComplete = (lineEnd < chunkSize) || (offset + lineEnd >= fileSize);
 
-    if (!lineComplete && static_cast<int>(outLines.size()) > 0) {
+    if (!lineComplete && lineCount > 0) {
       // Incomplete line and we already have some lines, stop here
       break;
     }
@@ -212,57 +450,25 @@ bool TxtReaderActivity::loadPageAtOffset(size_t offset, std::vector<std::string>
     bool hasCR = (lineContentLen > 0 && buffer[pos + lineContentLen - 1] == '\r');
     size_t displayLen = hasCR ? lineContentLen - 1 : lineContentLen;
 
-    // Extract line content for display (without CR/LF)
-    std::string line(reinterpret_cast<char*>(buffer + pos), displayLen);
+    // Line content for display (without CR/LF)
+    const char* line = reinterpret_cast<const char*>(buffer + pos);
 
     // Track position within this source line (in bytes from pos)
     size_t lineBytePos = 0;
 
-    // Word wrap if needed
-    while (!line.empty() && static_cast<int>(outLines.size()) < linesPerPage) {
-      int lineWidth = renderer.getTextWidth(cachedFontId, line.c_str());
-
-      if (lineWidth <= viewportWidth) {
-        outLines.push_back(line);
-        lineBytePos = displayLen;  // Consumed entire display content
-        line.clear();
-        break;
-      }
-
-      // Find break point
-      size_t breakPos = line.length();
-      while (breakPos > 0 && renderer.getTextWidth(cachedFontId, line.substr(0, breakPos).c_str()) > viewportWidth) {
-        // Try to break at space
-        size_t spacePos = line.rfind(' ', breakPos - 1);
-        if (spacePos != std::string::npos && spacePos > 0) {
-          breakPos = spacePos;
-        } else {
-          // Break at character boundary for UTF-8
-          breakPos--;
-          // Make sure we don't break in the middle of a UTF-8 sequence
-          while (breakPos > 0 && (line[breakPos] & 0xC0) == 0x80) {
-            breakPos--;
-          }
-        }
-      }
-
-      if (breakPos == 0) {
-        breakPos = 1;
-      }
-
-      outLines.push_back(line.substr(0, breakPos));
-
-      // Skip space at break point
-      size_t skipChars = breakPos;
-      if (breakPos < line.length() && line[breakPos] == ' ') {
-        skipChars++;
+    // Word wrap if needed; indexing only needs the byte counts
+    while (lineBytePos < displayLen && lineCount < linesPerPage) {
+      size_t shownLen;
+      const size_t consumed = wrapper.nextLine(line + lineBytePos, displayLen - lineBytePos, shownLen);
+      if (outLines) {
+        outLines->emplace_back(line + lineBytePos, shownLen);
       }
-      lineBytePos += skipChars;
-      line = line.substr(skipChars);
+      lineCount++;
+      lineBytePos += consumed;
     }
 
     // Determine how much of the source buffer we consumed
-    if (line.empty()) {
+    if (lineBytePos >= displayLen) {
       // Fully consumed this source line, move past the newline
       pos = lineEnd + 1;
     } else {
@@ -274,7 +480,7 @@ bool TxtReaderActivity::loadPageAtOffset(size_t offset, std::vector<std::string>
   }
 
   // Ensure we make progress even if calculations go wrong
-  if (pos == 0 && !outLines.empty()) {
+  if (pos == 0 && lineCount > 0) {
     // Fallback: at minimum, consume something to avoid infinite loop
     pos = 1;
   }
@@ -286,9 +492,7 @@ bool TxtReaderActivity::loadPageAtOffset(size_t offset, std::vector<std::string>
     nextOffset = fileSize;
   }
 
-  free(buffer);
-
-  return !outLines.empty();
+  return lineCount > 0;
 }
 
 void TxtReaderActivity::render(RenderLock&&) {
@@ -301,29 +505,21 @@ void TxtReaderActivity::render(RenderLock&&) {
     initializeReader();
   }
 
-  if (pageOffsets.empty()) {
+  if (txt->getFileSize() == 0) {
     renderer.clearScreen();
     renderer.drawCenteredText(UI_12_FONT_ID, 300, tr(STR_EMPTY_FILE), true, EpdFontFamily::BOLD);
     renderer.displayBuffer();
     return;
   }
 
-  // Bounds check
-  if (currentPage < 0) currentPage = 0;
-  if (currentPage >= totalPages) currentPage = totalPages - 1;
-
-  // Load current page content
-  size_t offset = pageOffsets[currentPage];
-  size_t nextOffset;
-  currentPageLines.clear();
-  loadPageAtOffset(offset, currentPageLines, nextOffset);
+  // Load current page content, unless it was laid out during the last refresh
+  if (!takePreparedPage()) {
+    loadPageAtOffset(currentOffset, currentPageLines, nextPageOffset);
+  }
 
   renderer.clearScreen();
   renderPage();
   renderer.clearFontCache();
-
-  // Save progress
-  saveProgress();
 }
 
 void TxtReaderActivity::renderPage() {
@@ -332,6 +528,7 @@ void TxtReaderActivity::renderPage() {
 
   // Render text lines with alignment
   auto renderLines = [&]() {
+    PERF_SCOPE(RENDER_PASS);
     int y = cachedOrientedMarginTop;
     for (const auto& line : currentPageLines) {
       if (!line.empty()) {
@@ -369,51 +566,149 @@ void TxtReaderActivity::renderPage() {
   renderLines();
   renderStatusBar();
 
+  requestPagePrep();
   ReaderUtils::displayWithRefreshCycle(renderer, pagesUntilFullRefresh);
+  // Layout shares the font caches with the grayscale pass
+  finishPagePrep();
 
   if (SETTINGS.textAntiAliasing) {
     ReaderUtils::renderAntiAliased(renderer, [&renderLines]() { renderLines(); });
   }
 }
 
+size_t TxtReaderActivity::estimatedTotalPages() const {
+  const size_t indexedPages = pageOffsets.size() - 1;
+  if (indexComplete || indexedPages == 0) {
+    return pageOffsets.size();
+  }
+  // Extrapolate from the pages indexed so far
+  const size_t estimate = static_cast<uint64_t>(txt->getFileSize()) * indexedPages / pageOffsets.back();
+  return std::max(estimate, pageOffsets.size());
+}
+
 void TxtReaderActivity::renderStatusBar() const {
-  const float progress = totalPages > 0 ? (currentPage + 1) * 100.0f / totalPages : 0;
+  const size_t fileSize = txt->getFileSize();
+  const int totalPages = static_cast<int>(estimatedTotalPages());
+  int pageNumber;
+  float progress;
+  if (currentPage >= 0 && indexComplete) {
+    pageNumber = currentPage + 1;
+    progress = pageNumber * 100.0f / totalPages;
+  } else {
+    // Page numbers are estimates until the index covers the book; progress follows the byte position
+    pageNumber = currentPage >= 0 ? currentPage + 1
+                                  : 1 + static_cast<int>(static_cast<uint64_t>(currentOffset) * totalPages / fileSize);
+    pageNumber = std::min(pageNumber, totalPages);
+    progress = fileSize > 0 ? nextPageOffset * 100.0f / fileSize : 0;
+  }
   std::string title;
   if (SETTINGS.statusBarTitle != CrossPointSettings::STATUS_BAR_TITLE::HIDE_TITLE) {
     title = txt->getTitle();
   }
-  GUI.drawStatusBar(renderer, progress, currentPage + 1, totalPages, title);
+  GUI.drawStatusBar(renderer, progress, pageNumber, totalPages, title);
 }
 
 void TxtReaderActivity::saveProgress() const {
   FsFile f;
   if (Storage.openFileForWrite("TRS", txt->getCachePath() + "/progress.bin", f)) {
-    uint8_t data[4];
-    data[0] = currentPage & 0xFF;
-    data[1] = (currentPage >> 8) & 0xFF;
+    // Page number (kept for older versions) followed by the byte offset of the page
+    const int page = std::max(currentPage, 0);
+    uint8_t data[8];
+    data[0] = page & 0xFF;
+    data[1] = (page >> 8) & 0xFF;
     data[2] = 0;
     data[3] = 0;
-    f.write(data, 4);
+    data[4] = currentOffset & 0xFF;
+    data[5] = (currentOffset >> 8) & 0xFF;
+    data[6] = (currentOffset >> 16) & 0xFF;
+    data[7] = (currentOffset >> 24) & 0xFF;
+    f.write(data, 8);
     f.close();
   }
 }
 
+void TxtReaderActivity::requestPagePrep() {
+  xSemaphoreTake(prepMutex, portMAX_DELAY);
+  prepOffset = NO_OFFSET;
+  if (pageDirection > 0 && nextPageOffset > currentOffset && nextPageOffset < txt->getFileSize()) {
+    prepOffset = nextPageOffset;
+  } else if (pageDirection < 0 && currentPage > 0) {
+    prepOffset = pageOffsets[currentPage - 1];
+  }
+  pagePrepPending = true;
+  xSemaphoreGive(prepMutex);
+  // The main loop may be waiting for a button
+  mappedInput.interruptWait();
+}
+
+void TxtReaderActivity::finishPagePrep() {
+  xSemaphoreTake(prepMutex, portMAX_DELAY);
+  if (pagePrepPending) {
+    // loop() did not get to it during the refresh; the next page will be laid out when it is shown
+    pagePrepPending = false;
+    saveProgress();
+  }
+  xSemaphoreGive(prepMutex);
+}
+
+void TxtReaderActivity::servicePagePrep() {
+  if (!pagePrepPending || !prepMutex) {
+    return;
+  }
+
+  xSemaphoreTake(prepMutex, portMAX_DELAY);
+  if (pagePrepPending) {
+    pagePrepPending = false;
+    saveProgress();
+    if (prepOffset != NO_OFFSET) {
+      const unsigned long start = millis();
+      preparedOffset = loadPageAtOffset(prepOffset, preparedLines, preparedNextOffset) ? prepOffset : NO_OFFSET;
+      if (preparedOffset != NO_OFFSET) {
+        LOG_DBG("TRS", "Prepared page at %zu during refresh in %lums", prepOffset, millis() - start);
+      }
+    }
+  }
+  xSemaphoreGive(prepMutex);
+}
+
+bool TxtReaderActivity::takePreparedPage() {
+  xSemaphoreTake(prepMutex, portMAX_DELAY);
+  const bool prepared = preparedOffset != NO_OFFSET && preparedOffset == currentOffset;
+  if (prepared) {
+    currentPageLines.swap(preparedLines);
+    nextPageOffset = preparedNextOffset;
+  }
+  // Any other prepared page is for a turn that did not happen
+  preparedLines.clear();
+  preparedOffset = NO_OFFSET;
+  xSemaphoreGive(prepMutex);
+  return prepared;
+}
+
 void TxtReaderActivity::loadProgress() {
   FsFile f;
-  if (Storage.openFileForRead("TRS", txt->getCachePath() + "/progress.bin", f)) {
-    uint8_t data[4];
-    if (f.read(data, 4) == 4) {
-      currentPage = data[0] + (data[1] << 8);
-      if (currentPage >= totalPages) {
-        currentPage = totalPages - 1;
-      }
-      if (currentPage < 0) {
-        currentPage = 0;
-      }
-      LOG_DBG("TRS", "Loaded progress: page %d/%d", currentPage, totalPages);
+  if (!Storage.openFileForRead("TRS", txt->getCachePath() + "/progress.bin", f)) {
+    return;
+  }
+
+  uint8_t data[8];
+  const size_t bytesRead = f.read(data, 8);
+  f.close();
+
+  const size_t fileSize = txt->getFileSize();
+  if (bytesRead == 8) {
+    const size_t offset = data[4] | (data[5] << 8) | (data[6] << 16) | (static_cast<uint32_t>(data[7]) << 24);
+    setPosition(offset < fileSize ? offset : 0);
+  } else if (bytesRead == 4) {
+    // Progress from before offsets were stored: index up to the saved page once
+    const size_t page = data[0] + (data[1] << 8);
+    if (page >= pageOffsets.size() && !indexComplete) {
+      GUI.drawPopup(renderer, tr(STR_INDEXING));
+      extendPageIndex(page + 1, 0);
     }
-    f.close();
+    setPosition(pageOffsets[std::min(page, pageOffsets.size() - 1)]);
   }
+  LOG_DBG("TRS", "Loaded progress: offset %zu, page %d", currentOffset, currentPage);
 }
 
 bool TxtReaderActivity::loadPageIndexCache() {
@@ -426,8 +721,9 @@ bool TxtReaderActivity::loadPageIndexCache() {
   // - int32_t: font ID (to invalidate cache on font change)
   // - int32_t: screen margin (to invalidate cache on margin change)
   // - uint8_t: paragraph alignment (to invalidate cache on alignment change)
+  // - uint8_t: 1 if the index covers the whole file, 0 if indexing was interrupted
   // - uint32_t: total pages count
-  // - N * uint32_t: page offsets
+  // - N * uint32_t: page offsets (for a partial index, the last one is the next page to lay out)
 
   std::string cachePath = txt->getCachePath() + "/index.bin";
   FsFile f;
@@ -435,10 +731,11 @@ bool TxtReaderActivity::loadPageIndexCache() {
     LOG_DBG("TRS", "No page index cache found");
     return false;
   }
+  serialization::BufferedReader reader(f);
 
   // Read and validate header using serialization module
   uint32_t magic;
-  serialization::readPod(f, magic);
+  serialization::readPod(reader, magic);
   if (magic != CACHE_MAGIC) {
     LOG_DBG("TRS", "Cache magic mismatch, rebuilding");
     f.close();
@@ -446,7 +743,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   uint8_t version;
-  serialization::readPod(f, version);
+  serialization::readPod(reader, version);
   if (version != CACHE_VERSION) {
     LOG_DBG("TRS", "Cache version mismatch (%d != %d), rebuilding", version, CACHE_VERSION);
     f.close();
@@ -454,7 +751,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   uint32_t fileSize;
-  serialization::readPod(f, fileSize);
+  serialization::readPod(reader, fileSize);
   if (fileSize != txt->getFileSize()) {
     LOG_DBG("TRS", "Cache file size mismatch, rebuilding");
     f.close();
@@ -462,7 +759,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   int32_t cachedWidth;
-  serialization::readPod(f, cachedWidth);
+  serialization::readPod(reader, cachedWidth);
   if (cachedWidth != viewportWidth) {
     LOG_DBG("TRS", "Cache viewport width mismatch, rebuilding");
     f.close();
@@ -470,7 +767,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   int32_t cachedLines;
-  serialization::readPod(f, cachedLines);
+  serialization::readPod(reader, cachedLines);
   if (cachedLines != linesPerPage) {
     LOG_DBG("TRS", "Cache lines per page mismatch, rebuilding");
     f.close();
@@ -478,7 +775,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   int32_t fontId;
-  serialization::readPod(f, fontId);
+  serialization::readPod(reader, fontId);
   if (fontId != cachedFontId) {
     LOG_DBG("TRS", "Cache font ID mismatch (%d != %d), rebuilding", fontId, cachedFontId);
     f.close();
@@ -486,7 +783,7 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   int32_t margin;
-  serialization::readPod(f, margin);
+  serialization::readPod(reader, margin);
   if (margin != cachedScreenMargin) {
     LOG_DBG("TRS", "Cache screen margin mismatch, rebuilding");
     f.close();
@@ -494,15 +791,23 @@ bool TxtReaderActivity::loadPageIndexCache() {
   }
 
   uint8_t alignment;
-  serialization::readPod(f, alignment);
+  serialization::readPod(reader, alignment);
   if (alignment != cachedParagraphAlignment) {
     LOG_DBG("TRS", "Cache paragraph alignment mismatch, rebuilding");
     f.close();
     return false;
   }
 
+  uint8_t complete;
+  serialization::readPod(reader, complete);
+
   uint32_t numPages;
-  serialization::readPod(f, numPages);
+  serialization::readPod(reader, numPages);
+  if (numPages == 0 || numPages > reader.remaining() / sizeof(uint32_t)) {
+    LOG_DBG("TRS", "Cache page count invalid, rebuilding");
+    f.close();
+    return false;
+  }
 
   // Read page offsets
   pageOffsets.clear();
@@ -510,40 +815,56 @@ bool TxtReaderActivity::loadPageIndexCache() {
 
   for (uint32_t i = 0; i < numPages; i++) {
     uint32_t offset;
-    serialization::readPod(f, offset);
+    serialization::readPod(reader, offset);
     pageOffsets.push_back(offset);
   }
 
   f.close();
-  totalPages = pageOffsets.size();
-  LOG_DBG("TRS", "Loaded page index cache: %d pages", totalPages);
+  if (!reader.ok()) {
+    LOG_DBG("TRS", "Cache truncated, rebuilding");
+    return false;
+  }
+
+  indexComplete = complete != 0;
+  indexDirty = false;
+  savedPageCount = pageOffsets.size();
+  LOG_DBG("TRS", "Loaded %s page index cache: %zu pages", indexComplete ? "complete" : "partial", pageOffsets.size());
   return true;
 }
 
-void TxtReaderActivity::savePageIndexCache() const {
+void TxtReaderActivity::savePageIndexCache() {
   std::string cachePath = txt->getCachePath() + "/index.bin";
   FsFile f;
   if (!Storage.openFileForWrite("TRS", cachePath, f)) {
     LOG_ERR("TRS", "Failed to save page index cache");
     return;
   }
+  serialization::BufferedWriter writer(f);
 
   // Write header using serialization module
-  serialization::writePod(f, CACHE_MAGIC);
-  serialization::writePod(f, CACHE_VERSION);
-  serialization::writePod(f, static_cast<uint32_t>(txt->getFileSize()));
-  serialization::writePod(f, static_cast<int32_t>(viewportWidth));
-  serialization::writePod(f, static_cast<int32_t>(linesPerPage));
-  serialization::writePod(f, static_cast<int32_t>(cachedFontId));
-  serialization::writePod(f, static_cast<int32_t>(cachedScreenMargin));
-  serialization::writePod(f, cachedParagraphAlignment);
-  serialization::writePod(f, static_cast<uint32_t>(pageOffsets.size()));
+  serialization::writePod(writer, CACHE_MAGIC);
+  serialization::writePod(writer, CACHE_VERSION);
+  serialization::writePod(writer, static_cast<uint32_t>(txt->getFileSize()));
+  serialization::writePod(writer, static_cast<int32_t>(viewportWidth));
+  serialization::writePod(writer, static_cast<int32_t>(linesPerPage));
+  serialization::writePod(writer, static_cast<int32_t>(cachedFontId));
+  serialization::writePod(writer, static_cast<int32_t>(cachedScreenMargin));
+  serialization::writePod(writer, cachedParagraphAlignment);
+  serialization::writePod(writer, static_cast<uint8_t>(indexComplete ? 1 : 0));
+  serialization::writePod(writer, static_cast<uint32_t>(pageOffsets.size()));
 
   // Write page offsets
   for (size_t offset : pageOffsets) {
-    serialization::writePod(f, static_cast<uint32_t>(offset));
+    serialization::writePod(writer, static_cast<uint32_t>(offset));
   }
 
+  const bool ok = writer.flush();
   f.close();
-  LOG_DBG("TRS", "Saved page index cache: %d pages", totalPages);
+  if (!ok) {
+    LOG_ERR("TRS", "Failed to write page index cache");
+    return;
+  }
+  indexDirty = false;
+  savedPageCount = pageOffsets.size();
+  LOG_DBG("TRS", "Saved %s page index cache: %zu pages", indexComplete ? "complete" : "partial", pageOffsets.size());
 }
@@ -1,6 +1,8 @@
 #pragma once
 
 #include <Txt.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 #include <vector>
 
@@ -10,16 +12,35 @@
 class TxtReaderActivity final : public Activity {
   std::unique_ptr<Txt> txt;
 
+  // Reading position. currentOffset is always valid; currentPage is -1 while the position is not an indexed page
+  // start (after a percent jump, or until indexing catches up with the saved position).
+  size_t currentOffset = 0;
   int currentPage = 0;
-  int totalPages = 1;
+  size_t nextPageOffset = 0;  // Start of the page after the one on screen
   int pagesUntilFullRefresh = 0;
 
-  // Streaming text reader - stores file offsets for each page
+  // Streaming text reader - stores file offsets for each page. The index is built from the start of the file in
+  // slices while the reader is idle; until it is complete, the last entry is the first page not laid out yet.
   std::vector<size_t> pageOffsets;  // File offset for start of each page
+  bool indexComplete = false;
+  bool indexDirty = false;    // Pages added since the index file was last written
+  bool indexFailed = false;   // Stop indexing for this session after a read error
+  size_t savedPageCount = 0;  // Entries in the index file on SD
   std::vector<std::string> currentPageLines;
   int linesPerPage = 0;
   int viewportWidth = 0;
   bool initialized = false;
+  int pageDirection = 1;  // direction of the last page turn, decides which neighbour is prepared
+
+  // Work handed to loop() while the render task waits for the panel refresh: save the progress and lay out the page
+  // the reader will most likely turn to next, so the next render can skip the SD read and the line wrapping
+  static constexpr size_t NO_OFFSET = SIZE_MAX;
+  volatile bool pagePrepPending = false;
+  size_t prepOffset = NO_OFFSET;  // page to lay out, NO_OFFSET for none
+  std::vector<std::string> preparedLines;
+  size_t preparedOffset = NO_OFFSET;
+  size_t preparedNextOffset = 0;
+  SemaphoreHandle_t prepMutex = nullptr;  // guards the prep request and the prepared page
 
   // Cached settings for cache validation (different fonts/margins require re-indexing)
   int cachedFontId = 0;
@@ -32,13 +53,28 @@ class TxtReaderActivity final : public Activity {
 
   void renderPage();
   void renderStatusBar() const;
+  size_t estimatedTotalPages() const;
 
   void initializeReader();
+  bool layoutPage(const uint8_t* buffer, size_t len, size_t offset, std::vector<std::string>* outLines,
+                  size_t& nextOffset);
   bool loadPageAtOffset(size_t offset, std::vector<std::string>& outLines, size_t& nextOffset);
-  void buildPageIndex();
+  bool extendPageIndex(size_t targetPages, unsigned long timeBudgetMs);
+  void indexWhileIdle();
+  int pageAtOffset(size_t offset) const;
+  void setPosition(size_t offset);
+  size_t previousPageOffset();
+  size_t lineStartNear(size_t offset);
+  void jumpToPercent(int percent);
   bool loadPageIndexCache();
-  void savePageIndexCache() const;
+  void savePageIndexCache();
   void saveProgress() const;
+  // Render task, around the BW refresh of a page. finishPagePrep() waits for a prep loop() already started and does
+  // the rest of one it did not get to.
+  void requestPagePrep();
+  void finishPagePrep();
+  void servicePagePrep();
+  bool takePreparedPage();
   void loadProgress();
 
  public:
@@ -49,4 +85,6 @@ class TxtReaderActivity final : public Activity {
   void loop() override;
   void render(RenderLock&&) override;
   bool isReaderActivity() const override { return true; }
+  // The page index is extended in slices from loop() until it is complete
+  bool isInputDriven() const override { return initialized && (indexComplete || indexFailed) && !pagePrepPending; }
 };
@@ -10,10 +10,16 @@
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
 #include <HalStorage.h>
+#include <HeapTrace.h>
 #include <I18n.h>
 
+#include <algorithm>
+#include <cstring>
+
+#include "CacheBudget.h"
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "RecentBooksStore.h"
 #include "XtcReaderChapterSelectionActivity.h"
@@ -23,6 +29,108 @@
 namespace {
 constexpr unsigned long skipPageMs = 700;
 constexpr unsigned long goHomeMs = 1000;
+// The prefetch slot is only allocated if this much heap stays available next to it
+constexpr size_t prefetchHeapReserve = 64 * 1024;
+// Direct page rendering reads in chunks of 64 rows of a 480 px wide XTG page
+constexpr size_t directChunkSize = 64 * 60;
+
+// Transposes an 8x8 bit block. Input byte i (counting from the most significant) is row i with its leftmost pixel in
+// the MSB; output byte j is column j with row 0 in the MSB.
+uint64_t transpose8x8(uint64_t x) {
+  uint64_t t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+  x = x ^ t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+  x = x ^ t ^ (t << 14);
+  t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+  return x ^ t ^ (t << 28);
+}
+
+// Streams both planes of an XTH page into a framebuffer-sized buffer: plane 1 bytes are stored through plane1Op, then
+// plane 2 bytes are combined with them through plane2Op
+template <typename Plane1Op, typename Plane2Op>
+bool streamXthPlanes(const Xtc& xtc, const uint32_t pageIndex, uint8_t* frameBuffer, Plane1Op plane1Op,
+                     Plane2Op plane2Op) {
+  constexpr size_t planeSize = HalDisplay::BUFFER_SIZE;
+  const auto err = xtc.loadPageStreaming(
+      pageIndex,
+      [&](const uint8_t* data, const size_t size, const size_t offset) {
+        const size_t end = std::min(offset + size, 2 * planeSize);
+        size_t pos = offset;
+        for (; pos < end && pos < planeSize; pos++) {
+          frameBuffer[pos] = plane1Op(data[pos - offset]);
+        }
+        for (; pos < end; pos++) {
+          uint8_t& fb = frameBuffer[pos - planeSize];
+          fb = plane2Op(fb, data[pos - offset]);
+        }
+      },
+      directChunkSize);
+  return err == xtc::XtcError::OK;
+}
+
+// Same as streamXthPlanes for a page that is already in memory
+template <typename Op>
+void combineXthPlanes(const uint8_t* pageData, uint8_t* frameBuffer, Op op) {
+  constexpr size_t planeSize = HalDisplay::BUFFER_SIZE;
+  for (size_t i = 0; i < planeSize; i++) {
+    frameBuffer[i] = op(pageData[i], pageData[planeSize + i]);
+  }
+}
+
+// Which of the three framebuffer images of an XTH page to build
+enum class XthPass { Bw, GrayLsb, GrayMsb };
+
+// Builds one pass of an XTH page from pageData, or by streaming the page from SD if pageData is null
+bool drawXthPass(const Xtc& xtc, const uint32_t pageIndex, const uint8_t* pageData, uint8_t* frameBuffer,
+                 const XthPass pass) {
+  // BW: every non-white pixel is black (framebuffer bit 0). LSB marks dark grey (value 1), MSB both greys (1 or 2).
+  switch (pass) {
+    case XthPass::Bw:
+      if (pageData) {
+        combineXthPlanes(pageData, frameBuffer,
+                         [](const uint8_t b1, const uint8_t b2) -> uint8_t { return ~(b1 | b2); });
+        return true;
+      }
+      return streamXthPlanes(
+          xtc, pageIndex, frameBuffer, [](const uint8_t b1) -> uint8_t { return ~b1; },
+          [](const uint8_t fb, const uint8_t b2) -> uint8_t { return fb & ~b2; });
+    case XthPass::GrayLsb:
+      if (pageData) {
+        combineXthPlanes(pageData, frameBuffer, [](const uint8_t b1, const uint8_t b2) -> uint8_t { return ~b1 & b2; });
+        return true;
+      }
+      return streamXthPlanes(
+          xtc, pageIndex, frameBuffer, [](const uint8_t b1) -> uint8_t { return ~b1; },
+          [](const uint8_t fb, const uint8_t b2) -> uint8_t { return fb & b2; });
+    case XthPass::GrayMsb:
+      if (pageData) {
+        combineXthPlanes(pageData, frameBuffer, [](const uint8_t b1, const uint8_t b2) -> uint8_t { return b1 ^ b2; });
+        return true;
+      }
+      return streamXthPlanes(
+          xtc, pageIndex, frameBuffer, [](const uint8_t b1) -> uint8_t { return b1; },
+          [](const uint8_t fb, const uint8_t b2) -> uint8_t { return fb ^ b2; });
+  }
+  return false;
+}
+
+// Transposes 8 XTG rows (band bandIndex of a full-screen portrait page) into the framebuffer. XTG rows are row-major
+// with 1 = white like the framebuffer, but in portrait a page row is a framebuffer column: 8x8 block bx of the band
+// becomes byte bandIndex of the framebuffer rows for page columns bx * 8 .. bx * 8 + 7.
+void transposeXtgBand(const uint8_t* band, const size_t bandIndex, uint8_t* frameBuffer) {
+  constexpr size_t rowBytes = HalDisplay::DISPLAY_HEIGHT / 8;
+  for (size_t bx = 0; bx < rowBytes; bx++) {
+    uint64_t block = 0;
+    for (size_t row = 0; row < 8; row++) {
+      block = (block << 8) | band[row * rowBytes + bx];
+    }
+    block = transpose8x8(block);
+    for (size_t col = 0; col < 8; col++) {
+      const size_t fbRow = HalDisplay::DISPLAY_HEIGHT - 1 - (bx * 8 + col);
+      frameBuffer[fbRow * HalDisplay::DISPLAY_WIDTH_BYTES + bandIndex] = static_cast<uint8_t>(block >> (56 - 8 * col));
+    }
+  }
+}
 }  // namespace
 
 void XtcReaderActivity::onEnter() {
@@ -33,6 +141,8 @@ void XtcReaderActivity::onEnter() {
   }
 
   xtc->setupCacheDir();
+  CACHE_BUDGET.touch(xtc->getCachePath());
+  pageMutex = xSemaphoreCreateMutex();
 
   // Load saved progress
   loadProgress();
@@ -49,15 +159,33 @@ void XtcReaderActivity::onEnter() {
 void XtcReaderActivity::onExit() {
   Activity::onExit();
 
+  // Progress shown next to the book in the file browser
+  if (xtc && xtc->getPageCount() > 0) {
+    LIBRARY_INDEX.updateProgress(xtc->getPath(), (currentPage + 1) * 100 / xtc->getPageCount());
+  }
+
   APP_STATE.readerActivityLoadCount = 0;
   APP_STATE.saveToFile();
+  releasePageSlots();
+  if (pageMutex) {
+    vSemaphoreDelete(pageMutex);
+    pageMutex = nullptr;
+  }
   xtc.reset();
 }
 
 void XtcReaderActivity::loop() {
+  // The render task asks for the next page while it waits for the panel refresh
+  servicePrefetch();
+
   // Enter chapter selection activity
-  if (mappedInput.wasReleased(MappedInputManager::Button::Confirm)) {
-    if (xtc && xtc->hasChapters() && !xtc->getChapters().empty()) {
+  if (mappedInput.wasReleased(MappedInputManager::Button::Confirm) && xtc && xtc->hasChapters()) {
+    // The chapter list is read on first use, through the file handle the render task reads pages with
+    xSemaphoreTake(pageMutex, portMAX_DELAY);
+    const bool haveChapters = !xtc->getChapters().empty();
+    xSemaphoreGive(pageMutex);
+    if (haveChapters) {
+      releasePrefetchSlot();
       startActivityForResult(
           std::make_unique<XtcReaderChapterSelectionActivity>(renderer, mappedInput, xtc, currentPage),
           [this](const ActivityResult& result) {
@@ -109,6 +237,7 @@ void XtcReaderActivity::loop() {
   const int skipAmount = skipPages ? 10 : 1;
 
   if (prevTriggered) {
+    pageDirection = -1;
     if (currentPage >= static_cast<uint32_t>(skipAmount)) {
       currentPage -= skipAmount;
     } else {
@@ -116,6 +245,7 @@ void XtcReaderActivity::loop() {
     }
     requestUpdate();
   } else if (nextTriggered) {
+    pageDirection = 1;
     currentPage += skipAmount;
     if (currentPage >= xtc->getPageCount()) {
       currentPage = xtc->getPageCount();  // Allow showing "End of book"
@@ -138,46 +268,203 @@ void XtcReaderActivity::render(RenderLock&&) {
     return;
   }
 
+  progressSaved = false;
   renderPage();
-  saveProgress();
+
+  xSemaphoreTake(pageMutex, portMAX_DELAY);
+  if (!progressSaved) {
+    progressPending = false;
+    saveProgress();
+  }
+  xSemaphoreGive(pageMutex);
 }
 
-void XtcReaderActivity::renderPage() {
+void XtcReaderActivity::displayPageBuffer() {
+  if (pagesUntilFullRefresh <= 1) {
+    renderer.displayBuffer(HalDisplay::HALF_REFRESH);
+    pagesUntilFullRefresh = SETTINGS.getRefreshFrequency();
+  } else {
+    renderer.displayBuffer();
+    pagesUntilFullRefresh--;
+  }
+}
+
+size_t XtcReaderActivity::getPageBufferSize() const {
   const uint16_t pageWidth = xtc->getPageWidth();
   const uint16_t pageHeight = xtc->getPageHeight();
-  const uint8_t bitDepth = xtc->getBitDepth();
 
-  // Calculate buffer size for one page
   // XTG (1-bit): Row-major, ((width+7)/8) * height bytes
   // XTH (2-bit): Two bit planes, column-major, ((width * height + 7) / 8) * 2 bytes
-  size_t pageBufferSize;
-  if (bitDepth == 2) {
-    pageBufferSize = ((static_cast<size_t>(pageWidth) * pageHeight + 7) / 8) * 2;
-  } else {
-    pageBufferSize = ((pageWidth + 7) / 8) * pageHeight;
+  if (xtc->getBitDepth() == 2) {
+    return ((static_cast<size_t>(pageWidth) * pageHeight + 7) / 8) * 2;
   }
+  return ((pageWidth + 7) / 8) * pageHeight;
+}
 
-  // Allocate page buffer
-  uint8_t* pageBuffer = static_cast<uint8_t*>(malloc(pageBufferSize));
-  if (!pageBuffer) {
-    LOG_ERR("XTR", "Failed to allocate page buffer (%lu bytes)", pageBufferSize);
-    renderer.clearScreen();
-    renderer.drawCenteredText(UI_12_FONT_ID, 300, tr(STR_MEMORY_ERROR), true, EpdFontFamily::BOLD);
-    renderer.displayBuffer();
+const uint8_t* XtcReaderActivity::bufferCurrentPage(bool& readOk) {
+  readOk = true;
+  const size_t pageBufferSize = getPageBufferSize();
+
+  xSemaphoreTake(pageMutex, portMAX_DELAY);
+  // Any prefetch still queued is for the page before this one
+  prefetchRequest = NO_PAGE;
+
+  for (int i = 0; i < 2; i++) {
+    if (pageSlots[i].data && pageSlots[i].page == currentPage) {
+      if (i != activeSlot) {
+        LOG_DBG("XTR", "Page %lu was prefetched", currentPage);
+        activeSlot = i;
+      }
+      xSemaphoreGive(pageMutex);
+      return pageSlots[i].data;
+    }
+  }
+
+  PageSlot& slot = pageSlots[activeSlot];
+  if (!slot.data) {
+    slot.data = static_cast<uint8_t*>(HEAP_MALLOC(PAGE_CACHE, pageBufferSize));
+    if (!slot.data) {
+      LOG_ERR("XTR", "Failed to allocate page buffer (%lu bytes)", pageBufferSize);
+      xSemaphoreGive(pageMutex);
+      return nullptr;
+    }
+  }
+
+  slot.page = NO_PAGE;
+  if (xtc->loadPage(currentPage, slot.data, pageBufferSize) == 0) {
+    readOk = false;
+    xSemaphoreGive(pageMutex);
+    return nullptr;
+  }
+  slot.page = currentPage;
+  xSemaphoreGive(pageMutex);
+  return slot.data;
+}
+
+void XtcReaderActivity::requestPrefetch() {
+  // Without a page buffer there is nothing to prefetch into. This also keeps the streamed path, which holds pageMutex
+  // while it renders, from getting here.
+  const int64_t nextPage = static_cast<int64_t>(currentPage) + pageDirection;
+  if (nextPage < 0 || nextPage >= xtc->getPageCount() || !pageSlots[activeSlot].data) {
     return;
   }
 
-  // Load page data
-  size_t bytesRead = xtc->loadPage(currentPage, pageBuffer, pageBufferSize);
-  if (bytesRead == 0) {
+  xSemaphoreTake(pageMutex, portMAX_DELAY);
+  PageSlot& slot = pageSlots[1 - activeSlot];
+  if (!slot.data) {
+    // Strict budget: the second page buffer is optional and must not squeeze out anything else
+    const size_t pageBufferSize = getPageBufferSize();
+    if (ESP.getMaxAllocHeap() >= pageBufferSize + prefetchHeapReserve) {
+      slot.data = static_cast<uint8_t*>(HEAP_MALLOC(PAGE_CACHE, pageBufferSize));
+      slot.page = NO_PAGE;
+    }
+  }
+  if (slot.data && slot.page != nextPage) {
+    prefetchRequest = static_cast<uint32_t>(nextPage);
+    progressPending = true;
+  }
+  xSemaphoreGive(pageMutex);
+  // The main loop may be waiting for a button
+  mappedInput.interruptWait();
+}
+
+void XtcReaderActivity::servicePrefetch() {
+  if (prefetchRequest == NO_PAGE || !pageMutex) {
+    return;
+  }
+
+  xSemaphoreTake(pageMutex, portMAX_DELAY);
+  if (progressPending) {
+    progressPending = false;
+    progressSaved = true;
+    saveProgress();
+  }
+  const uint32_t page = prefetchRequest;
+  prefetchRequest = NO_PAGE;
+  PageSlot& slot = pageSlots[1 - activeSlot];
+  if (page != NO_PAGE && slot.data && slot.page != page) {
+    const unsigned long start = millis();
+    slot.page = xtc->loadPage(page, slot.data, getPageBufferSize()) != 0 ? page : NO_PAGE;
+    if (slot.page == page) {
+      LOG_DBG("XTR", "Prefetched page %lu in %lums", page, millis() - start);
+    } else {
+      LOG_ERR("XTR", "Failed to prefetch page %lu", page);
+    }
+  }
+  xSemaphoreGive(pageMutex);
+}
+
+void XtcReaderActivity::releasePrefetchSlot() {
+  if (!pageMutex) {
+    return;
+  }
+  xSemaphoreTake(pageMutex, portMAX_DELAY);
+  prefetchRequest = NO_PAGE;
+  PageSlot& slot = pageSlots[1 - activeSlot];
+  HEAP_FREE(slot.data);
+  slot.data = nullptr;
+  slot.page = NO_PAGE;
+  xSemaphoreGive(pageMutex);
+}
+
+void XtcReaderActivity::releasePageSlots() {
+  prefetchRequest = NO_PAGE;
+  for (auto& slot : pageSlots) {
+    HEAP_FREE(slot.data);
+    slot.data = nullptr;
+    slot.page = NO_PAGE;
+  }
+}
+
+void XtcReaderActivity::renderPage() {
+  const uint16_t pageWidth = xtc->getPageWidth();
+  const uint16_t pageHeight = xtc->getPageHeight();
+  const uint8_t bitDepth = xtc->getBitDepth();
+  const unsigned long start = millis();
+
+  // Without a page buffer, full-screen portrait pages can still be streamed straight from SD
+  bool readOk;
+  const uint8_t* pageBuffer = bufferCurrentPage(readOk);
+  if (!readOk) {
     LOG_ERR("XTR", "Failed to load page %lu", currentPage);
-    free(pageBuffer);
     renderer.clearScreen();
     renderer.drawCenteredText(UI_12_FONT_ID, 300, tr(STR_PAGE_LOAD_ERROR), true, EpdFontFamily::BOLD);
     renderer.displayBuffer();
     return;
   }
 
+  // Full-screen pages in portrait go straight into the framebuffer with byte operations; anything else is drawn per
+  // pixel
+  if (renderer.getOrientation() == GfxRenderer::Portrait && pageWidth == HalDisplay::DISPLAY_HEIGHT &&
+      pageHeight == HalDisplay::DISPLAY_WIDTH) {
+    // Streaming reads the XTC file outside of bufferCurrentPage, so keep the prefetcher away from it
+    if (!pageBuffer) {
+      xSemaphoreTake(pageMutex, portMAX_DELAY);
+    }
+    const bool rendered = bitDepth == 2 ? renderXthPageDirect(pageBuffer) : renderXtgPageDirect(pageBuffer);
+    if (!pageBuffer) {
+      xSemaphoreGive(pageMutex);
+    }
+    if (!rendered) {
+      LOG_ERR("XTR", "Failed to load page %lu", currentPage);
+      renderer.clearScreen();
+      renderer.drawCenteredText(UI_12_FONT_ID, 300, tr(STR_PAGE_LOAD_ERROR), true, EpdFontFamily::BOLD);
+      renderer.displayBuffer();
+      return;
+    }
+    LOG_DBG("XTR", "Rendered page %lu/%lu (%u-bit, %s) in %lums", currentPage + 1, xtc->getPageCount(), bitDepth,
+            pageBuffer ? "buffered" : "streamed", millis() - start);
+    return;
+  }
+
+  if (!pageBuffer) {
+    LOG_ERR("XTR", "No page buffer for page %lu", currentPage);
+    renderer.clearScreen();
+    renderer.drawCenteredText(UI_12_FONT_ID, 300, tr(STR_MEMORY_ERROR), true, EpdFontFamily::BOLD);
+    renderer.displayBuffer();
+    return;
+  }
+
   // Clear screen first
   renderer.clearScreen();
 
@@ -212,16 +499,6 @@ void XtcReaderActivity::renderPage() {
     // Optimized grayscale rendering without storeBwBuffer (saves 48KB peak memory)
     // Flow: BW display → LSB/MSB passes → grayscale display → re-render BW for next frame
 
-    // Count pixel distribution for debugging
-    uint32_t pixelCounts[4] = {0, 0, 0, 0};
-    for (uint16_t y = 0; y < pageHeight; y++) {
-      for (uint16_t x = 0; x < pageWidth; x++) {
-        pixelCounts[getPixelValue(x, y)]++;
-      }
-    }
-    LOG_DBG("XTR", "Pixel distribution: White=%lu, DarkGrey=%lu, LightGrey=%lu, Black=%lu", pixelCounts[0],
-            pixelCounts[1], pixelCounts[2], pixelCounts[3]);
-
     // Pass 1: BW buffer - draw all non-white pixels as black
     for (uint16_t y = 0; y < pageHeight; y++) {
       for (uint16_t x = 0; x < pageWidth; x++) {
@@ -232,13 +509,8 @@ void XtcReaderActivity::renderPage() {
     }
 
     // Display BW with conditional refresh based on pagesUntilFullRefresh
-    if (pagesUntilFullRefresh <= 1) {
-      renderer.displayBuffer(HalDisplay::HALF_REFRESH);
-      pagesUntilFullRefresh = SETTINGS.getRefreshFrequency();
-    } else {
-      renderer.displayBuffer();
-      pagesUntilFullRefresh--;
-    }
+    requestPrefetch();
+    displayPageBuffer();
 
     // Pass 2: LSB buffer - mark DARK gray only (XTH value 1)
     // In LUT: 0 bit = apply gray effect, 1 bit = untouched
@@ -281,8 +553,6 @@ void XtcReaderActivity::renderPage() {
     // Cleanup grayscale buffers with current frame buffer
     renderer.cleanupGrayscaleWithFrameBuffer();
 
-    free(pageBuffer);
-
     LOG_DBG("XTR", "Rendered page %lu/%lu (2-bit grayscale)", currentPage + 1, xtc->getPageCount());
     return;
   } else {
@@ -306,20 +576,89 @@ void XtcReaderActivity::renderPage() {
   }
   // White pixels are already cleared by clearScreen()
 
-  free(pageBuffer);
-
   // XTC pages already have status bar pre-rendered, no need to add our own
 
   // Display with appropriate refresh
-  if (pagesUntilFullRefresh <= 1) {
-    renderer.displayBuffer(HalDisplay::HALF_REFRESH);
-    pagesUntilFullRefresh = SETTINGS.getRefreshFrequency();
+  requestPrefetch();
+  displayPageBuffer();
+
+  LOG_DBG("XTR", "Rendered page %lu/%lu (%u-bit)", currentPage + 1, xtc->getPageCount(), bitDepth);
+}
+
+bool XtcReaderActivity::renderXthPageDirect(const uint8_t* pageData) {
+  // In portrait, XTH column c (columns are stored right to left, 8 pixels per byte, topmost in the MSB) is exactly
+  // framebuffer row c, so each plane lines up byte for byte with the framebuffer. Pixel value = (bit1 << 1) | bit2,
+  // with 0 = white, 1 = dark grey, 2 = light grey, 3 = black.
+  uint8_t* frameBuffer = renderer.getFrameBuffer();
+
+  if (!drawXthPass(*xtc, currentPage, pageData, frameBuffer, XthPass::Bw)) {
+    return false;
+  }
+  requestPrefetch();
+  displayPageBuffer();
+
+  bool grayDrawn = drawXthPass(*xtc, currentPage, pageData, frameBuffer, XthPass::GrayLsb);
+  if (grayDrawn) {
+    renderer.copyGrayscaleLsbBuffers();
+    grayDrawn = drawXthPass(*xtc, currentPage, pageData, frameBuffer, XthPass::GrayMsb);
+  }
+  if (grayDrawn) {
+    renderer.copyGrayscaleMsbBuffers();
+    renderer.displayGrayBuffer();
   } else {
-    renderer.displayBuffer();
-    pagesUntilFullRefresh--;
+    LOG_ERR("XTR", "Failed to stream grayscale planes of page %lu", currentPage);
   }
 
-  LOG_DBG("XTR", "Rendered page %lu/%lu (%u-bit)", currentPage + 1, xtc->getPageCount(), bitDepth);
+  // Restore the BW frame so the next page refreshes against what is on screen
+  if (!drawXthPass(*xtc, currentPage, pageData, frameBuffer, XthPass::Bw)) {
+    LOG_ERR("XTR", "Failed to restore BW frame of page %lu", currentPage);
+    renderer.clearScreen();
+  }
+  renderer.cleanupGrayscaleWithFrameBuffer();
+  return true;
+}
+
+bool XtcReaderActivity::renderXtgPageDirect(const uint8_t* pageData) {
+  constexpr size_t bandBytes = 8 * (HalDisplay::DISPLAY_HEIGHT / 8);
+  uint8_t* frameBuffer = renderer.getFrameBuffer();
+
+  if (pageData) {
+    for (size_t bandIndex = 0; bandIndex < HalDisplay::DISPLAY_WIDTH_BYTES; bandIndex++) {
+      transposeXtgBand(pageData + bandIndex * bandBytes, bandIndex, frameBuffer);
+    }
+  } else {
+    // Gather 8 rows at a time from the stream
+    uint8_t band[bandBytes];
+    size_t bandFill = 0;
+    size_t bandIndex = 0;
+    const auto err = xtc->loadPageStreaming(
+        currentPage,
+        [&](const uint8_t* data, size_t size, size_t) {
+          while (size > 0) {
+            const size_t n = std::min(size, bandBytes - bandFill);
+            memcpy(band + bandFill, data, n);
+            bandFill += n;
+            data += n;
+            size -= n;
+            if (bandFill < bandBytes) {
+              break;
+            }
+            if (bandIndex < HalDisplay::DISPLAY_WIDTH_BYTES) {
+              transposeXtgBand(band, bandIndex, frameBuffer);
+            }
+            bandIndex++;
+            bandFill = 0;
+          }
+        },
+        directChunkSize);
+    if (err != xtc::XtcError::OK) {
+      return false;
+    }
+  }
+
+  requestPrefetch();
+  displayPageBuffer();
+  return true;
 }
 
 void XtcReaderActivity::saveProgress() const {
@@ -8,6 +8,8 @@
 #pragma once
 
 #include <Xtc.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
 
 #include "activities/Activity.h"
 
@@ -17,7 +19,37 @@ class XtcReaderActivity final : public Activity {
   uint32_t currentPage = 0;
   int pagesUntilFullRefresh = 0;
 
+  // Raw page data. The active slot holds the page on screen; the other one, allocated only when the heap allows,
+  // receives the likely next page, read by loop() while the render task waits for the panel refresh.
+  struct PageSlot {
+    uint8_t* data = nullptr;
+    uint32_t page = UINT32_MAX;
+  };
+  static constexpr uint32_t NO_PAGE = UINT32_MAX;
+  PageSlot pageSlots[2];
+  int activeSlot = 0;
+  int pageDirection = 1;  // direction of the last page turn, decides which neighbour is prefetched
+  volatile uint32_t prefetchRequest = NO_PAGE;
+  // The progress of the page on screen is saved by loop() along with the prefetch, or by render() if there is none
+  bool progressPending = false;
+  bool progressSaved = false;
+  SemaphoreHandle_t pageMutex = nullptr;  // guards the XTC file, the slots, prefetchRequest and the progress flags
+
   void renderPage();
+  // Fast paths for full-screen pages in portrait, from pageData or streamed from SD if it is null. Return false if
+  // the page could not be read.
+  bool renderXthPageDirect(const uint8_t* pageData);
+  bool renderXtgPageDirect(const uint8_t* pageData);
+  void displayPageBuffer();
+
+  size_t getPageBufferSize() const;
+  // Returns the current page from a slot, reading it if needed. nullptr with readOk set means no buffer could be
+  // allocated.
+  const uint8_t* bufferCurrentPage(bool& readOk);
+  void requestPrefetch();
+  void servicePrefetch();
+  void releasePrefetchSlot();
+  void releasePageSlots();
   void saveProgress() const;
   void loadProgress();
 
@@ -29,4 +61,5 @@ class XtcReaderActivity final : public Activity {
   void loop() override;
   void render(RenderLock&&) override;
   bool isReaderActivity() const override { return true; }
+  bool isInputDriven() const override { return prefetchRequest == NO_PAGE; }
 };
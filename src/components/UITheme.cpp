@@ -3,7 +3,9 @@
 #include <FsHelpers.h>
 #include <GfxRenderer.h>
 #include <Logging.h>
+#include <PlaneCache.h>
 
+#include <algorithm>
 #include <memory>
 
 #include "MappedInputManager.h"
@@ -74,6 +76,39 @@ std::string UITheme::getCoverThumbPath(std::string coverBmpPath, int coverHeight
   return coverBmpPath;
 }
 
+std::vector<int> UITheme::getCoverThumbHeights() {
+  std::vector<int> heights;
+  for (const int height : {BaseMetrics::values.homeCoverHeight, LyraMetrics::values.homeCoverHeight,
+                           Lyra3CoversMetrics::values.homeCoverHeight}) {
+    if (std::find(heights.begin(), heights.end(), height) == heights.end()) {
+      heights.push_back(height);
+    }
+  }
+  return heights;
+}
+
+void UITheme::drawCoverBitmap(GfxRenderer& renderer, const Bitmap& bitmap, FsFile& bmpFile,
+                              const std::string& coverBmpPath, const int x, const int y, const int maxWidth,
+                              const int maxHeight, const float cropX) {
+  const std::string planePath = PlaneCache::getPathFor(coverBmpPath);
+  const PlaneCache::Key key{x, y, maxWidth, maxHeight, 1, PlaneCache::makeSourceTag(bmpFile)};
+
+  FsFile planeFile;
+  if (PlaneCache::openForRead(planePath, renderer, key, planeFile)) {
+    const bool ok = renderer.readRegion(planeFile, x, y, maxWidth, maxHeight);
+    planeFile.close();
+    if (ok) {
+      return;
+    }
+  }
+
+  // Snapshot includes the untouched background inside the rectangle, which is blank on the first home render
+  renderer.drawBitmap(bitmap, x, y, maxWidth, maxHeight, cropX);
+  if (PlaneCache::openForWrite(planePath, renderer, key, planeFile)) {
+    PlaneCache::finish(planePath, planeFile, renderer.writeRegion(planeFile, x, y, maxWidth, maxHeight));
+  }
+}
+
 UIIcon UITheme::getFileIcon(const std::string& filename) {
   if (filename.back() == '/') {
     return Folder;
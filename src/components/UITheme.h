@@ -1,11 +1,16 @@
 #pragma once
 
+#include <HalStorage.h>
+
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "CrossPointSettings.h"
 #include "components/themes/BaseTheme.h"
 
+class Bitmap;
+
 class UITheme {
   // Static instance
   static UITheme instance;
@@ -21,6 +26,12 @@ class UITheme {
   static int getNumberOfItemsPerPage(const GfxRenderer& renderer, bool hasHeader, bool hasTabBar, bool hasButtonHints,
                                      bool hasSubtitle);
   static std::string getCoverThumbPath(std::string coverBmpPath, int coverHeight);
+  // Distinct thumbnail heights used by all themes, so switching themes does not regenerate thumbnails
+  static std::vector<int> getCoverThumbHeights();
+  // Draws a cover thumbnail, reusing its panel-native plane cache (see PlaneCache) when the layout is unchanged
+  static void drawCoverBitmap(GfxRenderer& renderer, const Bitmap& bitmap, FsFile& bmpFile,
+                              const std::string& coverBmpPath, int x, int y, int maxWidth, int maxHeight,
+                              float cropX = 0);
   static UIIcon getFileIcon(const std::string& filename);
   static int getStatusBarHeight();
   static int getProgressBarHeight();
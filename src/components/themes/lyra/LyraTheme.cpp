@@ -441,8 +441,8 @@ void LyraTheme::drawRecentBookCover(GfxRenderer& renderer, Rect rect, const std:
           Bitmap bitmap(file);
           if (bitmap.parseHeaders() == BmpReaderError::Ok) {
             coverWidth = bitmap.getWidth();
-            renderer.drawBitmap(bitmap, tileX + hPaddingInSelection, tileY + hPaddingInSelection, coverWidth,
-                                LyraMetrics::values.homeCoverHeight);
+            UITheme::drawCoverBitmap(renderer, bitmap, file, coverBmpPath, tileX + hPaddingInSelection,
+                                     tileY + hPaddingInSelection, coverWidth, LyraMetrics::values.homeCoverHeight);
           } else {
             hasCover = false;
           }
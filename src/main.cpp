@@ -7,22 +7,29 @@
 #include <HalPowerManager.h>
 #include <HalStorage.h>
 #include <HalSystem.h>
+#include <HeapTrace.h>
 #include <I18n.h>
 #include <Logging.h>
+#include <PerfTrace.h>
 #include <SPI.h>
 #include <builtinFonts/all.h>
 
+#include <algorithm>
 #include <cstring>
 
+#include "BackgroundJobQueue.h"
+#include "CacheBudget.h"
 #include "CrossPointSettings.h"
 #include "CrossPointState.h"
 #include "KOReaderCredentialStore.h"
+#include "LibraryIndex.h"
 #include "MappedInputManager.h"
 #include "RecentBooksStore.h"
 #include "activities/Activity.h"
 #include "activities/ActivityManager.h"
 #include "components/UITheme.h"
 #include "fontIds.h"
+#include "util/BookPrepJobs.h"
 #include "util/ButtonNavigator.h"
 #include "util/ScreenshotUtil.h"
 
@@ -181,6 +188,7 @@ void waitForPowerRelease() {
 // Enter deep sleep mode
 void enterDeepSleep() {
   HalPowerManager::Lock powerLock;  // Ensure we are at normal CPU frequency for sleep preparation
+  BACKGROUND_JOBS.pause();          // Don't power down in the middle of a cache write
   APP_STATE.lastSleepFromReader = activityManager.isReaderActivity();
   APP_STATE.saveToFile();
 
@@ -287,6 +295,10 @@ void setup() {
 
   APP_STATE.loadFromFile();
   RECENT_BOOKS.loadFromFile();
+  BACKGROUND_JOBS.begin();
+  LIBRARY_INDEX.begin();
+  CACHE_BUDGET.begin();
+  BookPrepJobs::begin(renderer);
 
   // Boot to home screen if no book is open, last sleep was not from reader, back button is held, or reader activity
   // crashed (indicated by readerActivityLoadCount > 0)
@@ -306,6 +318,9 @@ void setup() {
   waitForPowerRelease();
 }
 
+// Longest the main loop blocks waiting for a button while an input-driven activity is shown
+constexpr unsigned long MAX_INPUT_WAIT_MS = 1000;
+
 void loop() {
   static unsigned long maxLoopDuration = 0;
   const unsigned long loopStartTime = millis();
@@ -321,6 +336,15 @@ void loop() {
     lastMemPrint = millis();
   }
 
+#ifdef ENABLE_PERF_TRACE
+  // Free heap next to its largest block, for the fragmentation history in the perf report
+  static unsigned long lastHeapSample = 0;
+  if (millis() - lastHeapSample >= 1000) {
+    HEAP_TRACE.sample();
+    lastHeapSample = millis();
+  }
+#endif
+
   // Handle incoming serial commands,
   // nb: we use logSerial from logging to avoid deprecation warnings
   if (logSerial.available() > 0) {
@@ -334,6 +358,17 @@ void loop() {
         logSerial.write(buf, HalDisplay::BUFFER_SIZE);
         logSerial.printf("SCREENSHOT_END\n");
       }
+#ifdef ENABLE_PERF_TRACE
+      if (cmd == "PERF") {
+        logSerial.printf("PERF_START\n");
+        logSerial.print(PERF_TRACE.formatReport().c_str());
+        logSerial.print(HEAP_TRACE.formatReport().c_str());
+        logSerial.printf("PERF_END\n");
+      } else if (cmd == "PERF_RESET") {
+        PERF_TRACE.reset();
+        HEAP_TRACE.reset();
+      }
+#endif
     }
   }
 
@@ -388,20 +423,25 @@ void loop() {
     }
   }
 
-  // Add delay at the end of the loop to prevent tight spinning
+  // Wait at the end of the loop to prevent tight spinning
   // When an activity requests skip loop delay (e.g., webserver running), use yield() for faster response
-  // Otherwise, use longer delay to save power
+  // Otherwise, wait for the next button event with a timeout; a button press ends the wait at once
   if (activityManager.skipLoopDelay()) {
     powerManager.setPowerSaving(false);  // Make sure we're at full performance when skipLoopDelay is requested
     yield();                             // Give FreeRTOS a chance to run tasks, but return immediately
   } else {
-    if (millis() - lastActivityTime >= HalPowerManager::IDLE_POWER_SAVING_MS) {
-      // If we've been inactive for a while, increase the delay to save power
+    const unsigned long idleTime = millis() - lastActivityTime;
+    unsigned long waitMs = 10;  // Short wait to keep loop-driven activities responsive
+    if (idleTime >= HalPowerManager::IDLE_POWER_SAVING_MS) {
+      // If we've been inactive for a while, wait longer to save power
       powerManager.setPowerSaving(true);  // Lower CPU frequency after extended inactivity
-      delay(50);
-    } else {
-      // Short delay to prevent tight loop while still being responsive
-      delay(10);
+      waitMs = 50;
+    }
+    if (activityManager.isInputDriven() && !gpio.isAnyPressed() && idleTime < sleepTimeoutMs) {
+      // Nothing to do before the next button event or the sleep timeout. Still wake once a second for serial
+      // commands and the memory log.
+      waitMs = std::min<unsigned long>(MAX_INPUT_WAIT_MS, sleepTimeoutMs - idleTime);
     }
+    gpio.waitForInput(waitMs);
   }
 }
\ No newline at end of file
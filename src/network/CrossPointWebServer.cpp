@@ -1,21 +1,30 @@
 #include "CrossPointWebServer.h"
 
 #include <ArduinoJson.h>
+#include <DirectoryListing.h>
 #include <Epub.h>
 #include <FsHelpers.h>
 #include <HalStorage.h>
+#include <HeapTrace.h>
 #include <Logging.h>
+#include <PerfTrace.h>
 #include <WiFi.h>
 #include <esp_task_wdt.h>
 
 #include <algorithm>
+#include <cstring>
+#include <new>
+#include <optional>
 
+#include "BackgroundJobQueue.h"
 #include "CrossPointSettings.h"
+#include "LibraryIndex.h"
 #include "SettingsList.h"
 #include "WebDAVHandler.h"
 #include "html/FilesPageHtml.generated.h"
 #include "html/HomePageHtml.generated.h"
 #include "html/SettingsPageHtml.generated.h"
+#include "util/BookPrepJobs.h"
 
 namespace {
 // Folders/files to hide from the web interface file browser
@@ -29,13 +38,15 @@ constexpr uint16_t LOCAL_UDP_PORT = 8134;
 CrossPointWebServer* wsInstance = nullptr;
 
 // WebSocket upload state
-FsFile wsUploadFile;
+UploadWriter wsUploadWriter;
 String wsUploadFileName;
 String wsUploadPath;
 size_t wsUploadSize = 0;
 size_t wsUploadReceived = 0;
 unsigned long wsUploadStartTime = 0;
 bool wsUploadInProgress = false;
+// Keeps background jobs off the SD card from START until the upload is finished or dropped
+std::optional<BackgroundJobQueue::Hold> wsJobHold;
 String wsLastCompleteName;
 size_t wsLastCompleteSize = 0;
 unsigned long wsLastCompleteAt = 0;
@@ -49,6 +60,15 @@ void clearEpubCacheIfNeeded(const String& filePath) {
   }
 }
 
+// Deletes a failed upload; the writer reserved the announced size, so a leftover would look complete
+void removeUploadedFile(const String& dirPath, const String& fileName) {
+  String filePath = dirPath;
+  if (!filePath.endsWith("/")) filePath += "/";
+  filePath += fileName;
+  Storage.remove(filePath.c_str());
+  LOG_DBG("WEB", "Deleted incomplete upload: %s", filePath.c_str());
+}
+
 String normalizeWebPath(const String& inputPath) {
   if (inputPath.isEmpty() || inputPath == "/") {
     return "/";
@@ -89,6 +109,7 @@ CrossPointWebServer::CrossPointWebServer() {}
 CrossPointWebServer::~CrossPointWebServer() { stop(); }
 
 void CrossPointWebServer::begin() {
+  HEAP_SCOPE(NETWORK);
   if (running) {
     LOG_DBG("WEB", "Web server already running");
     return;
@@ -156,6 +177,11 @@ void CrossPointWebServer::begin() {
   server->on("/api/settings", HTTP_GET, [this] { handleGetSettings(); });
   server->on("/api/settings", HTTP_POST, [this] { handlePostSettings(); });
 
+#ifdef ENABLE_PERF_TRACE
+  server->on("/api/perf", HTTP_GET, [this] { handleGetPerf(); });
+  server->on("/api/perf", HTTP_DELETE, [this] { handleResetPerf(); });
+#endif
+
   server->onNotFound([this] { handleNotFound(); });
   LOG_DBG("WEB", "[MEM] Free heap after route setup: %d bytes", ESP.getFreeHeap());
 
@@ -199,11 +225,14 @@ void CrossPointWebServer::stop() {
 
   LOG_DBG("WEB", "[MEM] Free heap before stop: %d bytes", ESP.getFreeHeap());
 
-  // Close any in-progress WebSocket upload
-  if (wsUploadInProgress && wsUploadFile) {
-    wsUploadFile.close();
+  // Close any in-progress uploads
+  if (wsUploadInProgress && wsUploadWriter.isOpen()) {
+    wsUploadWriter.abort();
     wsUploadInProgress = false;
   }
+  wsJobHold.reset();
+  upload.writer.abort();
+  upload.jobHold.reset();
 
   // Stop WebSocket server
   if (wsServer) {
@@ -238,6 +267,7 @@ void CrossPointWebServer::stop() {
 }
 
 void CrossPointWebServer::handleClient() {
+  HEAP_SCOPE(NETWORK);
   static unsigned long lastDebugPrint = 0;
 
   // Check running flag FIRST before accessing server
@@ -287,6 +317,10 @@ void CrossPointWebServer::handleClient() {
   }
 }
 
+bool CrossPointWebServer::needsFastLoop() const {
+  return UploadWriter::getThroughput().active || !BACKGROUND_JOBS.hasPendingJobs();
+}
+
 CrossPointWebServer::WsUploadStatus CrossPointWebServer::getWsUploadStatus() const {
   WsUploadStatus status;
   status.inProgress = wsUploadInProgress;
@@ -327,12 +361,127 @@ void CrossPointWebServer::handleStatus() const {
   doc["freeHeap"] = ESP.getFreeHeap();
   doc["uptime"] = millis() / 1000;
 
+  // Current upload, or the last one once it has finished
+  const auto& throughput = UploadWriter::getThroughput();
+  JsonObject uploadJson = doc["upload"].to<JsonObject>();
+  uploadJson["active"] = throughput.active;
+  uploadJson["bytes"] = throughput.bytes;
+  uploadJson["total"] = throughput.expected;
+  uploadJson["elapsedMs"] = throughput.elapsedMs;
+  uploadJson["kbps"] = throughput.elapsedMs > 0 ? throughput.bytes / 1.024 / throughput.elapsedMs : 0;
+  uploadJson["sdWriteMs"] = throughput.writeMs;
+  uploadJson["sdStallMs"] = throughput.stallMs;
+
+  // Books received in this or an earlier session that are still being prepared for their first open
+  const auto prep = BookPrepJobs::getStatus();
+  JsonObject prepJson = doc["bookPrep"].to<JsonObject>();
+  prepJson["pending"] = prep.pending;
+  prepJson["current"] = prep.current;
+
   String json;
   serializeJson(doc, json);
   server->send(200, "application/json", json);
 }
 
-void CrossPointWebServer::scanFiles(const char* path, const std::function<void(FileInfo)>& callback) const {
+#ifdef ENABLE_PERF_TRACE
+void CrossPointWebServer::handleGetPerf() const {
+  JsonDocument doc;
+  doc["uptime"] = millis() / 1000;
+  doc["events"] = PERF_TRACE.getEventCount();
+
+  // Durations in microseconds; bucket b counts durations below 2^(b+1)
+  JsonArray stagesJson = doc["stages"].to<JsonArray>();
+  for (uint8_t stage = 0; stage < PerfTrace::STAGE_COUNT; stage++) {
+    const auto s = PERF_TRACE.getStats(static_cast<PerfTrace::Stage>(stage));
+    JsonObject stageJson = stagesJson.add<JsonObject>();
+    stageJson["name"] = PerfTrace::getStageName(static_cast<PerfTrace::Stage>(stage));
+    stageJson["count"] = s.count;
+    stageJson["totalUs"] = s.totalUs;
+    stageJson["avgUs"] = s.count > 0 ? s.totalUs / s.count : 0;
+    stageJson["p50Us"] = s.getPercentileUs(50);
+    stageJson["p90Us"] = s.getPercentileUs(90);
+    stageJson["p99Us"] = s.getPercentileUs(99);
+    stageJson["maxUs"] = s.maxUs;
+    JsonArray bucketsJson = stageJson["buckets"].to<JsonArray>();
+    for (const uint32_t count : s.buckets) {
+      bucketsJson.add(count);
+    }
+  }
+
+  // Tracked bytes by tag, and free heap next to its largest block over time (one sample a second). The counters are
+  // read at once, before the JSON below allocates.
+  const auto heap = HeapTrace::getHeapInfo();
+  const auto snapshot = HEAP_TRACE.getSnapshot();
+  JsonObject heapJson = doc["heap"].to<JsonObject>();
+  heapJson["free"] = heap.freeBytes;
+  heapJson["largestFreeBlock"] = heap.largestFreeBlock;
+  heapJson["lowestLargestFreeBlock"] = snapshot.lowestLargestFreeBlock;
+  heapJson["minFree"] = heap.minFreeBytes;
+  heapJson["tracked"] = snapshot.trackedBytes;
+  heapJson["trackedPeak"] = snapshot.trackedPeak;
+  JsonArray tagsJson = heapJson["tags"].to<JsonArray>();
+  for (uint8_t tag = 0; tag < HeapTrace::TAG_COUNT; tag++) {
+    const auto& s = snapshot.stats[tag];
+    JsonObject tagJson = tagsJson.add<JsonObject>();
+    tagJson["name"] = HeapTrace::getTagName(static_cast<HeapTrace::Tag>(tag));
+    tagJson["live"] = s.liveBytes;
+    tagJson["peak"] = s.peakBytes;
+    tagJson["blocks"] = s.liveBlocks;
+    tagJson["allocations"] = s.allocations;
+    tagJson["largest"] = s.largestBlock;
+    tagJson["failures"] = s.failures;
+  }
+  if (snapshot.hasFailure) {
+    const auto& failure = snapshot.lastFailure;
+    JsonObject failureJson = heapJson["lastFailure"].to<JsonObject>();
+    failureJson["ms"] = failure.timeMs;
+    failureJson["tag"] = HeapTrace::getTagName(static_cast<HeapTrace::Tag>(failure.tag));
+    failureJson["size"] = failure.size;
+    failureJson["free"] = failure.heap.freeBytes;
+    failureJson["largestFreeBlock"] = failure.heap.largestFreeBlock;
+  }
+  std::unique_ptr<HeapTrace::Sample[]> samples(new (std::nothrow) HeapTrace::Sample[HeapTrace::SAMPLE_COUNT]);
+  if (samples) {
+    const size_t count = HEAP_TRACE.copySamples(samples.get(), HeapTrace::SAMPLE_COUNT);
+    JsonArray samplesJson = heapJson["samples"].to<JsonArray>();
+    for (size_t i = 0; i < count; i++) {
+      JsonObject sampleJson = samplesJson.add<JsonObject>();
+      sampleJson["ms"] = samples[i].timeMs;
+      sampleJson["free"] = samples[i].freeBytes;
+      sampleJson["largest"] = samples[i].largestFreeBlock;
+      sampleJson["tracked"] = samples[i].trackedBytes;
+    }
+  }
+
+  // ?recent=N adds the last N begin/end events, oldest first
+  if (server->hasArg("recent")) {
+    const size_t wanted = std::min<long>(std::max<long>(server->arg("recent").toInt(), 0), PerfTrace::RING_SIZE);
+    std::unique_ptr<PerfTrace::Event[]> events(new (std::nothrow) PerfTrace::Event[wanted]);
+    if (events) {
+      const size_t count = PERF_TRACE.copyEvents(events.get(), wanted);
+      JsonArray recentJson = doc["recent"].to<JsonArray>();
+      for (size_t i = 0; i < count; i++) {
+        JsonObject eventJson = recentJson.add<JsonObject>();
+        eventJson["us"] = events[i].timeUs;
+        eventJson["stage"] = PerfTrace::getStageName(static_cast<PerfTrace::Stage>(events[i].stage));
+        eventJson["end"] = events[i].end;
+      }
+    }
+  }
+
+  String json;
+  serializeJson(doc, json);
+  server->send(200, "application/json", json);
+}
+
+void CrossPointWebServer::handleResetPerf() const {
+  PERF_TRACE.reset();
+  HEAP_TRACE.reset();
+  server->send(200, "text/plain", "OK");
+}
+#endif
+
+void CrossPointWebServer::scanFiles(const char* path, const std::function<void(const FileInfo&)>& callback) const {
   FsFile root = Storage.open(path);
   if (!root) {
     LOG_DBG("WEB", "Failed to open directory: %s", path);
@@ -351,24 +500,18 @@ void CrossPointWebServer::scanFiles(const char* path, const std::function<void(F
   char name[500];
   while (file) {
     file.getName(name, sizeof(name));
-    auto fileName = String(name);
 
     // Skip hidden items (starting with ".")
-    bool shouldHide = fileName.startsWith(".");
+    bool shouldHide = name[0] == '.';
 
     // Check against explicitly hidden items list
-    if (!shouldHide) {
-      for (size_t i = 0; i < HIDDEN_ITEMS_COUNT; i++) {
-        if (fileName.equals(HIDDEN_ITEMS[i])) {
-          shouldHide = true;
-          break;
-        }
-      }
+    for (size_t i = 0; i < HIDDEN_ITEMS_COUNT && !shouldHide; i++) {
+      shouldHide = strcmp(name, HIDDEN_ITEMS[i]) == 0;
     }
 
     if (!shouldHide) {
       FileInfo info;
-      info.name = fileName;
+      info.name = name;
       info.isDirectory = file.isDirectory();
 
       if (info.isDirectory) {
@@ -376,7 +519,7 @@ void CrossPointWebServer::scanFiles(const char* path, const std::function<void(F
         info.isEpub = false;
       } else {
         info.size = file.size();
-        info.isEpub = isEpubFile(info.name);
+        info.isEpub = FsHelpers::hasEpubExtension(std::string_view{name});
       }
 
       callback(info);
@@ -413,34 +556,20 @@ void CrossPointWebServer::handleFileListData() const {
 
   server->setContentLength(CONTENT_LENGTH_UNKNOWN);
   server->send(200, "application/json", "");
-  server->sendContent("[");
-  char output[512];
-  constexpr size_t outputSize = sizeof(output);
+  DirectoryListing::ChunkedWriter out([this](const char* data, size_t len) { server->sendContent(data, len); });
+  out.write('[');
   bool seenFirst = false;
-  JsonDocument doc;
-
-  scanFiles(currentPath.c_str(), [this, &output, &doc, seenFirst](const FileInfo& info) mutable {
-    doc.clear();
-    doc["name"] = info.name;
-    doc["size"] = info.size;
-    doc["isDirectory"] = info.isDirectory;
-    doc["isEpub"] = info.isEpub;
-
-    const size_t written = serializeJson(doc, output, outputSize);
-    if (written >= outputSize) {
-      // JSON output truncated; skip this entry to avoid sending malformed JSON
-      LOG_DBG("WEB", "Skipping file entry with oversized JSON for name: %s", info.name.c_str());
-      return;
-    }
 
+  scanFiles(currentPath.c_str(), [&out, &seenFirst](const FileInfo& info) {
     if (seenFirst) {
-      server->sendContent(",");
+      out.write(',');
     } else {
       seenFirst = true;
     }
-    server->sendContent(output);
+    DirectoryListing::writeFileJson(out, info.name, info.size, info.isDirectory, info.isEpub);
   });
-  server->sendContent("]");
+  out.write(']');
+  out.flush();
   // End of streamed response, empty chunk to signal client
   server->sendContent("");
   LOG_DBG("WEB", "Served file listing page for path: %s", currentPath.c_str());
@@ -509,29 +638,8 @@ void CrossPointWebServer::handleDownload() const {
   file.close();
 }
 
-// Diagnostic counters for upload performance analysis
+// Start of the current form upload, for the progress log
 static unsigned long uploadStartTime = 0;
-static unsigned long totalWriteTime = 0;
-static size_t writeCount = 0;
-
-static bool flushUploadBuffer(CrossPointWebServer::UploadState& state) {
-  if (state.bufferPos > 0 && state.file) {
-    esp_task_wdt_reset();  // Reset watchdog before potentially slow SD write
-    const unsigned long writeStart = millis();
-    const size_t written = state.file.write(state.buffer.data(), state.bufferPos);
-    totalWriteTime += millis() - writeStart;
-    writeCount++;
-    esp_task_wdt_reset();  // Reset watchdog after SD write
-
-    if (written != state.bufferPos) {
-      LOG_DBG("WEB", "[UPLOAD] Buffer flush failed: expected %d, wrote %d", state.bufferPos, written);
-      state.bufferPos = 0;
-      return false;
-    }
-    state.bufferPos = 0;
-  }
-  return true;
-}
 
 void CrossPointWebServer::handleUpload(UploadState& state) const {
   static size_t lastLoggedSize = 0;
@@ -557,9 +665,6 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
     state.error = "";
     uploadStartTime = millis();
     lastLoggedSize = 0;
-    state.bufferPos = 0;
-    totalWriteTime = 0;
-    writeCount = 0;
 
     // Get upload path from query parameter (defaults to root if not specified)
     // Note: We use query parameter instead of form data because multipart form
@@ -586,6 +691,10 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
     if (!filePath.endsWith("/")) filePath += "/";
     filePath += state.fileName;
 
+    // Background jobs stay off the SD card until the upload is done: one may have the book being replaced, or its
+    // cache, open. Released at the end of the upload or in handleUploadPost.
+    state.jobHold.emplace();
+
     // Check if file already exists - SD operations can be slow
     esp_task_wdt_reset();
     if (Storage.exists(filePath.c_str())) {
@@ -594,40 +703,28 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
       Storage.remove(filePath.c_str());
     }
 
-    // Open file for writing - this can be slow due to FAT cluster allocation
+    // Open file for writing and reserve its clusters - the request length slightly overestimates the file, the
+    // writer trims it when the upload ends
     esp_task_wdt_reset();
-    if (!Storage.openFileForWrite("WEB", filePath, state.file)) {
+    if (!state.writer.begin(filePath.c_str(), server->clientContentLength())) {
       state.error = "Failed to create file on SD card";
       LOG_DBG("WEB", "[UPLOAD] FAILED to create file: %s", filePath.c_str());
+      Storage.remove(filePath.c_str());
+      state.jobHold.reset();
       return;
     }
     esp_task_wdt_reset();
 
     LOG_DBG("WEB", "[UPLOAD] File created successfully: %s", filePath.c_str());
   } else if (upload.status == UPLOAD_FILE_WRITE) {
-    if (state.file && state.error.isEmpty()) {
-      // Buffer incoming data and flush when buffer is full
-      // This reduces SD card write operations and improves throughput
-      const uint8_t* data = upload.buf;
-      size_t remaining = upload.currentSize;
-
-      while (remaining > 0) {
-        const size_t space = UploadState::UPLOAD_BUFFER_SIZE - state.bufferPos;
-        const size_t toCopy = (remaining < space) ? remaining : space;
-
-        memcpy(state.buffer.data() + state.bufferPos, data, toCopy);
-        state.bufferPos += toCopy;
-        data += toCopy;
-        remaining -= toCopy;
-
-        // Flush buffer when full
-        if (state.bufferPos >= UploadState::UPLOAD_BUFFER_SIZE) {
-          if (!flushUploadBuffer(state)) {
-            state.error = "Failed to write to SD card - disk may be full";
-            state.file.close();
-            return;
-          }
-        }
+    if (state.writer.isOpen() && state.error.isEmpty()) {
+      // The writer task drains full buffers to the SD card while the next packets are received
+      if (!state.writer.append(upload.buf, upload.currentSize)) {
+        state.error = "Failed to write to SD card - disk may be full";
+        state.writer.abort();
+        removeUploadedFile(state.path, state.fileName);
+        state.jobHold.reset();
+        return;
       }
 
       state.size += upload.currentSize;
@@ -636,52 +733,52 @@ void CrossPointWebServer::handleUpload(UploadState& state) const {
       if (state.size - lastLoggedSize >= 102400) {
         const unsigned long elapsed = millis() - uploadStartTime;
         const float kbps = (elapsed > 0) ? (state.size / 1024.0) / (elapsed / 1000.0) : 0;
-        LOG_DBG("WEB", "[UPLOAD] %d bytes (%.1f KB), %.1f KB/s, %d writes", state.size, state.size / 1024.0, kbps,
-                writeCount);
+        LOG_DBG("WEB", "[UPLOAD] %d bytes (%.1f KB), %.1f KB/s", state.size, state.size / 1024.0, kbps);
         lastLoggedSize = state.size;
       }
     }
   } else if (upload.status == UPLOAD_FILE_END) {
-    if (state.file) {
-      // Flush any remaining buffered data
-      if (!flushUploadBuffer(state)) {
+    if (state.writer.isOpen()) {
+      // Write any remaining buffered data and wait for the writer
+      if (!state.writer.finish()) {
         state.error = "Failed to write final data to SD card";
+        removeUploadedFile(state.path, state.fileName);
       }
-      state.file.close();
 
       if (state.error.isEmpty()) {
         state.success = true;
         const unsigned long elapsed = millis() - uploadStartTime;
         const float avgKbps = (elapsed > 0) ? (state.size / 1024.0) / (elapsed / 1000.0) : 0;
-        const float writePercent = (elapsed > 0) ? (totalWriteTime * 100.0 / elapsed) : 0;
+        const auto& throughput = UploadWriter::getThroughput();
         LOG_DBG("WEB", "[UPLOAD] Complete: %s (%d bytes in %lu ms, avg %.1f KB/s)", state.fileName.c_str(), state.size,
                 elapsed, avgKbps);
-        LOG_DBG("WEB", "[UPLOAD] Diagnostics: %d writes, total write time: %lu ms (%.1f%%)", writeCount, totalWriteTime,
-                writePercent);
+        LOG_DBG("WEB", "[UPLOAD] Diagnostics: SD write time %lu ms, waited %lu ms for free buffers",
+                throughput.writeMs, throughput.stallMs);
 
         // Clear epub cache to prevent stale metadata issues when overwriting files
         String filePath = state.path;
         if (!filePath.endsWith("/")) filePath += "/";
         filePath += state.fileName;
         clearEpubCacheIfNeeded(filePath);
+        // Build the book caches and thumbnails while the device waits for the next transfer
+        BookPrepJobs::queue(filePath.c_str());
+        LIBRARY_INDEX.noteChanged(filePath.c_str());
       }
     }
+    state.jobHold.reset();
   } else if (upload.status == UPLOAD_FILE_ABORTED) {
-    state.bufferPos = 0;  // Discard buffered data
-    if (state.file) {
-      state.file.close();
-      // Try to delete the incomplete file
-      String filePath = state.path;
-      if (!filePath.endsWith("/")) filePath += "/";
-      filePath += state.fileName;
-      Storage.remove(filePath.c_str());
+    if (state.writer.isOpen()) {
+      state.writer.abort();  // Discard buffered data
+      removeUploadedFile(state.path, state.fileName);
     }
+    state.jobHold.reset();
     state.error = "Upload aborted";
     LOG_DBG("WEB", "Upload aborted");
   }
 }
 
 void CrossPointWebServer::handleUploadPost(UploadState& state) const {
+  state.jobHold.reset();
   if (state.success) {
     server->send(200, "text/plain", "File uploaded successfully: " + state.fileName);
   } else {
@@ -733,6 +830,7 @@ void CrossPointWebServer::handleCreateFolder() const {
   // Create the folder
   if (Storage.mkdir(folderPath.c_str())) {
     LOG_DBG("WEB", "Folder created successfully: %s", folderPath.c_str());
+    LIBRARY_INDEX.noteChanged(folderPath.c_str());
     server->send(200, "text/plain", "Folder created: " + folderName);
   } else {
     LOG_DBG("WEB", "Failed to create folder: %s", folderPath.c_str());
@@ -809,12 +907,16 @@ void CrossPointWebServer::handleRename() const {
     return;
   }
 
+  // No background job may have the book or its cache open while they are renamed and cleared
+  const BackgroundJobQueue::Hold jobHold;
   clearEpubCacheIfNeeded(itemPath);
   const bool success = file.rename(newPath.c_str());
   file.close();
 
   if (success) {
     LOG_DBG("WEB", "Renamed file: %s -> %s", itemPath.c_str(), newPath.c_str());
+    LIBRARY_INDEX.noteChanged(itemPath.c_str());
+    LIBRARY_INDEX.noteChanged(newPath.c_str());
     server->send(200, "text/plain", "Renamed successfully");
   } else {
     LOG_ERR("WEB", "Failed to rename file: %s -> %s", itemPath.c_str(), newPath.c_str());
@@ -902,12 +1004,16 @@ void CrossPointWebServer::handleMove() const {
     return;
   }
 
+  // No background job may have the book or its cache open while they are renamed and cleared
+  const BackgroundJobQueue::Hold jobHold;
   clearEpubCacheIfNeeded(itemPath);
   const bool success = file.rename(newPath.c_str());
   file.close();
 
   if (success) {
     LOG_DBG("WEB", "Moved file: %s -> %s", itemPath.c_str(), newPath.c_str());
+    LIBRARY_INDEX.noteChanged(itemPath.c_str());
+    LIBRARY_INDEX.noteChanged(newPath.c_str());
     server->send(200, "text/plain", "Moved successfully");
   } else {
     LOG_ERR("WEB", "Failed to move file: %s -> %s", itemPath.c_str(), newPath.c_str());
@@ -937,7 +1043,8 @@ void CrossPointWebServer::handleDelete() const {
     return;
   }
 
-  // Iterate over paths and delete each item
+  // Iterate over paths and delete each item, with background jobs kept off the books and caches being removed
+  const BackgroundJobQueue::Hold jobHold;
   bool allSuccess = true;
   String failedItems;
 
@@ -1009,7 +1116,9 @@ void CrossPointWebServer::handleDelete() const {
       clearEpubCacheIfNeeded(itemPath);
     }
 
-    if (!success) {
+    if (success) {
+      LIBRARY_INDEX.noteChanged(itemPath.c_str());
+    } else {
       failedItems += itemPath + " (deletion failed); ";
       allSuccess = false;
     }
@@ -1203,16 +1312,12 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
     case WStype_DISCONNECTED:
       LOG_DBG("WS", "Client %u disconnected", num);
       // Clean up any in-progress upload
-      if (wsUploadInProgress && wsUploadFile) {
-        wsUploadFile.close();
-        // Delete incomplete file
-        String filePath = wsUploadPath;
-        if (!filePath.endsWith("/")) filePath += "/";
-        filePath += wsUploadFileName;
-        Storage.remove(filePath.c_str());
-        LOG_DBG("WS", "Deleted incomplete upload: %s", filePath.c_str());
+      if (wsUploadInProgress && wsUploadWriter.isOpen()) {
+        wsUploadWriter.abort();
+        removeUploadedFile(wsUploadPath, wsUploadFileName);
       }
       wsUploadInProgress = false;
+      wsJobHold.reset();
       break;
 
     case WStype_CONNECTED: {
@@ -1251,17 +1356,22 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
           LOG_DBG("WS", "Starting upload: %s (%d bytes) to %s", wsUploadFileName.c_str(), wsUploadSize,
                   filePath.c_str());
 
+          // Background jobs stay off the SD card until the upload is done, as in handleUpload
+          wsJobHold.emplace();
+
           // Check if file exists and remove it
           esp_task_wdt_reset();
           if (Storage.exists(filePath.c_str())) {
             Storage.remove(filePath.c_str());
           }
 
-          // Open file for writing
+          // Open file for writing, reserving the announced size
           esp_task_wdt_reset();
-          if (!Storage.openFileForWrite("WS", filePath, wsUploadFile)) {
+          if (!wsUploadWriter.begin(filePath.c_str(), wsUploadSize)) {
+            Storage.remove(filePath.c_str());
             wsServer->sendTXT(num, "ERROR:Failed to create file");
             wsUploadInProgress = false;
+            wsJobHold.reset();
             return;
           }
           esp_task_wdt_reset();
@@ -1276,24 +1386,23 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
     }
 
     case WStype_BIN: {
-      if (!wsUploadInProgress || !wsUploadFile) {
+      if (!wsUploadInProgress || !wsUploadWriter.isOpen()) {
         wsServer->sendTXT(num, "ERROR:No upload in progress");
         return;
       }
 
-      // Write binary data directly to file
+      // Hand the frame to the writer; the SD write overlaps with receiving the next frames
       esp_task_wdt_reset();
-      size_t written = wsUploadFile.write(payload, length);
-      esp_task_wdt_reset();
-
-      if (written != length) {
-        wsUploadFile.close();
+      if (!wsUploadWriter.append(payload, length)) {
+        wsUploadWriter.abort();
+        removeUploadedFile(wsUploadPath, wsUploadFileName);
         wsUploadInProgress = false;
+        wsJobHold.reset();
         wsServer->sendTXT(num, "ERROR:Write failed - disk full?");
         return;
       }
 
-      wsUploadReceived += written;
+      wsUploadReceived += length;
 
       // Send progress update (every 64KB or at end)
       static size_t lastProgressSent = 0;
@@ -1305,8 +1414,15 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
 
       // Check if upload complete
       if (wsUploadReceived >= wsUploadSize) {
-        wsUploadFile.close();
+        const bool written = wsUploadWriter.finish();
         wsUploadInProgress = false;
+        if (!written) {
+          removeUploadedFile(wsUploadPath, wsUploadFileName);
+          wsJobHold.reset();
+          wsServer->sendTXT(num, "ERROR:Write failed - disk full?");
+          lastProgressSent = 0;
+          return;
+        }
 
         wsLastCompleteName = wsUploadFileName;
         wsLastCompleteSize = wsUploadSize;
@@ -1323,6 +1439,9 @@ void CrossPointWebServer::onWebSocketEvent(uint8_t num, WStype_t type, uint8_t*
         if (!filePath.endsWith("/")) filePath += "/";
         filePath += wsUploadFileName;
         clearEpubCacheIfNeeded(filePath);
+        BookPrepJobs::queue(filePath.c_str());
+        LIBRARY_INDEX.noteChanged(filePath.c_str());
+        wsJobHold.reset();
 
         wsServer->sendTXT(num, "DONE");
         lastProgressSent = 0;
@@ -6,12 +6,15 @@
 #include <WebSocketsServer.h>
 
 #include <memory>
+#include <optional>
 #include <string>
-#include <vector>
+
+#include "BackgroundJobQueue.h"
+#include "UploadWriter.h"
 
 // Structure to hold file information
 struct FileInfo {
-  String name;
+  const char* name;  // only valid during the scanFiles callback
   size_t size;
   bool isEpub;
   bool isDirectory;
@@ -31,21 +34,13 @@ class CrossPointWebServer {
 
   // Used by POST upload handler
   struct UploadState {
-    FsFile file;
+    UploadWriter writer;
     String fileName;
     String path = "/";
     size_t size = 0;
     bool success = false;
     String error = "";
-
-    // Upload write buffer - batches small writes into larger SD card operations
-    // 4KB is a good balance: large enough to reduce syscall overhead, small enough
-    // to keep individual write times short and avoid watchdog issues
-    static constexpr size_t UPLOAD_BUFFER_SIZE = 4096;  // 4KB buffer
-    std::vector<uint8_t> buffer;
-    size_t bufferPos = 0;
-
-    UploadState() { buffer.resize(UPLOAD_BUFFER_SIZE); }
+    std::optional<BackgroundJobQueue::Hold> jobHold;  // held from the start of an upload until it ends
   } upload;
 
   CrossPointWebServer();
@@ -63,6 +58,9 @@ class CrossPointWebServer {
   // Check if server is running
   bool isRunning() const { return running; }
 
+  // An upload needs the loop to run flat out; otherwise idle time goes to preparing received books
+  bool needsFastLoop() const;
+
   WsUploadStatus getWsUploadStatus() const;
 
   // Get the port number
@@ -83,7 +81,7 @@ class CrossPointWebServer {
   static void wsEventCallback(uint8_t num, WStype_t type, uint8_t* payload, size_t length);
 
   // File scanning
-  void scanFiles(const char* path, const std::function<void(FileInfo)>& callback) const;
+  void scanFiles(const char* path, const std::function<void(const FileInfo&)>& callback) const;
   String formatFileSize(size_t bytes) const;
   bool isEpubFile(const String& filename) const;
 
@@ -105,4 +103,10 @@ class CrossPointWebServer {
   void handleSettingsPage() const;
   void handleGetSettings() const;
   void handlePostSettings();
+
+#ifdef ENABLE_PERF_TRACE
+  // Stage timings and heap usage of perf builds
+  void handleGetPerf() const;
+  void handleResetPerf() const;
+#endif
 };
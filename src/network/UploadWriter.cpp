@@ -0,0 +1,199 @@
+#include "UploadWriter.h"
+
+#include <Arduino.h>
+#include <Logging.h>
+#include <esp_task_wdt.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+UploadWriter::Throughput UploadWriter::throughput;
+
+namespace {
+// Same priority as the loop task, so receiving and writing share the CPU while the card is busy
+constexpr UBaseType_t WRITER_PRIORITY = 1;
+constexpr uint32_t WRITER_STACK_SIZE = 4096;
+constexpr TickType_t WAIT_SLICE = pdMS_TO_TICKS(100);
+}  // namespace
+
+UploadWriter::~UploadWriter() { abort(); }
+
+bool UploadWriter::begin(const char* path, const size_t expectedSize) {
+  abort();
+
+  for (auto& buffer : buffers) {
+    buffer = static_cast<uint8_t*>(malloc(BUFFER_SIZE));
+    if (!buffer) {
+      LOG_ERR("UPW", "Failed to allocate upload buffers (%zu x %zu bytes)", BUFFER_COUNT, BUFFER_SIZE);
+      stopWriter();
+      return false;
+    }
+  }
+
+  esp_task_wdt_reset();
+  if (!Storage.openFileForWrite("UPW", path, file)) {
+    stopWriter();
+    return false;
+  }
+
+  // Reserve contiguous clusters up front; a fragmented card just falls back to growing the file as usual
+  preAllocated = expectedSize > 0 && file.preAllocate(expectedSize);
+  if (expectedSize > 0 && !preAllocated) {
+    LOG_DBG("UPW", "Could not pre-allocate %zu bytes for %s", expectedSize, path);
+  }
+  esp_task_wdt_reset();
+
+  fullQueue = xQueueCreate(BUFFER_COUNT + 1, sizeof(Chunk));
+  freeQueue = xQueueCreate(BUFFER_COUNT, sizeof(uint8_t));
+  writerDone = xSemaphoreCreateBinary();
+  if (!fullQueue || !freeQueue || !writerDone) {
+    LOG_ERR("UPW", "Failed to create upload queues");
+    file.close();
+    stopWriter();
+    return false;
+  }
+  for (uint8_t i = 1; i < BUFFER_COUNT; i++) {
+    xQueueSend(freeQueue, &i, 0);
+  }
+
+  fillIndex = 0;
+  fillLen = 0;
+  received = 0;
+  error = false;
+  discard = false;
+  startTime = millis();
+  throughput = Throughput{};
+  throughput.active = true;
+  throughput.expected = expectedSize;
+
+  if (xTaskCreate(&writerTrampoline, "UploadWriter", WRITER_STACK_SIZE, this, WRITER_PRIORITY, &writerTask) != pdPASS) {
+    LOG_ERR("UPW", "Failed to create writer task");
+    writerTask = nullptr;
+    file.close();
+    stopWriter();
+    throughput.active = false;
+    return false;
+  }
+  return true;
+}
+
+void UploadWriter::writerTrampoline(void* param) { static_cast<UploadWriter*>(param)->writerLoop(); }
+
+void UploadWriter::writerLoop() {
+  Chunk chunk;
+  while (xQueueReceive(fullQueue, &chunk, portMAX_DELAY) == pdTRUE && chunk.len > 0) {
+    if (!error && !discard) {
+      const unsigned long writeStart = millis();
+      const size_t written = file.write(buffers[chunk.index], chunk.len);
+      throughput.writeMs += millis() - writeStart;
+      if (written != chunk.len) {
+        LOG_ERR("UPW", "Write failed: expected %u, wrote %zu", chunk.len, written);
+        error = true;
+      }
+    }
+    xQueueSend(freeQueue, &chunk.index, portMAX_DELAY);
+  }
+
+  // Nothing of this object may be touched once the owner sees writerDone
+  xSemaphoreGive(writerDone);
+  vTaskDelete(nullptr);
+}
+
+void UploadWriter::submit(const uint16_t len) {
+  const Chunk chunk{fillIndex, len};
+  xQueueSend(fullQueue, &chunk, portMAX_DELAY);
+  fillLen = 0;
+}
+
+void UploadWriter::takeFreeBuffer() {
+  const unsigned long waitStart = millis();
+  while (xQueueReceive(freeQueue, &fillIndex, WAIT_SLICE) != pdTRUE) {
+    esp_task_wdt_reset();
+  }
+  throughput.stallMs += millis() - waitStart;
+}
+
+bool UploadWriter::append(const uint8_t* data, size_t len) {
+  if (!isOpen() || error) {
+    return false;
+  }
+
+  received += len;
+  while (len > 0) {
+    const size_t toCopy = std::min(len, BUFFER_SIZE - fillLen);
+    memcpy(buffers[fillIndex] + fillLen, data, toCopy);
+    fillLen += toCopy;
+    data += toCopy;
+    len -= toCopy;
+
+    if (fillLen == BUFFER_SIZE) {
+      submit(BUFFER_SIZE);
+      takeFreeBuffer();
+    }
+  }
+
+  throughput.bytes = received;
+  throughput.elapsedMs = millis() - startTime;
+  return !error;
+}
+
+void UploadWriter::stopWriter() {
+  if (writerTask) {
+    const Chunk stop{0, 0};
+    xQueueSend(fullQueue, &stop, portMAX_DELAY);
+    while (xSemaphoreTake(writerDone, WAIT_SLICE) != pdTRUE) {
+      esp_task_wdt_reset();
+    }
+    writerTask = nullptr;
+  }
+
+  if (fullQueue) vQueueDelete(fullQueue);
+  if (freeQueue) vQueueDelete(freeQueue);
+  if (writerDone) vSemaphoreDelete(writerDone);
+  fullQueue = nullptr;
+  freeQueue = nullptr;
+  writerDone = nullptr;
+
+  for (auto& buffer : buffers) {
+    free(buffer);
+    buffer = nullptr;
+  }
+}
+
+bool UploadWriter::finish() {
+  if (!isOpen()) {
+    return false;
+  }
+
+  if (fillLen > 0) {
+    submit(fillLen);
+  }
+  stopWriter();
+
+  // Give back the clusters reserved beyond the data (Content-Length includes the multipart framing)
+  if (preAllocated && !error && !file.truncate(received)) {
+    LOG_ERR("UPW", "Failed to trim pre-allocated file to %zu bytes", received);
+    error = true;
+  }
+  file.close();
+
+  throughput.active = false;
+  throughput.bytes = received;
+  throughput.elapsedMs = millis() - startTime;
+  LOG_DBG("UPW", "Wrote %zu bytes in %lu ms (%lu ms in SD writes, %lu ms waiting for the card)", received,
+          throughput.elapsedMs, throughput.writeMs, throughput.stallMs);
+  return !error;
+}
+
+void UploadWriter::abort() {
+  if (!isOpen()) {
+    stopWriter();
+    return;
+  }
+
+  discard = true;
+  stopWriter();
+  file.close();
+  throughput.active = false;
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <HalStorage.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Pipelined SD writer for file uploads (upload form, WebSocket and WebDAV PUT).
+ *
+ * The web server task copies received data into one buffer while a writer task drains the other to the file, so
+ * receiving from the network and writing to the card overlap instead of taking turns. Buffers are a whole number of
+ * sectors and are only handed over full, so every write but the last starts and ends on a sector boundary and SdFat
+ * passes it to the card as one multi-sector write. When the size is known up front the file is pre-allocated, which
+ * saves extending the FAT chain cluster by cluster. append() blocks, feeding the watchdog, while both buffers wait.
+ */
+class UploadWriter {
+ public:
+  static constexpr size_t BUFFER_SIZE = 8192;  // 16 sectors
+  static constexpr size_t BUFFER_COUNT = 2;
+
+  // Upload in flight, or the last one once it ended (reported by /api/status)
+  struct Throughput {
+    bool active = false;
+    size_t bytes = 0;
+    size_t expected = 0;  // 0 if the client did not announce a size
+    unsigned long elapsedMs = 0;
+    unsigned long writeMs = 0;  // time the writer task spent in SD writes
+    unsigned long stallMs = 0;  // time the receiver waited for a free buffer
+  };
+
+  UploadWriter() = default;
+  ~UploadWriter();
+
+  UploadWriter(const UploadWriter&) = delete;
+  UploadWriter& operator=(const UploadWriter&) = delete;
+
+  // Creates `path` and starts the writer task. expectedSize (0 = unknown) is pre-allocated; it may overestimate.
+  bool begin(const char* path, size_t expectedSize);
+  // Returns false once any write has failed
+  bool append(const uint8_t* data, size_t len);
+  // Writes the remaining data and closes the file. Returns false if any write failed; the caller removes the file.
+  bool finish();
+  // Drops pending data and closes the file; removing it is up to the caller
+  void abort();
+
+  bool isOpen() const { return writerTask != nullptr; }
+  size_t getBytesReceived() const { return received; }
+
+  static const Throughput& getThroughput() { return throughput; }
+
+ private:
+  struct Chunk {
+    uint8_t index;
+    uint16_t len;  // 0 stops the writer
+  };
+
+  static void writerTrampoline(void* param);
+  void writerLoop();
+  void submit(uint16_t len);
+  void takeFreeBuffer();
+  void stopWriter();
+
+  FsFile file;
+  uint8_t* buffers[BUFFER_COUNT] = {};
+  QueueHandle_t fullQueue = nullptr;  // Chunk, receiver -> writer
+  QueueHandle_t freeQueue = nullptr;  // buffer index, writer -> receiver
+  SemaphoreHandle_t writerDone = nullptr;
+  TaskHandle_t writerTask = nullptr;
+
+  uint8_t fillIndex = 0;
+  size_t fillLen = 0;
+  size_t received = 0;
+  unsigned long startTime = 0;
+  bool preAllocated = false;
+  volatile bool error = false;
+  volatile bool discard = false;
+
+  static Throughput throughput;
+};
@@ -1,11 +1,17 @@
 #include "WebDAVHandler.h"
 
+#include <DirectoryListing.h>
 #include <Epub.h>
 #include <FsHelpers.h>
 #include <HalStorage.h>
 #include <Logging.h>
 #include <esp_task_wdt.h>
 
+#include <cstring>
+
+#include "LibraryIndex.h"
+#include "util/BookPrepJobs.h"
+
 namespace {
 const char* HIDDEN_ITEMS[] = {"System Volume Information", "XTCache"};
 constexpr size_t HIDDEN_ITEMS_COUNT = sizeof(HIDDEN_ITEMS) / sizeof(HIDDEN_ITEMS[0]);
@@ -63,7 +69,7 @@ void WebDAVHandler::raw(WebServer& server, const String& uri, HTTPRaw& raw) {
       }
     }
 
-    if (_putFile) _putFile.close();
+    _putWriter.abort();
     _putExisted = Storage.exists(_putPath.c_str());
 
     if (_putExisted) {
@@ -76,23 +82,29 @@ void WebDAVHandler::raw(WebServer& server, const String& uri, HTTPRaw& raw) {
       if (existing) existing.close();
     }
 
+    // Background jobs stay off the SD card until handlePut has replaced the book and cleared its cache
+    _putHold.emplace();
+
     // Write to a temp file to avoid destroying the original on failed upload
     String tempPath = _putPath + ".davtmp";
     Storage.remove(tempPath.c_str());
-    _putOk = Storage.openFileForWrite("DAV", tempPath, _putFile);
+    _putOk = _putWriter.begin(tempPath.c_str(), server.clientContentLength());
     LOG_DBG("DAV", "PUT START: %s", _putPath.c_str());
 
   } else if (raw.status == RAW_WRITE) {
-    if (_putFile && _putOk) {
+    if (_putWriter.isOpen() && _putOk) {
       esp_task_wdt_reset();
-      size_t written = _putFile.write(raw.buf, raw.currentSize);
-      if (written != raw.currentSize) {
-        _putOk = false;
-      }
+      _putOk = _putWriter.append(raw.buf, raw.currentSize);
     }
 
   } else if (raw.status == RAW_END) {
-    if (_putFile) _putFile.close();
+    if (_putWriter.isOpen()) {
+      if (_putOk) {
+        _putOk = _putWriter.finish();
+      } else {
+        _putWriter.abort();
+      }
+    }
     if (_putOk) {
       String tempPath = _putPath + ".davtmp";
       if (_putExisted) Storage.remove(_putPath.c_str());
@@ -108,10 +120,11 @@ void WebDAVHandler::raw(WebServer& server, const String& uri, HTTPRaw& raw) {
     LOG_DBG("DAV", "PUT END: %u bytes, ok=%d", raw.totalSize, _putOk);
 
   } else if (raw.status == RAW_ABORTED) {
-    if (_putFile) _putFile.close();
+    _putWriter.abort();
     String tempPath = _putPath + ".davtmp";
     Storage.remove(tempPath.c_str());
     _putOk = false;
+    _putHold.reset();
   }
 }
 
@@ -183,118 +196,61 @@ void WebDAVHandler::handlePropfind(WebServer& s) {
   }
 
   FsFile root = Storage.open(path.c_str());
-  if (!root) {
-    if (path == "/") {
-      // Root should always work — send minimal response
-      s.setContentLength(CONTENT_LENGTH_UNKNOWN);
-      s.send(207, "application/xml; charset=\"utf-8\"", "");
-      s.sendContent(
-          "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
-          "<D:multistatus xmlns:D=\"DAV:\">\n");
-      sendPropEntry(s, "/", true, 0, FIXED_DATE);
-      s.sendContent("</D:multistatus>\n");
-      s.sendContent("");
-      return;
-    }
+  if (!root && path != "/") {
     s.send(500, "text/plain", "Failed to open");
     return;
   }
 
-  bool isDir = root.isDirectory();
-
   s.setContentLength(CONTENT_LENGTH_UNKNOWN);
   s.send(207, "application/xml; charset=\"utf-8\"", "");
-  s.sendContent(
+  DirectoryListing::ChunkedWriter out([&s](const char* data, size_t len) { s.sendContent(data, len); });
+  out.write(
       "<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
       "<D:multistatus xmlns:D=\"DAV:\">\n");
 
-  // Entry for the resource itself
-  if (isDir) {
-    sendPropEntry(s, path, true, 0, FIXED_DATE);
+  if (!root) {
+    // Root should always work — send minimal response
+    DirectoryListing::writePropResponse(out, "/", nullptr, true, 0, nullptr, FIXED_DATE);
+  } else if (!root.isDirectory()) {
+    DirectoryListing::writePropResponse(out, path.c_str(), nullptr, false, root.size(), getMimeType(path.c_str()),
+                                        FIXED_DATE);
   } else {
-    sendPropEntry(s, path, false, root.size(), FIXED_DATE);
-    root.close();
-    s.sendContent("</D:multistatus>\n");
-    s.sendContent("");
-    return;
-  }
-
-  // If depth > 0 and it's a directory, list children
-  if (depth > 0) {
-    FsFile file = root.openNextFile();
-    char name[500];
-    while (file) {
-      file.getName(name, sizeof(name));
-      String fileName(name);
-
-      // Skip hidden/protected items
-      bool shouldHide = fileName.startsWith(".");
-      if (!shouldHide) {
-        for (size_t i = 0; i < HIDDEN_ITEMS_COUNT; i++) {
-          if (fileName.equals(HIDDEN_ITEMS[i])) {
-            shouldHide = true;
-            break;
-          }
+    // Entry for the resource itself
+    DirectoryListing::writePropResponse(out, path.c_str(), nullptr, true, 0, nullptr, FIXED_DATE);
+
+    // If depth > 0, list children
+    if (depth > 0) {
+      FsFile file = root.openNextFile();
+      char name[500];
+      while (file) {
+        file.getName(name, sizeof(name));
+
+        // Skip hidden/protected items
+        bool shouldHide = name[0] == '.';
+        for (size_t i = 0; i < HIDDEN_ITEMS_COUNT && !shouldHide; i++) {
+          shouldHide = strcmp(name, HIDDEN_ITEMS[i]) == 0;
         }
-      }
-
-      if (!shouldHide) {
-        String childPath = path;
-        if (!childPath.endsWith("/")) childPath += "/";
-        childPath += fileName;
 
-        if (file.isDirectory()) {
-          sendPropEntry(s, childPath, true, 0, FIXED_DATE);
-        } else {
-          sendPropEntry(s, childPath, false, file.size(), FIXED_DATE);
+        if (!shouldHide) {
+          const bool childIsDir = file.isDirectory();
+          DirectoryListing::writePropResponse(out, path.c_str(), name, childIsDir, childIsDir ? 0 : file.size(),
+                                              childIsDir ? nullptr : getMimeType(name), FIXED_DATE);
         }
-      }
 
-      file.close();
-      yield();
-      esp_task_wdt_reset();
-      file = root.openNextFile();
+        file.close();
+        yield();
+        esp_task_wdt_reset();
+        file = root.openNextFile();
+      }
     }
   }
 
-  root.close();
-  s.sendContent("</D:multistatus>\n");
+  if (root) root.close();
+  out.write("</D:multistatus>\n");
+  out.flush();
   s.sendContent("");
 }
 
-void WebDAVHandler::sendPropEntry(WebServer& s, const String& path, bool isDir, size_t size,
-                                  const String& lastModified) const {
-  String href;
-  urlEncodePath(path, href);
-  // Ensure directory hrefs end with /
-  if (isDir && !href.endsWith("/")) href += "/";
-
-  String xml = "<D:response><D:href>";
-  xml += href;
-  xml += "</D:href><D:propstat><D:prop>";
-
-  if (isDir) {
-    xml += "<D:resourcetype><D:collection/></D:resourcetype>";
-  } else {
-    xml += "<D:resourcetype/>";
-    xml += "<D:getcontentlength>";
-    xml += String(size);
-    xml += "</D:getcontentlength>";
-    String mime = getMimeType(path);
-    xml += "<D:getcontenttype>";
-    xml += mime;
-    xml += "</D:getcontenttype>";
-  }
-
-  xml += "<D:getlastmodified>";
-  xml += lastModified;
-  xml += "</D:getlastmodified>";
-
-  xml += "</D:prop><D:status>HTTP/1.1 200 OK</D:status></D:propstat></D:response>\n";
-
-  s.sendContent(xml);
-}
-
 // ── GET ──────────────────────────────────────────────────────────────────────
 
 void WebDAVHandler::handleGet(WebServer& s) {
@@ -323,9 +279,9 @@ void WebDAVHandler::handleGet(WebServer& s) {
     return;
   }
 
-  String contentType = getMimeType(path);
+  const char* contentType = getMimeType(path.c_str());
   s.setContentLength(file.size());
-  s.send(200, contentType.c_str(), "");
+  s.send(200, contentType, "");
 
   NetworkClient client = s.client();
   client.write(file);
@@ -360,9 +316,9 @@ void WebDAVHandler::handleHead(WebServer& s) {
     return;
   }
 
-  String contentType = getMimeType(path);
+  const char* contentType = getMimeType(path.c_str());
   s.setContentLength(file.size());
-  s.send(200, contentType.c_str(), "");
+  s.send(200, contentType, "");
   file.close();
 }
 
@@ -374,6 +330,7 @@ void WebDAVHandler::handlePut(WebServer& s) {
   LOG_DBG("DAV", "PUT %s", path.c_str());
 
   if (isProtectedPath(path)) {
+    _putHold.reset();
     s.send(403, "text/plain", "Forbidden");
     return;
   }
@@ -381,11 +338,15 @@ void WebDAVHandler::handlePut(WebServer& s) {
   if (!_putOk) {
     String tempPath = path + ".davtmp";
     Storage.remove(tempPath.c_str());
+    _putHold.reset();
     s.send(500, "text/plain", "Write failed - incomplete upload or disk full");
     return;
   }
 
   clearEpubCacheIfNeeded(path);
+  _putHold.reset();
+  BookPrepJobs::queue(path.c_str());
+  LIBRARY_INDEX.noteChanged(path.c_str());
   s.send(_putExisted ? 204 : 201);
   LOG_DBG("DAV", "PUT complete: %s", path.c_str());
 }
@@ -411,6 +372,8 @@ void WebDAVHandler::handleDelete(WebServer& s) {
     return;
   }
 
+  // Background jobs stay off the book and cache being removed
+  const BackgroundJobQueue::Hold jobHold;
   FsFile file = Storage.open(path.c_str());
   if (!file) {
     s.send(500, "text/plain", "Failed to open");
@@ -428,6 +391,7 @@ void WebDAVHandler::handleDelete(WebServer& s) {
     }
     file.close();
     if (Storage.rmdir(path.c_str())) {
+      LIBRARY_INDEX.noteChanged(path.c_str());
       s.send(204);
     } else {
       s.send(500, "text/plain", "Failed to remove directory");
@@ -436,6 +400,7 @@ void WebDAVHandler::handleDelete(WebServer& s) {
     file.close();
     clearEpubCacheIfNeeded(path);
     if (Storage.remove(path.c_str())) {
+      LIBRARY_INDEX.noteChanged(path.c_str());
       s.send(204);
     } else {
       s.send(500, "text/plain", "Failed to delete file");
@@ -476,6 +441,7 @@ void WebDAVHandler::handleMkcol(WebServer& s) {
   }
 
   if (Storage.mkdir(path.c_str())) {
+    LIBRARY_INDEX.noteChanged(path.c_str());
     s.send(201);
     LOG_DBG("DAV", "Created directory: %s", path.c_str());
   } else {
@@ -533,6 +499,8 @@ void WebDAVHandler::handleMove(WebServer& s) {
     return;
   }
 
+  // Background jobs stay off the books and caches this replaces
+  const BackgroundJobQueue::Hold jobHold;
   if (dstExists) {
     Storage.remove(dstPath.c_str());
   }
@@ -548,6 +516,8 @@ void WebDAVHandler::handleMove(WebServer& s) {
   file.close();
 
   if (success) {
+    LIBRARY_INDEX.noteChanged(srcPath.c_str());
+    LIBRARY_INDEX.noteChanged(dstPath.c_str());
     s.send(dstExists ? 204 : 201);
   } else {
     s.send(500, "text/plain", "Move failed");
@@ -613,6 +583,8 @@ void WebDAVHandler::handleCopy(WebServer& s) {
     return;
   }
 
+  // Background jobs stay off the books and caches this replaces
+  const BackgroundJobQueue::Hold jobHold;
   if (dstExists) {
     Storage.remove(dstPath.c_str());
   }
@@ -642,6 +614,7 @@ void WebDAVHandler::handleCopy(WebServer& s) {
   dstFile.close();
 
   if (copyOk) {
+    LIBRARY_INDEX.noteChanged(dstPath.c_str());
     s.send(dstExists ? 204 : 201);
   } else {
     Storage.remove(dstPath.c_str());
@@ -731,33 +704,6 @@ String WebDAVHandler::getDestinationPath(WebServer& s) const {
   return result;
 }
 
-void WebDAVHandler::urlEncodePath(const String& path, String& out) const {
-  out = "";
-  for (unsigned int i = 0; i < path.length(); i++) {
-    char c = path.charAt(i);
-    if (c == '/') {
-      out += '/';
-    } else if (c == ' ') {
-      out += "%20";
-    } else if (c == '%') {
-      out += "%25";
-    } else if (c == '#') {
-      out += "%23";
-    } else if (c == '?') {
-      out += "%3F";
-    } else if (c == '&') {
-      out += "%26";
-    } else if ((uint8_t)c > 127) {
-      // Encode non-ASCII bytes
-      char hex[4];
-      snprintf(hex, sizeof(hex), "%%%02X", (uint8_t)c);
-      out += hex;
-    } else {
-      out += c;
-    }
-  }
-}
-
 bool WebDAVHandler::isProtectedPath(const String& path) const {
   // Check every segment of the path, not just the last one.
   // This prevents access to e.g. /.hidden/somefile or /System Volume Information/foo
@@ -805,7 +751,7 @@ void WebDAVHandler::clearEpubCacheIfNeeded(const String& path) const {
   }
 }
 
-String WebDAVHandler::getMimeType(const String& path) const {
+const char* WebDAVHandler::getMimeType(std::string_view path) const {
   if (FsHelpers::hasEpubExtension(path)) return "application/epub+zip";
   if (FsHelpers::checkFileExtension(path, ".pdf")) return "application/pdf";
   if (FsHelpers::hasTxtExtension(path)) return "text/plain";
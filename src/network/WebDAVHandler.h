@@ -3,6 +3,12 @@
 #include <HalStorage.h>
 #include <WebServer.h>
 
+#include <optional>
+#include <string_view>
+
+#include "BackgroundJobQueue.h"
+#include "UploadWriter.h"
+
 class WebDAVHandler : public RequestHandler {
  public:
   // RequestHandler interface
@@ -13,10 +19,11 @@ class WebDAVHandler : public RequestHandler {
 
  private:
   // PUT streaming state (raw() is called in chunks)
-  FsFile _putFile;
+  UploadWriter _putWriter;
   String _putPath;
   bool _putOk = false;
   bool _putExisted = false;
+  std::optional<BackgroundJobQueue::Hold> _putHold;  // from the start of a PUT body until the file is in place
 
   // WebDAV method handlers
   void handleOptions(WebServer& s);
@@ -34,11 +41,9 @@ class WebDAVHandler : public RequestHandler {
   // Utilities
   String getRequestPath(WebServer& s) const;
   String getDestinationPath(WebServer& s) const;
-  void urlEncodePath(const String& path, String& out) const;
   bool isProtectedPath(const String& path) const;
   int getDepth(WebServer& s) const;
   bool getOverwrite(WebServer& s) const;
   void clearEpubCacheIfNeeded(const String& path) const;
-  void sendPropEntry(WebServer& s, const String& href, bool isDir, size_t size, const String& lastModified) const;
-  String getMimeType(const String& path) const;
+  const char* getMimeType(std::string_view path) const;
 };
@@ -0,0 +1,313 @@
+#include "BookPrepJobs.h"
+
+#include <Arduino.h>
+#include <BufferedIO.h>
+#include <Epub.h>
+#include <Epub/PageIndex.h>
+#include <Epub/Section.h>
+#include <FsHelpers.h>
+#include <GfxRenderer.h>
+#include <HalStorage.h>
+#include <Logging.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include <algorithm>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "BackgroundJobQueue.h"
+#include "CoverImageJobs.h"
+#include "CrossPointSettings.h"
+#include "LibraryIndex.h"
+#include "activities/RenderLock.h"
+#include "activities/reader/ReaderUtils.h"
+#include "components/UITheme.h"
+
+namespace BookPrepJobs {
+
+namespace {
+constexpr uint8_t QUEUE_FILE_VERSION = 1;
+constexpr char QUEUE_FILE[] = "/.crosspoint/prep_queue.bin";
+// Laying out a chapter needs the parser and page buffers on top of whatever the current activity holds
+constexpr uint32_t SECTION_HEAP_RESERVE = 48 * 1024;
+
+GfxRenderer* prepRenderer = nullptr;
+SemaphoreHandle_t pendingMutex = nullptr;  // guards pendingBooks and currentBook
+std::vector<std::string> pendingBooks;
+std::string currentBook;
+
+// Called with pendingMutex held
+void savePending() {
+  FsFile f;
+  if (!Storage.openFileForWrite("BPJ", QUEUE_FILE, f)) {
+    LOG_ERR("BPJ", "Failed to save prep queue");
+    return;
+  }
+  serialization::BufferedWriter writer(f);
+  serialization::writePod(writer, QUEUE_FILE_VERSION);
+  serialization::writePod(writer, static_cast<uint32_t>(pendingBooks.size()));
+  for (const auto& path : pendingBooks) {
+    serialization::writeString(writer, path);
+  }
+  writer.flush();
+  f.close();
+}
+
+void loadPending() {
+  FsFile f;
+  if (!Storage.openFileForRead("BPJ", QUEUE_FILE, f)) {
+    return;
+  }
+  serialization::BufferedReader reader(f);
+  uint8_t version = 0;
+  uint32_t count = 0;
+  serialization::readPod(reader, version);
+  serialization::readPod(reader, count);
+  if (version == QUEUE_FILE_VERSION) {
+    for (uint32_t i = 0; i < count && reader.ok(); i++) {
+      std::string path;
+      if (serialization::readString(reader, path) && Storage.exists(path.c_str())) {
+        pendingBooks.push_back(std::move(path));
+      }
+    }
+  }
+  f.close();
+}
+
+// The renderer's orientation and font caches belong to the render task. A layout borrows it with the reader
+// orientation applied and gives it back, in the render task's orientation, between chunks of the chapter.
+class RendererLease {
+  GfxRenderer& renderer;
+  std::optional<RenderLock> lock;
+  GfxRenderer::Orientation previousOrientation = GfxRenderer::Portrait;
+
+ public:
+  explicit RendererLease(GfxRenderer& renderer) : renderer(renderer) {}
+  ~RendererLease() { release(); }
+  RendererLease(const RendererLease&) = delete;
+  RendererLease& operator=(const RendererLease&) = delete;
+
+  void acquire() {
+    if (lock) {
+      return;
+    }
+    lock.emplace();
+    previousOrientation = renderer.getOrientation();
+    ReaderUtils::applyOrientation(renderer, SETTINGS.orientation);
+  }
+
+  void release() {
+    if (!lock) {
+      return;
+    }
+    renderer.setOrientation(previousOrientation);
+    lock.reset();
+  }
+};
+
+enum class BuildResult { Built, Failed, Stopped };
+
+// Same viewport as EpubReaderActivity without the automatic page turn indicator. layout is set even on failure.
+// Stops, discarding the partial section, as soon as the queue is asked to pause.
+BuildResult buildSection(const std::shared_ptr<Epub>& epub, const int spineIndex, uint32_t& layout) {
+  GfxRenderer& renderer = *prepRenderer;
+  RendererLease lease(renderer);
+
+  lease.acquire();
+  int marginTop, marginRight, marginBottom, marginLeft;
+  renderer.getOrientedViewableTRBL(&marginTop, &marginRight, &marginBottom, &marginLeft);
+  marginTop += SETTINGS.screenMargin;
+  marginLeft += SETTINGS.screenMargin;
+  marginRight += SETTINGS.screenMargin;
+  marginBottom += std::max(SETTINGS.screenMargin, static_cast<uint8_t>(UITheme::getInstance().getStatusBarHeight()));
+  const uint16_t viewportWidth = renderer.getScreenWidth() - marginLeft - marginRight;
+  const uint16_t viewportHeight = renderer.getScreenHeight() - marginTop - marginBottom;
+  lease.release();
+
+  Section section(epub, spineIndex, renderer);
+  if (section.loadSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
+                              SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment, viewportWidth,
+                              viewportHeight, SETTINGS.hyphenationEnabled, SETTINGS.embeddedStyle,
+                              SETTINGS.imageRendering)) {
+    layout = section.getLayout();
+    return BuildResult::Built;
+  }
+
+  // Runs before every chunk of the chapter: a waiting render gets the renderer in between
+  bool stopped = false;
+  const auto progress = [&lease, &stopped] {
+    lease.release();
+    stopped = BACKGROUND_JOBS.isPauseRequested();
+    if (!stopped) {
+      lease.acquire();
+    }
+    return !stopped;
+  };
+  const bool built = section.createSectionFile(SETTINGS.getReaderFontId(), SETTINGS.getReaderLineCompression(),
+                                               SETTINGS.extraParagraphSpacing, SETTINGS.paragraphAlignment,
+                                               viewportWidth, viewportHeight, SETTINGS.hyphenationEnabled,
+                                               SETTINGS.embeddedStyle, SETTINGS.imageRendering, nullptr, progress);
+  layout = section.getLayout();
+  lease.acquire();
+  renderer.clearFontCache();
+  lease.release();
+
+  if (stopped) {
+    LOG_DBG("BPJ", "Section %d of %s stopped for a pause", spineIndex, epub->getPath().c_str());
+    return BuildResult::Stopped;
+  }
+  if (!built) {
+    LOG_ERR("BPJ", "Failed to build section %d of %s", spineIndex, epub->getPath().c_str());
+    return BuildResult::Failed;
+  }
+  return BuildResult::Built;
+}
+
+// False if a pause stopped the layout
+bool buildFirstSection(const std::shared_ptr<Epub>& epub) {
+  if (!prepRenderer || ESP.getMaxAllocHeap() < SECTION_HEAP_RESERVE) {
+    return true;
+  }
+
+  int spineIndex = epub->getSpineIndexForTextReference();
+  if (spineIndex < 0 || spineIndex >= epub->getSpineItemsCount()) {
+    spineIndex = 0;
+  }
+  uint32_t layout;
+  return buildSection(epub, spineIndex, layout) != BuildResult::Stopped;
+}
+
+void enqueuePageIndexStep(const std::string& bookPath, int spineIndex);
+
+// Lays out one chapter missing from the book's page index, then queues the next one
+void indexPages(const std::string& bookPath, const int spineIndex) {
+  if (!prepRenderer || ESP.getMaxAllocHeap() < SECTION_HEAP_RESERVE) {
+    // Picked up again the next time the book is closed
+    return;
+  }
+  auto epub = std::make_shared<Epub>(bookPath, "/.crosspoint");
+  epub->setPackCaches(SETTINGS.packBookCaches);
+  if (!epub->load(false, SETTINGS.embeddedStyle == 0)) {
+    return;
+  }
+  const int spineCount = epub->getSpineItemsCount();
+  if (spineIndex < 0 || spineIndex >= spineCount) {
+    return;
+  }
+
+  uint32_t layout;
+  const BuildResult result = buildSection(epub, spineIndex, layout);
+  if (result == BuildResult::Stopped) {
+    // Laid out again from the start once the queue resumes
+    enqueuePageIndexStep(bookPath, spineIndex);
+    return;
+  }
+  if (result == BuildResult::Failed) {
+    // Counted as empty so the index can complete; opening the chapter records its real count
+    PageIndex::record(epub->getCachePath(), layout, spineCount, spineIndex, 0);
+  }
+
+  PageIndex index;
+  if (!index.load(epub->getCachePath(), layout, spineCount)) {
+    return;
+  }
+  if (index.isComplete()) {
+    LOG_DBG("BPJ", "Page index of %s complete: %d pages", bookPath.c_str(), index.getTotalPages());
+  } else {
+    enqueuePageIndexStep(bookPath, index.getFirstMissing());
+  }
+}
+
+// Each chapter gets its own key because a running job cannot queue itself again
+void enqueuePageIndexStep(const std::string& bookPath, const int spineIndex) {
+  BACKGROUND_JOBS.enqueue("pages:" + bookPath + ":" + std::to_string(spineIndex),
+                          [bookPath, spineIndex] { indexPages(bookPath, spineIndex); });
+}
+
+void prepareBook(const std::string& bookPath) {
+  xSemaphoreTake(pendingMutex, portMAX_DELAY);
+  currentBook = bookPath;
+  xSemaphoreGive(pendingMutex);
+
+  bool finished = true;
+  if (FsHelpers::hasEpubExtension(bookPath)) {
+    // book.bin and the CSS cache; covers and thumbnails follow as their own job
+    auto epub = std::make_shared<Epub>(bookPath, "/.crosspoint");
+    epub->setPackCaches(SETTINGS.packBookCaches);
+    if (epub->load(true, false)) {
+      finished = buildFirstSection(epub);
+    }
+  }
+
+  xSemaphoreTake(pendingMutex, portMAX_DELAY);
+  currentBook.clear();
+  if (!finished) {
+    // Still pending; book.bin is cached by now, so the retry goes straight to the section
+    xSemaphoreGive(pendingMutex);
+    BACKGROUND_JOBS.enqueue("prep:" + bookPath, [bookPath] { prepareBook(bookPath); });
+    return;
+  }
+  pendingBooks.erase(std::remove(pendingBooks.begin(), pendingBooks.end(), bookPath), pendingBooks.end());
+  savePending();
+  xSemaphoreGive(pendingMutex);
+
+  // Title and author are known now; queued behind the cover job so the thumbnail is recorded too
+  LIBRARY_INDEX.noteChanged(bookPath);
+}
+
+void enqueueJobs(const std::string& bookPath) {
+  BACKGROUND_JOBS.enqueue("prep:" + bookPath, [bookPath] { prepareBook(bookPath); });
+  CoverImageJobs::queue(bookPath, false);
+}
+}  // namespace
+
+void begin(GfxRenderer& renderer) {
+  prepRenderer = &renderer;
+  pendingMutex = xSemaphoreCreateMutex();
+
+  loadPending();
+  if (!pendingBooks.empty()) {
+    LOG_DBG("BPJ", "Resuming preparation of %zu book(s)", pendingBooks.size());
+  }
+  for (const auto& path : pendingBooks) {
+    enqueueJobs(path);
+  }
+}
+
+void queue(const std::string& bookPath) {
+  if (!pendingMutex || (!FsHelpers::hasEpubExtension(bookPath) && !FsHelpers::hasXtcExtension(bookPath))) {
+    return;
+  }
+
+  xSemaphoreTake(pendingMutex, portMAX_DELAY);
+  if (std::find(pendingBooks.begin(), pendingBooks.end(), bookPath) == pendingBooks.end()) {
+    pendingBooks.push_back(bookPath);
+    savePending();
+  }
+  xSemaphoreGive(pendingMutex);
+
+  enqueueJobs(bookPath);
+}
+
+void queuePageIndex(const std::string& bookPath, const int firstMissing) {
+  if (!pendingMutex) {
+    return;
+  }
+  enqueuePageIndexStep(bookPath, firstMissing);
+}
+
+Status getStatus() {
+  Status status;
+  if (!pendingMutex) {
+    return status;
+  }
+  xSemaphoreTake(pendingMutex, portMAX_DELAY);
+  status.pending = pendingBooks.size();
+  status.current = currentBook;
+  xSemaphoreGive(pendingMutex);
+  return status;
+}
+
+}  // namespace BookPrepJobs
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+class GfxRenderer;
+
+namespace BookPrepJobs {
+
+/**
+ * Prepare newly transferred books on the background job queue so their first open is fast: book.bin and the CSS
+ * cache, the cover thumbnails and, for EPUBs, the section of the first text chapter for the current reader settings.
+ * Pending books are kept in a list on the SD card; begin() queues whatever was left when the device last went to
+ * sleep or rebooted.
+ */
+void begin(GfxRenderer& renderer);
+
+// Queue a book (EPUB or XTC; other files are ignored) and remember it until it has been prepared
+void queue(const std::string& bookPath);
+
+// Count the pages of every chapter of an EPUB for the current layout, one chapter per job, starting with firstMissing.
+// Chapters already laid out only cost a header read.
+void queuePageIndex(const std::string& bookPath, int firstMissing);
+
+struct Status {
+  size_t pending = 0;   // books queued, including the one being prepared
+  std::string current;  // path of the book being prepared, empty when idle
+};
+Status getStatus();
+
+}  // namespace BookPrepJobs
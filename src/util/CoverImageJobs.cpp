@@ -0,0 +1,121 @@
+#include "CoverImageJobs.h"
+
+#include <Epub.h>
+#include <FsHelpers.h>
+#include <HalStorage.h>
+#include <Logging.h>
+#include <Xtc.h>
+
+#include <vector>
+
+#include "BackgroundJobQueue.h"
+#include "CrossPointSettings.h"
+#include "LibraryIndex.h"
+#include "components/UITheme.h"
+
+namespace CoverImageJobs {
+
+namespace {
+
+volatile uint32_t finishedJobs = 0;
+
+// An empty thumbnail keeps a broken cover from being decoded again on every visit to the home screen
+void writeEmptyThumb(const std::string& thumbPath) {
+  if (!Storage.exists(thumbPath.c_str())) {
+    FsFile thumbBmp;
+    Storage.openFileForWrite("CIJ", thumbPath, thumbBmp);
+    thumbBmp.close();
+  }
+}
+
+enum class CoverResult { Generated, NoCover, Stopped };
+
+// Polled during the decode so a pause does not wait for a full-size cover
+bool keepDecoding(bool& stopped) {
+  stopped = BACKGROUND_JOBS.isPauseRequested();
+  return !stopped;
+}
+
+CoverResult generateEpubCovers(const std::string& bookPath, const bool includeSleepCover) {
+  Epub epub(bookPath, "/.crosspoint");
+  // Skip loading css since only the cover is needed
+  if (!epub.load(true, true)) {
+    return CoverResult::NoCover;
+  }
+
+  const std::vector<int> heights = UITheme::getCoverThumbHeights();
+  const bool crop = SETTINGS.sleepScreenCoverMode == CrossPointSettings::SLEEP_SCREEN_COVER_MODE::CROP;
+  bool stopped = false;
+  if (!epub.generateCoverImages(includeSleepCover && !crop, includeSleepCover && crop, heights,
+                                [&stopped] { return keepDecoding(stopped); })) {
+    if (stopped) {
+      return CoverResult::Stopped;
+    }
+    for (const int height : heights) {
+      writeEmptyThumb(epub.getThumbBmpPath(height));
+    }
+    return CoverResult::NoCover;
+  }
+  return CoverResult::Generated;
+}
+
+CoverResult generateXtcCovers(const std::string& bookPath, const bool includeSleepCover) {
+  Xtc xtc(bookPath, "/.crosspoint");
+  if (!xtc.load()) {
+    return CoverResult::NoCover;
+  }
+
+  // Each output is a separate page decode; a pause is taken between them and the finished ones are kept
+  bool stopped = false;
+  if (includeSleepCover) {
+    xtc.generateCoverBmp();
+  }
+  CoverResult result = CoverResult::Generated;
+  for (const int height : UITheme::getCoverThumbHeights()) {
+    if (!keepDecoding(stopped)) {
+      return CoverResult::Stopped;
+    }
+    if (!xtc.generateThumbBmp(height)) {
+      xtc.setupCacheDir();
+      writeEmptyThumb(xtc.getThumbBmpPath(height));
+      result = CoverResult::NoCover;
+    }
+  }
+  return result;
+}
+
+void enqueueJob(const std::string& bookPath, const bool isEpub, const bool includeSleepCover) {
+  BACKGROUND_JOBS.enqueue("cover:" + bookPath, [bookPath, isEpub, includeSleepCover] {
+    const CoverResult result =
+        isEpub ? generateEpubCovers(bookPath, includeSleepCover) : generateXtcCovers(bookPath, includeSleepCover);
+    if (result == CoverResult::Stopped) {
+      // Decoded again from the start once the queue resumes
+      LOG_DBG("CIJ", "Cover of %s stopped for a pause", bookPath.c_str());
+      enqueueJob(bookPath, isEpub, includeSleepCover);
+      return;
+    }
+    if (result == CoverResult::NoCover) {
+      // Otherwise the library keeps looking the book up for a thumbnail on every visit to its folder
+      LIBRARY_INDEX.noteNoCover(bookPath);
+    }
+    finishedJobs = finishedJobs + 1;
+  });
+}
+
+}  // namespace
+
+void queue(const std::string& bookPath, bool includeSleepCover) {
+  const bool isEpub = FsHelpers::hasEpubExtension(bookPath);
+  if (!isEpub && !FsHelpers::hasXtcExtension(bookPath)) {
+    return;
+  }
+
+  // The full-screen cover is only worth decoding when the sleep screen will show it
+  const bool coverSleepScreen = SETTINGS.sleepScreen == CrossPointSettings::SLEEP_SCREEN_MODE::COVER ||
+                                SETTINGS.sleepScreen == CrossPointSettings::SLEEP_SCREEN_MODE::COVER_CUSTOM;
+  enqueueJob(bookPath, isEpub, includeSleepCover && coverSleepScreen);
+}
+
+uint32_t getFinishedCount() { return finishedJobs; }
+
+}  // namespace CoverImageJobs
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace CoverImageJobs {
+
+/**
+ * Queue generation of the cover images of a book on the background job queue.
+ * All theme thumbnail heights are produced from one decode of the cover; includeSleepCover also produces the
+ * full-screen cover in the variant the sleep screen settings ask for. Files that already exist are skipped.
+ */
+void queue(const std::string& bookPath, bool includeSleepCover);
+
+// Incremented after every finished cover job, so screens showing covers can pick up new thumbnails
+uint32_t getFinishedCount();
+
+}  // namespace CoverImageJobs
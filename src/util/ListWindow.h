@@ -0,0 +1,92 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+/**
+ * Rows of a list screen, addressed by position. A source backed by a file (a folder's library index, a book's TOC)
+ * seeks straight to the requested range, so the cost of a fetch does not depend on the length of the list.
+ */
+template <typename T>
+class ListDataSource {
+ public:
+  virtual ~ListDataSource() = default;
+
+  virtual int size() const = 0;
+  // Appends rows [first, first + count) to out; the range never extends past size()
+  virtual bool fetch(int first, int count, std::vector<T>& out) = 0;
+};
+
+/**
+ * The rows of a ListDataSource around the page being shown: that page plus one page of look-ahead in the direction
+ * the list was last scrolled. A list screen holds and reads at most two pages of rows, however long the list is.
+ *
+ * Call show() from loop() when the selection moves and before requesting a render; render() then only reads rows of
+ * the page that was shown. at() fetches on a miss, so a page computed differently by the theme still draws.
+ */
+template <typename T>
+class ListWindow {
+  ListDataSource<T>* source = nullptr;
+  std::vector<T> rows;
+  int first = 0;
+  int pageItems = 1;
+  T missing{};
+
+  void fetchAround(const int index) {
+    const int total = size();
+    const int pageStart = index / pageItems * pageItems;
+    const int pageEnd = std::min(total, pageStart + pageItems);
+    // Forward look-ahead unless the page lies before the current window
+    const bool backwards = !rows.empty() && pageStart < first;
+    const int start = backwards ? std::max(0, pageStart - pageItems) : pageStart;
+    const int end = backwards ? pageEnd : std::min(total, pageStart + 2 * pageItems);
+
+    rows.clear();
+    first = start;
+    if (end > start && !source->fetch(start, end - start, rows)) {
+      rows.clear();
+    }
+  }
+
+ public:
+  void setSource(ListDataSource<T>* listSource) {
+    source = listSource;
+    invalidate();
+  }
+
+  // Drop the fetched rows, e.g. after the source changed
+  void invalidate() {
+    rows.clear();
+    first = 0;
+  }
+
+  int size() const { return source ? source->size() : 0; }
+  bool empty() const { return size() == 0; }
+
+  // Whether the page of pageItems rows holding index is already fetched
+  bool covers(const int index, const int pageItemsPerPage) const {
+    const int pageStart = index / std::max(1, pageItemsPerPage) * std::max(1, pageItemsPerPage);
+    const int pageEnd = std::min(size(), pageStart + std::max(1, pageItemsPerPage));
+    return pageItemsPerPage == pageItems && pageStart >= first &&
+           pageEnd <= first + static_cast<int>(rows.size());
+  }
+
+  // Fetch the page of pageItems rows holding index, unless it is already there
+  void show(const int index, const int pageItemsPerPage) {
+    if (!source || covers(index, pageItemsPerPage)) {
+      return;
+    }
+    pageItems = std::max(1, pageItemsPerPage);
+    fetchAround(index);
+  }
+
+  const T& at(const int index) {
+    if (source && index >= 0 && index < size() && (index < first || index >= first + static_cast<int>(rows.size()))) {
+      fetchAround(index);
+    }
+    if (index < first || index >= first + static_cast<int>(rows.size())) {
+      return missing;
+    }
+    return rows[index - first];
+  }
+};
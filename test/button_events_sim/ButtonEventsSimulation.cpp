@@ -0,0 +1,237 @@
+#include <ButtonEvents.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+// Host simulation of the event-driven input path. A scripted GPIO source stands in for the ADC button ladder: it is
+// sampled like HalGPIO's input task, changes become ButtonEvents on a queue, and a model of the main loop applies them.
+// The loop runs once as it used to (polling every 10ms, 50ms after 3s idle, with the buttons sampled every 10ms) and
+// once blocking on the queue with the sampler backing off to 50ms while idle, with the same reader logic on top. Both
+// must see the same page turns and long presses. Wakeups of the loop and of the sampler are counted, and page turn
+// latency is measured from the scripted press, so it includes the time until the sampler sees it.
+
+namespace {
+constexpr uint8_t BTN_BACK = 0;
+constexpr uint8_t BTN_LEFT = 2;
+constexpr uint8_t BTN_RIGHT = 3;
+constexpr uint8_t BTN_POWER = 6;
+
+constexpr uint32_t SAMPLE_MS = 10;
+constexpr uint32_t IDLE_SAMPLE_MS = 50;
+constexpr uint32_t IDLE_SAMPLE_AFTER_MS = 1000;
+constexpr uint32_t IDLE_POWER_SAVING_MS = 3000;
+constexpr uint32_t MAX_INPUT_WAIT_MS = 1000;
+constexpr uint32_t GO_HOME_MS = 1000;
+
+int failures = 0;
+
+void check(const bool condition, const char* what) {
+  if (!condition) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+// Simulated GPIO event source: a button held from `at` for `duration` ms
+struct Press {
+  uint32_t at;
+  uint8_t button;
+  uint32_t duration;
+};
+
+uint8_t sampleAt(const std::vector<Press>& script, const uint32_t time) {
+  uint8_t mask = 0;
+  for (const auto& press : script) {
+    if (time >= press.at && time < press.at + press.duration) mask |= 1 << press.button;
+  }
+  return mask;
+}
+
+// When the press of a button that was sampled at `time` really started
+uint32_t pressStart(const std::vector<Press>& script, const uint8_t button, const uint32_t time) {
+  uint32_t start = 0;
+  for (const auto& press : script) {
+    if (press.button == button && press.at <= time && press.at > start) start = press.at;
+  }
+  return start;
+}
+
+// What the input task would have queued over the whole script; with idleBackOff it slows down like HalGPIO's
+std::deque<ButtonEvent> sampleScript(const std::vector<Press>& script, const uint32_t endTime, const bool idleBackOff,
+                                     uint64_t& wakeups) {
+  std::deque<ButtonEvent> events;
+  uint8_t previous = 0;
+  uint32_t lastHeld = 0;
+  for (uint32_t time = 0; time <= endTime;) {
+    const uint8_t sample = sampleAt(script, time);
+    ButtonEvents::diff(previous, sample, time, [&events](const ButtonEvent& event) { events.push_back(event); });
+    previous = sample;
+    wakeups++;
+    if (sample != 0) lastHeld = time;
+    const bool idle = idleBackOff && sample == 0 && time - lastHeld >= IDLE_SAMPLE_AFTER_MS;
+    time += idle ? IDLE_SAMPLE_MS : SAMPLE_MS;
+  }
+  return events;
+}
+
+struct ReaderModel {
+  int pageTurns = 0;
+  int goHome = 0;
+  int shortBacks = 0;
+  bool homeFired = false;
+  uint64_t latencyTotal = 0;  // ms from a page button going down to the loop turning the page
+  uint32_t latencyMax = 0;
+  uint32_t lastPagePress = 0;
+
+  void loop(const ButtonEvents& buttons, const uint32_t now) {
+    if (buttons.isPressed(BTN_BACK) && buttons.getHeldTime(now) >= GO_HOME_MS && !homeFired) {
+      goHome++;
+      homeFired = true;
+    }
+    if (buttons.wasReleased(BTN_BACK)) {
+      if (buttons.getHeldTime(now) < GO_HOME_MS) shortBacks++;
+      homeFired = false;
+    }
+    if (buttons.wasPressed(BTN_LEFT) || buttons.wasPressed(BTN_RIGHT)) {
+      pageTurns++;
+      latencyTotal += now - lastPagePress;
+      latencyMax = std::max(latencyMax, now - lastPagePress);
+    }
+  }
+};
+
+struct RunStats {
+  ReaderModel reader;
+  uint64_t wakeups = 0;
+  uint64_t samplerWakeups = 0;
+};
+
+// One loop iteration: apply the events sampled up to now, then run the reader
+void runFrame(const std::vector<Press>& script, ButtonEvents& buttons, std::deque<ButtonEvent>& queue, RunStats& stats,
+              uint32_t& lastActivity, const uint32_t now) {
+  buttons.beginFrame();
+  while (!queue.empty() && queue.front().time <= now) {
+    const ButtonEvent event = queue.front();
+    queue.pop_front();
+    if (event.pressed && (event.button == BTN_LEFT || event.button == BTN_RIGHT)) {
+      stats.reader.lastPagePress = pressStart(script, event.button, event.time);
+    }
+    buttons.apply(event);
+  }
+  if (buttons.wasAnyPressed() || buttons.wasAnyReleased()) lastActivity = now;
+  stats.reader.loop(buttons, now);
+  stats.wakeups++;
+}
+
+RunStats runPolling(const std::vector<Press>& script, const uint32_t endTime) {
+  RunStats stats;
+  auto queue = sampleScript(script, endTime, false, stats.samplerWakeups);
+  ButtonEvents buttons;
+  uint32_t lastActivity = 0;
+  for (uint32_t now = 0; now <= endTime;) {
+    runFrame(script, buttons, queue, stats, lastActivity, now);
+    now += now - lastActivity >= IDLE_POWER_SAVING_MS ? 50 : 10;
+  }
+  return stats;
+}
+
+RunStats runEventDriven(const std::vector<Press>& script, const uint32_t endTime) {
+  RunStats stats;
+  auto queue = sampleScript(script, endTime, true, stats.samplerWakeups);
+  ButtonEvents buttons;
+  uint32_t lastActivity = 0;
+  for (uint32_t now = 0; now <= endTime;) {
+    runFrame(script, buttons, queue, stats, lastActivity, now);
+    // Same policy as main.cpp: short waits while a button is held, otherwise block until the next event
+    const uint32_t timeout = buttons.isAnyPressed() ? SAMPLE_MS : MAX_INPUT_WAIT_MS;
+    const uint32_t nextEvent = queue.empty() ? UINT32_MAX : queue.front().time;
+    now = std::min(now + timeout, std::max(nextEvent, now + 1));
+  }
+  return stats;
+}
+
+void testEdges() {
+  ButtonEvents buttons;
+
+  // A tap that starts and ends between two iterations shows both edges
+  buttons.beginFrame();
+  buttons.apply({BTN_RIGHT, true, 100});
+  buttons.apply({BTN_RIGHT, false, 180});
+  check(buttons.wasPressed(BTN_RIGHT) && buttons.wasReleased(BTN_RIGHT), "tap within one frame has both edges");
+  check(!buttons.isAnyPressed(), "tap within one frame leaves nothing held");
+  check(buttons.getHeldTime(500) == 80, "held time of a released tap");
+
+  // Edges last one iteration
+  buttons.beginFrame();
+  check(!buttons.wasAnyPressed() && !buttons.wasAnyReleased(), "edges cleared by the next frame");
+
+  // Overlapping buttons count from the first press to the last release
+  buttons.apply({BTN_POWER, true, 1000});
+  buttons.apply({BTN_LEFT, true, 1200});
+  check(buttons.getHeldTime(1500) == 500, "held time runs from the first of overlapping presses");
+  buttons.apply({BTN_POWER, false, 1600});
+  check(buttons.isPressed(BTN_LEFT) && !buttons.isPressed(BTN_POWER), "partial release");
+  buttons.apply({BTN_LEFT, false, 1700});
+  check(buttons.getHeldTime(5000) == 700, "held time frozen after the last release");
+
+  // A release without its press (queue overflow) is ignored, and so is a wake-up
+  buttons.beginFrame();
+  buttons.apply({BTN_BACK, false, 1800});
+  buttons.apply({ButtonEvents::NO_BUTTON, false, 1800});
+  check(!buttons.wasAnyReleased(), "release of a button not held is ignored");
+
+  // Lost events are recovered from the latest sample
+  buttons.resync(1 << BTN_BACK, 2000);
+  check(buttons.isPressed(BTN_BACK) && buttons.wasPressed(BTN_BACK), "resync reports the missed press");
+  buttons.beginFrame();
+  buttons.resync(0, 2100);
+  check(!buttons.isAnyPressed() && buttons.wasReleased(BTN_BACK), "resync reports the missed release");
+}
+}  // namespace
+
+int main() {
+  testEdges();
+
+  // Ten minutes of reading: a page turn every 25-40s, a few quick double turns, one long BACK press and a short one
+  std::vector<Press> script;
+  uint32_t time = 2000;
+  for (int i = 0; i < 20; i++) {
+    script.push_back({time, static_cast<uint8_t>(i % 7 == 3 ? BTN_LEFT : BTN_RIGHT), 120});
+    if (i % 5 == 1) script.push_back({time + 300, BTN_RIGHT, 90});
+    time += 25000 + (i * 7919) % 15000;
+  }
+  script.push_back({time, BTN_BACK, 1500});
+  script.push_back({time + 5000, BTN_BACK, 200});
+  const uint32_t endTime = time + 10000;
+
+  const RunStats polling = runPolling(script, endTime);
+  const RunStats events = runEventDriven(script, endTime);
+
+  printf("Simulated %u s of reading, %zu presses\n", endTime / 1000, script.size());
+  const auto report = [](const char* name, const RunStats& stats) {
+    printf("%s %7llu loop wakeups, %7llu sampler wakeups, %d page turns, latency avg %.1f ms, max %u ms\n", name,
+           static_cast<unsigned long long>(stats.wakeups), static_cast<unsigned long long>(stats.samplerWakeups),
+           stats.reader.pageTurns, static_cast<double>(stats.reader.latencyTotal) / std::max(1, stats.reader.pageTurns),
+           stats.reader.latencyMax);
+  };
+  report("Polling loop:     ", polling);
+  report("Event-driven loop:", events);
+
+  check(polling.reader.pageTurns == 24 && events.reader.pageTurns == 24, "every page turn seen");
+  check(polling.reader.goHome == 1 && events.reader.goHome == 1, "long BACK press seen once");
+  check(polling.reader.shortBacks == 1 && events.reader.shortBacks == 1, "short BACK press seen once");
+  // The old loop polled every 50ms when idle, on top of the 10ms sampling; the idle sampler adds no more than that
+  check(polling.reader.latencyMax < 50 + SAMPLE_MS, "polling loop turns within one idle poll of the sample");
+  check(events.reader.latencyMax < IDLE_SAMPLE_MS, "event-driven loop turns within one idle sample of the press");
+  check(events.wakeups * 10 < polling.wakeups, "event-driven loop wakes at least 10x less often");
+  check(events.samplerWakeups * 4 < polling.samplerWakeups, "idle sampler wakes at least 4x less often");
+
+  if (failures > 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
@@ -0,0 +1,190 @@
+#include <HeapTrace.h>
+
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Host run of the heap tracker. The bench is built with the tracker's operator new, so every container below is
+// tracked: a chapter-like workload builds words and lines under LAYOUT, keeps loaded pages under PAGE_CACHE and mallocs
+// image and font buffers directly, and the per-tag live, peak and block counts must come out exact. A fake heap probe
+// stands in for the device allocator to check the fragmentation samples and the failure record.
+
+namespace {
+int failures = 0;
+
+void check(const bool condition, const char* what) {
+  if (!condition) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+// The tracked total is kept separately from the tags; a snapshot must show it equal to their sum
+void checkTotals(const char* what) {
+  const HeapTrace::Snapshot snapshot = HEAP_TRACE.getSnapshot();
+  uint64_t live = 0;
+  for (const auto& s : snapshot.stats) {
+    live += s.liveBytes;
+  }
+  check(snapshot.trackedBytes == live, what);
+}
+
+// The report must not count its own string: the tracked total it prints equals the sum of its live_b column
+void checkReport(const std::string& report) {
+  unsigned long tracked = 0;
+  check(sscanf(report.c_str() + report.find("tracked:"), "tracked: live %lu", &tracked) == 1, "report has a total");
+  uint64_t live = 0;
+  size_t pos = report.find('\n', report.find("tag "));
+  while (pos != std::string::npos && pos + 1 < report.size() && report.compare(pos + 1, 5, "last ") != 0) {
+    char name[16];
+    unsigned long bytes = 0;
+    if (sscanf(report.c_str() + pos + 1, "%15s %lu", name, &bytes) == 2) {
+      live += bytes;
+    }
+    pos = report.find('\n', pos + 1);
+  }
+  check(tracked == live, "report total equals the sum of its tags");
+}
+
+HeapTrace::HeapInfo fakeHeap;
+HeapTrace::HeapInfo fakeProbe() { return fakeHeap; }
+
+struct FakePage {
+  std::vector<std::string> lines;
+};
+
+// Parse a "chapter" into words and lines and page them; the page list itself is layout's, the pages are cached
+std::vector<std::unique_ptr<FakePage>> buildChapter(const int words) {
+  std::vector<std::unique_ptr<FakePage>> pages;
+  HEAP_SCOPE(LAYOUT);
+  std::list<std::string> pending;
+  for (int i = 0; i < words; i++) {
+    pending.emplace_back("word-number-" + std::to_string(i) + "-with-some-length");
+  }
+  std::vector<std::string> lines;
+  std::string line;
+  for (const auto& word : pending) {
+    line += word;
+    line += ' ';
+    if (line.size() > 60) {
+      lines.push_back(std::move(line));
+      line.clear();
+    }
+  }
+  for (size_t i = 0; i < lines.size(); i += 20) {
+    std::unique_ptr<FakePage> page;
+    {
+      HEAP_SCOPE(PAGE_CACHE);
+      page = std::make_unique<FakePage>();
+      for (size_t j = i; j < lines.size() && j < i + 20; j++) {
+        page->lines.push_back(lines[j]);
+      }
+    }
+    pages.push_back(std::move(page));
+  }
+  return pages;
+}
+
+void testTags() {
+  HEAP_TRACE.reset();
+  const auto layoutBefore = HEAP_TRACE.getStats(HeapTrace::LAYOUT);
+  const auto pagesBefore = HEAP_TRACE.getStats(HeapTrace::PAGE_CACHE);
+
+  auto pages = buildChapter(4000);
+  checkTotals("tracked total equals the tags after a chapter");
+  const auto layout = HEAP_TRACE.getStats(HeapTrace::LAYOUT);
+  const auto cached = HEAP_TRACE.getStats(HeapTrace::PAGE_CACHE);
+  check(layout.allocations > 4000, "every word allocation is tagged LAYOUT");
+  check(layout.liveBlocks == layoutBefore.liveBlocks + 1, "only the returned page vector stays live as LAYOUT");
+  check(layout.peakBytes > layout.liveBytes, "LAYOUT peaked while the words were pending");
+  check(cached.liveBlocks > pagesBefore.liveBlocks + pages.size(), "pages and their lines stay live as PAGE_CACHE");
+  check(HeapTrace::getCurrentTag() == HeapTrace::OTHER, "scopes restore the previous tag");
+
+  const uint32_t cachedBytes = cached.liveBytes;
+  pages.clear();
+  const auto released = HEAP_TRACE.getStats(HeapTrace::PAGE_CACHE);
+  check(released.liveBytes == pagesBefore.liveBytes && released.liveBlocks == pagesBefore.liveBlocks,
+        "freeing the pages outside any scope credits PAGE_CACHE back");
+  check(released.peakBytes >= cachedBytes, "PAGE_CACHE peak kept after the free");
+
+  // Direct buffers as the firmware mallocs them
+  void* chunk = HEAP_MALLOC(IMAGE, 24000);
+  void* glyphs = HEAP_MALLOC(FONT_CACHE, 3000);
+  const auto image = HEAP_TRACE.getStats(HeapTrace::IMAGE);
+  check(chunk && image.liveBytes == 24000 && image.liveBlocks == 1 && image.largestBlock == 24000, "IMAGE buffer");
+  check(HEAP_TRACE.getStats(HeapTrace::FONT_CACHE).liveBytes == 3000, "FONT_CACHE buffer");
+  checkTotals("tracked total equals the tags with direct buffers");
+  HEAP_FREE(chunk);
+  HEAP_FREE(glyphs);
+  const auto imageAfter = HEAP_TRACE.getStats(HeapTrace::IMAGE);
+  check(imageAfter.liveBytes == 0 && imageAfter.peakBytes == 24000, "IMAGE released, peak kept");
+
+  // Tags follow the allocating thread only
+  std::thread network([] {
+    HEAP_SCOPE(NETWORK);
+    std::vector<char> body(5000);
+  });
+  {
+    HEAP_SCOPE(CSS);
+    std::vector<char> rules(7000);
+    network.join();
+    check(HEAP_TRACE.getStats(HeapTrace::CSS).peakBytes >= 7000, "CSS scope on this thread");
+  }
+  check(HEAP_TRACE.getStats(HeapTrace::NETWORK).peakBytes >= 5000, "NETWORK scope on the other thread");
+  check(HEAP_TRACE.getStats(HeapTrace::CSS).liveBytes == 0 && HEAP_TRACE.getStats(HeapTrace::NETWORK).liveBytes == 0,
+        "scoped buffers released");
+  checkTotals("tracked total equals the tags after other threads");
+  const std::string report = HEAP_TRACE.formatReport();
+  checkReport(report);
+  printf("%s\n", report.c_str());
+}
+
+void testFragmentation() {
+  HeapTrace::setHeapProbe(fakeProbe);
+  HEAP_TRACE.reset();
+
+  // Free memory stays about the same while the largest block shrinks: a heap getting fragmented
+  for (uint32_t i = 0; i < HeapTrace::SAMPLE_COUNT + 30; i++) {
+    fakeHeap.freeBytes = 150000 - i * 10;
+    fakeHeap.largestFreeBlock = 110000 - i * 400;
+    fakeHeap.minFreeBytes = 90000;
+    HEAP_TRACE.sample();
+  }
+  std::vector<HeapTrace::Sample> samples(HeapTrace::SAMPLE_COUNT);
+  const size_t copied = HEAP_TRACE.copySamples(samples.data(), samples.size());
+  check(copied == HeapTrace::SAMPLE_COUNT, "sample ring is full after wrapping");
+  check(samples[0].largestFreeBlock == 110000 - 30 * 400, "samples come oldest first");
+  check(samples[copied - 1].largestFreeBlock == 110000 - (HeapTrace::SAMPLE_COUNT + 29) * 400, "newest sample last");
+  check(HEAP_TRACE.getLowestLargestFreeBlock() == 110000 - (HeapTrace::SAMPLE_COUNT + 29) * 400,
+        "lowest largest block");
+
+  // A request the heap cannot serve; the size check stands in for the device allocator running out
+  check(HEAP_MALLOC(DISPLAY, UINT32_MAX) == nullptr, "oversized request fails");
+  HeapTrace::Failure failure;
+  check(HEAP_TRACE.getLastFailure(failure) && failure.tag == HeapTrace::DISPLAY && failure.size == UINT32_MAX &&
+            failure.heap.largestFreeBlock == fakeHeap.largestFreeBlock,
+        "failure recorded with the heap state it met");
+  check(HEAP_TRACE.getStats(HeapTrace::DISPLAY).failures == 1, "failure counted on its tag");
+
+  const std::string report = HEAP_TRACE.formatReport();
+  checkReport(report);
+  checkTotals("tracked total equals the tags after a failure");
+  printf("%s\n", report.c_str());
+  HeapTrace::setHeapProbe(nullptr);
+}
+}  // namespace
+
+int main() {
+  testTags();
+  testFragmentation();
+
+  if (failures > 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
@@ -0,0 +1,157 @@
+#include <picojpeg.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Host benchmark for picojpeg's DCT-domain reduced gray decode (pjpeg_decode_init_gray).
+// Every JPEG is decoded at 1/1, 1/2, 1/4 and 1/8; the reduced images are compared against the full decode
+// box-averaged to the same size.
+
+struct GrayImage {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> pixels;
+};
+
+FILE* gInput = nullptr;
+
+unsigned char readCallback(unsigned char* buf, const unsigned char size, unsigned char* bytesRead, void*) {
+  *bytesRead = static_cast<unsigned char>(fread(buf, 1, size, gInput));
+  return 0;
+}
+
+bool decode(const std::string& path, const int scaleShift, GrayImage& out, double& millis) {
+  gInput = fopen(path.c_str(), "rb");
+  if (!gInput) {
+    return false;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  pjpeg_image_info_t info;
+  if (pjpeg_decode_init_gray(&info, readCallback, nullptr, scaleShift) != 0) {
+    fclose(gInput);
+    return false;
+  }
+
+  // Same block layout walk as JpegToBmpConverter
+  const int blockSize = 8 >> scaleShift;
+  const int mcuWidth = info.m_MCUWidth >> scaleShift;
+  const int mcuHeight = info.m_MCUHeight >> scaleShift;
+  out.width = (info.m_width + (1 << scaleShift) - 1) >> scaleShift;
+  out.height = (info.m_height + (1 << scaleShift) - 1) >> scaleShift;
+  out.pixels.assign(out.width * out.height, 0);
+
+  for (int mcuY = 0; mcuY < info.m_MCUSPerCol; mcuY++) {
+    for (int mcuX = 0; mcuX < info.m_MCUSPerRow; mcuX++) {
+      if (pjpeg_decode_mcu() != 0) {
+        fclose(gInput);
+        return false;
+      }
+      for (int y = 0; y < mcuHeight; y++) {
+        const int pixelY = mcuY * mcuHeight + y;
+        if (pixelY >= out.height) break;
+        const uint8_t* blockRow = info.m_pMCUBufR + (y / blockSize) * 128 + (y % blockSize) * 8;
+        for (int x = 0; x < mcuWidth; x++) {
+          const int pixelX = mcuX * mcuWidth + x;
+          if (pixelX >= out.width) break;
+          out.pixels[pixelY * out.width + pixelX] = blockRow[(x / blockSize) * 64 + x % blockSize];
+        }
+      }
+    }
+  }
+
+  millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  fclose(gInput);
+  return true;
+}
+
+// PSNR of a reduced decode against the full decode averaged over factor x factor cells
+double psnrAgainstFull(const GrayImage& full, const GrayImage& reduced, const int factor) {
+  double squaredError = 0;
+  long count = 0;
+  for (int y = 0; y < full.height / factor; y++) {
+    for (int x = 0; x < full.width / factor; x++) {
+      int sum = 0;
+      for (int j = 0; j < factor; j++) {
+        for (int i = 0; i < factor; i++) {
+          sum += full.pixels[(y * factor + j) * full.width + x * factor + i];
+        }
+      }
+      const double diff = static_cast<double>(sum) / (factor * factor) - reduced.pixels[y * reduced.width + x];
+      squaredError += diff * diff;
+      count++;
+    }
+  }
+  if (count == 0 || squaredError == 0) {
+    return INFINITY;
+  }
+  return 10 * std::log10(255.0 * 255.0 / (squaredError / count));
+}
+
+std::vector<std::string> collectJpegs(const std::vector<std::string>& args) {
+  std::vector<std::string> files;
+  for (const auto& arg : args) {
+    if (std::filesystem::is_directory(arg)) {
+      for (const auto& entry : std::filesystem::recursive_directory_iterator(arg)) {
+        std::string ext = entry.path().extension().string();
+        for (auto& c : ext) c = static_cast<char>(tolower(c));
+        if (entry.is_regular_file() && (ext == ".jpg" || ext == ".jpeg")) {
+          files.push_back(entry.path().string());
+        }
+      }
+    } else {
+      files.push_back(arg);
+    }
+  }
+  return files;
+}
+
+int main(int argc, char* argv[]) {
+  const std::vector<std::string> files = collectJpegs(std::vector<std::string>(argv + 1, argv + argc));
+  if (files.empty()) {
+    std::cerr << "Usage: " << argv[0] << " <jpeg file or directory>..." << std::endl;
+    return 1;
+  }
+
+  double totalMillis[4] = {};
+  int decoded = 0;
+  std::cout << std::fixed << std::setprecision(1);
+
+  for (const auto& file : files) {
+    GrayImage full;
+    double fullMillis = 0;
+    if (!decode(file, 0, full, fullMillis)) {
+      std::cout << file << ": not supported by picojpeg, skipped" << std::endl;
+      continue;
+    }
+
+    std::cout << file << " (" << full.width << "x" << full.height << ")" << std::endl;
+    std::cout << "  1/1: " << fullMillis << " ms" << std::endl;
+    totalMillis[0] += fullMillis;
+
+    for (int shift = 1; shift <= 3; shift++) {
+      GrayImage reduced;
+      double millis = 0;
+      if (!decode(file, shift, reduced, millis)) {
+        std::cout << "  1/" << (1 << shift) << ": decode failed" << std::endl;
+        return 1;
+      }
+      totalMillis[shift] += millis;
+      std::cout << "  1/" << (1 << shift) << ": " << millis << " ms (" << (fullMillis / millis) << "x), PSNR "
+                << psnrAgainstFull(full, reduced, 1 << shift) << " dB" << std::endl;
+    }
+    decoded++;
+  }
+
+  std::cout << std::endl << "Total over " << decoded << " image(s):" << std::endl;
+  for (int shift = 0; shift <= 3; shift++) {
+    std::cout << "  1/" << (1 << shift) << ": " << totalMillis[shift] << " ms" << std::endl;
+  }
+  return 0;
+}
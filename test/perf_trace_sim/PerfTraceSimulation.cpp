@@ -0,0 +1,169 @@
+#include <PerfTrace.h>
+
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Host run of the perf tracing library. A fake microsecond clock drives a scripted page-turn pipeline (page load with
+// nested SD reads, render passes, panel refreshes) so histograms, percentiles and the event ring can be checked
+// exactly; then several threads trace concurrently on the real clock. Prints the report the device serves.
+
+namespace {
+uint32_t fakeNow = 0;
+uint32_t fakeClock() { return fakeNow; }
+
+int failures = 0;
+
+void check(const bool condition, const char* what) {
+  if (!condition) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+void spend(const uint32_t us) { fakeNow += us; }
+
+// One page turn as the EPUB reader does it: load (three SD reads), BW pass, refresh, two grayscale passes, refresh
+void pageTurn(const int turn) {
+  {
+    PERF_SCOPE(PAGE_LOAD);
+    for (int i = 0; i < 3; i++) {
+      PERF_SCOPE(SD_READ);
+      spend(1500);
+    }
+    spend(4000);
+  }
+  {
+    PERF_SCOPE(RENDER_PASS);
+    spend(30000);
+  }
+  {
+    PERF_SCOPE(DISPLAY_REFRESH);
+    // Every tenth turn is a half refresh
+    spend(turn % 10 == 9 ? 1700000 : 420000);
+  }
+  for (int pass = 0; pass < 2; pass++) {
+    PERF_SCOPE(RENDER_PASS);
+    spend(25000);
+  }
+  {
+    PERF_SCOPE(DISPLAY_REFRESH);
+    spend(380000);
+  }
+}
+
+void testPipeline() {
+  PerfTrace::setClock(fakeClock);
+  PERF_TRACE.reset();
+
+  constexpr int turns = 100;
+  for (int turn = 0; turn < turns; turn++) {
+    pageTurn(turn);
+  }
+
+  const auto load = PERF_TRACE.getStats(PerfTrace::PAGE_LOAD);
+  check(load.count == turns, "one page load per turn");
+  check(load.totalUs == turns * 8500ull, "page load includes its nested SD reads");
+  check(load.maxUs == 8500, "page load max");
+  check(load.buckets[13] == turns, "8.5ms lands in the 8192-16383us bucket");
+
+  const auto reads = PERF_TRACE.getStats(PerfTrace::SD_READ);
+  check(reads.count == turns * 3, "three SD reads per turn");
+
+  const auto render = PERF_TRACE.getStats(PerfTrace::RENDER_PASS);
+  check(render.count == turns * 3, "BW and two grayscale passes per turn");
+  check(render.maxUs == 30000, "render max is the BW pass");
+
+  const auto refresh = PERF_TRACE.getStats(PerfTrace::DISPLAY_REFRESH);
+  check(refresh.count == turns * 2, "BW and grayscale refresh per turn");
+  check(refresh.maxUs == 1700000, "half refresh is the slowest");
+  // 100 grayscale (380ms) and 90 fast (420ms) refreshes share the 262-524ms bucket, 10 half refreshes are above it
+  check(refresh.getPercentileUs(50) == 524287, "p50 bound of the refresh histogram");
+  check(refresh.getPercentileUs(99) == 1700000, "p99 capped at the max");
+  check(PERF_TRACE.getStats(PerfTrace::ZIP_LOOKUP).count == 0, "untouched stages stay empty");
+
+  // Each turn writes 2 * (1 + 3 + 3 + 2) events, so the ring holds only the last turns
+  const uint32_t eventsPerTurn = 2 * 9;
+  check(PERF_TRACE.getEventCount() == turns * eventsPerTurn, "every begin and end is counted");
+  std::vector<PerfTrace::Event> events(PerfTrace::RING_SIZE);
+  const size_t copied = PERF_TRACE.copyEvents(events.data(), events.size());
+  check(copied == PerfTrace::RING_SIZE, "ring is full after wrapping");
+  bool ordered = true;
+  for (size_t i = 1; i < copied; i++) {
+    ordered = ordered && events[i].timeUs >= events[i - 1].timeUs;
+  }
+  check(ordered, "events come oldest first");
+  const auto& last = events[copied - 1];
+  check(last.end && last.stage == PerfTrace::DISPLAY_REFRESH && last.timeUs == fakeNow,
+        "newest event is the end of the last refresh");
+
+  // Begin and end events nest like the scopes did
+  std::vector<uint8_t> open;
+  bool nested = true;
+  std::vector<PerfTrace::Event> lastTurn(eventsPerTurn);
+  PERF_TRACE.copyEvents(lastTurn.data(), lastTurn.size());
+  for (const auto& event : lastTurn) {
+    if (!event.end) {
+      open.push_back(event.stage);
+    } else {
+      nested = nested && !open.empty() && open.back() == event.stage;
+      if (!open.empty()) open.pop_back();
+    }
+  }
+  check(nested && open.empty(), "begin and end events of one turn are balanced");
+
+  printf("%s\n", PERF_TRACE.formatReport().c_str());
+
+  PERF_TRACE.reset();
+  check(PERF_TRACE.getEventCount() == 0 && PERF_TRACE.getStats(PerfTrace::RENDER_PASS).count == 0, "reset clears");
+}
+
+void testThreads() {
+  PerfTrace::setClock(nullptr);
+  PERF_TRACE.reset();
+
+  constexpr int threads = 4;
+  constexpr int scopesPerThread = 20000;
+  std::vector<std::thread> workers;
+  for (int t = 0; t < threads; t++) {
+    workers.emplace_back([t] {
+      for (int i = 0; i < scopesPerThread; i++) {
+        if (t % 2 == 0) {
+          PERF_SCOPE(SD_WRITE);
+        } else {
+          PERF_SCOPE(FONT_INFLATE);
+        }
+      }
+    });
+  }
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  const auto writes = PERF_TRACE.getStats(PerfTrace::SD_WRITE);
+  const auto inflates = PERF_TRACE.getStats(PerfTrace::FONT_INFLATE);
+  check(writes.count == threads / 2 * scopesPerThread, "no SD_WRITE scope lost across threads");
+  check(inflates.count == threads / 2 * scopesPerThread, "no FONT_INFLATE scope lost across threads");
+  check(PERF_TRACE.getEventCount() == 2u * threads * scopesPerThread, "no event lost across threads");
+
+  uint64_t bucketSum = 0;
+  for (const uint32_t count : writes.buckets) {
+    bucketSum += count;
+  }
+  check(bucketSum == writes.count, "histogram buckets add up to the count");
+  printf("%d threads, %d scopes each: avg scope %.2f us on the real clock\n", threads, scopesPerThread,
+         static_cast<double>(writes.totalUs + inflates.totalUs) / (writes.count + inflates.count));
+}
+}  // namespace
+
+int main() {
+  testPipeline();
+  testThreads();
+
+  if (failures > 0) {
+    printf("%d check(s) failed\n", failures);
+    return 1;
+  }
+  printf("All checks passed\n");
+  return 0;
+}
@@ -0,0 +1,17 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/button_events_sim"
+BINARY="$BUILD_DIR/ButtonEventsSimulation"
+
+mkdir -p "$BUILD_DIR"
+
+c++ -std=c++20 -O2 -Wall -Wextra -I"$ROOT_DIR/lib/ButtonEvents" \
+  "$ROOT_DIR/test/button_events_sim/ButtonEventsSimulation.cpp" "$ROOT_DIR/lib/ButtonEvents/ButtonEvents.cpp" \
+  -o "$BINARY"
+
+# Usage: run_button_events_sim.sh
+# Replays a scripted reading session through the polling and the event-driven main loop and checks they agree;
+# reports loop and sampler wakeups and page turn latency from the press.
+"$BINARY"
@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/dir_listing_bench"
+BINARY="$BUILD_DIR/DirectoryListingBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+c++ -std=c++20 -O2 -Wall -Wextra -I"$ROOT_DIR/lib/DirectoryListing" \
+  "$ROOT_DIR/test/dir_listing_bench/DirectoryListingBenchmark.cpp" \
+  "$ROOT_DIR/lib/DirectoryListing/DirectoryListing.cpp" -o "$BINARY"
+
+# Usage: run_dir_listing_bench.sh [directory | file count]
+# Without arguments, 5,000 files are generated in a temporary directory.
+"$BINARY" "$@"
@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/heap_trace_sim"
+BINARY="$BUILD_DIR/HeapTraceSimulation"
+
+mkdir -p "$BUILD_DIR"
+
+c++ -std=c++20 -O2 -Wall -Wextra -pthread -DENABLE_PERF_TRACE -I"$ROOT_DIR/lib/PerfTrace" \
+  "$ROOT_DIR/test/heap_trace_sim/HeapTraceSimulation.cpp" "$ROOT_DIR/lib/PerfTrace/HeapTrace.cpp" \
+  "$ROOT_DIR/lib/PerfTrace/PerfTrace.cpp" -o "$BINARY"
+
+# Usage: run_heap_trace_sim.sh
+# Tracks a tagged chapter workload through the tracker's operator new and checks live, peak and fragmentation figures.
+"$BINARY"
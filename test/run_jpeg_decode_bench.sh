@@ -0,0 +1,22 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/jpeg_decode_bench"
+BINARY="$BUILD_DIR/JpegDecodeBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+cc -O2 -c "$ROOT_DIR/lib/picojpeg/picojpeg.c" -o "$BUILD_DIR/picojpeg.o"
+c++ -std=c++20 -O2 -Wall -Wextra -I"$ROOT_DIR/lib/picojpeg" \
+  "$ROOT_DIR/test/jpeg_decode_bench/JpegDecodeBenchmark.cpp" "$BUILD_DIR/picojpeg.o" -o "$BINARY"
+
+# Default input: the images of the JPEG test book. Pass files or directories (e.g. a folder of covers) to override.
+if [ "$#" -eq 0 ]; then
+  EXTRACT_DIR="$BUILD_DIR/test_jpeg_images"
+  rm -rf "$EXTRACT_DIR"
+  unzip -q "$ROOT_DIR/test/epubs/test_jpeg_images.epub" -d "$EXTRACT_DIR"
+  set -- "$EXTRACT_DIR"
+fi
+
+"$BINARY" "$@"
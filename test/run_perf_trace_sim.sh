@@ -0,0 +1,15 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/perf_trace_sim"
+BINARY="$BUILD_DIR/PerfTraceSimulation"
+
+mkdir -p "$BUILD_DIR"
+
+c++ -std=c++20 -O2 -Wall -Wextra -pthread -DENABLE_PERF_TRACE -I"$ROOT_DIR/lib/PerfTrace" \
+  "$ROOT_DIR/test/perf_trace_sim/PerfTraceSimulation.cpp" "$ROOT_DIR/lib/PerfTrace/PerfTrace.cpp" -o "$BINARY"
+
+# Usage: run_perf_trace_sim.sh
+# Traces a scripted page-turn pipeline on a fake clock and checks the histograms and the event ring.
+"$BINARY"
@@ -0,0 +1,16 @@
+#!/usr/bin/env bash
+set -euo pipefail
+
+ROOT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")/.." && pwd)"
+BUILD_DIR="$ROOT_DIR/build/txt_wrap_bench"
+BINARY="$BUILD_DIR/TxtWrapBenchmark"
+
+mkdir -p "$BUILD_DIR"
+
+c++ -std=c++20 -O2 -Wall -Wextra -pthread -DENABLE_PERF_TRACE -I"$ROOT_DIR/lib/Txt" -I"$ROOT_DIR/lib/PerfTrace" \
+  "$ROOT_DIR/test/txt_wrap_bench/TxtWrapBenchmark.cpp" "$ROOT_DIR/lib/Txt/TxtLineWrapper.cpp" \
+  "$ROOT_DIR/lib/PerfTrace/HeapTrace.cpp" "$ROOT_DIR/lib/PerfTrace/PerfTrace.cpp" -o "$BINARY"
+
+# Usage: run_txt_wrap_bench.sh [file.txt [old-loop prefix in KB]]
+# Without a file, a 4MB synthetic text of long unwrapped paragraphs is indexed.
+"$BINARY" "$@"
@@ -0,0 +1,251 @@
+#include <HeapTrace.h>
+#include <TxtLineWrapper.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+// Host benchmark for TXT page indexing. Runs the page indexer of TxtReaderActivity over a text file with the previous
+// wrap loop (prefix measuring from the end of the line) and with TxtLineWrapper, using a synthetic proportional font
+// whose widths are additive, so both must produce the same page offsets. Built with the heap tracker, it also reports
+// the peak heap each loop needs while indexing.
+
+constexpr size_t CHUNK_SIZE = 8 * 1024;
+constexpr int LINES_PER_PAGE = 24;
+constexpr int VIEWPORT_WIDTH = 464;
+constexpr int SPACE_WIDTH = 5;
+
+int codepointWidth(const uint32_t cp) {
+  if (cp == ' ') return SPACE_WIDTH;
+  if (cp < 0x80) return 4 + static_cast<int>(cp * 7 % 9);
+  return cp >= 0x3000 ? 20 : 11;
+}
+
+// Advance of text[0, len), like GfxRenderer::getTextAdvanceX without kerning
+int measure(const char* text, const size_t len) {
+  int width = 0;
+  for (size_t i = 0; i < len;) {
+    const auto lead = static_cast<unsigned char>(text[i]);
+    uint32_t cp = lead;
+    size_t n = 1;
+    if (lead >= 0xF0) {
+      cp = lead & 0x07;
+      n = 4;
+    } else if (lead >= 0xE0) {
+      cp = lead & 0x0F;
+      n = 3;
+    } else if (lead >= 0xC0) {
+      cp = lead & 0x1F;
+      n = 2;
+    }
+    for (size_t k = 1; k < n && i + k < len; k++) {
+      cp = (cp << 6) | (static_cast<unsigned char>(text[i + k]) & 0x3F);
+    }
+    width += codepointWidth(cp);
+    i += n;
+  }
+  return width;
+}
+
+int getTextWidth(const char* text) { return measure(text, strlen(text)); }
+
+// The wrap loop TxtReaderActivity used before TxtLineWrapper. Returns the bytes of `line` consumed.
+size_t wrapOld(std::string line, std::vector<std::string>& outLines) {
+  const size_t displayLen = line.size();
+  size_t lineBytePos = 0;
+  while (!line.empty() && static_cast<int>(outLines.size()) < LINES_PER_PAGE) {
+    if (getTextWidth(line.c_str()) <= VIEWPORT_WIDTH) {
+      outLines.push_back(line);
+      lineBytePos = displayLen;
+      line.clear();
+      break;
+    }
+
+    size_t breakPos = line.length();
+    while (breakPos > 0 && getTextWidth(line.substr(0, breakPos).c_str()) > VIEWPORT_WIDTH) {
+      size_t spacePos = line.rfind(' ', breakPos - 1);
+      if (spacePos != std::string::npos && spacePos > 0) {
+        breakPos = spacePos;
+      } else {
+        breakPos--;
+        while (breakPos > 0 && (line[breakPos] & 0xC0) == 0x80) {
+          breakPos--;
+        }
+      }
+    }
+    if (breakPos == 0) {
+      breakPos = 1;
+    }
+
+    outLines.push_back(line.substr(0, breakPos));
+    size_t skipChars = breakPos;
+    if (breakPos < line.length() && line[breakPos] == ' ') {
+      skipChars++;
+    }
+    lineBytePos += skipChars;
+    line = line.substr(skipChars);
+  }
+  return lineBytePos;
+}
+
+size_t wrapNew(TxtLineWrapper& wrapper, const char* line, const size_t displayLen, std::vector<std::string>& outLines) {
+  size_t lineBytePos = 0;
+  while (lineBytePos < displayLen && static_cast<int>(outLines.size()) < LINES_PER_PAGE) {
+    size_t shownLen;
+    const size_t consumed = wrapper.nextLine(line + lineBytePos, displayLen - lineBytePos, shownLen);
+    outLines.emplace_back(line + lineBytePos, shownLen);
+    lineBytePos += consumed;
+  }
+  return lineBytePos;
+}
+
+// Same chunking and line handling as TxtReaderActivity::loadPageAtOffset
+size_t loadPage(const std::string& text, const size_t offset, const bool useNew) {
+  const size_t fileSize = text.size();
+  const size_t chunkSize = std::min(CHUNK_SIZE, fileSize - offset);
+  const std::string chunk = text.substr(offset, chunkSize);
+  const char* buffer = chunk.c_str();
+  std::vector<std::string> outLines;
+  TxtLineWrapper wrapper(measure, SPACE_WIDTH, VIEWPORT_WIDTH);
+
+  size_t pos = 0;
+  while (pos < chunkSize && static_cast<int>(outLines.size()) < LINES_PER_PAGE) {
+    size_t lineEnd = pos;
+    while (lineEnd < chunkSize && buffer[lineEnd] != '\n') {
+      lineEnd++;
+    }
+    const bool lineComplete = (lineEnd < chunkSize) || (offset + lineEnd >= fileSize);
+    if (!lineComplete && !outLines.empty()) {
+      break;
+    }
+    const size_t lineContentLen = lineEnd - pos;
+    const bool hasCR = lineContentLen > 0 && buffer[pos + lineContentLen - 1] == '\r';
+    const size_t displayLen = hasCR ? lineContentLen - 1 : lineContentLen;
+
+    const size_t lineBytePos = useNew ? wrapNew(wrapper, buffer + pos, displayLen, outLines)
+                                      : wrapOld(std::string(buffer + pos, displayLen), outLines);
+    if (lineBytePos >= displayLen) {
+      pos = lineEnd + 1;
+    } else {
+      pos += lineBytePos;
+      break;
+    }
+  }
+  if (pos == 0 && !outLines.empty()) {
+    pos = 1;
+  }
+  return std::min(offset + pos, fileSize);
+}
+
+std::vector<size_t> buildPageIndex(const std::string& text, const bool useNew, double& millis) {
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<size_t> pageOffsets{0};
+  HEAP_SCOPE(LAYOUT);
+  size_t offset = 0;
+  while (offset < text.size()) {
+    const size_t next = loadPage(text, offset, useNew);
+    if (next <= offset) break;
+    offset = next;
+    if (offset < text.size()) pageOffsets.push_back(offset);
+  }
+  millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  return pageOffsets;
+}
+
+// Peak LAYOUT heap since the previous call, above what was still live then (earlier page indexes), when built with the
+// tracker (run_txt_wrap_bench.sh does)
+unsigned long takeLayoutPeakKb() {
+#ifdef ENABLE_PERF_TRACE
+  static uint32_t liveAtReset = 0;
+  const uint32_t peak = HEAP_TRACE.getStats(HeapTrace::LAYOUT).peakBytes - liveAtReset;
+  HEAP_TRACE.reset();
+  liveAtReset = HEAP_TRACE.getStats(HeapTrace::LAYOUT).liveBytes;
+  return (peak + 1023) / 1024;
+#else
+  return 0;
+#endif
+}
+
+// Unwrapped paragraphs of 1-12KB, as in web-scraped text, with some accented words, long URLs and CJK paragraphs
+std::string syntheticText(const size_t size) {
+  std::mt19937 rng(42);
+  std::string text;
+  while (text.size() < size) {
+    const size_t paragraphEnd = text.size() + 1024 + rng() % (11 * 1024);
+    const bool cjk = rng() % 10 == 0;
+    while (text.size() < paragraphEnd) {
+      if (cjk) {
+        text += "\xE6\x96\x87\xE5\xAD\x97";  // two CJK characters, no spaces
+        continue;
+      }
+      const unsigned kind = rng() % 100;
+      if (kind < 2) {
+        text += "https://example.com/";
+        for (int i = 0; i < 150; i++) text += static_cast<char>('a' + rng() % 26);
+      } else {
+        const int len = 1 + rng() % 10;
+        for (int i = 0; i < len; i++) text += static_cast<char>('a' + rng() % 26);
+        if (kind < 10) text += "\xC3\xA9";  // é
+      }
+      text += ' ';
+    }
+    text += "\r\n";
+  }
+  return text;
+}
+
+int main(int argc, char** argv) {
+  std::string text;
+  size_t oldLimit = 128 * 1024;
+  if (argc > 1) {
+    std::ifstream in(argv[1], std::ios::binary);
+    if (!in) {
+      std::cerr << "Cannot open " << argv[1] << "\n";
+      return 1;
+    }
+    text.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+  } else {
+    text = syntheticText(4 * 1024 * 1024);
+  }
+  if (argc > 2) {
+    oldLimit = std::stoul(argv[2]) * 1024;
+  }
+
+  takeLayoutPeakKb();
+  double newMillis = 0;
+  const auto newOffsets = buildPageIndex(text, true, newMillis);
+  printf("Input: %zu bytes, %zu pages\n", text.size(), newOffsets.size());
+  printf("TxtLineWrapper:  %9.1f ms (%.1f MB/s), peak layout heap %lu KB\n", newMillis,
+         text.size() / 1048576.0 / (newMillis / 1000), takeLayoutPeakKb());
+
+  // The old loop is far slower, so it only indexes a prefix
+  const std::string prefix = text.substr(0, std::min(oldLimit, text.size()));
+  double oldMillis = 0;
+  double newPrefixMillis = 0;
+  const auto oldOffsets = buildPageIndex(prefix, false, oldMillis);
+  const unsigned long oldPeakKb = takeLayoutPeakKb();
+  const auto newPrefixOffsets = buildPageIndex(prefix, true, newPrefixMillis);
+  const unsigned long newPrefixPeakKb = takeLayoutPeakKb();
+  printf("Old wrap loop:   %9.1f ms for the first %zu KB (%.1f ms with TxtLineWrapper, %.0fx)\n", oldMillis,
+         prefix.size() / 1024, newPrefixMillis, oldMillis / newPrefixMillis);
+  printf("Peak layout heap over that prefix: %lu KB old loop, %lu KB TxtLineWrapper\n", oldPeakKb, newPrefixPeakKb);
+#ifdef ENABLE_PERF_TRACE
+  printf("\n%s\n", HEAP_TRACE.formatReport().c_str());
+#endif
+
+  if (oldOffsets != newPrefixOffsets) {
+    size_t i = 0;
+    while (i < oldOffsets.size() && i < newPrefixOffsets.size() && oldOffsets[i] == newPrefixOffsets[i]) i++;
+    printf("Page offsets differ from page %zu\n", i);
+    return 1;
+  }
+  printf("Page offsets identical (%zu pages)\n", oldOffsets.size());
+  return 0;
+}